@@ -101,6 +101,23 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetWorldMatrix(int _i
 	RendererManager::Instance().SetWorldMatrix(_instanceID, _world);
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetWorldMatrices(const int* _ids, const XMFLOAT4X4* _worlds, int _count)
+{
+	// queued and applied by worker threads at the beginning of next render
+	RendererManager::Instance().SetWorldMatrices(_ids, _worlds, _count);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReserveWorldMatrices(int _capacity, int** _ids, XMFLOAT4X4** _worlds)
+{
+	// native buffer filled by caller, valid until CommitWorldMatrices
+	RendererManager::Instance().ReserveWorldMatrices(_capacity, _ids, _worlds);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CommitWorldMatrices(int _count)
+{
+	RendererManager::Instance().CommitWorldMatrices(_count);
+}
+
 extern "C" bool UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddNativeMesh(int _instanceID, MeshData _MeshData)
 {
 	return MeshManager::Instance().AddMesh(_instanceID, _MeshData);
@@ -111,6 +128,11 @@ extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddNativeRenderer(int
 	return RendererManager::Instance().AddRenderer(_instanceID, _meshInstanceID, _isDynamic);
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddNativeRendererLod(int _id, int _meshInstanceID, float _screenSize)
+{
+	RendererManager::Instance().AddRendererLod(_id, _meshInstanceID, _screenSize);
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetNativeRendererActive(int _id, bool _active)
 {
 	RendererManager::Instance().SetNativeRendererActive(_id, _active);
@@ -187,6 +209,16 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API InitInstanceRendering
 	RendererManager::Instance().InitInstanceRendering();
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetSoftwareOcclusion(bool _enable)
+{
+	RendererManager::Instance().SetSoftwareOcclusion(_enable);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetScreenSizeCulling(float _pixels)
+{
+	RendererManager::Instance().SetScreenSizeCulling(_pixels);
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ResetPipelineState()
 {
 	Camera* c = CameraManager::Instance().GetCamera();
@@ -223,6 +255,11 @@ extern "C" UNITY_INTERFACE_EXPORT char* UNITY_INTERFACE_API GetGpuProfile()
 	return (char*)GameTimerManager::Instance().gpuProfile.c_str();
 }
 
+extern "C" UNITY_INTERFACE_EXPORT char* UNITY_INTERFACE_API GetFrameStatistics()
+{
+	return (char*)GameTimerManager::Instance().statProfile.c_str();
+}
+
 // --------------------------------------------------------------------------
 // UnitySetInterfaces
 
@@ -0,0 +1,123 @@
+#include "TestUtility.h"
+#include "AabbTree.h"
+#include <cmath>
+
+static const int BOX_COUNT = 50000;
+
+static uint32_t randomState = 404;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static BoundingBox RandomBox()
+{
+	return BoundingBox(XMFLOAT3(NextRandom(-1000.0f, 1000.0f), NextRandom(-50.0f, 50.0f), NextRandom(-1000.0f, 1000.0f)), XMFLOAT3(NextRandom(0.2f, 4.0f), NextRandom(0.2f, 4.0f), NextRandom(0.2f, 4.0f)));
+}
+
+// build, refit and frustum query of 50k boxes, query against testing every box like culling did before the tree
+int main()
+{
+	int iterations = BenchIterations(20);
+
+	vector<BoundingBox> bounds(BOX_COUNT);
+	for (auto& b : bounds)
+	{
+		b = RandomBox();
+	}
+
+	// build is proxy by proxy, same as renderers get their first world matrix
+	AabbTree tree;
+	vector<int> proxies(BOX_COUNT);
+	auto start = chrono::high_resolution_clock::now();
+	tree.Init(0.5f);
+	for (int i = 0; i < BOX_COUNT; i++)
+	{
+		proxies[i] = tree.CreateProxy(bounds[i], i);
+	}
+	double buildMs = ElapsedMs(start);
+
+	// 10% of boxes move each frame, most a little inside their fat bound, every tenth of them jumps
+	double refitMs = 0.0;
+	int reinsertCount = 0;
+	for (int n = 0; n < iterations; n++)
+	{
+		start = chrono::high_resolution_clock::now();
+		for (int k = 0; k < BOX_COUNT / 10; k++)
+		{
+			int id = (int)NextRandom(0.0f, BOX_COUNT - 0.01f);
+			if (k % 10 == 0)
+			{
+				bounds[id] = RandomBox();
+			}
+			else
+			{
+				bounds[id].Center.x += NextRandom(-0.4f, 0.4f);
+				bounds[id].Center.z += NextRandom(-0.4f, 0.4f);
+			}
+			reinsertCount += tree.MoveProxy(proxies[id], bounds[id]) ? 1 : 0;
+		}
+		refitMs += ElapsedMs(start);
+	}
+
+	BoundingFrustum frustum(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, sinf(0.3f), 0.0f, cosf(0.3f)), 1.0f, -1.0f, 0.6f, -0.6f, 0.3f, 600.0f);
+	XMVECTOR p[6];
+	frustum.GetPlanes(&p[0], &p[1], &p[2], &p[3], &p[4], &p[5]);
+	XMFLOAT4 planes[6];
+	for (int i = 0; i < 6; i++)
+	{
+		XMStoreFloat4(&planes[i], p[i]);
+	}
+
+	vector<int> inside, intersect;
+	vector<char> visible(BOX_COUNT);
+	int queryVisible = 0;
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		inside.clear();
+		intersect.clear();
+		tree.QueryFrustum(tree.GetRoot(), planes, 6, inside, intersect);
+
+		// crossing leaves still get the exact test, like CullingWork
+		queryVisible = (int)inside.size();
+		for (int id : intersect)
+		{
+			queryVisible += (frustum.Contains(bounds[id]) != DISJOINT) ? 1 : 0;
+		}
+	}
+	double queryMs = ElapsedMs(start);
+
+	int bruteVisible = 0;
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		bruteVisible = 0;
+		for (int i = 0; i < BOX_COUNT; i++)
+		{
+			visible[i] = frustum.Contains(bounds[i]) != DISJOINT;
+			bruteVisible += visible[i];
+		}
+	}
+	double bruteMs = ElapsedMs(start);
+
+	printf("boxes %d, height %d, iterations %d\n", BOX_COUNT, tree.GetHeight(), iterations);
+	printf("build: %.3f ms\n", buildMs);
+	printf("refit %d moves: %.3f ms per frame, %d reinserted\n", BOX_COUNT / 10, refitMs / iterations, reinsertCount / iterations);
+	printf("query: %.3f ms, test every box: %.3f ms per frame, visible %d\n", queryMs / iterations, bruteMs / iterations, bruteVisible);
+
+	TEST_CHECK(tree.GetProxyCount() == BOX_COUNT);
+	TEST_CHECK(reinsertCount > 0);
+	TEST_CHECK(queryVisible == bruteVisible);
+
+	// leaves found fully inside are visible by the exact test too
+	int wrongInside = 0;
+	for (int id : inside)
+	{
+		wrongInside += visible[id] ? 0 : 1;
+	}
+	TEST_CHECK(wrongInside == 0);
+
+	return TestResult();
+}
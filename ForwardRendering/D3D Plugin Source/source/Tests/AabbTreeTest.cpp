@@ -0,0 +1,235 @@
+#include "TestUtility.h"
+#include "AabbTree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <set>
+
+static uint32_t randomState = 2024;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static BoundingBox RandomBox()
+{
+	return BoundingBox(XMFLOAT3(NextRandom(-200.0f, 200.0f), NextRandom(-50.0f, 50.0f), NextRandom(-200.0f, 200.0f)), XMFLOAT3(NextRandom(0.1f, 5.0f), NextRandom(0.1f, 5.0f), NextRandom(0.1f, 5.0f)));
+}
+
+static void RandomPlanes(XMFLOAT4* _planes)
+{
+	float h = NextRandom(0.3f, 1.0f);
+	BoundingFrustum frustum(XMFLOAT3(NextRandom(-50.0f, 50.0f), 0.0f, NextRandom(-50.0f, 50.0f)), XMFLOAT4(0.0f, sinf(NextRandom(-1.5f, 1.5f)), 0.0f, 1.0f), h * 1.7f, -h * 1.7f, h, -h, 0.3f, NextRandom(50.0f, 300.0f));
+
+	// make orientation a unit quaternion
+	float len = sqrtf(frustum.Orientation.y * frustum.Orientation.y + 1.0f);
+	frustum.Orientation.y /= len;
+	frustum.Orientation.w /= len;
+
+	XMVECTOR p[6];
+	frustum.GetPlanes(&p[0], &p[1], &p[2], &p[3], &p[4], &p[5]);
+	for (int i = 0; i < 6; i++)
+	{
+		XMStoreFloat4(&_planes[i], p[i]);
+	}
+}
+
+// signed distance of the box from the frustum, positive is outside by that much, negative is inside by that much
+static float FrustumDistance(const XMFLOAT4* _planes, const BoundingBox& _bound)
+{
+	float maxDist = -FLT_MAX;
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& p = _planes[i];
+		float dist = p.x * _bound.Center.x + p.y * _bound.Center.y + p.z * _bound.Center.z + p.w;
+		float radius = fabsf(p.x) * _bound.Extents.x + fabsf(p.y) * _bound.Extents.y + fabsf(p.z) * _bound.Extents.z;
+		maxDist = max(maxDist, dist - radius);
+	}
+
+	return maxDist;
+}
+
+static bool FullyInside(const XMFLOAT4* _planes, const BoundingBox& _bound)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& p = _planes[i];
+		float dist = p.x * _bound.Center.x + p.y * _bound.Center.y + p.z * _bound.Center.z + p.w;
+		float radius = fabsf(p.x) * _bound.Extents.x + fabsf(p.y) * _bound.Extents.y + fabsf(p.z) * _bound.Extents.z;
+		if (dist + radius > 1e-3f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// proxies kept next to the tree, user data is the index here
+struct BruteProxy
+{
+	int proxy;
+	BoundingBox bound;
+	bool alive;
+};
+
+// query results against brute force over every live proxy
+static void CheckQuery(const AabbTree& _tree, const vector<BruteProxy>& _proxies, float _fatMargin)
+{
+	XMFLOAT4 planes[6];
+	RandomPlanes(planes);
+
+	vector<int> inside, intersect;
+	_tree.QueryFrustum(_tree.GetRoot(), planes, 6, inside, intersect);
+
+	set<int> reported;
+	for (int id : inside)
+	{
+		TEST_CHECK(reported.insert(id).second);
+		TEST_CHECK(_proxies[id].alive);
+
+		// fat bound contains the tight one, so a leaf accepted as inside is really inside
+		TEST_CHECK(FullyInside(planes, _proxies[id].bound));
+	}
+
+	for (int id : intersect)
+	{
+		TEST_CHECK(reported.insert(id).second);
+		TEST_CHECK(_proxies[id].alive);
+	}
+
+	for (int i = 0; i < (int)_proxies.size(); i++)
+	{
+		if (!_proxies[i].alive)
+		{
+			continue;
+		}
+
+		float dist = FrustumDistance(planes, _proxies[i].bound);
+
+		// never lose a visible proxy
+		if (dist < -1e-3f)
+		{
+			TEST_CHECK(reported.count(i) == 1);
+		}
+
+		// a leaf is reported only if its fat bound reaches the frustum, fat bound grows by at most 2 margins per axis when moved
+		if (dist > 4.0f * _fatMargin + 1e-2f)
+		{
+			TEST_CHECK(reported.count(i) == 0);
+		}
+	}
+
+	// subtrees together give the same leaves as the root
+	vector<int> roots;
+	_tree.GetSubtreeRoots(8, roots);
+	TEST_CHECK(_tree.GetProxyCount() < 8 || (int)roots.size() >= 8);
+
+	set<int> fromSubtrees;
+	for (int r : roots)
+	{
+		vector<int> subInside, subIntersect;
+		_tree.QueryFrustum(r, planes, 6, subInside, subIntersect);
+		fromSubtrees.insert(subInside.begin(), subInside.end());
+		fromSubtrees.insert(subIntersect.begin(), subIntersect.end());
+	}
+	TEST_CHECK(fromSubtrees == reported);
+}
+
+static void RunRandomOperations(float _fatMargin)
+{
+	AabbTree tree;
+	tree.Init(_fatMargin);
+
+	vector<BruteProxy> proxies;
+	int aliveCount = 0;
+
+	for (int step = 0; step < 4000; step++)
+	{
+		float op = NextRandom(0.0f, 1.0f);
+		if (op < 0.4f || aliveCount == 0)
+		{
+			BruteProxy p;
+			p.bound = RandomBox();
+			p.proxy = tree.CreateProxy(p.bound, (int)proxies.size());
+			p.alive = true;
+			proxies.push_back(p);
+			aliveCount++;
+		}
+		else
+		{
+			int i = (int)NextRandom(0.0f, proxies.size() - 0.01f);
+			if (!proxies[i].alive)
+			{
+				continue;
+			}
+
+			if (op < 0.55f)
+			{
+				tree.DestroyProxy(proxies[i].proxy);
+				proxies[i].alive = false;
+				aliveCount--;
+			}
+			else
+			{
+				// mostly small movement that stays in the fat bound, sometimes a jump
+				BoundingBox& b = proxies[i].bound;
+				float range = (op < 0.9f) ? 0.2f : 100.0f;
+				b.Center.x += NextRandom(-range, range);
+				b.Center.y += NextRandom(-range, range);
+				b.Center.z += NextRandom(-range, range);
+				tree.MoveProxy(proxies[i].proxy, b);
+			}
+		}
+
+		if (step % 200 == 0)
+		{
+			CheckQuery(tree, proxies, _fatMargin);
+		}
+	}
+
+	CheckQuery(tree, proxies, _fatMargin);
+	TEST_CHECK(tree.GetProxyCount() == aliveCount);
+
+	// balanced tree stays shallow
+	TEST_CHECK(tree.GetHeight() <= 2 * (int)ceil(log2((double)max(aliveCount, 2))) + 2);
+}
+
+static void TestTightTree()
+{
+	RunRandomOperations(0.0f);
+}
+
+static void TestFatTree()
+{
+	RunRandomOperations(0.5f);
+}
+
+static void TestMoveInsideFatBound()
+{
+	AabbTree tree;
+	tree.Init(0.5f);
+
+	BoundingBox b(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	int proxy = tree.CreateProxy(b, 0);
+
+	b.Center.x = 0.4f;
+	TEST_CHECK(!tree.MoveProxy(proxy, b));
+
+	b.Center.x = 0.6f;
+	TEST_CHECK(tree.MoveProxy(proxy, b));
+
+	tree.DestroyProxy(proxy);
+	TEST_CHECK(tree.GetProxyCount() == 0);
+	TEST_CHECK(tree.GetRoot() == AabbTree::NULL_NODE);
+}
+
+int main()
+{
+	TEST_RUN(TestTightTree);
+	TEST_RUN(TestFatTree);
+	TEST_RUN(TestMoveInsideFatBound);
+
+	return TestResult();
+}
@@ -0,0 +1,75 @@
+#include "TestUtility.h"
+#include "AffineMath.h"
+#include <vector>
+
+// affine kernels against the general 4x4 inverse and 8-corner bound transform they replace
+int main()
+{
+	const int count = 4096;
+	int iterations = BenchIterations(200);
+
+	vector<XMFLOAT4X4> worlds(count);
+	vector<XMFLOAT4X4> inverses(count);
+	vector<BoundingBox> bounds(count);
+	for (int i = 0; i < count; i++)
+	{
+		XMMATRIX m = XMMatrixMultiply(XMMatrixScaling(1.0f + i % 3, 2.0f, 0.5f), XMMatrixRotationRollPitchYaw(i * 0.1f, i * 0.2f, i * 0.3f));
+		m = XMMatrixMultiply(m, XMMatrixTranslation((float)i, 0.0f, -(float)i));
+		XMStoreFloat4x4(&worlds[i], m);
+	}
+
+	BoundingBox local(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 2.0f, 0.5f));
+	float sink = 0.0f;
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			XMStoreFloat4x4(&inverses[i], XMMatrixInverse(nullptr, XMLoadFloat4x4(&worlds[i])));
+		}
+		sink += inverses[n % count]._11;
+	}
+	double generalInverseMs = ElapsedMs(start);
+
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			AffineInverse(worlds[i], inverses[i]);
+		}
+		sink += inverses[n % count]._11;
+	}
+	double affineInverseMs = ElapsedMs(start);
+
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			local.Transform(bounds[i], XMLoadFloat4x4(&worlds[i]));
+		}
+		sink += bounds[n % count].Extents.x;
+	}
+	double cornerBoundMs = ElapsedMs(start);
+
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			AffineTransformBound(local, worlds[i], bounds[i]);
+		}
+		sink += bounds[n % count].Extents.x;
+	}
+	double affineBoundMs = ElapsedMs(start);
+
+	double perCall = 1e6 / ((double)iterations * count);
+	printf("matrices %d, iterations %d\n", count, iterations);
+	printf("XMMatrixInverse: %.2f ns, AffineInverse: %.2f ns\n", generalInverseMs * perCall, affineInverseMs * perCall);
+	printf("BoundingBox::Transform: %.2f ns, AffineTransformBound: %.2f ns\n", cornerBoundMs * perCall, affineBoundMs * perCall);
+
+	TEST_CHECK(sink != 0.0f);
+	return TestResult();
+}
@@ -0,0 +1,250 @@
+#include "TestUtility.h"
+#include "AffineMath.h"
+#include "RendererPool.h"
+#include <cmath>
+
+static uint32_t randomState = 777;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+// scale (negative allowed), rotation and translation like a unity local to world matrix
+static XMFLOAT4X4 RandomAffine()
+{
+	float sx = NextRandom(0.1f, 5.0f) * (NextRandom(0.0f, 1.0f) < 0.2f ? -1.0f : 1.0f);
+	XMMATRIX m = XMMatrixScaling(sx, NextRandom(0.1f, 5.0f), NextRandom(0.1f, 5.0f));
+	m = XMMatrixMultiply(m, XMMatrixRotationRollPitchYaw(NextRandom(-3.0f, 3.0f), NextRandom(-3.0f, 3.0f), NextRandom(-3.0f, 3.0f)));
+	m = XMMatrixMultiply(m, XMMatrixTranslation(NextRandom(-500.0f, 500.0f), NextRandom(-500.0f, 500.0f), NextRandom(-500.0f, 500.0f)));
+
+	XMFLOAT4X4 result;
+	XMStoreFloat4x4(&result, m);
+	return result;
+}
+
+static void TestInverseMatchesGeneralInverse()
+{
+	for (int i = 0; i < 1000; i++)
+	{
+		XMFLOAT4X4 world = RandomAffine();
+
+		XMFLOAT4X4 affine, general;
+		AffineInverse(world, affine);
+		XMStoreFloat4x4(&general, XMMatrixInverse(nullptr, XMLoadFloat4x4(&world)));
+
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				// translation row scales with the translation, linear part with 1/scale
+				float eps = (r == 3) ? 1e-2f : 1e-3f * (1.0f + fabsf(general.m[r][c]));
+				TEST_CHECK_NEAR(affine.m[r][c], general.m[r][c], eps);
+			}
+		}
+
+		// column 3 stays exactly 0,0,0,1
+		TEST_CHECK(affine._14 == 0.0f && affine._24 == 0.0f && affine._34 == 0.0f && affine._44 == 1.0f);
+	}
+}
+
+static void TestSingularInverse()
+{
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixMultiply(XMMatrixScaling(1.0f, 0.0f, 2.0f), XMMatrixTranslation(1.0f, 2.0f, 3.0f)));
+
+	XMFLOAT4X4 inv;
+	AffineInverse(world, inv);
+
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			TEST_CHECK(std::isfinite(inv.m[r][c]));
+			if (r < 3)
+			{
+				TEST_CHECK(inv.m[r][c] == 0.0f);
+			}
+		}
+	}
+}
+
+static void TestBoundMatchesCornerTransform()
+{
+	for (int i = 0; i < 1000; i++)
+	{
+		XMFLOAT4X4 world = RandomAffine();
+		BoundingBox local(XMFLOAT3(NextRandom(-5.0f, 5.0f), NextRandom(-5.0f, 5.0f), NextRandom(-5.0f, 5.0f)), XMFLOAT3(NextRandom(0.0f, 3.0f), NextRandom(0.0f, 3.0f), NextRandom(0.0f, 3.0f)));
+
+		BoundingBox affine, corners;
+		AffineTransformBound(local, world, affine);
+		local.Transform(corners, XMLoadFloat4x4(&world));
+
+		TEST_CHECK_NEAR(affine.Center.x, corners.Center.x, 1e-2f);
+		TEST_CHECK_NEAR(affine.Center.y, corners.Center.y, 1e-2f);
+		TEST_CHECK_NEAR(affine.Center.z, corners.Center.z, 1e-2f);
+		TEST_CHECK_NEAR(affine.Extents.x, corners.Extents.x, 1e-2f);
+		TEST_CHECK_NEAR(affine.Extents.y, corners.Extents.y, 1e-2f);
+		TEST_CHECK_NEAR(affine.Extents.z, corners.Extents.z, 1e-2f);
+	}
+}
+
+static void TestPack3x4()
+{
+	XMFLOAT4X4 world = RandomAffine();
+	XMFLOAT4 rows[3];
+	AffinePack3x4(world, rows);
+
+	for (int r = 0; r < 3; r++)
+	{
+		const float* row = &rows[r].x;
+		for (int c = 0; c < 4; c++)
+		{
+			TEST_CHECK(row[c] == world.m[c][r]);
+		}
+	}
+}
+
+// same math as LocalToWorldNormal(float3x4, float3) in SqForwardInclude.hlsl, reading the packed rows like the shader
+static XMFLOAT3 ShaderCofactorNormal(const XMFLOAT4* _rows, const XMFLOAT3& _normal)
+{
+	XMVECTOR m0 = XMLoadFloat4(&_rows[0]);
+	XMVECTOR m1 = XMLoadFloat4(&_rows[1]);
+	XMVECTOR m2 = XMLoadFloat4(&_rows[2]);
+	XMVECTOR c0 = XMVector3Cross(m1, m2);
+	XMVECTOR c1 = XMVector3Cross(m2, m0);
+	XMVECTOR c2 = XMVector3Cross(m0, m1);
+	float detSign = (XMVectorGetX(XMVector3Dot(m0, c0)) < 0) ? -1.0f : 1.0f;
+
+	XMVECTOR n = XMLoadFloat3(&_normal);
+	XMVECTOR result = XMVectorSet(XMVectorGetX(XMVector3Dot(c0, n)), XMVectorGetX(XMVector3Dot(c1, n)), XMVectorGetX(XMVector3Dot(c2, n)), 0.0f);
+
+	XMFLOAT3 out;
+	XMStoreFloat3(&out, XMVector3Normalize(XMVectorScale(result, detSign)));
+	return out;
+}
+
+// normal times inverse-transpose of the linear part, what the per-instance invWorld gave before
+static XMFLOAT3 InverseTransposeNormal(const XMFLOAT4X4& _world, const XMFLOAT3& _normal)
+{
+	XMMATRIX invTranspose = XMMatrixTranspose(XMMatrixInverse(nullptr, XMLoadFloat4x4(&_world)));
+
+	XMFLOAT3 out;
+	XMStoreFloat3(&out, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&_normal), invTranspose)));
+	return out;
+}
+
+static void CheckCofactorNormal(const XMFLOAT4X4& _world)
+{
+	XMFLOAT4 rows[3];
+	AffinePack3x4(_world, rows);
+
+	for (int k = 0; k < 8; k++)
+	{
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(NextRandom(-1.0f, 1.0f), NextRandom(-1.0f, 1.0f), NextRandom(-1.0f, 1.0f), 0.0f)));
+
+		XMFLOAT3 cofactor = ShaderCofactorNormal(rows, normal);
+		XMFLOAT3 expected = InverseTransposeNormal(_world, normal);
+		TEST_CHECK_NEAR(cofactor.x, expected.x, 1e-3f);
+		TEST_CHECK_NEAR(cofactor.y, expected.y, 1e-3f);
+		TEST_CHECK_NEAR(cofactor.z, expected.z, 1e-3f);
+	}
+}
+
+// cofactor normal of the shader points the same way as the inverse-transpose, for non-uniform and mirrored scale
+static void TestCofactorNormalMatchesInverseTranspose()
+{
+	for (int i = 0; i < 500; i++)
+	{
+		CheckCofactorNormal(RandomAffine());
+	}
+
+	// strong non-uniform scale, a plain transpose of world would bend these normals
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixMultiply(XMMatrixScaling(10.0f, 0.1f, 1.0f), XMMatrixRotationRollPitchYaw(0.3f, 0.7f, -0.2f)));
+	CheckCofactorNormal(world);
+
+	// scale after rotation, like a child under a non-uniformly scaled parent, gives shear
+	XMStoreFloat4x4(&world, XMMatrixMultiply(XMMatrixRotationRollPitchYaw(0.5f, -0.4f, 0.9f), XMMatrixScaling(4.0f, 0.5f, 2.0f)));
+	CheckCofactorNormal(world);
+
+	// mirrored on two and on one axis, negative determinant must not flip the normal inwards
+	XMStoreFloat4x4(&world, XMMatrixScaling(-2.0f, -3.0f, 0.5f));
+	CheckCofactorNormal(world);
+	XMStoreFloat4x4(&world, XMMatrixMultiply(XMMatrixScaling(-1.0f, 2.0f, 3.0f), XMMatrixTranslation(5.0f, 0.0f, -5.0f)));
+	CheckCofactorNormal(world);
+
+	// axis aligned case by hand, scale (2,1,1) turns normal (1,1,0) towards y
+	XMStoreFloat4x4(&world, XMMatrixScaling(2.0f, 1.0f, 1.0f));
+	XMFLOAT4 rows[3];
+	AffinePack3x4(world, rows);
+	XMFLOAT3 n = ShaderCofactorNormal(rows, XMFLOAT3(0.70710678f, 0.70710678f, 0.0f));
+	TEST_CHECK_NEAR(n.x, 0.4472136f, 1e-5f);
+	TEST_CHECK_NEAR(n.y, 0.8944272f, 1e-5f);
+	TEST_CHECK_NEAR(n.z, 0.0f, 1e-5f);
+}
+
+// both world update paths of the renderer pool, SetWorldMatrix and the batched transform stage, against the general math
+static void TestRendererPoolMatchesGeneral()
+{
+	RendererPool pool;
+	for (int i = 0; i < 200; i++)
+	{
+		pool.Add(true);
+	}
+
+	for (int i = 0; i < 200; i++)
+	{
+		XMFLOAT4X4 world = RandomAffine();
+		BoundingBox local(XMFLOAT3(NextRandom(-5.0f, 5.0f), NextRandom(-5.0f, 5.0f), NextRandom(-5.0f, 5.0f)), XMFLOAT3(NextRandom(0.0f, 3.0f), NextRandom(0.0f, 3.0f), NextRandom(0.0f, 3.0f)));
+
+		uint32_t version = pool.GetWorldVersion(i);
+		if (i % 2 == 0)
+		{
+			pool.SetWorld(i, world, local);
+		}
+		else
+		{
+			pool.UpdateWorld(i, world, local);
+			pool.MarkWorldDirty(i);
+		}
+		TEST_CHECK(pool.GetWorldVersion(i) == version + 1);
+
+		XMFLOAT4X4 general;
+		XMStoreFloat4x4(&general, XMMatrixInverse(nullptr, XMLoadFloat4x4(&world)));
+		const XMFLOAT4X4& inv = pool.GetInvWorld(i);
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float eps = (r == 3) ? 1e-2f : 1e-3f * (1.0f + fabsf(general.m[r][c]));
+				TEST_CHECK_NEAR(inv.m[r][c], general.m[r][c], eps);
+			}
+		}
+
+		BoundingBox corners;
+		local.Transform(corners, XMLoadFloat4x4(&world));
+		const BoundingBox& bound = pool.GetWorldBound(i);
+		TEST_CHECK_NEAR(bound.Center.x, corners.Center.x, 1e-2f);
+		TEST_CHECK_NEAR(bound.Center.y, corners.Center.y, 1e-2f);
+		TEST_CHECK_NEAR(bound.Center.z, corners.Center.z, 1e-2f);
+		TEST_CHECK_NEAR(bound.Extents.x, corners.Extents.x, 1e-2f);
+		TEST_CHECK_NEAR(bound.Extents.y, corners.Extents.y, 1e-2f);
+		TEST_CHECK_NEAR(bound.Extents.z, corners.Extents.z, 1e-2f);
+	}
+
+	pool.Release();
+}
+
+int main()
+{
+	TEST_RUN(TestInverseMatchesGeneralInverse);
+	TEST_RUN(TestSingularInverse);
+	TEST_RUN(TestBoundMatchesCornerTransform);
+	TEST_RUN(TestPack3x4);
+	TEST_RUN(TestCofactorNormalMatchesInverseTranspose);
+	TEST_RUN(TestRendererPoolMatchesGeneral);
+
+	return TestResult();
+}
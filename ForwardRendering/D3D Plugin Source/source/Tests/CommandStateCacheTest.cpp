@@ -0,0 +1,235 @@
+#include "TestUtility.h"
+#include "CommandStateCache.h"
+#include <cstring>
+#include <vector>
+
+static const int ROOT_COUNT = 20;
+
+// state bound when a draw is recorded
+struct DrawState
+{
+	ID3D12PipelineState* pso;
+	ID3D12RootSignature* rootSignature;
+	int rootType[ROOT_COUNT];
+	UINT64 rootValue[ROOT_COUNT];
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer;
+	D3D12_INDEX_BUFFER_VIEW indexBuffer;
+	D3D12_PRIMITIVE_TOPOLOGY topology;
+	UINT indexCount;
+
+	bool operator==(const DrawState& _other) const
+	{
+		for (int i = 0; i < ROOT_COUNT; i++)
+		{
+			if (rootType[i] != _other.rootType[i] || rootValue[i] != _other.rootValue[i])
+			{
+				return false;
+			}
+		}
+
+		return pso == _other.pso && rootSignature == _other.rootSignature && topology == _other.topology && indexCount == _other.indexCount
+			&& vertexBuffer.BufferLocation == _other.vertexBuffer.BufferLocation && vertexBuffer.SizeInBytes == _other.vertexBuffer.SizeInBytes
+			&& vertexBuffer.StrideInBytes == _other.vertexBuffer.StrideInBytes && indexBuffer.BufferLocation == _other.indexBuffer.BufferLocation
+			&& indexBuffer.SizeInBytes == _other.indexBuffer.SizeInBytes && indexBuffer.Format == _other.indexBuffer.Format;
+	}
+};
+
+// mock list that tracks bound state like the gpu would and snapshots it at every draw
+struct MockList
+{
+	DrawState state;
+	vector<DrawState> draws;
+	int callCount = 0;
+
+	MockList()
+	{
+		memset(&state, 0, sizeof(state));
+	}
+
+	void SetPipelineState(ID3D12PipelineState* _pso)
+	{
+		state.pso = _pso;
+		callCount++;
+	}
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* _rootSignature)
+	{
+		// root arguments are undefined after a root signature change
+		state.rootSignature = _rootSignature;
+		for (int i = 0; i < ROOT_COUNT; i++)
+		{
+			state.rootType[i] = -1;
+			state.rootValue[i] = 0;
+		}
+		callCount++;
+	}
+
+	void SetRoot(UINT _index, int _type, UINT64 _value)
+	{
+		state.rootType[_index] = _type;
+		state.rootValue[_index] = _value;
+		callCount++;
+	}
+
+	void SetGraphicsRootConstantBufferView(UINT _index, D3D12_GPU_VIRTUAL_ADDRESS _address) { SetRoot(_index, 1, _address); }
+	void SetGraphicsRootShaderResourceView(UINT _index, D3D12_GPU_VIRTUAL_ADDRESS _address) { SetRoot(_index, 2, _address); }
+	void SetGraphicsRootDescriptorTable(UINT _index, D3D12_GPU_DESCRIPTOR_HANDLE _table) { SetRoot(_index, 3, _table.ptr); }
+
+	void IASetVertexBuffers(UINT _slot, UINT _count, const D3D12_VERTEX_BUFFER_VIEW* _view)
+	{
+		if (_slot == 0 && _count == 1)
+		{
+			state.vertexBuffer = *_view;
+		}
+		callCount++;
+	}
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* _view)
+	{
+		state.indexBuffer = *_view;
+		callCount++;
+	}
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY _topology)
+	{
+		state.topology = _topology;
+		callCount++;
+	}
+
+	void DrawIndexedInstanced(UINT _indexCount, UINT, UINT, INT, UINT)
+	{
+		state.indexCount = _indexCount;
+		draws.push_back(state);
+	}
+};
+
+static ID3D12PipelineState psoPool[3];
+static ID3D12RootSignature rootSignaturePool[2];
+
+static uint32_t randomState = 8080;
+static uint32_t NextRandom(uint32_t _range)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) % _range;
+}
+
+// one draw the way BindForwardObject records it, every binding is set again each time
+template<typename List> static void RecordDraw(List& _list, bool _changeRootSignature)
+{
+	if (_changeRootSignature)
+	{
+		_list.SetGraphicsRootSignature(&rootSignaturePool[NextRandom(2)]);
+	}
+	_list.SetPipelineState(&psoPool[NextRandom(3)]);
+
+	// system constants and tables rarely change, per object data changes every few draws
+	_list.SetGraphicsRootConstantBufferView(0, 0x1000);
+	_list.SetGraphicsRootDescriptorTable(1, D3D12_GPU_DESCRIPTOR_HANDLE{ 0x2000 });
+	_list.SetGraphicsRootDescriptorTable(2, D3D12_GPU_DESCRIPTOR_HANDLE{ 0x3000 + NextRandom(2) * 0x100 });
+	_list.SetGraphicsRootShaderResourceView(3, 0x4000);
+	_list.SetGraphicsRootConstantBufferView(4, 0x5000 + NextRandom(4) * 0x100);
+
+	// above cache size, must never be filtered
+	_list.SetGraphicsRootConstantBufferView(17, 0x6000);
+
+	D3D12_VERTEX_BUFFER_VIEW vbv = { 0x10000 + NextRandom(3) * 0x1000, 0x1000, 64 };
+	D3D12_INDEX_BUFFER_VIEW ibv = { 0x20000 + NextRandom(3) * 0x1000, 0x800, NextRandom(2) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT };
+	_list.IASetVertexBuffers(0, 1, &vbv);
+	_list.IASetIndexBuffer(&ibv);
+	_list.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	_list.DrawIndexedInstanced(36 + NextRandom(100), 1, 0, 0, 0);
+}
+
+// adapts the cache to the call shape RecordDraw uses
+struct CachedRecorder
+{
+	CommandStateCache<MockList>& cache;
+	int callCount = 0;
+
+	void SetPipelineState(ID3D12PipelineState* _pso) { callCount++; cache.SetPipelineState(_pso); }
+	void SetGraphicsRootSignature(ID3D12RootSignature* _rs) { callCount++; cache.SetGraphicsRootSignature(_rs); }
+	void SetGraphicsRootConstantBufferView(UINT _i, D3D12_GPU_VIRTUAL_ADDRESS _a) { callCount++; cache.SetGraphicsRootConstantBufferView(_i, _a); }
+	void SetGraphicsRootShaderResourceView(UINT _i, D3D12_GPU_VIRTUAL_ADDRESS _a) { callCount++; cache.SetGraphicsRootShaderResourceView(_i, _a); }
+	void SetGraphicsRootDescriptorTable(UINT _i, D3D12_GPU_DESCRIPTOR_HANDLE _t) { callCount++; cache.SetGraphicsRootDescriptorTable(_i, _t); }
+	void IASetVertexBuffers(UINT _slot, UINT, const D3D12_VERTEX_BUFFER_VIEW* _v) { callCount++; cache.IASetVertexBuffers(_slot, _v); }
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* _v) { callCount++; cache.IASetIndexBuffer(_v); }
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY _t) { callCount++; cache.IASetPrimitiveTopology(_t); }
+	void DrawIndexedInstanced(UINT _a, UINT _b, UINT _c, INT _d, UINT _e) { cache.DrawIndexedInstanced(_a, _b, _c, _d, _e); }
+};
+
+// every draw sees the same state with and without the cache, and fewer calls reach the list
+static void TestSameStateAtEveryDraw()
+{
+	MockList direct;
+	MockList filtered;
+	CommandStateCache<MockList> cache;
+	cache.Begin(&filtered);
+	CachedRecorder recorder = { cache };
+
+	uint32_t seed = randomState;
+	for (int i = 0; i < 2000; i++)
+	{
+		RecordDraw(direct, i == 0 || i % 97 == 0);
+	}
+
+	randomState = seed;
+	for (int i = 0; i < 2000; i++)
+	{
+		RecordDraw(recorder, i == 0 || i % 97 == 0);
+	}
+
+	TEST_CHECK(direct.draws.size() == filtered.draws.size());
+	bool same = true;
+	for (size_t i = 0; i < direct.draws.size() && i < filtered.draws.size(); i++)
+	{
+		same &= (direct.draws[i] == filtered.draws[i]);
+	}
+	TEST_CHECK(same);
+
+	StateCallCount count = cache.TakeCount();
+	TEST_CHECK(count.Issued() == filtered.callCount);
+	TEST_CHECK(count.Issued() + count.filtered == recorder.callCount);
+	TEST_CHECK(filtered.callCount < direct.callCount / 2);
+
+	// counts restart after TakeCount
+	TEST_CHECK(cache.TakeCount().Issued() == 0);
+}
+
+// a new root signature or Begin forgets root arguments
+static void TestInvalidation()
+{
+	MockList list;
+	CommandStateCache<MockList> cache;
+	cache.Begin(&list);
+
+	cache.SetGraphicsRootSignature(&rootSignaturePool[0]);
+	cache.SetGraphicsRootConstantBufferView(0, 0x100);
+	cache.SetGraphicsRootConstantBufferView(0, 0x100);
+	TEST_CHECK(list.callCount == 2);
+
+	cache.SetGraphicsRootSignature(&rootSignaturePool[1]);
+	cache.SetGraphicsRootConstantBufferView(0, 0x100);
+	TEST_CHECK(list.callCount == 4);
+
+	// same address bound as another root argument type is a different binding
+	cache.SetGraphicsRootShaderResourceView(0, 0x100);
+	TEST_CHECK(list.callCount == 5);
+
+	cache.Begin(&list);
+	cache.SetGraphicsRootSignature(&rootSignaturePool[1]);
+	cache.SetPipelineState(&psoPool[0]);
+	cache.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	TEST_CHECK(list.callCount == 8);
+
+	StateCallCount count = cache.TakeCount();
+	TEST_CHECK(count.filtered == 1);
+	TEST_CHECK(count.rootSignature == 3 && count.rootArgument == 3 && count.pipelineState == 1 && count.inputAssembler == 1);
+}
+
+int main()
+{
+	TEST_RUN(TestSameStateAtEveryDraw);
+	TEST_RUN(TestInvalidation);
+
+	return TestResult();
+}
@@ -0,0 +1,154 @@
+#include "TestUtility.h"
+#include "DeferredReleaseList.h"
+#include "InstanceSlotTable.h"
+#include "FrameSettings.h"
+#include <algorithm>
+
+// stands in for an instance upload buffer, counts how many are alive
+static int aliveCount = 0;
+struct FakeBuffer
+{
+	explicit FakeBuffer(int _capacity) : capacity(_capacity) { aliveCount++; }
+	~FakeBuffer() { aliveCount--; }
+
+	int capacity;
+};
+
+static uint32_t randomState = 99;
+static uint32_t NextRandom()
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return randomState >> 8;
+}
+
+// object stays alive until its fence completes, later fences are kept
+static void TestReleaseWaitsForFence()
+{
+	DeferredReleaseList list;
+	weak_ptr<FakeBuffer> a, b;
+	{
+		shared_ptr<FakeBuffer> bufferA = make_shared<FakeBuffer>(64);
+		shared_ptr<FakeBuffer> bufferB = make_shared<FakeBuffer>(128);
+		a = bufferA;
+		b = bufferB;
+		list.Add(bufferA, 3);
+		list.Add(bufferB, 5);
+	}
+	TEST_CHECK(aliveCount == 2);
+
+	list.Release(2);
+	TEST_CHECK(list.GetCount() == 2);
+	TEST_CHECK(!a.expired() && !b.expired());
+
+	list.Release(3);
+	TEST_CHECK(list.GetCount() == 1);
+	TEST_CHECK(a.expired() && !b.expired());
+
+	list.Release(10);
+	TEST_CHECK(list.GetCount() == 0);
+	TEST_CHECK(aliveCount == 0);
+
+	list.Add(make_shared<FakeBuffer>(64), 20);
+	list.Clear();
+	TEST_CHECK(aliveCount == 0);
+}
+
+// frame the gpu has not finished, with the buffer it reads
+struct InFlightFrame
+{
+	uint64_t fence;
+	weak_ptr<FakeBuffer> buffer;
+};
+
+// batch grows and shrinks while frames are in flight, same steps as GraphicManager::Update and InstanceRenderer::FitCapacity
+static void TestGrowthKeepsInFlightBuffers()
+{
+	DeferredReleaseList list;
+	shared_ptr<FakeBuffer> buffers[MAX_FRAME_COUNT];
+	uint64_t graphicFences[MAX_FRAME_COUNT] = {};
+	uint64_t mainFence = 0;
+	uint64_t completedFence = 0;
+	int bufferCapacity = 0;
+	int memberCount = 100;
+	int resizeCount = 0;
+	bool freedInUse = false;
+	bool keptCompleted = false;
+	vector<InFlightFrame> inFlight;
+	vector<InFlightFrame> retired;
+
+	for (int frame = 0; frame < 2000; frame++)
+	{
+		// wait for the frame that used this index, the gpu may also be further ahead
+		int frameIndex = frame % MAX_FRAME_COUNT;
+		completedFence = max(completedFence, graphicFences[frameIndex]);
+		completedFence += NextRandom() % (mainFence - completedFence + 1);
+		list.Release(completedFence);
+
+		inFlight.erase(remove_if(inFlight.begin(), inFlight.end(), [completedFence](const InFlightFrame& _f) { return _f.fence <= completedFence; }), inFlight.end());
+		for (const InFlightFrame& f : inFlight)
+		{
+			freedInUse |= f.buffer.expired();
+		}
+		for (const InFlightFrame& r : retired)
+		{
+			keptCompleted |= (r.fence <= completedFence && !r.buffer.expired());
+		}
+		retired.erase(remove_if(retired.begin(), retired.end(), [completedFence](const InFlightFrame& _f) { return _f.fence <= completedFence; }), retired.end());
+
+		// members come and go, sometimes a lot at once
+		int change = (NextRandom() % 10 == 0) ? 400 : 20;
+		memberCount = max(memberCount + (int)(NextRandom() % (change * 2 + 1)) - change, 0);
+
+		int capacity = FitInstanceCapacity(bufferCapacity, memberCount);
+		if (capacity != bufferCapacity)
+		{
+			for (int i = 0; i < MAX_FRAME_COUNT; i++)
+			{
+				if (buffers[i])
+				{
+					InFlightFrame r;
+					r.fence = mainFence + 1;
+					r.buffer = buffers[i];
+					retired.push_back(r);
+					list.Add(buffers[i], mainFence + 1);
+				}
+				buffers[i] = make_shared<FakeBuffer>(capacity);
+			}
+			bufferCapacity = capacity;
+			resizeCount++;
+		}
+
+		// new buffer is used right away by the frame being recorded
+		TEST_CHECK(buffers[frameIndex]->capacity >= memberCount);
+
+		mainFence++;
+		graphicFences[frameIndex] = mainFence;
+		InFlightFrame f;
+		f.fence = mainFence;
+		f.buffer = buffers[frameIndex];
+		inFlight.push_back(f);
+	}
+
+	TEST_CHECK(resizeCount > 10);
+	TEST_CHECK(!freedInUse);
+	TEST_CHECK(!keptCompleted);
+
+	// gpu idle, only the current buffers are left
+	list.Release(mainFence);
+	TEST_CHECK(list.GetCount() == 0);
+	TEST_CHECK(aliveCount == MAX_FRAME_COUNT);
+
+	for (int i = 0; i < MAX_FRAME_COUNT; i++)
+	{
+		buffers[i].reset();
+	}
+	TEST_CHECK(aliveCount == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestReleaseWaitsForFence);
+	TEST_RUN(TestGrowthKeepsInFlightBuffers);
+
+	return TestResult();
+}
@@ -0,0 +1,421 @@
+#include "TestUtility.h"
+#include "DrawPacket.h"
+#include "DrawPartition.h"
+#include "CommandStateCache.h"
+#include <map>
+#include <deque>
+#include <new>
+#include <cstring>
+
+// packets only carry material pointers
+class Material
+{
+public:
+	int id;
+};
+
+// heap allocations made by this thread while counting is on
+static bool countAllocations = false;
+static int allocationCount = 0;
+
+void* operator new(size_t _size)
+{
+	if (countAllocations)
+	{
+		allocationCount++;
+	}
+
+	void* p = malloc(_size > 0 ? _size : 1);
+	if (p == nullptr)
+	{
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* _p) noexcept
+{
+	free(_p);
+}
+
+void operator delete(void* _p, size_t) noexcept
+{
+	free(_p);
+}
+
+static const int MESH_COUNT = 6;
+static const int MATERIAL_COUNT = 5;
+static const int MAX_PARTS = 8;
+
+struct TestMesh
+{
+	D3D12_VERTEX_BUFFER_VIEW vbv;
+	D3D12_INDEX_BUFFER_VIEW ibv;
+	UINT indexCount[3];
+	UINT startIndex[3];
+	INT baseVertex[3];
+};
+
+// instance batch of the old renderer maps, mesh -1 is a renderer without a mesh
+struct TestBatch
+{
+	int queue;
+	int mesh;
+	int submesh;
+	int material;
+	int instanceCount;
+	D3D12_GPU_VIRTUAL_ADDRESS instanceData;
+};
+
+// what the gpu sees at a draw
+struct DrawState
+{
+	D3D12_GPU_VIRTUAL_ADDRESS vertexBuffer;
+	D3D12_GPU_VIRTUAL_ADDRESS indexBuffer;
+	D3D12_GPU_VIRTUAL_ADDRESS instanceData;
+	UINT indexCount;
+	UINT instanceCount;
+	UINT startIndex;
+	INT baseVertex;
+
+	bool operator==(const DrawState& _other) const
+	{
+		return memcmp(this, &_other, sizeof(DrawState)) == 0;
+	}
+};
+
+// mock list that tracks bound state and snapshots it at every draw
+struct MockList
+{
+	DrawState state;
+	vector<DrawState> draws;
+
+	MockList()
+	{
+		memset(&state, 0, sizeof(state));
+	}
+
+	void SetPipelineState(ID3D12PipelineState*) {}
+	void SetGraphicsRootSignature(ID3D12RootSignature*) {}
+	void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {}
+	void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) {}
+
+	void SetGraphicsRootShaderResourceView(UINT _index, D3D12_GPU_VIRTUAL_ADDRESS _address)
+	{
+		if (_index == 1)
+		{
+			state.instanceData = _address;
+		}
+	}
+
+	void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW* _view)
+	{
+		state.vertexBuffer = _view->BufferLocation;
+	}
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* _view)
+	{
+		state.indexBuffer = _view->BufferLocation;
+	}
+
+	void DrawIndexedInstanced(UINT _indexCount, UINT _instanceCount, UINT _startIndex, INT _baseVertex, UINT)
+	{
+		state.indexCount = _indexCount;
+		state.instanceCount = _instanceCount;
+		state.startIndex = _startIndex;
+		state.baseVertex = _baseVertex;
+		draws.push_back(state);
+	}
+};
+
+static uint32_t randomState = 4711;
+static uint32_t NextRandom(uint32_t _range)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) % _range;
+}
+
+static TestMesh meshes[MESH_COUNT];
+static Material materials[MATERIAL_COUNT];
+
+static void InitResources()
+{
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		meshes[i].vbv = { 0x100000u * (i + 1), 0x10000, 32 };
+		meshes[i].ibv = { 0x100000u * (i + 1) + 0x80000, 0x8000, DXGI_FORMAT_R32_UINT };
+		for (int k = 0; k < 3; k++)
+		{
+			meshes[i].indexCount[k] = 36 + NextRandom(3000);
+			meshes[i].startIndex[k] = NextRandom(1000);
+			meshes[i].baseVertex[k] = (INT)NextRandom(500);
+		}
+	}
+
+	for (int i = 0; i < MATERIAL_COUNT; i++)
+	{
+		materials[i].id = i;
+	}
+}
+
+// render queue -> batches, the layout workers used to copy and walk
+static void BuildScene(map<int, deque<TestBatch>>& _scene, int _batchCount)
+{
+	const int queues[4] = { 1000, 2000, 2450, 3000 };
+	_scene.clear();
+	for (int i = 0; i < _batchCount; i++)
+	{
+		TestBatch b;
+		b.queue = queues[NextRandom(4)];
+		b.mesh = (NextRandom(40) == 0) ? -1 : (int)NextRandom(MESH_COUNT);
+		b.submesh = NextRandom(3);
+		b.material = NextRandom(MATERIAL_COUNT);
+		b.instanceCount = (NextRandom(10) == 0) ? 0 : 1 + NextRandom(100);
+		b.instanceData = 0x40000000ull + i * 0x1000ull;
+		_scene[b.queue].push_back(b);
+	}
+}
+
+// old path: walk the maps, skip empty batches and renderers without a mesh, bind straight from the batch
+static void RecordOldPath(const map<int, deque<TestBatch>>& _scene, MockList& _list)
+{
+	for (auto const& qr : _scene)
+	{
+		for (auto const& b : qr.second)
+		{
+			if (b.instanceCount == 0 || b.mesh < 0)
+			{
+				continue;
+			}
+
+			const TestMesh& m = meshes[b.mesh];
+			_list.IASetVertexBuffers(0, 1, &m.vbv);
+			_list.IASetIndexBuffer(&m.ibv);
+			_list.SetGraphicsRootShaderResourceView(1, b.instanceData);
+			_list.DrawIndexedInstanced(m.indexCount[b.submesh], b.instanceCount, m.startIndex[b.submesh], m.baseVertex[b.submesh], 0);
+		}
+	}
+}
+
+// packet path state kept between frames, like RendererManager keeps it
+struct PacketPath
+{
+	vector<const TestBatch*> sorted;
+	DrawPacketStream stream;
+	vector<double> cost;
+	vector<int> bounds;
+	MockList lists[MAX_PARTS];
+	CommandStateCache<MockList> cache[MAX_PARTS];
+};
+
+// sort items of non-empty batches, queue is the highest part of the key so this is map order
+static void CollectSorted(const map<int, deque<TestBatch>>& _scene, vector<const TestBatch*>& _sorted)
+{
+	_sorted.clear();
+	for (auto const& qr : _scene)
+	{
+		for (auto const& b : qr.second)
+		{
+			if (b.instanceCount > 0)
+			{
+				_sorted.push_back(&b);
+			}
+		}
+	}
+}
+
+// same steps as CompileDrawPackets for instance batches
+static void CompilePackets(PacketPath& _path, int _numParts)
+{
+	_path.stream.Clear();
+	for (const TestBatch* b : _path.sorted)
+	{
+		if (b->mesh < 0)
+		{
+			continue;
+		}
+
+		const TestMesh& m = meshes[b->mesh];
+		DrawPacket dp;
+		dp.vbv = m.vbv;
+		dp.ibv = m.ibv;
+		dp.indexCount = m.indexCount[b->submesh];
+		dp.startIndex = m.startIndex[b->submesh];
+		dp.baseVertex = m.baseVertex[b->submesh];
+		dp.material = &materials[b->material];
+		dp.instanceData = b->instanceData;
+		dp.objectConstant = 0;
+		dp.instanceCount = b->instanceCount;
+		dp.queue = b->queue;
+		_path.stream.Add(dp);
+	}
+
+	const vector<DrawPacket>& packets = _path.stream.GetPackets();
+	_path.cost.resize(packets.size() + 1);
+	_path.cost[0] = 0.0;
+	for (int i = 0; i < (int)packets.size(); i++)
+	{
+		bool stateChange = (i == 0) || (packets[i].material != packets[i - 1].material);
+		_path.cost[i + 1] = _path.cost[i] + EstimateDrawCost(packets[i].indexCount, packets[i].instanceCount, stateChange);
+	}
+
+	vector<DrawPacketRange>& ranges = _path.stream.GetRanges();
+	_path.bounds.resize(ranges.size() * (_numParts + 1));
+	for (int i = 0; i < (int)ranges.size(); i++)
+	{
+		ranges[i].partStart = i * (_numParts + 1);
+		PartitionByCost(_path.cost, ranges[i].start, ranges[i].start + ranges[i].count, _numParts, &_path.bounds[ranges[i].partStart]);
+	}
+}
+
+// same loop as the opaque passes, every thread draws its part of each range through its state cache
+static void RecordPart(PacketPath& _path, int _part)
+{
+	MockList& list = _path.lists[_part];
+	list.draws.clear();
+	CommandStateCache<MockList>& cache = _path.cache[_part];
+	cache.Begin(&list);
+
+	const vector<DrawPacket>& packets = _path.stream.GetPackets();
+	for (auto const& range : _path.stream.GetRanges())
+	{
+		int start = _path.bounds[range.partStart + _part];
+		int end = _path.bounds[range.partStart + _part + 1];
+		for (int i = start; i < end; i++)
+		{
+			const DrawPacket& dp = packets[i];
+			cache.IASetVertexBuffers(0, &dp.vbv);
+			cache.IASetIndexBuffer(&dp.ibv);
+			cache.SetGraphicsRootShaderResourceView(1, dp.instanceData);
+			cache.DrawIndexedInstanced(dp.indexCount, dp.instanceCount, dp.startIndex, dp.baseVertex, 0);
+		}
+	}
+}
+
+// draws of one queue from every part, in part order
+static void GatherQueue(const PacketPath& _path, int _numParts, int _queue, vector<DrawState>& _draws)
+{
+	for (int p = 0; p < _numParts; p++)
+	{
+		int drawIndex = 0;
+		for (auto const& range : _path.stream.GetRanges())
+		{
+			int count = _path.bounds[range.partStart + p + 1] - _path.bounds[range.partStart + p];
+			if (range.queue == _queue)
+			{
+				_draws.insert(_draws.end(), _path.lists[p].draws.begin() + drawIndex, _path.lists[p].draws.begin() + drawIndex + count);
+			}
+			drawIndex += count;
+		}
+	}
+}
+
+// every queue is one range holding the old draws of that queue in the old order, with the same bound state
+static void TestSameOrderAsOldPath()
+{
+	PacketPath path;
+	for (int round = 0; round < 50; round++)
+	{
+		map<int, deque<TestBatch>> scene;
+		BuildScene(scene, NextRandom(600));
+		int numParts = 1 + NextRandom(MAX_PARTS);
+
+		CollectSorted(scene, path.sorted);
+		CompilePackets(path, numParts);
+		for (int p = 0; p < numParts; p++)
+		{
+			RecordPart(path, p);
+		}
+
+		int lastQueue = -1;
+		int totalDraws = 0;
+		for (auto const& range : path.stream.GetRanges())
+		{
+			TEST_CHECK(range.queue > lastQueue);
+			TEST_CHECK(range.count > 0);
+			lastQueue = range.queue;
+
+			map<int, deque<TestBatch>> single;
+			single[range.queue] = scene[range.queue];
+			MockList oldList;
+			RecordOldPath(single, oldList);
+
+			vector<DrawState> newDraws;
+			GatherQueue(path, numParts, range.queue, newDraws);
+			TEST_CHECK(newDraws == oldList.draws);
+			totalDraws += (int)newDraws.size();
+		}
+
+		MockList oldList;
+		RecordOldPath(scene, oldList);
+		TEST_CHECK(totalDraws == (int)oldList.draws.size());
+	}
+}
+
+// once vectors have grown, compiling and recording a frame no bigger than earlier ones allocates nothing
+static void TestSteadyStateDoesNotAllocate()
+{
+	const int numParts = 4;
+	PacketPath path;
+
+	// warm up with the largest frame, every batch drawn
+	map<int, deque<TestBatch>> scene;
+	BuildScene(scene, 800);
+	for (auto& qr : scene)
+	{
+		for (auto& b : qr.second)
+		{
+			b.instanceCount = 1 + NextRandom(100);
+		}
+	}
+	CollectSorted(scene, path.sorted);
+	CompilePackets(path, numParts);
+	for (int p = 0; p < numParts; p++)
+	{
+		path.lists[p].draws.reserve(path.stream.GetPackets().size());
+		RecordPart(path, p);
+	}
+
+	for (int frame = 0; frame < 20; frame++)
+	{
+		// instance counts and data change between frames, the scene itself is prepared outside the measured part
+		for (auto& qr : scene)
+		{
+			for (auto& b : qr.second)
+			{
+				b.instanceCount = (NextRandom(10) == 0) ? 0 : 1 + NextRandom(100);
+				b.instanceData += 0x100;
+			}
+		}
+		CollectSorted(scene, path.sorted);
+
+		allocationCount = 0;
+		countAllocations = true;
+		CompilePackets(path, numParts);
+		for (int p = 0; p < numParts; p++)
+		{
+			RecordPart(path, p);
+		}
+		countAllocations = false;
+
+		TEST_CHECK(allocationCount == 0);
+	}
+
+	// and the counter does see allocations
+	countAllocations = true;
+	vector<int>* probe = new vector<int>(16);
+	countAllocations = false;
+	TEST_CHECK(allocationCount >= 2);
+	delete probe;
+}
+
+int main()
+{
+	InitResources();
+
+	TEST_RUN(TestSameOrderAsOldPath);
+	TEST_RUN(TestSteadyStateDoesNotAllocate);
+
+	return TestResult();
+}
@@ -0,0 +1,48 @@
+#include "TestUtility.h"
+#include "DrawPartition.h"
+#include <algorithm>
+
+// heaviest part against the fair share, for cost partition and for equal packet counts
+int main()
+{
+	const int count = 4000;
+	const int numParts = 8;
+	int iterations = BenchIterations(20000);
+
+	uint32_t seed = 5;
+	auto rand = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+	vector<double> prefix(count + 1, 0.0);
+	for (int i = 0; i < count; i++)
+	{
+		int instanceCount = (rand() % 50 == 0) ? 1 + rand() % 500 : 1;
+		prefix[i + 1] = prefix[i] + EstimateDrawCost(36 + rand() % 20000, instanceCount, rand() % 3 == 0);
+	}
+
+	int bounds[numParts + 1];
+	int sink = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		PartitionByCost(prefix, 0, count, numParts, bounds);
+		sink += bounds[n % numParts];
+	}
+	double partitionMs = ElapsedMs(start);
+
+	double fair = prefix[count] / numParts;
+	double costMax = 0.0;
+	double countMax = 0.0;
+	for (int k = 0; k < numParts; k++)
+	{
+		costMax = max(costMax, prefix[bounds[k + 1]] - prefix[bounds[k]]);
+		countMax = max(countMax, prefix[min(count, (k + 1) * count / numParts)] - prefix[k * count / numParts]);
+	}
+
+	printf("draws %d, parts %d, iterations %d\n", count, numParts, iterations);
+	printf("PartitionByCost: %.3f us\n", partitionMs * 1000.0 / iterations);
+	printf("heaviest part / fair share: by cost %.3f, by count %.3f\n", costMax / fair, countMax / fair);
+
+	TEST_CHECK(sink >= 0);
+	TEST_CHECK(costMax <= countMax);
+	return TestResult();
+}
@@ -0,0 +1,127 @@
+#include "TestUtility.h"
+#include "DrawPartition.h"
+#include <algorithm>
+
+static uint32_t randomState = 31337;
+static uint32_t NextRandom()
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return randomState >> 8;
+}
+
+// mostly small draws with a few heavy instanced batches
+static vector<double> RandomPrefixCost(int _count, double& _maxPacket)
+{
+	vector<double> prefix(_count + 1, 0.0);
+	_maxPacket = 0.0;
+	for (int i = 0; i < _count; i++)
+	{
+		unsigned int indexCount = 36 + NextRandom() % 20000;
+		int instanceCount = (NextRandom() % 50 == 0) ? 1 + NextRandom() % 500 : 1;
+		double cost = EstimateDrawCost(indexCount, instanceCount, NextRandom() % 3 == 0);
+
+		prefix[i + 1] = prefix[i] + cost;
+		_maxPacket = max(_maxPacket, cost);
+	}
+
+	return prefix;
+}
+
+// every packet in exactly one part, in order
+static void TestEveryDrawOnce()
+{
+	for (int round = 0; round < 500; round++)
+	{
+		int count = NextRandom() % 300;
+		double maxPacket;
+		vector<double> prefix = RandomPrefixCost(count, maxPacket);
+
+		int start = (count > 0) ? NextRandom() % (count + 1) : 0;
+		int end = start + ((count - start > 0) ? NextRandom() % (count - start + 1) : 0);
+		int numParts = 1 + NextRandom() % 16;
+
+		vector<int> bounds(numParts + 1, -1);
+		PartitionByCost(prefix, start, end, numParts, bounds.data());
+
+		TEST_CHECK(bounds[0] == start);
+		TEST_CHECK(bounds[numParts] == end);
+
+		vector<int> assigned(count, 0);
+		for (int k = 0; k < numParts; k++)
+		{
+			TEST_CHECK(bounds[k] <= bounds[k + 1]);
+			for (int i = bounds[k]; i < bounds[k + 1]; i++)
+			{
+				assigned[i]++;
+			}
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			bool inRange = (i >= start && i < end);
+			TEST_CHECK(assigned[i] == (inRange ? 1 : 0));
+		}
+	}
+}
+
+// no part is heavier than its fair share plus one packet
+static void TestBalanced()
+{
+	for (int round = 0; round < 200; round++)
+	{
+		int count = 1 + NextRandom() % 2000;
+		int numParts = 1 + NextRandom() % 16;
+		double maxPacket;
+		vector<double> prefix = RandomPrefixCost(count, maxPacket);
+
+		vector<int> bounds(numParts + 1);
+		PartitionByCost(prefix, 0, count, numParts, bounds.data());
+
+		double fair = prefix[count] / numParts;
+		for (int k = 0; k < numParts; k++)
+		{
+			double partCost = prefix[bounds[k + 1]] - prefix[bounds[k]];
+			TEST_CHECK(partCost <= fair + maxPacket + 1e-9);
+		}
+	}
+}
+
+// one batch costs as much as all the others together, it gets a part of its own
+static void TestHeavyBatch()
+{
+	vector<double> prefix(9, 0.0);
+	for (int i = 0; i < 8; i++)
+	{
+		prefix[i + 1] = prefix[i] + ((i == 3) ? 7.0 : 1.0);
+	}
+
+	int bounds[3];
+	PartitionByCost(prefix, 0, 8, 2, bounds);
+	TEST_CHECK(bounds[1] == 3 || bounds[1] == 4);
+}
+
+// more parts than packets leaves some parts empty
+static void TestMorePartsThanDraws()
+{
+	vector<double> prefix = { 0.0, 1.0, 2.0 };
+	int bounds[9];
+	PartitionByCost(prefix, 0, 2, 8, bounds);
+
+	int nonEmpty = 0;
+	for (int k = 0; k < 8; k++)
+	{
+		TEST_CHECK(bounds[k] <= bounds[k + 1]);
+		nonEmpty += (bounds[k + 1] > bounds[k]) ? 1 : 0;
+	}
+	TEST_CHECK(nonEmpty == 2);
+}
+
+int main()
+{
+	TEST_RUN(TestEveryDrawOnce);
+	TEST_RUN(TestBalanced);
+	TEST_RUN(TestHeavyBatch);
+	TEST_RUN(TestMorePartsThanDraws);
+
+	return TestResult();
+}
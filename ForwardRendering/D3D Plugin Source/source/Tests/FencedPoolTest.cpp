@@ -0,0 +1,189 @@
+#include "TestUtility.h"
+#include "FencedPool.h"
+#include <atomic>
+#include <thread>
+
+// stands in for an allocator/list pair, counts how many are alive
+static atomic<int> aliveCount{ 0 };
+struct MockCommand
+{
+	MockCommand() { aliveCount++; }
+	~MockCommand() { aliveCount--; }
+
+	bool inUse = false;
+};
+
+static MockCommand* CreateMock()
+{
+	return new MockCommand();
+}
+
+// recycled object comes back only after gpu completes its fence
+static void TestRecycleWaitsForFence()
+{
+	FencedPool<MockCommand> pool;
+	pool.Init(CreateMock, 100);
+
+	MockCommand* a = pool.Acquire(0);
+	TEST_CHECK(a != nullptr);
+	pool.Recycle(a, 5);
+
+	// fence 5 not reached yet, a new one is created
+	MockCommand* b = pool.Acquire(4);
+	TEST_CHECK(b != nullptr && b != a);
+	TEST_CHECK(pool.GetCount() == 2);
+
+	// now a is free again
+	MockCommand* c = pool.Acquire(5);
+	TEST_CHECK(c == a);
+	TEST_CHECK(pool.GetCount() == 2);
+
+	pool.Recycle(b, 6);
+	pool.Recycle(c, 6);
+	pool.Clear();
+	TEST_CHECK(aliveCount.load() == 0);
+}
+
+// after a busy window, free objects above the next window's peak are destroyed
+static void TestTrimToHighWater()
+{
+	const int trimFrames = 4;
+	FencedPool<MockCommand> pool;
+	pool.Init(CreateMock, trimFrames);
+
+	uint64_t fence = 0;
+	vector<MockCommand*> used;
+
+	// busy frames need 8 objects
+	for (int frame = 0; frame < trimFrames; frame++)
+	{
+		fence++;
+		for (int i = 0; i < 8; i++)
+		{
+			used.push_back(pool.Acquire(fence - 1));
+		}
+		for (auto u : used)
+		{
+			pool.Recycle(u, fence);
+		}
+		used.clear();
+		pool.EndFrame(fence);
+	}
+	TEST_CHECK(pool.GetCount() == 8);
+
+	// quiet window needs 2, everything above is trimmed at its end
+	for (int frame = 0; frame < trimFrames; frame++)
+	{
+		fence++;
+		for (int i = 0; i < 2; i++)
+		{
+			used.push_back(pool.Acquire(fence - 1));
+		}
+		for (auto u : used)
+		{
+			pool.Recycle(u, fence);
+		}
+		used.clear();
+		pool.EndFrame(fence);
+	}
+	TEST_CHECK(pool.GetCount() == 2);
+	TEST_CHECK(aliveCount.load() == 2);
+
+	pool.Clear();
+	TEST_CHECK(aliveCount.load() == 0);
+}
+
+// objects still in use or waiting for gpu are never trimmed
+static void TestTrimKeepsBusyObjects()
+{
+	FencedPool<MockCommand> pool;
+	pool.Init(CreateMock, 1);
+
+	MockCommand* held = pool.Acquire(0);
+	MockCommand* pending = pool.Acquire(0);
+	pool.Recycle(pending, 10);
+
+	pool.EndFrame(5);
+	pool.EndFrame(5);
+	TEST_CHECK(pool.GetCount() == 2);
+
+	// pending is free once fence 10 completes and nothing needed it in that window
+	pool.EndFrame(10);
+	TEST_CHECK(pool.GetCount() == 1);
+	TEST_CHECK(pool.Acquire(10) != held);
+
+	pool.Clear();
+}
+
+static void TestCreateFails()
+{
+	FencedPool<MockCommand> pool;
+	pool.Init([]() -> MockCommand* { return nullptr; }, 1);
+	TEST_CHECK(pool.Acquire(0) == nullptr);
+	TEST_CHECK(pool.GetCount() == 0);
+}
+
+// several recording threads acquire and recycle while render thread advances the fence
+static void TestThreads()
+{
+	FencedPool<MockCommand> pool;
+	pool.Init(CreateMock, 8);
+
+	atomic<uint64_t> completed{ 0 };
+	atomic<bool> doubleUse{ false };
+	vector<thread> threads;
+
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			for (int i = 0; i < 2000; i++)
+			{
+				uint64_t done = completed.load();
+				MockCommand* cmd = pool.Acquire(done);
+				if (cmd == nullptr)
+				{
+					continue;
+				}
+
+				if (cmd->inUse)
+				{
+					doubleUse = true;
+				}
+				cmd->inUse = true;
+				this_thread::yield();
+				cmd->inUse = false;
+
+				pool.Recycle(cmd, done + 1);
+			}
+		});
+	}
+
+	for (int frame = 0; frame < 200; frame++)
+	{
+		completed++;
+		pool.EndFrame(completed.load());
+		this_thread::yield();
+	}
+
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	TEST_CHECK(!doubleUse.load());
+	TEST_CHECK(pool.GetCount() == aliveCount.load());
+	pool.Clear();
+	TEST_CHECK(aliveCount.load() == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestRecycleWaitsForFence);
+	TEST_RUN(TestTrimToHighWater);
+	TEST_RUN(TestTrimKeepsBusyObjects);
+	TEST_RUN(TestCreateFails);
+	TEST_RUN(TestThreads);
+
+	return TestResult();
+}
@@ -0,0 +1,197 @@
+#include "TestUtility.h"
+#include "FrameStatistics.h"
+
+// per-slot, per-pass counters add up to pass, thread and frame totals, export lists the non-empty ones
+static void TestMergeAndExport()
+{
+	FrameStatistics& stat = FrameStatistics::Instance();
+	stat.Reset();
+
+	// main thread and two workers, worker 3 stays idle
+	stat.Add(0, StatUpload, StatUploadBytes, 4096);
+	stat.Add(0, StatOther, StatBarriers, 4);
+	stat.Add(1, StatOpaque, StatDraws, 10);
+	stat.Add(1, StatOpaque, StatInstances, 100);
+	stat.Add(1, StatOpaque, StatTriangles, 5000);
+	stat.Add(1, StatPrePass, StatDraws, 10);
+	stat.Add(2, StatOpaque, StatDraws, 6);
+	stat.Add(2, StatOpaque, StatPsoSwitches, 2);
+	stat.Add(2, StatTransparent, StatDraws, 3);
+	stat.Add(2, StatTransparent, StatRootParameters, 9);
+	stat.Add(2, StatTransparent, StatDescriptorTables, 5);
+
+	// out of range slots are ignored
+	stat.Add(-1, StatOpaque, StatDraws, 1000);
+	stat.Add(FrameStatistics::MAX_STAT_THREAD_COUNT, StatOpaque, StatDraws, 1000);
+	stat.Merge();
+
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatDraws] == 16);
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatInstances] == 100);
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatPsoSwitches] == 2);
+	TEST_CHECK(stat.GetPassTotal(StatPrePass).counter[StatDraws] == 10);
+	TEST_CHECK(stat.GetPassTotal(StatTransparent).counter[StatRootParameters] == 9);
+	TEST_CHECK(stat.GetPassTotal(StatUpload).counter[StatUploadBytes] == 4096);
+	TEST_CHECK(stat.GetPassTotal(StatCutoff).counter[StatDraws] == 0);
+
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatUploadBytes] == 4096);
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatBarriers] == 4);
+	TEST_CHECK(stat.GetThreadTotal(1).counter[StatDraws] == 20);
+	TEST_CHECK(stat.GetThreadTotal(2).counter[StatDraws] == 9);
+	TEST_CHECK(stat.GetThreadTotal(3).counter[StatDraws] == 0);
+
+	TEST_CHECK(stat.GetFrameTotal().counter[StatDraws] == 29);
+	TEST_CHECK(stat.GetFrameTotal().counter[StatTriangles] == 5000);
+	TEST_CHECK(stat.GetFrameTotal().counter[StatDescriptorTables] == 5);
+
+	string expected = "-------------- Frame Statistics --------------\n"
+		"Frame: Draw 29, Inst 100, Tri 5000, PSO 2, Root 9, Table 5, Barrier 4, Upload(KB) 4\n"
+		"PrePass: Draw 10, Inst 0, Tri 0, PSO 0, Root 0, Table 0, Barrier 0, Upload(KB) 0\n"
+		"Opaque: Draw 16, Inst 100, Tri 5000, PSO 2, Root 0, Table 0, Barrier 0, Upload(KB) 0\n"
+		"Transparent: Draw 3, Inst 0, Tri 0, PSO 0, Root 9, Table 5, Barrier 0, Upload(KB) 0\n"
+		"Upload: Draw 0, Inst 0, Tri 0, PSO 0, Root 0, Table 0, Barrier 0, Upload(KB) 4\n"
+		"Other: Draw 0, Inst 0, Tri 0, PSO 0, Root 0, Table 0, Barrier 4, Upload(KB) 0\n"
+		"\tMain: Draw 0, Inst 0, Tri 0, PSO 0, Root 0, Table 0, Barrier 4, Upload(KB) 4\n"
+		"\tWorker 0: Draw 20, Inst 100, Tri 5000, PSO 0, Root 0, Table 0, Barrier 0, Upload(KB) 0\n"
+		"\tWorker 1: Draw 9, Inst 0, Tri 0, PSO 2, Root 9, Table 5, Barrier 0, Upload(KB) 0\n";
+	TEST_CHECK(stat.Export() == expected);
+
+	// merge rebuilds totals, a second merge doesn't double them
+	stat.Merge();
+	TEST_CHECK(stat.GetFrameTotal().counter[StatDraws] == 29);
+
+	stat.Reset();
+	stat.Merge();
+	TEST_CHECK(stat.GetFrameTotal().counter[StatDraws] == 0);
+}
+
+// nested scopes restore the outer pass, counters of the calling thread follow it
+static void TestPassScope()
+{
+	FrameStatistics& stat = FrameStatistics::Instance();
+	stat.Reset();
+
+	TEST_CHECK(FrameStatistics::GetCurrentPass() == StatOther);
+	{
+		StatPassScope opaque(StatOpaque);
+		stat.AddDraw(2, 20);
+		{
+			StatPassScope upload(StatUpload);
+			stat.Add(StatUploadBytes, 1024);
+		}
+		TEST_CHECK(FrameStatistics::GetCurrentPass() == StatOpaque);
+		stat.AddDraw(1, 10);
+	}
+	TEST_CHECK(FrameStatistics::GetCurrentPass() == StatOther);
+	stat.Add(StatBarriers, 1);
+	stat.Merge();
+
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatDraws] == 2);
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatInstances] == 3);
+	TEST_CHECK(stat.GetPassTotal(StatOpaque).counter[StatTriangles] == 30);
+	TEST_CHECK(stat.GetPassTotal(StatUpload).counter[StatUploadBytes] == 1024);
+	TEST_CHECK(stat.GetPassTotal(StatOther).counter[StatBarriers] == 1);
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatDraws] == 2);
+}
+
+// a job keeps the pass of the place it was dispatched from, also when it is stolen by a thread
+// that waits inside another pass, and a worker job counts to that worker's slot
+static void TestStolenJobKeepsPass()
+{
+	FrameStatistics& stat = FrameStatistics::Instance();
+	JobSystem jobSystem;
+	jobSystem.Init(1);
+
+	stat.Reset();
+
+	// keep the only worker busy, so the main thread runs the next jobs while it waits
+	atomic<bool> blockerStarted{ false };
+	atomic<bool> release{ false };
+	JobCounter blockerCounter;
+	JobSystem::JobFunc blocker = [&](int)
+	{
+		blockerStarted = true;
+		while (!release)
+		{
+			this_thread::yield();
+		}
+		FrameStatistics::Instance().Add(StatDraws, 1);
+	};
+	{
+		StatPassScope cutoff(StatCutoff);
+		jobSystem.Dispatch(1, blocker, blockerCounter);
+	}
+	while (!blockerStarted)
+	{
+		this_thread::yield();
+	}
+
+	// dispatched outside any pass, like BeginFrame
+	JobCounter otherCounter;
+	JobSystem::JobFunc otherJob = [&](int) { FrameStatistics::Instance().Add(StatBarriers, 1); };
+	jobSystem.Dispatch(1, otherJob, otherCounter);
+
+	{
+		StatPassScope upload(StatUpload);
+
+		JobCounter uploadCounter;
+		JobSystem::JobFunc uploadJob = [&](int)
+		{
+			FrameStatistics::Instance().Add(StatUploadBytes, 2048);
+			release = true;
+		};
+		jobSystem.Dispatch(1, uploadJob, uploadCounter);
+
+		// oldest job is stolen first, so this runs otherJob inside the upload scope, then uploadJob
+		jobSystem.Wait(uploadCounter);
+		TEST_CHECK(FrameStatistics::GetCurrentPass() == StatUpload);
+	}
+
+	jobSystem.Wait(otherCounter);
+	jobSystem.Wait(blockerCounter);
+	jobSystem.Release();
+	stat.Merge();
+
+	TEST_CHECK(stat.GetPassTotal(StatOther).counter[StatBarriers] == 1);
+	TEST_CHECK(stat.GetPassTotal(StatUpload).counter[StatBarriers] == 0);
+	TEST_CHECK(stat.GetPassTotal(StatUpload).counter[StatUploadBytes] == 2048);
+	TEST_CHECK(stat.GetPassTotal(StatCutoff).counter[StatDraws] == 1);
+
+	// main thread ran both stolen jobs, worker 0 ran the blocker
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatBarriers] == 1);
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatUploadBytes] == 2048);
+	TEST_CHECK(stat.GetThreadTotal(1).counter[StatDraws] == 1);
+}
+
+// only the thread that reset the frame owns slot 0, other outside threads are dropped instead of racing on it
+static void TestOutsideThreadHasNoSlot()
+{
+	FrameStatistics& stat = FrameStatistics::Instance();
+	stat.Reset();
+	TEST_CHECK(stat.GetCurrentSlot() == 0);
+
+	int otherSlot = 0;
+	thread other([&]()
+	{
+		otherSlot = FrameStatistics::Instance().GetCurrentSlot();
+		FrameStatistics::Instance().Add(StatDraws, 100);
+		FrameStatistics::Instance().AddDraw(100, 100);
+	});
+	other.join();
+
+	stat.Add(StatDraws, 1);
+	stat.Merge();
+
+	TEST_CHECK(otherSlot == -1);
+	TEST_CHECK(stat.GetFrameTotal().counter[StatDraws] == 1);
+	TEST_CHECK(stat.GetThreadTotal(0).counter[StatDraws] == 1);
+}
+
+int main()
+{
+	TEST_RUN(TestMergeAndExport);
+	TEST_RUN(TestPassScope);
+	TEST_RUN(TestStolenJobKeepsPass);
+	TEST_RUN(TestOutsideThreadHasNoSlot);
+
+	return TestResult();
+}
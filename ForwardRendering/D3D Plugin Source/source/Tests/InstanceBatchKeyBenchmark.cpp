@@ -0,0 +1,170 @@
+#include "TestUtility.h"
+#include "InstanceBatchKey.h"
+#include <vector>
+#include <map>
+#include <unordered_map>
+using namespace std;
+
+static const int RENDERER_COUNT = 50000;
+static const int MESH_COUNT = 400;
+
+// material variants a submesh of one mesh is placed with
+static const int VARIANT_COUNT = 2;
+
+static uint32_t randomState = 5;
+static int NextRandom(int _count)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (int)((randomState >> 8) % (uint32_t)_count);
+}
+
+struct MeshStub
+{
+	int instanceID;
+};
+
+// what grouping reads from InstanceRenderer, mesh is reached through a pointer like there
+struct BatchStub
+{
+	MeshStub* mesh;
+	int submeshIndex;
+	int materialID;
+};
+
+struct RendererStub
+{
+	MeshStub* mesh;
+	int materialIDs[3];
+	int queues[3];
+	int numMaterials;
+};
+
+// linear scan of FindInstanceRenderer before the key table, same compare as InstanceRenderer::operator==
+static int FindByScan(map<int, vector<BatchStub>>& _batches, int _queue, const BatchStub& _ir)
+{
+	vector<BatchStub>& list = _batches[_queue];
+	for (int i = 0; i < (int)list.size(); i++)
+	{
+		if (_ir.mesh->instanceID == list[i].mesh->instanceID
+			&& _ir.submeshIndex == list[i].submeshIndex
+			&& _ir.materialID == list[i].materialID)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static InstanceBatchKey MakeKey(int _queue, const BatchStub& _ir)
+{
+	InstanceBatchKey key;
+	key.meshID = _ir.mesh->instanceID;
+	key.submeshIndex = _ir.submeshIndex;
+	key.materialID = _ir.materialID;
+	key.queue = _queue;
+
+	return key;
+}
+
+// grouping 50k renderers into instance batches each frame, linear scan against the hashed key table
+int main()
+{
+	int iterations = BenchIterations(10);
+
+	vector<MeshStub> meshes(MESH_COUNT);
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		meshes[i].instanceID = 1000 + i * 7;
+	}
+
+	// opaque and alpha test queues, a few materials per renderer picked from the variants of its mesh
+	const int queues[2] = { 2000, 2450 };
+	vector<RendererStub> renderers(RENDERER_COUNT);
+	for (auto& r : renderers)
+	{
+		int meshIndex = NextRandom(MESH_COUNT);
+		r.mesh = &meshes[meshIndex];
+		r.numMaterials = 1 + meshIndex % 3;
+		for (int i = 0; i < r.numMaterials; i++)
+		{
+			int variant = NextRandom(VARIANT_COUNT);
+			r.materialIDs[i] = 50000 + (meshIndex * 3 + i) * VARIANT_COUNT + variant;
+			r.queues[i] = queues[(meshIndex + variant) % 8 == 0 ? 1 : 0];
+		}
+	}
+
+	// batches are created in renderer order by both, so their indices match
+	map<int, vector<BatchStub>> scanBatches;
+	unordered_map<InstanceBatchKey, int, InstanceBatchKeyHash> batchIndex;
+	map<int, int> queueBatchCount;
+	for (auto& r : renderers)
+	{
+		for (int i = 0; i < r.numMaterials; i++)
+		{
+			BatchStub ir = { r.mesh, i, r.materialIDs[i] };
+			if (FindByScan(scanBatches, r.queues[i], ir) == -1)
+			{
+				scanBatches[r.queues[i]].push_back(ir);
+				batchIndex[MakeKey(r.queues[i], ir)] = queueBatchCount[r.queues[i]]++;
+			}
+		}
+	}
+
+	int batchCount = 0;
+	for (auto& q : scanBatches)
+	{
+		batchCount += (int)q.second.size();
+	}
+
+	vector<int> scanResult, hashResult;
+	scanResult.reserve(RENDERER_COUNT * 3);
+	hashResult.reserve(RENDERER_COUNT * 3);
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		scanResult.clear();
+		for (auto& r : renderers)
+		{
+			for (int i = 0; i < r.numMaterials; i++)
+			{
+				BatchStub ir = { r.mesh, i, r.materialIDs[i] };
+				scanResult.push_back(FindByScan(scanBatches, r.queues[i], ir));
+			}
+		}
+	}
+	double scanMs = ElapsedMs(start);
+
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		hashResult.clear();
+		for (auto& r : renderers)
+		{
+			for (int i = 0; i < r.numMaterials; i++)
+			{
+				BatchStub ir = { r.mesh, i, r.materialIDs[i] };
+				auto it = batchIndex.find(MakeKey(r.queues[i], ir));
+				hashResult.push_back(it == batchIndex.end() ? -1 : it->second);
+			}
+		}
+	}
+	double hashMs = ElapsedMs(start);
+
+	printf("renderers %d, batches %d, lookups %d, iterations %d\n", RENDERER_COUNT, batchCount, (int)hashResult.size(), iterations);
+	printf("linear scan: %.3f ms, key table: %.3f ms per frame\n", scanMs / iterations, hashMs / iterations);
+
+	TEST_CHECK(scanResult == hashResult);
+	TEST_CHECK((int)batchIndex.size() == batchCount);
+
+	// every renderer found a batch
+	int missCount = 0;
+	for (int b : hashResult)
+	{
+		missCount += (b == -1) ? 1 : 0;
+	}
+	TEST_CHECK(missCount == 0);
+
+	return TestResult();
+}
@@ -0,0 +1,516 @@
+#include "TestUtility.h"
+#include "InstanceSlotTable.h"
+#include <algorithm>
+
+static const int FRAME_COUNT = 2;
+static const int LOD_COUNT = 2;
+
+// world versions and dirty lists of renderers, like RendererPool
+struct TestScene
+{
+	vector<uint32_t> versions;
+	vector<bool> visible;
+	WorldDirtyList<FRAME_COUNT> dirty;
+
+	explicit TestScene(int _count)
+	{
+		for (int i = 0; i < _count; i++)
+		{
+			versions.push_back(1);
+			visible.push_back(true);
+			dirty.Add();
+		}
+	}
+
+	void Move(int _id)
+	{
+		versions[_id]++;
+		dirty.Mark(_id);
+	}
+
+	// same as RendererManager::FinishUploadInstanceData
+	void FinishUpload(int _frameIdx)
+	{
+		dirty.Clear(_frameIdx, [this](int _id) { return (bool)visible[_id]; });
+	}
+};
+
+// one lod batch, a slot table and a fake instance buffer for each frame
+struct TestBatch
+{
+	InstanceSlotTable table[FRAME_COUNT];
+	vector<int> bufferID[FRAME_COUNT];
+	vector<uint32_t> bufferVersion[FRAME_COUNT];
+	vector<int> instanceIDs;
+	vector<int> writeSlots;
+
+	void Reset(int _capacity)
+	{
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			table[i].Reset(_capacity);
+			bufferID[i].assign(_capacity, -1);
+			bufferVersion[i].assign(_capacity, 0);
+		}
+	}
+
+	void Clear()
+	{
+		instanceIDs.clear();
+		writeSlots.clear();
+	}
+
+	// same as InstanceRenderer::AddInstance
+	void Collect(int _id, int _frameIdx, const TestScene& _scene)
+	{
+		int slot = (int)instanceIDs.size();
+		instanceIDs.push_back(_id);
+		if (slot < table[_frameIdx].GetCapacity() && table[_frameIdx].NeedsWrite(slot, _id, _scene.dirty.IsDirty(_id, _frameIdx)))
+		{
+			writeSlots.push_back(slot);
+		}
+	}
+
+	// same loop as InstanceRenderer::UploadInstanceData
+	int Upload(int _frameIdx, const TestScene& _scene)
+	{
+		int writeCount = 0;
+		for (int slot : writeSlots)
+		{
+			int id = instanceIDs[slot];
+			if (!table[_frameIdx].Claim(slot, id, _scene.versions[id]))
+			{
+				continue;
+			}
+
+			bufferID[_frameIdx][slot] = id;
+			bufferVersion[_frameIdx][slot] = _scene.versions[id];
+			writeCount++;
+		}
+
+		return writeCount;
+	}
+
+	// every drawn slot must hold current world of its renderer
+	bool IsUpToDate(int _frameIdx, const TestScene& _scene)
+	{
+		for (int i = 0; i < (int)instanceIDs.size(); i++)
+		{
+			int id = instanceIDs[i];
+			if (bufferID[_frameIdx][i] != id || bufferVersion[_frameIdx][i] != _scene.versions[id])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+// collect, upload and clear one frame of a single batch holding _ids
+static int RunFrame(TestBatch& _batch, TestScene& _scene, const vector<int>& _ids, int _frameIdx)
+{
+	_batch.Clear();
+	for (int id : _ids)
+	{
+		_batch.Collect(id, _frameIdx, _scene);
+	}
+
+	int writeCount = _batch.Upload(_frameIdx, _scene);
+	_scene.FinishUpload(_frameIdx);
+
+	return writeCount;
+}
+
+// renderer leaves a lod batch, keeps moving, then comes back to the same slot
+static void TestLodSwitchWhileMoving()
+{
+	TestBatch batches[LOD_COUNT];
+	for (int i = 0; i < LOD_COUNT; i++)
+	{
+		batches[i].Reset(4);
+	}
+
+	TestScene scene(1);
+	bool upToDate = true;
+	int lastLod = 0;
+
+	for (int frame = 0; frame < 200; frame++)
+	{
+		int frameIdx = frame % FRAME_COUNT;
+
+		// lod flips every 3 frames, renderer moves only while it is in lod 1 batch
+		// so its move is uploaded elsewhere and lod 0 slot still has the same owner when it comes back
+		int lod = (frame / 3) % LOD_COUNT;
+		if (lod == 1)
+		{
+			scene.Move(0);
+		}
+
+		// lod change marks the renderer dirty, like RendererManager::SortWork
+		if (lod != lastLod)
+		{
+			scene.Move(0);
+			lastLod = lod;
+		}
+
+		for (int i = 0; i < LOD_COUNT; i++)
+		{
+			batches[i].Clear();
+		}
+		batches[lod].Collect(0, frameIdx, scene);
+
+		batches[lod].Upload(frameIdx, scene);
+		scene.FinishUpload(frameIdx);
+		upToDate &= batches[lod].IsUpToDate(frameIdx, scene);
+	}
+
+	TEST_CHECK(upToDate);
+}
+
+// renderer shifts to an earlier slot when the one before it hides, moves there, then shifts back
+// its old slot still names it as owner unless the move out released it
+static void TestSlotShiftWhileMoving()
+{
+	TestBatch batch;
+	batch.Reset(4);
+	TestScene scene(2);
+	vector<int> both = { 0, 1 };
+	vector<int> onlySecond = { 1 };
+
+	RunFrame(batch, scene, both, 0);
+	RunFrame(batch, scene, both, 1);
+
+	scene.visible[0] = false;
+	scene.Move(1);
+	RunFrame(batch, scene, onlySecond, 0);
+	RunFrame(batch, scene, onlySecond, 1);
+	TEST_CHECK(!scene.dirty.IsDirty(1, 0));
+
+	scene.visible[0] = true;
+	TEST_CHECK(RunFrame(batch, scene, both, 0) == 2);
+	TEST_CHECK(batch.IsUpToDate(0, scene));
+	TEST_CHECK(RunFrame(batch, scene, both, 1) == 2);
+	TEST_CHECK(batch.IsUpToDate(1, scene));
+}
+
+// many renderers with random lod, movement and visibility against a full rewrite every frame
+static void TestRandomScene()
+{
+	const int rendererCount = 64;
+	TestBatch batches[LOD_COUNT];
+	for (int i = 0; i < LOD_COUNT; i++)
+	{
+		batches[i].Reset(rendererCount);
+	}
+
+	// reference buffers rewrite every drawn slot every frame, like the upload before dirty tracking
+	vector<int> fullID[LOD_COUNT][FRAME_COUNT];
+	vector<uint32_t> fullVersion[LOD_COUNT][FRAME_COUNT];
+	for (int i = 0; i < LOD_COUNT; i++)
+	{
+		for (int f = 0; f < FRAME_COUNT; f++)
+		{
+			fullID[i][f].assign(rendererCount, -1);
+			fullVersion[i][f].assign(rendererCount, 0);
+		}
+	}
+
+	TestScene scene(rendererCount);
+	vector<int> lods(rendererCount, 0);
+	uint32_t seed = 12345;
+	auto rand = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+	bool upToDate = true;
+	bool matchesFull = true;
+	int dirtyWrites = 0;
+	int fullWrites = 0;
+	for (int frame = 0; frame < 500; frame++)
+	{
+		int frameIdx = frame % FRAME_COUNT;
+		for (int i = 0; i < LOD_COUNT; i++)
+		{
+			batches[i].Clear();
+		}
+
+		for (int id = 0; id < rendererCount; id++)
+		{
+			if (rand() % 4 == 0)
+			{
+				scene.Move(id);
+			}
+
+			if (rand() % 8 == 0)
+			{
+				lods[id] = (lods[id] + 1) % LOD_COUNT;
+				scene.Move(id);
+			}
+
+			scene.visible[id] = (rand() % 5 != 0);
+			if (scene.visible[id])
+			{
+				batches[lods[id]].Collect(id, frameIdx, scene);
+			}
+		}
+
+		for (int i = 0; i < LOD_COUNT; i++)
+		{
+			dirtyWrites += batches[i].Upload(frameIdx, scene);
+			upToDate &= batches[i].IsUpToDate(frameIdx, scene);
+
+			const vector<int>& ids = batches[i].instanceIDs;
+			for (int slot = 0; slot < (int)ids.size(); slot++)
+			{
+				fullID[i][frameIdx][slot] = ids[slot];
+				fullVersion[i][frameIdx][slot] = scene.versions[ids[slot]];
+				fullWrites++;
+
+				matchesFull &= (batches[i].bufferID[frameIdx][slot] == fullID[i][frameIdx][slot]);
+				matchesFull &= (batches[i].bufferVersion[frameIdx][slot] == fullVersion[i][frameIdx][slot]);
+			}
+		}
+		scene.FinishUpload(frameIdx);
+	}
+
+	TEST_CHECK(upToDate);
+	TEST_CHECK(matchesFull);
+	TEST_CHECK(dirtyWrites < fullWrites);
+	printf("random scene: %d dirty writes, %d full rewrite writes\n", dirtyWrites, fullWrites);
+}
+
+// static scene writes each slot once per frame buffer, then nothing
+static void TestStaticSceneWritesOnce()
+{
+	TestBatch batch;
+	batch.Reset(8);
+	TestScene scene(8);
+	vector<int> ids;
+	for (int id = 0; id < 8; id++)
+	{
+		ids.push_back(id);
+	}
+
+	TEST_CHECK(RunFrame(batch, scene, ids, 0) == 8);
+	TEST_CHECK(RunFrame(batch, scene, ids, 1) == 8);
+	TEST_CHECK(RunFrame(batch, scene, ids, 0) == 0);
+	TEST_CHECK(batch.writeSlots.empty());
+	TEST_CHECK(RunFrame(batch, scene, ids, 1) == 0);
+
+	// one renderer moves, one slot per frame buffer is rewritten
+	scene.Move(5);
+	TEST_CHECK(RunFrame(batch, scene, ids, 0) == 1);
+	TEST_CHECK(RunFrame(batch, scene, ids, 1) == 1);
+
+	// recreated buffer forgets every slot
+	batch.Reset(8);
+	TEST_CHECK(RunFrame(batch, scene, ids, 0) == 8);
+}
+
+// K of N renderers move each frame, upload visits and writes exactly K slots and the dirty lists hold only them
+static void TestOnlyChangedSlotsWritten()
+{
+	const int rendererCount = 10000;
+	const int moveCount = 37;
+	TestBatch batch;
+	batch.Reset(rendererCount);
+	TestScene scene(rendererCount);
+
+	vector<int> ids;
+	for (int id = 0; id < rendererCount; id++)
+	{
+		ids.push_back(id);
+	}
+
+	// first frame of each buffer writes everything
+	TEST_CHECK(RunFrame(batch, scene, ids, 0) == rendererCount);
+	TEST_CHECK(RunFrame(batch, scene, ids, 1) == rendererCount);
+	TEST_CHECK(scene.dirty.GetList(0).empty());
+	TEST_CHECK(scene.dirty.GetList(1).empty());
+
+	uint32_t seed = 99;
+	auto rand = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+	bool exact = true;
+	bool upToDate = true;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		int frameIdx = frame % FRAME_COUNT;
+
+		// K distinct renderers, moving one twice doesn't list it twice
+		vector<int> moved;
+		while ((int)moved.size() < moveCount)
+		{
+			int id = (int)(rand() % rendererCount);
+			if (find(moved.begin(), moved.end(), id) == moved.end())
+			{
+				moved.push_back(id);
+			}
+		}
+		for (int id : moved)
+		{
+			scene.Move(id);
+			scene.Move(id);
+		}
+
+		// buffer of this frame also missed the renderers moved last frame
+		int expected = (int)scene.dirty.GetList(frameIdx).size();
+		exact &= (frame == 0) ? (expected == moveCount) : (expected >= moveCount && expected <= 2 * moveCount);
+
+		int writeCount = RunFrame(batch, scene, ids, frameIdx);
+		exact &= (writeCount == expected);
+		exact &= ((int)batch.writeSlots.size() == expected);
+		upToDate &= batch.IsUpToDate(frameIdx, scene);
+	}
+
+	TEST_CHECK(exact);
+	TEST_CHECK(upToDate);
+}
+
+// invisible renderers stay dirty until a frame uploads them
+static void TestHiddenRendererStaysDirty()
+{
+	TestBatch batch;
+	batch.Reset(4);
+	TestScene scene(2);
+	vector<int> both = { 0, 1 };
+	vector<int> onlyFirst = { 0 };
+
+	RunFrame(batch, scene, both, 0);
+	RunFrame(batch, scene, both, 1);
+
+	// renderer 1 moves while hidden for two frames
+	scene.Move(1);
+	scene.visible[1] = false;
+	TEST_CHECK(RunFrame(batch, scene, onlyFirst, 0) == 0);
+	TEST_CHECK(RunFrame(batch, scene, onlyFirst, 1) == 0);
+	TEST_CHECK(scene.dirty.IsDirty(1, 0));
+	TEST_CHECK(scene.dirty.IsDirty(1, 1));
+
+	// its old slot is still owned by it, only the dirty bit gets it rewritten
+	scene.visible[1] = true;
+	TEST_CHECK(RunFrame(batch, scene, both, 0) == 1);
+	TEST_CHECK(batch.IsUpToDate(0, scene));
+	TEST_CHECK(!scene.dirty.IsDirty(1, 0));
+	TEST_CHECK(scene.dirty.IsDirty(1, 1));
+}
+
+// adding renderers one by one reallocates only a logarithmic number of times
+static void TestCapacityGrowsGeometrically()
+{
+	int capacity = 0;
+	int growCount = 0;
+	for (int members = 1; members <= 10000; members++)
+	{
+		int fit = FitInstanceCapacity(capacity, members);
+		TEST_CHECK(fit >= members);
+		TEST_CHECK(fit >= INSTANCE_MIN_CAPACITY);
+
+		growCount += (fit != capacity) ? 1 : 0;
+		capacity = fit;
+	}
+
+	// 16, 32, ..., 16384
+	TEST_CHECK(growCount == 11);
+}
+
+// adding and removing around one size never reallocates
+static void TestCapacityDoesNotThrash()
+{
+	int capacity = FitInstanceCapacity(0, 100);
+	int reallocCount = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		int members = (i % 2 == 0) ? 100 : 40;
+		int fit = FitInstanceCapacity(capacity, members);
+		reallocCount += (fit != capacity) ? 1 : 0;
+		capacity = fit;
+	}
+
+	TEST_CHECK(reallocCount == 0);
+}
+
+// a mostly empty batch shrinks, but not below the minimum
+static void TestCapacityShrinks()
+{
+	TEST_CHECK(FitInstanceCapacity(1024, 100) == 200);
+	TEST_CHECK(FitInstanceCapacity(1024, 300) == 1024);
+	TEST_CHECK(FitInstanceCapacity(64, 0) == INSTANCE_MIN_CAPACITY);
+	TEST_CHECK(FitInstanceCapacity(INSTANCE_MIN_CAPACITY, 0) == INSTANCE_MIN_CAPACITY);
+}
+
+// renderers stream in and out of a batch, buffers are recreated when capacity changes like InstanceRenderer::FitCapacity
+static void TestStreamingBatch()
+{
+	const int rendererCount = 4096;
+	TestBatch batch;
+	TestScene scene(rendererCount);
+	int capacity = 0;
+	vector<int> members;
+	uint32_t seed = 777;
+	auto rand = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+	bool fits = true;
+	bool upToDate = true;
+	int reallocCount = 0;
+	for (int frame = 0; frame < 600; frame++)
+	{
+		// grow for the first half, then drain
+		int changes = (int)(rand() % 20);
+		for (int i = 0; i < changes; i++)
+		{
+			bool add = (frame < 300) ? (rand() % 4 != 0) : (rand() % 4 == 0);
+			if (add && (int)members.size() < rendererCount)
+			{
+				// joining a batch is a rebatch, which marks the renderer dirty
+				int id = (int)(rand() % rendererCount);
+				members.push_back(id);
+				scene.Move(id);
+			}
+			else if (!add && members.size() > 0)
+			{
+				members.erase(members.begin() + rand() % members.size());
+			}
+		}
+
+		int fit = FitInstanceCapacity(capacity, (int)members.size());
+		if (fit != capacity)
+		{
+			batch.Reset(fit);
+			capacity = fit;
+			reallocCount++;
+		}
+
+		fits &= (int)members.size() <= capacity;
+		for (int id : members)
+		{
+			if (rand() % 3 == 0)
+			{
+				scene.Move(id);
+			}
+		}
+
+		int frameIdx = frame % FRAME_COUNT;
+		RunFrame(batch, scene, members, frameIdx);
+		upToDate &= batch.IsUpToDate(frameIdx, scene);
+	}
+
+	TEST_CHECK(fits);
+	TEST_CHECK(upToDate);
+	TEST_CHECK(reallocCount < 20);
+}
+
+int main()
+{
+	TEST_RUN(TestLodSwitchWhileMoving);
+	TEST_RUN(TestSlotShiftWhileMoving);
+	TEST_RUN(TestRandomScene);
+	TEST_RUN(TestStaticSceneWritesOnce);
+	TEST_RUN(TestOnlyChangedSlotsWritten);
+	TEST_RUN(TestHiddenRendererStaysDirty);
+	TEST_RUN(TestCapacityGrowsGeometrically);
+	TEST_RUN(TestCapacityDoesNotThrash);
+	TEST_RUN(TestCapacityShrinks);
+	TEST_RUN(TestStreamingBatch);
+
+	return TestResult();
+}
@@ -0,0 +1,47 @@
+#include "TestUtility.h"
+#include "JobSystem.h"
+#include <cmath>
+
+// dispatch overhead of empty jobs and throughput of uneven jobs that need stealing
+int main()
+{
+	int iterations = BenchIterations(2000);
+	int numThreads = max((int)thread::hardware_concurrency() - 1, 1);
+
+	JobSystem jobSystem;
+	jobSystem.Init(numThreads);
+
+	atomic<int> sink{ 0 };
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		jobSystem.ParallelFor(64, [&](int j) { sink += j; });
+	}
+	double emptyMs = ElapsedMs(start);
+
+	// job cost grows with index, so the threads that got the cheap jobs steal the rest
+	start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations / 10 + 1; i++)
+	{
+		jobSystem.ParallelFor(64, [&](int j)
+		{
+			double x = 0.0;
+			for (int k = 0; k < j * 200; k++)
+			{
+				x += sqrt((double)k);
+			}
+			sink += (int)x & 1;
+		});
+	}
+	double unevenMs = ElapsedMs(start);
+
+	jobSystem.Release();
+
+	printf("threads %d, iterations %d\n", numThreads, iterations);
+	printf("empty ParallelFor(64): %.3f us\n", emptyMs * 1000.0 / iterations);
+	printf("uneven ParallelFor(64): %.3f us\n", unevenMs * 1000.0 / (iterations / 10 + 1));
+
+	TEST_CHECK(sink.load() != 0);
+	return TestResult();
+}
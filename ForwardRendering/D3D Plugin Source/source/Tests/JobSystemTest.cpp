@@ -0,0 +1,208 @@
+#include "TestUtility.h"
+#include "JobSystem.h"
+#include <set>
+
+static const int WORKER_COUNT = 4;
+
+// every index of every dispatch runs exactly once, also with nested dispatches
+static void TestEveryIndexOnce()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	for (int n = 1; n < 200; n += 7)
+	{
+		vector<atomic<int>> hits(n * n);
+		for (auto& h : hits)
+		{
+			h = 0;
+		}
+
+		jobSystem.ParallelFor(n, [&](int i)
+		{
+			jobSystem.ParallelFor(n, [&](int j)
+			{
+				hits[i * n + j]++;
+			});
+		});
+
+		bool allOnce = true;
+		for (auto& h : hits)
+		{
+			allOnce &= (h.load() == 1);
+		}
+		TEST_CHECK(allOnce);
+	}
+
+	jobSystem.Release();
+}
+
+// jobs dispatched inside a job go to one deque, idle workers must steal them
+static void TestSteal()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	mutex lock;
+	set<int> runners;
+
+	jobSystem.ParallelFor(1, [&](int)
+	{
+		jobSystem.ParallelFor(64, [&](int)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+			lock_guard<mutex> guard(lock);
+			runners.insert(JobSystem::GetCurrentWorker());
+		});
+	});
+
+	TEST_CHECK(runners.size() > 1);
+	TEST_CHECK(runners.count(-1) == 0 || runners.size() > 2);
+
+	jobSystem.Release();
+}
+
+// many outside threads dispatch and wait at the same time
+static void TestWaitContention()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	const int threadCount = 8;
+	const int loopCount = 300;
+	vector<thread> threads;
+	atomic<int> wrongSums{ 0 };
+
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads.push_back(thread([&, t]()
+		{
+			for (int l = 0; l < loopCount; l++)
+			{
+				int n = 1 + (t * 31 + l * 17) % 50;
+				atomic<int> sum{ 0 };
+
+				JobCounter counter;
+				JobSystem::JobFunc func = [&](int i)
+				{
+					// some jobs finish late, so waiters run out of work to steal and block
+					if (i == 0 && l % 10 == 0)
+					{
+						this_thread::sleep_for(chrono::microseconds(200));
+					}
+					sum += i + 1;
+				};
+
+				jobSystem.Dispatch(n, func, counter);
+				jobSystem.Wait(counter);
+
+				if (counter.count.load() != 0 || sum.load() != n * (n + 1) / 2)
+				{
+					wrongSums++;
+				}
+			}
+		}));
+	}
+
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	TEST_CHECK(wrongSums.load() == 0);
+	jobSystem.Release();
+}
+
+// a waiter whose jobs all run on other threads returns once the counter drains
+static void TestWaitForRunningJob()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(1);
+
+	atomic<bool> started{ false };
+	atomic<bool> finished{ false };
+	JobCounter counter;
+	JobSystem::JobFunc func = [&](int)
+	{
+		started = true;
+		this_thread::sleep_for(chrono::milliseconds(20));
+		finished = true;
+	};
+
+	jobSystem.Dispatch(1, func, counter);
+	while (!started)
+	{
+		this_thread::yield();
+	}
+
+	jobSystem.Wait(counter);
+	TEST_CHECK(finished.load());
+	TEST_CHECK(counter.count.load() == 0);
+
+	jobSystem.Release();
+}
+
+// release drains queued jobs, including jobs they dispatch while shutting down
+static void TestShutdown()
+{
+	for (int r = 0; r < 50; r++)
+	{
+		JobSystem jobSystem;
+		jobSystem.Init(WORKER_COUNT);
+
+		const int threadCount = 4;
+		JobCounter counters[threadCount];
+		JobCounter nestedCounter;
+		atomic<int> runCount{ 0 };
+
+		JobSystem::JobFunc nested = [&](int)
+		{
+			runCount++;
+		};
+
+		JobSystem::JobFunc func = [&](int i)
+		{
+			runCount++;
+			if (i % 8 == 0)
+			{
+				jobSystem.Dispatch(4, nested, nestedCounter);
+			}
+		};
+
+		vector<thread> threads;
+		for (int t = 0; t < threadCount; t++)
+		{
+			threads.push_back(thread([&, t]()
+			{
+				jobSystem.Dispatch(64, func, counters[t]);
+			}));
+		}
+
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+
+		jobSystem.Release();
+
+		bool drained = (nestedCounter.count.load() == 0);
+		for (int t = 0; t < threadCount; t++)
+		{
+			drained &= (counters[t].count.load() == 0);
+		}
+
+		TEST_CHECK(drained);
+		TEST_CHECK(runCount.load() == threadCount * 64 + threadCount * 8 * 4);
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestEveryIndexOnce);
+	TEST_RUN(TestSteal);
+	TEST_RUN(TestWaitContention);
+	TEST_RUN(TestWaitForRunningJob);
+	TEST_RUN(TestShutdown);
+
+	return TestResult();
+}
@@ -0,0 +1,85 @@
+#include "TestUtility.h"
+#include "LodSelection.h"
+#include "InstanceSlotTable.h"
+
+static const float thresholds[3] = { 0.5f, 0.2f, 0.0f };
+
+// no history picks the lod whose range holds the screen size
+static void TestDirectPick()
+{
+	TEST_CHECK(SelectLod(thresholds, 3, 0.9f, -1, LOD_HYSTERESIS) == 0);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.3f, -1, LOD_HYSTERESIS) == 1);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.1f, -1, LOD_HYSTERESIS) == 2);
+	TEST_CHECK(SelectLod(thresholds, 0, 0.1f, -1, LOD_HYSTERESIS) == 0);
+}
+
+// screen size wobbling inside the band keeps current lod
+static void TestHysteresis()
+{
+	TEST_CHECK(SelectLod(thresholds, 3, 0.52f, 1, LOD_HYSTERESIS) == 1);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.48f, 0, LOD_HYSTERESIS) == 0);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.56f, 1, LOD_HYSTERESIS) == 0);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.44f, 0, LOD_HYSTERESIS) == 1);
+
+	// large jump crosses several lods at once
+	TEST_CHECK(SelectLod(thresholds, 3, 0.01f, 0, LOD_HYSTERESIS) == 2);
+	TEST_CHECK(SelectLod(thresholds, 3, 0.9f, 2, LOD_HYSTERESIS) == 0);
+}
+
+// renderer flies away and back across lod boundaries, a lod change bumps world version
+// like RendererManager::EvaluateScreenSize, every drawn slot must hold its latest world
+static void TestLodChangeWhileMoving()
+{
+	InstanceSlotTable tables[3][2];
+	uint32_t held[3][2] = {};
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			tables[i][j].Reset(1);
+		}
+	}
+
+	uint32_t version = 1;
+	int lod = -1;
+	bool upToDate = true;
+	int lodChanges = 0;
+
+	for (int frame = 0; frame < 400; frame++)
+	{
+		int frameIdx = frame % 2;
+
+		// distance follows a triangle wave, the renderer moves only in some frames
+		float dist = 1.0f + (float)(frame % 100 < 50 ? frame % 100 : 100 - frame % 100) * 0.2f;
+		if (frame % 3 == 0)
+		{
+			version++;
+		}
+
+		int newLod = SelectLod(thresholds, 3, 1.0f / dist, lod, LOD_HYSTERESIS);
+		if (newLod != lod)
+		{
+			version++;
+			lodChanges++;
+		}
+		lod = newLod;
+
+		if (tables[lod][frameIdx].Claim(0, 0, version))
+		{
+			held[lod][frameIdx] = version;
+		}
+		upToDate &= (held[lod][frameIdx] == version);
+	}
+
+	TEST_CHECK(lodChanges > 10);
+	TEST_CHECK(upToDate);
+}
+
+int main()
+{
+	TEST_RUN(TestDirectPick);
+	TEST_RUN(TestHysteresis);
+	TEST_RUN(TestLodChangeWhileMoving);
+
+	return TestResult();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+// just the d3d12 types the header-only recording helpers use, for building their tests without the windows sdk
+// only on the include path when the real d3d12.h isn't found
+
+typedef unsigned int UINT;
+typedef int INT;
+typedef uint64_t UINT64;
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+struct ID3D12PipelineState {};
+struct ID3D12RootSignature {};
+
+enum D3D12_PRIMITIVE_TOPOLOGY
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4
+};
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
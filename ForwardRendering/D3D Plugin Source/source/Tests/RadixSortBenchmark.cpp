@@ -0,0 +1,126 @@
+#include "TestUtility.h"
+#include "SortUtility.h"
+#include "SortKey.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <map>
+
+static const int DRAW_COUNT = 100000;
+
+static uint32_t randomState = 123;
+static uint32_t NextRandom()
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return randomState >> 8;
+}
+
+// queued draw like QueueRenderer, old SortWork only read depth through the comparator
+struct QueuedDraw
+{
+	void* cache;
+	int queue;
+	int pso;
+	int material;
+	int mesh;
+	int submeshIndex;
+	float depth;
+	int index;
+};
+
+// old SortWork: std::sort per render queue with a depth comparator, against one key sort, serial and split like RadixSortWork
+int main()
+{
+	int iterations = BenchIterations(20);
+	int numThreads = max((int)thread::hardware_concurrency() - 1, 1);
+
+	JobSystem jobSystem;
+	jobSystem.Init(numThreads);
+
+	vector<QueuedDraw> draws(DRAW_COUNT);
+	for (int i = 0; i < DRAW_COUNT; i++)
+	{
+		draws[i].queue = (NextRandom() % 8 == 0) ? 2450 : 2000;
+		draws[i].pso = (int)(NextRandom() % 60);
+		draws[i].material = (int)(NextRandom() % 500);
+		draws[i].mesh = (int)(NextRandom() % 2000);
+		draws[i].cache = nullptr;
+		draws[i].submeshIndex = 0;
+		draws[i].depth = (float)(NextRandom() % 100000) * 0.01f;
+		draws[i].index = i;
+	}
+
+	vector<SortItem> input(DRAW_COUNT);
+	for (int i = 0; i < DRAW_COUNT; i++)
+	{
+		const QueuedDraw& d = draws[i];
+		input[i].key = MakeOpaqueSortKey(MakeOpaqueSortKeyBase(d.queue, d.pso, d.material, d.mesh), d.depth);
+		input[i].index = i;
+	}
+
+	map<int, vector<QueuedDraw>> queues;
+	double comparatorMs = 0.0;
+	for (int n = 0; n < iterations; n++)
+	{
+		queues.clear();
+		for (auto& d : draws)
+		{
+			queues[d.queue].push_back(d);
+		}
+
+		auto start = chrono::high_resolution_clock::now();
+		for (auto& q : queues)
+		{
+			sort(q.second.begin(), q.second.end(), [](const QueuedDraw& _a, const QueuedDraw& _b) { return _a.depth < _b.depth; });
+		}
+		comparatorMs += ElapsedMs(start);
+	}
+
+	RadixSorter serial;
+	double serialMs = 0.0;
+	for (int n = 0; n < iterations; n++)
+	{
+		serial.GetItems() = input;
+		auto start = chrono::high_resolution_clock::now();
+		serial.Sort();
+		serialMs += ElapsedMs(start);
+	}
+
+	// same steps as ForwardRenderingPath::RadixSortWork
+	RadixSorter parallel;
+	double parallelMs = 0.0;
+	for (int n = 0; n < iterations; n++)
+	{
+		parallel.GetItems() = input;
+		auto start = chrono::high_resolution_clock::now();
+		parallel.Begin(numThreads);
+		while (parallel.NextPass())
+		{
+			jobSystem.ParallelFor(numThreads, [&parallel](int _jobIndex) { parallel.Histogram(_jobIndex); });
+			if (parallel.PrefixSum())
+			{
+				jobSystem.ParallelFor(numThreads, [&parallel](int _jobIndex) { parallel.Scatter(_jobIndex); });
+			}
+		}
+		parallel.End();
+		parallelMs += ElapsedMs(start);
+	}
+
+	jobSystem.Release();
+
+	printf("draws %d, threads %d, iterations %d\n", DRAW_COUNT, numThreads, iterations);
+	printf("std::sort per queue: %.3f ms, radix: %.3f ms, parallel radix: %.3f ms\n", comparatorMs / iterations, serialMs / iterations, parallelMs / iterations);
+
+	// split sort gives the serial order, both are the stable order of the keys
+	vector<SortItem> expected = input;
+	stable_sort(expected.begin(), expected.end(), [](const SortItem& _a, const SortItem& _b) { return _a.key < _b.key; });
+	int mismatchCount = 0;
+	for (int i = 0; i < DRAW_COUNT; i++)
+	{
+		const SortItem& s = serial.GetItems()[i];
+		const SortItem& p = parallel.GetItems()[i];
+		mismatchCount += (s.key == p.key && s.index == p.index && s.index == expected[i].index) ? 0 : 1;
+	}
+	TEST_CHECK(mismatchCount == 0);
+
+	return TestResult();
+}
@@ -0,0 +1,377 @@
+#include "TestUtility.h"
+#include "SortUtility.h"
+#include "SortKey.h"
+#include <algorithm>
+#include <cmath>
+
+static uint32_t seed = 1;
+
+static uint32_t NextRandom()
+{
+	seed = seed * 1664525u + 1013904223u;
+	return seed;
+}
+
+// random keys, _keyBits limits distinct values so equal keys show up and stability matters
+static void FillItems(vector<SortItem>& _items, int _count, int _keyBits)
+{
+	_items.resize(_count);
+	for (int i = 0; i < _count; i++)
+	{
+		uint64_t key = ((uint64_t)NextRandom() << 32) | NextRandom();
+		_items[i].key = (_keyBits >= 64) ? key : (key & ((1ULL << _keyBits) - 1));
+		_items[i].index = i;
+	}
+}
+
+static vector<SortItem> ReferenceSort(vector<SortItem> _items)
+{
+	stable_sort(_items.begin(), _items.end(), [](const SortItem& _a, const SortItem& _b) { return _a.key < _b.key; });
+	return _items;
+}
+
+static bool SameOrder(const vector<SortItem>& _a, const vector<SortItem>& _b)
+{
+	if (_a.size() != _b.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < _a.size(); i++)
+	{
+		if (_a[i].key != _b[i].key || _a[i].index != _b[i].index)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// runs the parallel steps with every thread index in turn, same calls the worker jobs make
+static void SortInSteps(RadixSorter& _sorter, int _numThreads)
+{
+	_sorter.Begin(_numThreads);
+	while (_sorter.NextPass())
+	{
+		for (int t = 0; t < _numThreads; t++)
+		{
+			_sorter.Histogram(t);
+		}
+
+		if (_sorter.PrefixSum())
+		{
+			for (int t = 0; t < _numThreads; t++)
+			{
+				_sorter.Scatter(t);
+			}
+		}
+	}
+	_sorter.End();
+}
+
+static void TestSortMatchesStableSort()
+{
+	const int counts[] = { 0, 1, 2, 17, 255, 256, 1000, 5000 };
+	const int keyBits[] = { 4, 16, 40, 64 };
+
+	for (int c : counts)
+	{
+		for (int b : keyBits)
+		{
+			RadixSorter sorter;
+			FillItems(sorter.GetItems(), c, b);
+			vector<SortItem> expected = ReferenceSort(sorter.GetItems());
+
+			sorter.Sort();
+			TEST_CHECK(SameOrder(sorter.GetItems(), expected));
+		}
+	}
+}
+
+// result doesn't depend on thread count
+static void TestParallelStepsMatchStableSort()
+{
+	for (int numThreads = 1; numThreads <= 8; numThreads++)
+	{
+		RadixSorter sorter;
+		FillItems(sorter.GetItems(), 3000 + numThreads * 111, 24);
+		vector<SortItem> expected = ReferenceSort(sorter.GetItems());
+
+		SortInSteps(sorter, numThreads);
+		TEST_CHECK(SameOrder(sorter.GetItems(), expected));
+		TEST_CHECK(sorter.GetItemCount() == (int)expected.size());
+	}
+
+	// more threads than items
+	RadixSorter sorter;
+	FillItems(sorter.GetItems(), 3, 64);
+	vector<SortItem> expected = ReferenceSort(sorter.GetItems());
+	SortInSteps(sorter, 8);
+	TEST_CHECK(SameOrder(sorter.GetItems(), expected));
+}
+
+// digits that are equal for all keys skip their scatter, an odd number of real passes must still end in items
+static void TestSkippedPasses()
+{
+	const uint64_t masks[] = { 0xffULL, 0xff00ULL, 0xffffULL, 0xff00ff0000000000ULL, 0xffffffULL };
+
+	for (uint64_t mask : masks)
+	{
+		RadixSorter sorter;
+		FillItems(sorter.GetItems(), 2000, 64);
+		for (auto& item : sorter.GetItems())
+		{
+			item.key = (item.key & mask) | 0x0100000000000000ULL;
+		}
+		vector<SortItem> expected = ReferenceSort(sorter.GetItems());
+
+		SortInSteps(sorter, 3);
+		TEST_CHECK(SameOrder(sorter.GetItems(), expected));
+	}
+}
+
+static bool IsPermutation(vector<SortItem> _items, int _count)
+{
+	sort(_items.begin(), _items.end(), [](const SortItem& _a, const SortItem& _b) { return _a.index < _b.index; });
+	for (int i = 0; i < _count; i++)
+	{
+		if (i >= (int)_items.size() || _items[i].index != i)
+		{
+			return false;
+		}
+	}
+
+	return (int)_items.size() == _count;
+}
+
+struct PathObject
+{
+	float x, y, z;
+	float radius;
+	uint64_t opaqueKeyBase;
+	int queue;
+	int material;
+};
+
+// one sorted list of SortWork, items start in last frame's order, newly visible ones are appended in index order
+struct PathSortList
+{
+	RadixSorter sorter;
+	vector<int> lastOrder;
+	vector<int> addedFrame;
+	int incrementalCount = 0;
+	int fullCount = 0;
+	int mismatchCount = 0;
+
+	void Sort(bool _incremental)
+	{
+		vector<SortItem> expected = ReferenceSort(sorter.GetItems());
+
+		// same fallback as RadixSortWork
+		bool done = _incremental && sorter.SortIncremental();
+		if (done)
+		{
+			incrementalCount++;
+			mismatchCount += SameOrder(sorter.GetItems(), expected) ? 0 : 1;
+		}
+		else
+		{
+			// a failed incremental pass reorders equal keys, so only keys are compared then
+			sorter.Sort();
+			fullCount++;
+			for (int i = 0; i < sorter.GetItemCount(); i++)
+			{
+				bool same = sorter.GetItems()[i].key == expected[i].key && (!_incremental || sorter.GetItems()[i].index == expected[i].index);
+				mismatchCount += same ? 0 : 1;
+			}
+		}
+
+		lastOrder.clear();
+		for (auto& item : sorter.GetItems())
+		{
+			lastOrder.push_back(item.index);
+		}
+	}
+};
+
+// camera walks, turns, strafes, stands, cuts and snaps around over many frames, depth keys are rebuilt from it every frame
+// and every frame's sort, incremental from last frame's order or full after a cut, must equal a full sort of the same input
+static void TestIncrementalCameraPath()
+{
+	const int objectCount = 3000;
+	const float farZ = 150.0f;
+
+	vector<PathObject> objects(objectCount);
+	for (auto& o : objects)
+	{
+		o.x = (float)(NextRandom() % 4000) * 0.1f - 200.0f;
+		o.y = (float)(NextRandom() % 200) * 0.1f - 10.0f;
+		o.z = (float)(NextRandom() % 4000) * 0.1f - 200.0f;
+		o.radius = 0.2f + (float)(NextRandom() % 30) * 0.1f;
+		o.queue = (NextRandom() % 8 == 0) ? 3000 : 2000;
+		o.material = (int)(NextRandom() % 200);
+		o.opaqueKeyBase = MakeOpaqueSortKeyBase(o.queue, (int)(NextRandom() % 40), o.material, (int)(NextRandom() % 300));
+	}
+
+	PathSortList opaque, transparent;
+	opaque.addedFrame.resize(objectCount, -1);
+	transparent.addedFrame.resize(objectCount, -1);
+
+	float camX = 0.0f, camY = 0.0f, camZ = 0.0f, yaw = 0.0f;
+	float lastX = 0.0f, lastY = 0.0f, lastZ = 0.0f, lastDirX = 0.0f, lastDirZ = 1.0f;
+	int cutCount = 0;
+
+	for (int frame = 0; frame < 400; frame++)
+	{
+		int phase = (frame / 40) % 5;
+		if (phase == 0)
+		{
+			camX += sinf(yaw) * 0.5f;
+			camZ += cosf(yaw) * 0.5f;
+		}
+		else if (phase == 1)
+		{
+			yaw += 0.01f;
+		}
+		else if (phase == 2)
+		{
+			camX += cosf(yaw) * 0.3f;
+			camZ -= sinf(yaw) * 0.3f;
+		}
+		else if (phase == 4)
+		{
+			yaw -= 0.008f;
+			camX += sinf(yaw) * 0.4f;
+			camZ += cosf(yaw) * 0.4f;
+			camY += 0.02f;
+		}
+
+		// cut to another place, then a snap turn on the spot
+		if (frame == 250)
+		{
+			camX = -120.0f;
+			camZ = 90.0f;
+			yaw = 2.5f;
+		}
+		if (frame == 320)
+		{
+			yaw += 0.6f;
+		}
+
+		float dirX = sinf(yaw);
+		float dirZ = cosf(yaw);
+
+		// same check as RendererManager::IsCameraTeleport, first frame has no last order
+		float dx = camX - lastX, dy = camY - lastY, dz = camZ - lastZ;
+		bool teleport = dx * dx + dy * dy + dz * dz > SORT_TELEPORT_DISTANCE * SORT_TELEPORT_DISTANCE || dirX * lastDirX + dirZ * lastDirZ < SORT_TELEPORT_COS;
+		bool incremental = frame > 0 && !teleport;
+		cutCount += (frame > 0 && teleport) ? 1 : 0;
+		lastX = camX;
+		lastY = camY;
+		lastZ = camZ;
+		lastDirX = dirX;
+		lastDirZ = dirZ;
+
+		// view depth along camera forward like CalcViewDepth, simple cone stands in for culling
+		vector<float> depth(objectCount);
+		vector<char> visible(objectCount);
+		for (int i = 0; i < objectCount; i++)
+		{
+			const PathObject& o = objects[i];
+			depth[i] = (o.x - camX) * dirX + (o.z - camZ) * dirZ;
+			float side = (o.x - camX) * dirZ - (o.z - camZ) * dirX;
+			visible[i] = depth[i] + o.radius > 0.3f && depth[i] - o.radius < farZ && fabsf(side) < depth[i] * 1.2f + o.radius;
+		}
+
+		PathSortList* lists[2] = { &opaque, &transparent };
+		for (int l = 0; l < 2; l++)
+		{
+			PathSortList& list = *lists[l];
+			auto& items = list.sorter.GetItems();
+			items.clear();
+
+			auto addItem = [&](int _id)
+			{
+				const PathObject& o = objects[_id];
+				if (!visible[_id] || list.addedFrame[_id] == frame || (l == 1) != (o.queue > 2500))
+				{
+					return;
+				}
+				list.addedFrame[_id] = frame;
+
+				SortItem item;
+				item.key = (l == 0) ? MakeOpaqueSortKey(o.opaqueKeyBase, depth[_id] - o.radius) : MakeTransparentSortKey(o.queue, o.material, depth[_id]);
+				item.index = _id;
+				items.push_back(item);
+			};
+
+			for (int id : list.lastOrder)
+			{
+				addItem(id);
+			}
+			for (int i = 0; i < objectCount; i++)
+			{
+				addItem(i);
+			}
+
+			list.Sort(incremental);
+		}
+	}
+
+	printf("opaque incremental %d full %d, transparent incremental %d full %d, cuts %d\n"
+		, opaque.incrementalCount, opaque.fullCount, transparent.incrementalCount, transparent.fullCount, cutCount);
+
+	TEST_CHECK(opaque.mismatchCount == 0);
+	TEST_CHECK(transparent.mismatchCount == 0);
+	TEST_CHECK(cutCount == 2);
+
+	// the path mostly reused last frame's order, otherwise it tested nothing
+	TEST_CHECK(opaque.incrementalCount > 300);
+	TEST_CHECK(transparent.incrementalCount > 300);
+
+	// sorted input is left as is
+	RadixSorter sorter;
+	FillItems(sorter.GetItems(), 500, 8);
+	sorter.Sort();
+	vector<SortItem> expected = sorter.GetItems();
+	TEST_CHECK(sorter.SortIncremental());
+	TEST_CHECK(SameOrder(sorter.GetItems(), expected));
+}
+
+// reversed input runs out of budget, items stay a permutation and full sort still works
+static void TestIncrementalGivesUp()
+{
+	RadixSorter sorter;
+	FillItems(sorter.GetItems(), 3000, 64);
+	vector<SortItem>& items = sorter.GetItems();
+	sort(items.begin(), items.end(), [](const SortItem& _a, const SortItem& _b) { return _a.key > _b.key; });
+	for (int i = 0; i < (int)items.size(); i++)
+	{
+		items[i].index = i;
+	}
+	vector<SortItem> expected = ReferenceSort(items);
+
+	TEST_CHECK(!sorter.SortIncremental());
+	TEST_CHECK(IsPermutation(sorter.GetItems(), 3000));
+
+	// partially sorted items keep equal keys in their new order, so only keys are compared
+	sorter.Sort();
+	bool sameKeys = true;
+	for (int i = 0; i < sorter.GetItemCount(); i++)
+	{
+		sameKeys &= (sorter.GetItems()[i].key == expected[i].key);
+	}
+	TEST_CHECK(sameKeys);
+}
+
+int main()
+{
+	TEST_RUN(TestSortMatchesStableSort);
+	TEST_RUN(TestParallelStepsMatchStableSort);
+	TEST_RUN(TestSkippedPasses);
+	TEST_RUN(TestIncrementalCameraPath);
+	TEST_RUN(TestIncrementalGivesUp);
+
+	return TestResult();
+}
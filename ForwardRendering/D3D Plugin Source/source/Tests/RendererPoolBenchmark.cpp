@@ -0,0 +1,246 @@
+#include "TestUtility.h"
+#include "RendererPool.h"
+#include "SortUtility.h"
+#include <memory>
+#include <cstring>
+
+static const int RENDERER_COUNT = 100000;
+
+// renderer layout before the hot/cold split, hot state sits between cold members of a heap object
+// and getters return copies, like Renderer did
+class LegacyRenderer
+{
+public:
+	XMFLOAT4X4 GetWorld() { return world; }
+	XMFLOAT4X4 GetInvWorld() { return invWorld; }
+	BoundingBox GetWorldBound() { return worldBound; }
+	bool GetVisible() { return isVisible; }
+	bool GetActive() { return isActive; }
+	bool IsDirty(int _frameIdx) { return isDirty[_frameIdx]; }
+	void SetVisible(bool _visible) { isVisible = _visible && isActive; }
+
+	void SetWorld(const XMFLOAT4X4& _world, const XMFLOAT4X4& _invWorld, const BoundingBox& _worldBound)
+	{
+		world = _world;
+		invWorld = _invWorld;
+		worldBound = _worldBound;
+		for (int i = 0; i < MAX_FRAME_COUNT; i++)
+		{
+			isDirty[i] = true;
+		}
+	}
+
+	void ClearDirty(int _frameIdx) { isDirty[_frameIdx] = false; }
+
+	// cold members, same sizes as the ones Renderer had
+	XMFLOAT4X4 currentObjConst[2];
+	void* rendererConstant[MAX_FRAME_COUNT];
+	vector<void*> lodMeshes;
+	vector<float> lodScreenSizes;
+	int currLod = 0;
+	BoundingBox localBound;
+
+	BoundingBox worldBound;
+	bool isVisible = true;
+	bool isShadowVisible = true;
+	bool isActive = true;
+	bool isDirty[MAX_FRAME_COUNT];
+	bool isDynamic = false;
+	int instanceID = -1;
+
+	vector<void*> materials;
+	XMFLOAT4X4 world;
+	XMFLOAT4X4 invWorld;
+};
+
+struct ScenePoint
+{
+	XMFLOAT4X4 world;
+	XMFLOAT4X4 invWorld;
+	BoundingBox bound;
+};
+
+static uint32_t randomState = 77;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static ScenePoint RandomPoint()
+{
+	ScenePoint p;
+	XMFLOAT3 pos(NextRandom(-1000.0f, 1000.0f), NextRandom(-50.0f, 50.0f), NextRandom(-1000.0f, 1000.0f));
+	XMStoreFloat4x4(&p.world, XMMatrixTranslation(pos.x, pos.y, pos.z));
+	XMStoreFloat4x4(&p.invWorld, XMMatrixTranslation(-pos.x, -pos.y, -pos.z));
+	p.bound = BoundingBox(pos, XMFLOAT3(1.0f, 1.0f, 1.0f));
+	return p;
+}
+
+// front to back key from view depth of world position, the part of a sort key that reads renderer state
+static uint64_t DepthKey(const XMFLOAT4X4& _world, const XMFLOAT3& _camPos, const XMFLOAT3& _camDir)
+{
+	float depth = (_world._41 - _camPos.x) * _camDir.x + (_world._42 - _camPos.y) * _camDir.y + (_world._43 - _camPos.z) * _camDir.z;
+	return (uint64_t)(max(depth, 0.0f) * 16.0f);
+}
+
+// cull, sort and upload one frame from renderer objects
+static int LegacyFrame(vector<shared_ptr<LegacyRenderer>>& _renderers, const BoundingFrustum& _frustum, const XMFLOAT3& _camPos, const XMFLOAT3& _camDir
+	, RadixSorter& _sorter, vector<XMFLOAT4X4>& _upload, int _frameIdx)
+{
+	for (auto& r : _renderers)
+	{
+		r->SetVisible(r->GetActive() && _frustum.Contains(r->GetWorldBound()) != DISJOINT);
+	}
+
+	auto& items = _sorter.GetItems();
+	items.clear();
+	for (int i = 0; i < (int)_renderers.size(); i++)
+	{
+		if (_renderers[i]->GetVisible())
+		{
+			SortItem item;
+			item.key = DepthKey(_renderers[i]->GetWorld(), _camPos, _camDir);
+			item.index = i;
+			items.push_back(item);
+		}
+	}
+	_sorter.Sort();
+
+	int uploadCount = 0;
+	for (auto& item : items)
+	{
+		LegacyRenderer* r = _renderers[item.index].get();
+		if (r->IsDirty(_frameIdx))
+		{
+			_upload[uploadCount * 2] = r->GetWorld();
+			_upload[uploadCount * 2 + 1] = r->GetInvWorld();
+			r->ClearDirty(_frameIdx);
+			uploadCount++;
+		}
+	}
+
+	return uploadCount;
+}
+
+// same frame from the flat pool
+static int PoolFrame(RendererPool& _pool, const BoundingFrustum& _frustum, const XMFLOAT3& _camPos, const XMFLOAT3& _camDir
+	, RadixSorter& _sorter, vector<XMFLOAT4X4>& _upload, int _frameIdx)
+{
+	int count = _pool.GetCount();
+	for (int i = 0; i < count; i++)
+	{
+		_pool.SetVisible(i, _frustum.Contains(_pool.GetWorldBound(i)) != DISJOINT);
+	}
+
+	auto& items = _sorter.GetItems();
+	items.clear();
+	for (int i = 0; i < count; i++)
+	{
+		if (_pool.IsVisible(i))
+		{
+			SortItem item;
+			item.key = DepthKey(_pool.GetWorld(i), _camPos, _camDir);
+			item.index = i;
+			items.push_back(item);
+		}
+	}
+	_sorter.Sort();
+
+	int uploadCount = 0;
+	for (auto& item : items)
+	{
+		if (_pool.IsWorldDirty(item.index, _frameIdx))
+		{
+			_upload[uploadCount * 2] = _pool.GetWorld(item.index);
+			_upload[uploadCount * 2 + 1] = _pool.GetInvWorld(item.index);
+			uploadCount++;
+		}
+	}
+	_pool.ClearWorldDirty(_frameIdx);
+
+	return uploadCount;
+}
+
+// cull + sort + upload of 100k renderers, renderer objects against the flat pool, 5% of renderers move every frame
+int main()
+{
+	int iterations = BenchIterations(50);
+
+	vector<ScenePoint> points(RENDERER_COUNT);
+	for (auto& p : points)
+	{
+		p = RandomPoint();
+	}
+
+	// renderers are created between other allocations, like meshes and materials loaded with them
+	vector<shared_ptr<LegacyRenderer>> legacy;
+	vector<unique_ptr<char[]>> coldAllocations;
+	BoundingBox localBound(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	RendererPool pool;
+	for (int i = 0; i < RENDERER_COUNT; i++)
+	{
+		shared_ptr<LegacyRenderer> r = make_shared<LegacyRenderer>();
+		r->materials.resize(1 + i % 3);
+		r->SetWorld(points[i].world, points[i].invWorld, points[i].bound);
+		legacy.push_back(r);
+		coldAllocations.push_back(unique_ptr<char[]>(new char[64 + (i % 7) * 32]));
+
+		int handle = pool.Add(true);
+		pool.SetWorld(handle, points[i].world, localBound);
+	}
+
+	BoundingFrustum frustum(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, -1.0f, 0.6f, -0.6f, 0.3f, 800.0f);
+	XMFLOAT3 camPos(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 camDir(0.0f, 0.0f, 1.0f);
+
+	RadixSorter legacySorter, poolSorter;
+	vector<XMFLOAT4X4> upload(RENDERER_COUNT * 2);
+	double legacyMs = 0.0;
+	double poolMs = 0.0;
+	int legacyUploads = 0;
+	int poolUploads = 0;
+	int legacyVisible = 0;
+	int poolVisible = 0;
+
+	for (int n = 0; n < iterations; n++)
+	{
+		int frameIdx = n % MAX_FRAME_COUNT;
+
+		// move the same renderers in both layouts, not timed
+		for (int k = 0; k < RENDERER_COUNT / 20; k++)
+		{
+			int id = (int)NextRandom(0.0f, RENDERER_COUNT - 0.01f);
+			points[id] = RandomPoint();
+			legacy[id]->SetWorld(points[id].world, points[id].invWorld, points[id].bound);
+			pool.SetWorld(id, points[id].world, localBound);
+		}
+
+		auto start = chrono::high_resolution_clock::now();
+		legacyUploads = LegacyFrame(legacy, frustum, camPos, camDir, legacySorter, upload, frameIdx);
+		legacyMs += ElapsedMs(start);
+		legacyVisible = legacySorter.GetItemCount();
+
+		start = chrono::high_resolution_clock::now();
+		poolUploads = PoolFrame(pool, frustum, camPos, camDir, poolSorter, upload, frameIdx);
+		poolMs += ElapsedMs(start);
+		poolVisible = poolSorter.GetItemCount();
+	}
+
+	printf("renderers %d, iterations %d, visible %d, uploaded %d\n", RENDERER_COUNT, iterations, poolVisible, poolUploads);
+	printf("renderer objects: %.3f ms, RendererPool: %.3f ms per frame\n", legacyMs / iterations, poolMs / iterations);
+
+	TEST_CHECK(legacyVisible == poolVisible);
+	TEST_CHECK(legacyUploads == poolUploads);
+	TEST_CHECK(poolVisible > 0);
+
+	// both sorted the same keys
+	bool sameOrder = true;
+	for (int i = 0; i < poolVisible && sameOrder; i++)
+	{
+		sameOrder = legacySorter.GetItems()[i].index == poolSorter.GetItems()[i].index;
+	}
+	TEST_CHECK(sameOrder);
+
+	return TestResult();
+}
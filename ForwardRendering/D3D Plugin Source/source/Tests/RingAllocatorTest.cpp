@@ -0,0 +1,171 @@
+#include "TestUtility.h"
+#include "RingAllocator.h"
+#include <vector>
+
+struct LiveRange
+{
+	uint64_t fence;
+	uint64_t offset;
+	uint64_t size;
+};
+
+static bool Overlaps(const LiveRange& _a, const LiveRange& _b)
+{
+	return _a.offset < _b.offset + _b.size && _b.offset < _a.offset + _a.size;
+}
+
+// slice that doesn't fit before the end starts again at 0, the skipped tail stays used until its frame retires
+static void TestWrapAround()
+{
+	RingAllocator ring;
+	ring.Init(1024, 256);
+	uint64_t offset = 0;
+
+	ring.BeginFrame(0, 1);
+	TEST_CHECK(ring.Allocate(512, offset) && offset == 0);
+
+	ring.BeginFrame(0, 2);
+	TEST_CHECK(ring.Allocate(256, offset) && offset == 512);
+
+	// frame 1 retired, [0, 512) is free but [768, 1024) is too short
+	ring.BeginFrame(1, 3);
+	TEST_CHECK(ring.GetUsedSize() == 256);
+	TEST_CHECK(ring.Allocate(512, offset) && offset == 0);
+	TEST_CHECK(ring.GetUsedSize() == 1024);
+	TEST_CHECK(!ring.Allocate(256, offset));
+
+	// frame 2 gives back its slice only, the waste belongs to frame 3
+	ring.BeginFrame(2, 4);
+	TEST_CHECK(ring.GetUsedSize() == 768);
+	TEST_CHECK(ring.Allocate(256, offset) && offset == 512);
+
+	ring.BeginFrame(4, 5);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+	TEST_CHECK(ring.Allocate(1024, offset));
+}
+
+// exact fit fills the ring, head == tail must read as full and not empty
+static void TestExactFit()
+{
+	RingAllocator ring;
+	ring.Init(1024, 256);
+	uint64_t offset = 0;
+
+	ring.BeginFrame(0, 1);
+	TEST_CHECK(ring.Allocate(768, offset) && offset == 0);
+	TEST_CHECK(ring.Allocate(256, offset) && offset == 768);
+	TEST_CHECK(ring.GetUsedSize() == 1024);
+	TEST_CHECK(!ring.Allocate(256, offset));
+	TEST_CHECK(!ring.Allocate(2048, offset));
+
+	ring.BeginFrame(1, 2);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+	TEST_CHECK(ring.Allocate(1024, offset) && offset == 0);
+}
+
+// slices of any size start 256-byte aligned like constant buffer views need, capacity is rounded down
+static void TestAlignment()
+{
+	RingAllocator ring;
+	ring.Init(1000, 256);
+	TEST_CHECK(ring.GetCapacity() == 768);
+	uint64_t offset = 0;
+
+	ring.BeginFrame(0, 1);
+	TEST_CHECK(ring.Allocate(208, offset) && offset == 0);
+	TEST_CHECK(ring.GetUsedSize() == 256);
+
+	// 300 bytes take two slots and end exactly at the end of the ring
+	ring.BeginFrame(0, 2);
+	TEST_CHECK(ring.Allocate(300, offset) && offset == 256);
+	TEST_CHECK(!ring.Allocate(1, offset));
+
+	// after the wrap slices start at 0 again
+	ring.BeginFrame(1, 3);
+	TEST_CHECK(ring.Allocate(1, offset) && offset == 0);
+	TEST_CHECK(!ring.Allocate(1, offset));
+
+	ring.BeginFrame(3, 4);
+	TEST_CHECK(ring.Allocate(513, offset) && offset == 0);
+	TEST_CHECK(ring.GetUsedSize() == 768);
+}
+
+// memory of a frame stays allocated until its fence completes, gpu running a few frames behind
+static void TestRandomFrames()
+{
+	const uint64_t capacity = 64 * 256;
+	const uint64_t gpuLatency = 2;
+
+	RingAllocator ring;
+	ring.Init(capacity, 256);
+
+	vector<LiveRange> live;
+	uint32_t randomState = 99;
+	int failCount = 0;
+
+	for (uint64_t frame = 1; frame < 2000; frame++)
+	{
+		uint64_t completed = (frame > gpuLatency) ? frame - gpuLatency : 0;
+		ring.BeginFrame(completed, frame);
+
+		vector<LiveRange> stillLive;
+		for (auto& r : live)
+		{
+			if (r.fence > completed)
+			{
+				stillLive.push_back(r);
+			}
+		}
+		live.swap(stillLive);
+
+		int allocCount = (int)(frame % 7) + 1;
+		for (int i = 0; i < allocCount; i++)
+		{
+			randomState = randomState * 1664525u + 1013904223u;
+			uint64_t size = 1 + (randomState >> 8) % 3000;
+
+			uint64_t liveSize = 0;
+			for (auto& r : live)
+			{
+				liveSize += r.size;
+			}
+
+			// constant sizes aren't multiples of 256, the ring holds the rounded size
+			LiveRange range;
+			range.fence = frame;
+			range.size = (size + 255) & ~255ULL;
+			if (!ring.Allocate(size, range.offset))
+			{
+				// only when the in-flight frames really hold most of the ring
+				TEST_CHECK(liveSize + range.size > capacity / 2);
+				failCount++;
+				continue;
+			}
+
+			TEST_CHECK(range.offset % 256 == 0);
+			TEST_CHECK(range.offset + range.size <= capacity);
+			for (auto& r : live)
+			{
+				TEST_CHECK(!Overlaps(r, range));
+			}
+
+			live.push_back(range);
+			TEST_CHECK(ring.GetUsedSize() <= capacity);
+		}
+	}
+
+	// everything comes back once gpu catches up
+	ring.BeginFrame(2000, 2001);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+	TEST_CHECK(failCount < 2000);
+}
+
+int main()
+{
+	TEST_RUN(TestWrapAround);
+	TEST_RUN(TestExactFit);
+	TEST_RUN(TestAlignment);
+	TEST_RUN(TestRandomFrames);
+
+	return TestResult();
+}
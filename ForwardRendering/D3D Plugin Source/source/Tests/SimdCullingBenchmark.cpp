@@ -0,0 +1,82 @@
+#include "TestUtility.h"
+#include "SimdCulling.h"
+
+// 4-wide plane test over 100k boxes against one BoundingFrustum::Contains per box
+int main()
+{
+	const int count = 100000;
+	int iterations = BenchIterations(100);
+
+	uint32_t seed = 11;
+	auto rand = [&seed](float _min, float _max)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return _min + (_max - _min) * (float)(seed >> 8) / (float)(1 << 24);
+	};
+
+	// camera in the middle of a scene, about a quarter of it is in view
+	BoundingFrustum frustum(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, -1.0f, 0.6f, -0.6f, 0.3f, 500.0f);
+
+	SimdCulling culling;
+	culling.Resize(count);
+	culling.SetFrustum(frustum);
+
+	vector<BoundingBox> bounds(count);
+	for (int i = 0; i < count; i++)
+	{
+		bounds[i] = BoundingBox(XMFLOAT3(rand(-500.0f, 500.0f), rand(-100.0f, 100.0f), rand(-500.0f, 500.0f)), XMFLOAT3(rand(0.5f, 5.0f), rand(0.5f, 5.0f), rand(0.5f, 5.0f)));
+		culling.SetBound(i, bounds[i]);
+	}
+
+	int scalarVisible = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		scalarVisible = 0;
+		for (int i = 0; i < count; i++)
+		{
+			scalarVisible += (frustum.Contains(bounds[i]) != DISJOINT) ? 1 : 0;
+		}
+	}
+	double scalarMs = ElapsedMs(start);
+
+	// same decision the renderer makes, ambiguous lanes fall back to Contains
+	int simdVisible = 0;
+	int ambiguousCount = 0;
+	start = chrono::high_resolution_clock::now();
+	for (int n = 0; n < iterations; n++)
+	{
+		simdVisible = 0;
+		ambiguousCount = 0;
+		for (int g = 0; g < culling.GetGroupCount(); g++)
+		{
+			int visibleMask, ambiguousMask;
+			culling.TestGroup(g, visibleMask, ambiguousMask);
+
+			for (int lane = 0; lane < SimdCulling::LANE_COUNT; lane++)
+			{
+				int index = g * SimdCulling::LANE_COUNT + lane;
+				if (index >= count)
+				{
+					break;
+				}
+
+				bool visible = (visibleMask & (1 << lane)) != 0;
+				if (ambiguousMask & (1 << lane))
+				{
+					visible = frustum.Contains(bounds[index]) != DISJOINT;
+					ambiguousCount++;
+				}
+				simdVisible += visible ? 1 : 0;
+			}
+		}
+	}
+	double simdMs = ElapsedMs(start);
+
+	printf("boxes %d, iterations %d, visible %d, ambiguous %d\n", count, iterations, simdVisible, ambiguousCount);
+	printf("BoundingFrustum::Contains: %.3f ms, SimdCulling: %.3f ms per frame\n", scalarMs / iterations, simdMs / iterations);
+
+	TEST_CHECK(simdVisible == scalarVisible);
+	TEST_CHECK(simdVisible > 0);
+	return TestResult();
+}
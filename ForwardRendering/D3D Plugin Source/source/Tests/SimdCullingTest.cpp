@@ -0,0 +1,155 @@
+#include "TestUtility.h"
+#include "SimdCulling.h"
+#include <cmath>
+
+static uint32_t randomState = 4242;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static BoundingFrustum RandomFrustum()
+{
+	XMFLOAT4 orientation(NextRandom(-1.0f, 1.0f), NextRandom(-1.0f, 1.0f), NextRandom(-1.0f, 1.0f), NextRandom(-1.0f, 1.0f));
+	float len = sqrtf(orientation.x * orientation.x + orientation.y * orientation.y + orientation.z * orientation.z + orientation.w * orientation.w);
+	orientation = XMFLOAT4(orientation.x / len, orientation.y / len, orientation.z / len, orientation.w / len);
+
+	float h = NextRandom(0.3f, 1.5f);
+	float w = h * NextRandom(1.0f, 2.0f);
+	return BoundingFrustum(XMFLOAT3(NextRandom(-20.0f, 20.0f), NextRandom(-20.0f, 20.0f), NextRandom(-20.0f, 20.0f)), orientation, w, -w, h, -h, NextRandom(0.1f, 1.0f), NextRandom(50.0f, 200.0f));
+}
+
+static BoundingBox RandomBox()
+{
+	return BoundingBox(XMFLOAT3(NextRandom(-150.0f, 150.0f), NextRandom(-150.0f, 150.0f), NextRandom(-150.0f, 150.0f)), XMFLOAT3(NextRandom(0.0f, 10.0f), NextRandom(0.0f, 10.0f), NextRandom(0.0f, 10.0f)));
+}
+
+// a lane is visible only if Contains doesn't call it disjoint, culled only if it does,
+// ambiguous lanes are settled by Contains like the renderer does
+static void CheckLane(int _lane, int _visibleMask, int _ambiguousMask, const BoundingFrustum& _frustum, const BoundingBox& _bound, int& _ambiguous)
+{
+	bool visible = (_visibleMask & (1 << _lane)) != 0;
+	bool ambiguous = (_ambiguousMask & (1 << _lane)) != 0;
+	bool expected = _frustum.Contains(_bound) != DISJOINT;
+
+	TEST_CHECK(!(visible && ambiguous));
+	if (!ambiguous)
+	{
+		TEST_CHECK(visible == expected);
+	}
+	_ambiguous += ambiguous ? 1 : 0;
+}
+
+static void TestGroupMatchesContains()
+{
+	const int boundCount = 1001;
+	int ambiguous = 0;
+	int visible = 0;
+
+	for (int f = 0; f < 20; f++)
+	{
+		BoundingFrustum frustum = RandomFrustum();
+		SimdCulling culling;
+		culling.Resize(boundCount);
+		culling.SetFrustum(frustum);
+
+		vector<BoundingBox> bounds(boundCount);
+		for (int i = 0; i < boundCount; i++)
+		{
+			bounds[i] = RandomBox();
+			culling.SetBound(i, bounds[i]);
+		}
+
+		TEST_CHECK(culling.GetGroupCount() == (boundCount + SimdCulling::LANE_COUNT - 1) / SimdCulling::LANE_COUNT);
+
+		for (int g = 0; g < culling.GetGroupCount(); g++)
+		{
+			int visibleMask, ambiguousMask;
+			culling.TestGroup(g, visibleMask, ambiguousMask);
+
+			for (int lane = 0; lane < SimdCulling::LANE_COUNT; lane++)
+			{
+				int index = g * SimdCulling::LANE_COUNT + lane;
+				if (index < boundCount)
+				{
+					CheckLane(lane, visibleMask, ambiguousMask, frustum, bounds[index], ambiguous);
+					visible += (visibleMask >> lane) & 1;
+				}
+			}
+		}
+	}
+
+	// random boxes practically never sit on the outside threshold, and some of them are seen
+	TEST_CHECK(ambiguous < boundCount * 20 / 1000);
+	TEST_CHECK(visible > 0);
+}
+
+static void TestIndicesMatchesContains()
+{
+	const int boundCount = 257;
+	BoundingFrustum frustum = RandomFrustum();
+	SimdCulling culling;
+	culling.Resize(boundCount);
+	culling.SetFrustum(frustum);
+
+	vector<BoundingBox> bounds(boundCount);
+	for (int i = 0; i < boundCount; i++)
+	{
+		bounds[i] = RandomBox();
+		culling.SetBound(i, bounds[i]);
+	}
+
+	int ambiguous = 0;
+	for (int n = 0; n < 2000; n++)
+	{
+		int indices[SimdCulling::LANE_COUNT];
+		int count = 1 + (int)NextRandom(0.0f, (float)SimdCulling::LANE_COUNT - 0.01f);
+		for (int i = 0; i < count; i++)
+		{
+			indices[i] = (int)NextRandom(0.0f, boundCount - 0.01f);
+		}
+
+		int visibleMask, ambiguousMask;
+		culling.TestIndices(indices, count, visibleMask, ambiguousMask);
+
+		for (int lane = 0; lane < count; lane++)
+		{
+			CheckLane(lane, visibleMask, ambiguousMask, frustum, bounds[indices[lane]], ambiguous);
+		}
+	}
+
+	TEST_CHECK(ambiguous < 2000 / 100);
+}
+
+// boxes cut by a plane are visible straight away, only a box touching the outside of a plane
+// goes to the scalar test
+static void TestIntersectingIsVisible()
+{
+	BoundingFrustum frustum(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 100.0f);
+	SimdCulling culling;
+	culling.Resize(4);
+	culling.SetFrustum(frustum);
+
+	// far plane at z = 100, first box crosses it, second ends exactly there from outside,
+	// third is inside everything, fourth is past it
+	culling.SetBound(0, BoundingBox(XMFLOAT3(0.0f, 0.0f, 100.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	culling.SetBound(1, BoundingBox(XMFLOAT3(0.0f, 0.0f, 101.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	culling.SetBound(2, BoundingBox(XMFLOAT3(0.0f, 0.0f, 50.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	culling.SetBound(3, BoundingBox(XMFLOAT3(0.0f, 0.0f, 103.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+
+	int visibleMask, ambiguousMask;
+	culling.TestGroup(0, visibleMask, ambiguousMask);
+	TEST_CHECK(visibleMask == 0x5);
+	TEST_CHECK(ambiguousMask == 0x2);
+	TEST_CHECK(frustum.Contains(BoundingBox(XMFLOAT3(0.0f, 0.0f, 100.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))) == INTERSECTS);
+}
+
+int main()
+{
+	TEST_RUN(TestGroupMatchesContains);
+	TEST_RUN(TestIndicesMatchesContains);
+	TEST_RUN(TestIntersectingIsVisible);
+
+	return TestResult();
+}
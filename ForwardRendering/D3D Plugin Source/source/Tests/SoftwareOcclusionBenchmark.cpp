@@ -0,0 +1,79 @@
+#include "TestUtility.h"
+#include "SoftwareOcclusion.h"
+
+// one frame of occlusion culling the way RendererManager runs it, 32 box occluders rasterized
+// into the buffer, then every frustum visible bound queried against it
+int main()
+{
+	const int occluderCount = 32;
+	const int queryCount = 20000;
+	const float nearZ = 0.1f;
+	int iterations = BenchIterations(100);
+
+	uint32_t seed = 3;
+	auto rand = [&seed](float _min, float _max)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return _min + (_max - _min) * (float)(seed >> 8) / (float)(1 << 24);
+	};
+
+	XMFLOAT4X4 viewProj;
+	float aspect = (float)SoftwareOcclusion::BUFFER_WIDTH / SoftwareOcclusion::BUFFER_HEIGHT;
+	XMStoreFloat4x4(&viewProj, XMMatrixPerspectiveFovLH(1.0f, aspect, nearZ, 1000.0f));
+
+	// unit cube mesh, 12 triangles
+	XMFLOAT3 cube[8];
+	BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)).GetCorners(cube);
+	unsigned int cubeIndices[36] = { 0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1, 1, 5, 6, 1, 6, 2, 2, 6, 7, 2, 7, 3, 3, 7, 4, 3, 4, 0 };
+
+	// wide walls at mid distance
+	vector<XMFLOAT4X4> occluderWorlds(occluderCount);
+	for (int i = 0; i < occluderCount; i++)
+	{
+		XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(rand(2.0f, 8.0f), rand(2.0f, 6.0f), 0.5f), XMMatrixTranslation(rand(-30.0f, 30.0f), rand(-15.0f, 15.0f), rand(20.0f, 50.0f)));
+		XMStoreFloat4x4(&occluderWorlds[i], world);
+	}
+
+	vector<BoundingBox> queries(queryCount);
+	for (int i = 0; i < queryCount; i++)
+	{
+		queries[i] = BoundingBox(XMFLOAT3(rand(-60.0f, 60.0f), rand(-30.0f, 30.0f), rand(30.0f, 120.0f)), XMFLOAT3(rand(0.2f, 2.0f), rand(0.2f, 2.0f), rand(0.2f, 2.0f)));
+	}
+
+	SoftwareOcclusion occlusion;
+	occlusion.Init();
+
+	int triangleCount = 0;
+	int occludedCount = 0;
+	double rasterMs = 0.0;
+	double testMs = 0.0;
+
+	for (int n = 0; n < iterations; n++)
+	{
+		auto start = chrono::high_resolution_clock::now();
+		occlusion.BeginFrame(viewProj, nearZ);
+
+		triangleCount = 0;
+		for (int i = 0; i < occluderCount; i++)
+		{
+			triangleCount += occlusion.RasterizeTriangles(cube, 8, cubeIndices, 36, 0, occluderWorlds[i]);
+		}
+		occlusion.BuildHiZ();
+		rasterMs += ElapsedMs(start);
+
+		start = chrono::high_resolution_clock::now();
+		occludedCount = 0;
+		for (int i = 0; i < queryCount; i++)
+		{
+			occludedCount += occlusion.IsOccluded(queries[i]) ? 1 : 0;
+		}
+		testMs += ElapsedMs(start);
+	}
+
+	printf("occluders %d (%d triangles), queries %d, iterations %d, occluded %d\n", occluderCount, triangleCount, queryCount, iterations, occludedCount);
+	printf("rasterize + hiz: %.3f ms, test: %.3f ms (%.1f ns per bound) per frame\n", rasterMs / iterations, testMs / iterations, testMs * 1e6 / ((double)iterations * queryCount));
+
+	TEST_CHECK(triangleCount > 0);
+	TEST_CHECK(occludedCount > 0);
+	return TestResult();
+}
@@ -0,0 +1,242 @@
+#include "TestUtility.h"
+#include "SoftwareOcclusion.h"
+#include <algorithm>
+#include <cfloat>
+
+// samples per pixel side for the reference image, the grid includes pixel corners
+static const int REF_SAMPLES = 9;
+static const float NEAR_Z = 0.1f;
+
+struct ScreenTriangle
+{
+	XMFLOAT3 v[3];
+};
+
+static uint32_t randomState = 12345;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static XMFLOAT4X4 MakeViewProj()
+{
+	XMFLOAT4X4 viewProj;
+	float aspect = (float)SoftwareOcclusion::BUFFER_WIDTH / SoftwareOcclusion::BUFFER_HEIGHT;
+	XMStoreFloat4x4(&viewProj, XMMatrixPerspectiveFovLH(1.0f, aspect, NEAR_Z, 1000.0f));
+	return viewProj;
+}
+
+static XMFLOAT4X4 Identity()
+{
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, XMMatrixIdentity());
+	return m;
+}
+
+// same projection SoftwareOcclusion uses, screen xy and 1/w
+static XMFLOAT3 Project(const XMFLOAT3& _pos, const XMFLOAT4X4& _viewProj)
+{
+	XMFLOAT4 clip;
+	XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&_pos), XMLoadFloat4x4(&_viewProj)));
+
+	float invW = 1.0f / clip.w;
+	return XMFLOAT3((clip.x * invW * 0.5f + 0.5f) * SoftwareOcclusion::BUFFER_WIDTH, (clip.y * invW * 0.5f + 0.5f) * SoftwareOcclusion::BUFFER_HEIGHT, invW);
+}
+
+// exact nearest occluder 1/w at a screen point, 0 if nothing covers it
+static float ReferenceDepth(const vector<ScreenTriangle>& _tris, float _x, float _y)
+{
+	float nearest = 0.0f;
+	for (auto& t : _tris)
+	{
+		const XMFLOAT3& a = t.v[0];
+		const XMFLOAT3& b = t.v[1];
+		const XMFLOAT3& c = t.v[2];
+
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (fabsf(area) < 1e-6f)
+		{
+			continue;
+		}
+
+		float w0 = ((c.x - b.x) * (_y - b.y) - (c.y - b.y) * (_x - b.x)) / area;
+		float w1 = ((a.x - c.x) * (_y - c.y) - (a.y - c.y) * (_x - c.x)) / area;
+		float w2 = 1.0f - w0 - w1;
+		if (w0 < 0 || w1 < 0 || w2 < 0)
+		{
+			continue;
+		}
+
+		nearest = max(nearest, w0 * a.z + w1 * b.z + w2 * c.z);
+	}
+
+	return nearest;
+}
+
+// reference image, farthest of the nearest occluder over every sample of a pixel
+static vector<float> BuildReference(const vector<ScreenTriangle>& _tris)
+{
+	vector<float> reference(SoftwareOcclusion::BUFFER_WIDTH * SoftwareOcclusion::BUFFER_HEIGHT);
+	for (int y = 0; y < SoftwareOcclusion::BUFFER_HEIGHT; y++)
+	{
+		for (int x = 0; x < SoftwareOcclusion::BUFFER_WIDTH; x++)
+		{
+			float farthest = FLT_MAX;
+			for (int sy = 0; sy < REF_SAMPLES; sy++)
+			{
+				for (int sx = 0; sx < REF_SAMPLES; sx++)
+				{
+					float px = x + sx / (float)(REF_SAMPLES - 1);
+					float py = y + sy / (float)(REF_SAMPLES - 1);
+					farthest = min(farthest, ReferenceDepth(_tris, px, py));
+				}
+			}
+			reference[y * SoftwareOcclusion::BUFFER_WIDTH + x] = farthest;
+		}
+	}
+
+	return reference;
+}
+
+// rasterize random triangles in front of camera, they are also returned in screen space for the reference
+static void RasterizeRandomOccluders(SoftwareOcclusion& _occlusion, const XMFLOAT4X4& _viewProj, int _count, vector<ScreenTriangle>& _tris)
+{
+	vector<XMFLOAT3> positions;
+	vector<unsigned int> indices;
+	for (int i = 0; i < _count; i++)
+	{
+		float cx = NextRandom(-20.0f, 20.0f);
+		float cy = NextRandom(-12.0f, 12.0f);
+		float cz = NextRandom(15.0f, 60.0f);
+
+		ScreenTriangle t;
+		for (int k = 0; k < 3; k++)
+		{
+			XMFLOAT3 p(cx + NextRandom(-8.0f, 8.0f), cy + NextRandom(-8.0f, 8.0f), cz + NextRandom(-5.0f, 5.0f));
+			t.v[k] = Project(p, _viewProj);
+			indices.push_back((unsigned int)positions.size());
+			positions.push_back(p);
+		}
+		_tris.push_back(t);
+	}
+
+	_occlusion.RasterizeTriangles(positions.data(), (int)positions.size(), indices.data(), (int)indices.size(), 0, Identity());
+	_occlusion.BuildHiZ();
+}
+
+// no pixel may hold an occluder nearer than the farthest point of the occluders over that pixel
+static void TestDepthIsConservative()
+{
+	XMFLOAT4X4 viewProj = MakeViewProj();
+	SoftwareOcclusion occlusion;
+	occlusion.Init();
+	occlusion.BeginFrame(viewProj, NEAR_Z);
+
+	vector<ScreenTriangle> tris;
+	RasterizeRandomOccluders(occlusion, viewProj, 40, tris);
+	vector<float> reference = BuildReference(tris);
+
+	const vector<float>& depth = occlusion.GetDepthBuffer();
+	int overCount = 0;
+	int writtenCount = 0;
+	for (size_t i = 0; i < depth.size(); i++)
+	{
+		if (depth[i] > reference[i] * 1.0001f + 1e-7f)
+		{
+			overCount++;
+		}
+		writtenCount += (depth[i] > 0.0f) ? 1 : 0;
+	}
+
+	TEST_CHECK(overCount == 0);
+
+	// but doesn't give up on the interiors
+	TEST_CHECK(writtenCount > (int)depth.size() / 10);
+}
+
+// any box reported occluded must be behind occluders at every sample of its screen rect
+static void TestQueryIsConservative()
+{
+	XMFLOAT4X4 viewProj = MakeViewProj();
+	SoftwareOcclusion occlusion;
+	occlusion.Init();
+	occlusion.BeginFrame(viewProj, NEAR_Z);
+
+	vector<ScreenTriangle> tris;
+	RasterizeRandomOccluders(occlusion, viewProj, 40, tris);
+
+	int occludedCount = 0;
+	for (int i = 0; i < 3000; i++)
+	{
+		BoundingBox box(XMFLOAT3(NextRandom(-40.0f, 40.0f), NextRandom(-25.0f, 25.0f), NextRandom(20.0f, 100.0f)), XMFLOAT3(NextRandom(0.05f, 2.0f), NextRandom(0.05f, 2.0f), NextRandom(0.05f, 2.0f)));
+		if (!occlusion.IsOccluded(box))
+		{
+			continue;
+		}
+		occludedCount++;
+
+		XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+		box.GetCorners(corners);
+
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearestInvW = 0.0f;
+		for (size_t k = 0; k < BoundingBox::CORNER_COUNT; k++)
+		{
+			XMFLOAT3 s = Project(corners[k], viewProj);
+			minX = min(minX, s.x);
+			maxX = max(maxX, s.x);
+			minY = min(minY, s.y);
+			maxY = max(maxY, s.y);
+			nearestInvW = max(nearestInvW, s.z);
+		}
+
+		minX = max(minX, 0.0f);
+		minY = max(minY, 0.0f);
+		maxX = min(maxX, (float)SoftwareOcclusion::BUFFER_WIDTH);
+		maxY = min(maxY, (float)SoftwareOcclusion::BUFFER_HEIGHT);
+
+		bool hidden = true;
+		for (int sy = 0; sy < 16 && hidden; sy++)
+		{
+			for (int sx = 0; sx < 16 && hidden; sx++)
+			{
+				float px = minX + (maxX - minX) * sx / 15.0f;
+				float py = minY + (maxY - minY) * sy / 15.0f;
+				hidden = ReferenceDepth(tris, px, py) > nearestInvW;
+			}
+		}
+
+		TEST_CHECK(hidden);
+	}
+
+	// random scene should still have some hits
+	TEST_CHECK(occludedCount > 0);
+}
+
+// a box right behind a large wall is still occluded, away from the diagonal the two triangles share
+// since pixels crossing an edge between triangles stay empty
+static void TestWallOccludes()
+{
+	XMFLOAT4X4 viewProj = MakeViewProj();
+	SoftwareOcclusion occlusion;
+	occlusion.Init();
+	occlusion.BeginFrame(viewProj, NEAR_Z);
+
+	XMFLOAT3 wall[4] = { XMFLOAT3(-10.0f, -10.0f, 20.0f), XMFLOAT3(10.0f, -10.0f, 20.0f), XMFLOAT3(10.0f, 10.0f, 20.0f), XMFLOAT3(-10.0f, 10.0f, 20.0f) };
+	unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+	TEST_CHECK(occlusion.RasterizeTriangles(wall, 4, indices, 6, 0, Identity()) == 2);
+	occlusion.BuildHiZ();
+
+	TEST_CHECK(occlusion.IsOccluded(BoundingBox(XMFLOAT3(5.0f, -4.0f, 30.0f), XMFLOAT3(1.0f, 1.0f, 1.0f))));
+	TEST_CHECK(!occlusion.IsOccluded(BoundingBox(XMFLOAT3(0.0f, 0.0f, 15.0f), XMFLOAT3(2.0f, 2.0f, 2.0f))));
+	TEST_CHECK(!occlusion.IsOccluded(BoundingBox(XMFLOAT3(30.0f, 0.0f, 60.0f), XMFLOAT3(2.0f, 2.0f, 2.0f))));
+}
+
+int main()
+{
+	TEST_RUN(TestDepthIsConservative);
+	TEST_RUN(TestQueryIsConservative);
+	TEST_RUN(TestWallOccludes);
+
+	return TestResult();
+}
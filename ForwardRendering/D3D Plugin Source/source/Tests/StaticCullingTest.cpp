@@ -0,0 +1,208 @@
+#include "TestUtility.h"
+#include "StaticCulling.h"
+#include "AabbTree.h"
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cmath>
+
+static const int NUM_THREADS = 3;
+static const float FAR_Z = 200.0f;
+
+static uint32_t randomState = 99;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+static BoundingFrustum MakeFrustum(const XMFLOAT3& _pos, float _yaw)
+{
+	// rotation around y, a unit quaternion
+	return BoundingFrustum(_pos, XMFLOAT4(0.0f, sinf(_yaw * 0.5f), 0.0f, cosf(_yaw * 0.5f)), 1.2f, -1.2f, 0.7f, -0.7f, 0.3f, FAR_Z);
+}
+
+// static part of RendererManager culling: tree is queried with cache planes on rebuild,
+// candidates get the exact test unless the frustum didn't change
+struct StaticScene
+{
+	AabbTree tree;
+	vector<BoundingBox> bounds;
+	vector<int> proxies;
+	vector<int> subtreeRoots;
+	StaticCullingCache cache;
+	int version = 0;
+
+	StaticCullingState Cull(const BoundingFrustum& _frustum, vector<int>& _visible)
+	{
+		XMVECTOR p[6];
+		_frustum.GetPlanes(&p[0], &p[1], &p[2], &p[3], &p[4], &p[5]);
+		XMFLOAT4 planes[6];
+		for (int i = 0; i < 6; i++)
+		{
+			XMStoreFloat4(&planes[i], p[i]);
+		}
+
+		XMFLOAT3 corners[BoundingFrustum::CORNER_COUNT];
+		_frustum.GetCorners(corners);
+
+		StaticCullingState state = UpdateStaticCulling(cache, planes, corners, FAR_Z * STATIC_CULLING_MARGIN_RATIO, version, NUM_THREADS);
+
+		// subtrees are interleaved between threads like CullingWork does
+		if (state == StaticCullingState::Rebuild)
+		{
+			tree.GetSubtreeRoots(NUM_THREADS * 4, subtreeRoots);
+			for (int i = 0; i < (int)subtreeRoots.size(); i++)
+			{
+				vector<int>& candidates = cache.candidates[i % NUM_THREADS];
+				tree.QueryFrustum(subtreeRoots[i], cache.planes, StaticCullingCache::NUM_PLANES, candidates, candidates);
+			}
+		}
+
+		_visible.clear();
+		for (int t = 0; t < NUM_THREADS; t++)
+		{
+			if (state != StaticCullingState::Reuse)
+			{
+				cache.visible[t].clear();
+				for (int id : cache.candidates[t])
+				{
+					if (_frustum.Contains(bounds[id]) != DISJOINT)
+					{
+						cache.visible[t].push_back(id);
+					}
+				}
+			}
+			_visible.insert(_visible.end(), cache.visible[t].begin(), cache.visible[t].end());
+		}
+
+		sort(_visible.begin(), _visible.end());
+		return state;
+	}
+};
+
+static void BruteForce(const BoundingFrustum& _frustum, const vector<BoundingBox>& _bounds, vector<int>& _visible)
+{
+	_visible.clear();
+	for (int i = 0; i < (int)_bounds.size(); i++)
+	{
+		if (_frustum.Contains(_bounds[i]) != DISJOINT)
+		{
+			_visible.push_back(i);
+		}
+	}
+}
+
+// camera walks, turns, stops, teleports and a static renderer moves on the way,
+// every frame the cached result must be exactly the brute force one
+static void TestCameraPathMatchesBruteForce()
+{
+	StaticScene scene;
+	scene.tree.Init(0.5f);
+	for (int i = 0; i < 4000; i++)
+	{
+		BoundingBox b(XMFLOAT3(NextRandom(-300.0f, 300.0f), NextRandom(-30.0f, 30.0f), NextRandom(-300.0f, 300.0f)), XMFLOAT3(NextRandom(0.2f, 6.0f), NextRandom(0.2f, 6.0f), NextRandom(0.2f, 6.0f)));
+		scene.bounds.push_back(b);
+		scene.proxies.push_back(scene.tree.CreateProxy(b, i));
+	}
+
+	XMFLOAT3 pos(0.0f, 0.0f, 0.0f);
+	float yaw = 0.0f;
+	int stateCount[3] = { 0, 0, 0 };
+	int mismatchCount = 0;
+	vector<int> cached, expected;
+
+	for (int frame = 0; frame < 600; frame++)
+	{
+		int phase = (frame / 50) % 4;
+		if (phase == 0)
+		{
+			// walk forward
+			pos.x += sinf(yaw) * 0.4f;
+			pos.z += cosf(yaw) * 0.4f;
+		}
+		else if (phase == 1)
+		{
+			// turn on the spot
+			yaw += 0.004f;
+		}
+		else if (phase == 2 && frame % 10 == 0)
+		{
+			// mostly standing still, small strafe now and then
+			pos.x += cosf(yaw) * 0.2f;
+			pos.z -= sinf(yaw) * 0.2f;
+		}
+		else if (phase == 3)
+		{
+			// walk and turn together
+			yaw -= 0.003f;
+			pos.x += sinf(yaw) * 0.3f;
+			pos.z += cosf(yaw) * 0.3f;
+		}
+
+		// cut to another place
+		if (frame == 333)
+		{
+			pos = XMFLOAT3(-150.0f, 5.0f, 120.0f);
+			yaw = 2.0f;
+		}
+
+		// a static renderer moves into view, its version bump must rebuild the cache
+		if (frame == 420)
+		{
+			int id = (int)NextRandom(0.0f, (float)scene.bounds.size() - 0.01f);
+			scene.bounds[id].Center = XMFLOAT3(pos.x + sinf(yaw) * 20.0f, pos.y, pos.z + cosf(yaw) * 20.0f);
+			scene.tree.MoveProxy(scene.proxies[id], scene.bounds[id]);
+			scene.version++;
+		}
+
+		BoundingFrustum frustum = MakeFrustum(pos, yaw);
+		StaticCullingState state = scene.Cull(frustum, cached);
+		BruteForce(frustum, scene.bounds, expected);
+
+		stateCount[state]++;
+		mismatchCount += (cached == expected) ? 0 : 1;
+		if (frame == 333 || frame == 420)
+		{
+			TEST_CHECK(state == StaticCullingState::Rebuild);
+		}
+	}
+
+	TEST_CHECK(mismatchCount == 0);
+
+	// the path exercised every state, and the cache really saved tree traversals
+	printf("rebuild %d, retest %d, reuse %d\n", stateCount[StaticCullingState::Rebuild], stateCount[StaticCullingState::Retest], stateCount[StaticCullingState::Reuse]);
+	TEST_CHECK(stateCount[StaticCullingState::Reuse] > 0);
+	TEST_CHECK(stateCount[StaticCullingState::Retest] > stateCount[StaticCullingState::Rebuild]);
+	TEST_CHECK(stateCount[StaticCullingState::Rebuild] > 2);
+}
+
+// a different worker count splits candidates differently, so the cache must be rebuilt
+static void TestThreadCountChangeRebuilds()
+{
+	StaticCullingCache cache;
+	BoundingFrustum frustum = MakeFrustum(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+
+	XMVECTOR p[6];
+	frustum.GetPlanes(&p[0], &p[1], &p[2], &p[3], &p[4], &p[5]);
+	XMFLOAT4 planes[6];
+	for (int i = 0; i < 6; i++)
+	{
+		XMStoreFloat4(&planes[i], p[i]);
+	}
+	XMFLOAT3 corners[BoundingFrustum::CORNER_COUNT];
+	frustum.GetCorners(corners);
+
+	float margin = FAR_Z * STATIC_CULLING_MARGIN_RATIO;
+	TEST_CHECK(UpdateStaticCulling(cache, planes, corners, margin, 0, 2) == StaticCullingState::Rebuild);
+	TEST_CHECK(UpdateStaticCulling(cache, planes, corners, margin, 0, 2) == StaticCullingState::Reuse);
+	TEST_CHECK(UpdateStaticCulling(cache, planes, corners, margin, 0, 3) == StaticCullingState::Rebuild);
+	TEST_CHECK(UpdateStaticCulling(cache, planes, corners, margin, 1, 3) == StaticCullingState::Rebuild);
+}
+
+int main()
+{
+	TEST_RUN(TestCameraPathMatchesBruteForce);
+	TEST_RUN(TestThreadCountChangeRebuilds);
+
+	return TestResult();
+}
@@ -0,0 +1,116 @@
+#include "TestUtility.h"
+#include "SubmissionQueue.h"
+#include "JobSystem.h"
+#include <thread>
+
+// mock list that remembers which stage and worker recorded it
+struct MockList
+{
+	int stage;
+	int slot;
+};
+
+// workers finish in random order, flush still goes by (stage, slot)
+static void TestFlushOrder()
+{
+	const int numStages = 4;
+	const int numSlots = 6;
+
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	SubmissionQueue<MockList> queue;
+	queue.Init(numStages, numSlots);
+
+	MockList lists[numStages][numSlots];
+	for (int round = 0; round < 200; round++)
+	{
+		jobSystem.ParallelFor(numStages * numSlots, [&](int i)
+		{
+			int stage = i / numSlots;
+			int slot = i % numSlots;
+
+			// uneven work so deposits land in a different order every round
+			if ((i * 7 + round) % 5 == 0)
+			{
+				this_thread::yield();
+			}
+
+			lists[stage][slot].stage = stage;
+			lists[stage][slot].slot = slot;
+			queue.Deposit(stage, slot, &lists[stage][slot]);
+		});
+
+		int callCount = 0;
+		bool ordered = true;
+		int flushed = queue.Flush(0, numStages - 1, [&](MockList** _lists, int _count)
+		{
+			callCount++;
+			for (int i = 0; i < _count; i++)
+			{
+				ordered &= (_lists[i] == &lists[i / numSlots][i % numSlots]);
+			}
+		});
+
+		TEST_CHECK(flushed == numStages * numSlots);
+		TEST_CHECK(callCount == 1);
+		TEST_CHECK(ordered);
+	}
+
+	jobSystem.Release();
+}
+
+// flushing some stages leaves the others queued, empty slots are skipped
+static void TestPartialFlush()
+{
+	SubmissionQueue<MockList> queue;
+	queue.Init(3, 4);
+
+	MockList a = { 0, 3 };
+	MockList b = { 1, 0 };
+	MockList c = { 1, 2 };
+	MockList d = { 2, 1 };
+	queue.Deposit(2, 1, &d);
+	queue.Deposit(1, 2, &c);
+	queue.Deposit(0, 3, &a);
+	queue.Deposit(1, 0, &b);
+
+	vector<MockList*> executed;
+	auto collect = [&](MockList** _lists, int _count) { executed.insert(executed.end(), _lists, _lists + _count); };
+
+	TEST_CHECK(queue.Flush(0, 1, collect) == 3);
+	TEST_CHECK(executed.size() == 3 && executed[0] == &a && executed[1] == &b && executed[2] == &c);
+
+	executed.clear();
+	TEST_CHECK(queue.Flush(2, 2, collect) == 1);
+	TEST_CHECK(executed.size() == 1 && executed[0] == &d);
+
+	// already flushed, nothing is executed twice and execute isn't called for nothing
+	int callCount = 0;
+	TEST_CHECK(queue.Flush(0, 2, [&](MockList**, int) { callCount++; }) == 0);
+	TEST_CHECK(callCount == 0);
+}
+
+// deposits outside the queue are dropped
+static void TestOutOfRange()
+{
+	SubmissionQueue<MockList> queue;
+	queue.Init(2, 2);
+
+	MockList a = { 0, 0 };
+	queue.Deposit(-1, 0, &a);
+	queue.Deposit(2, 0, &a);
+	queue.Deposit(0, 2, &a);
+	queue.Deposit(0, -1, &a);
+
+	TEST_CHECK(queue.Flush(0, 1, [](MockList**, int) {}) == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestFlushOrder);
+	TEST_RUN(TestPartialFlush);
+	TEST_RUN(TestOutOfRange);
+
+	return TestResult();
+}
@@ -0,0 +1,231 @@
+#include "TestUtility.h"
+#include "TaskGraph.h"
+#include <mutex>
+
+static const int WORKER_COUNT = 4;
+
+// position of every task in the order they started
+struct RunLog
+{
+	mutex lock;
+	vector<int> started;
+
+	void Add(int _task)
+	{
+		lock_guard<mutex> guard(lock);
+		started.push_back(_task);
+	}
+
+	int PositionOf(int _task) const
+	{
+		for (int i = 0; i < (int)started.size(); i++)
+		{
+			if (started[i] == _task)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+};
+
+static void SleepMs(int _ms)
+{
+	this_thread::sleep_for(chrono::milliseconds(_ms));
+}
+
+// random layered graph, every task must start after all of its inputs have finished
+static void TestDependencyOrder()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	const int taskCount = 64;
+	TaskGraph graph;
+	vector<atomic<int>> finished(taskCount);
+	vector<vector<int>> inputs(taskCount);
+	atomic<int> brokenCount{ 0 };
+
+	for (int i = 0; i < taskCount; i++)
+	{
+		graph.AddTask("task" + to_string(i), [&, i]()
+		{
+			for (int d : inputs[i])
+			{
+				brokenCount += (finished[d].load() == 0) ? 1 : 0;
+			}
+			finished[i] = 1;
+		});
+	}
+
+	// edges only point backwards, so the graph is acyclic
+	uint32_t state = 7;
+	for (int i = 1; i < taskCount; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			state = state * 1664525u + 1013904223u;
+			int d = (int)((state >> 8) % (uint32_t)i);
+			TEST_CHECK(graph.AddDependency(i, d));
+			inputs[i].push_back(d);
+		}
+	}
+
+	// graph is built once and run many times, like the frame graph
+	for (int run = 0; run < 50; run++)
+	{
+		for (auto& f : finished)
+		{
+			f = 0;
+		}
+
+		TEST_CHECK(graph.Run(jobSystem));
+
+		int finishedCount = 0;
+		for (auto& f : finished)
+		{
+			finishedCount += f.load();
+		}
+		TEST_CHECK(finishedCount == taskCount);
+	}
+	TEST_CHECK(brokenCount == 0);
+
+	jobSystem.Release();
+}
+
+// independent branches of a diamond overlap, the join waits for both
+static void TestDiamond()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	RunLog log;
+	TaskGraph graph;
+	int top = graph.AddTask("top", [&]() { log.Add(0); });
+	int left = graph.AddTask("left", [&]() { log.Add(1); SleepMs(20); });
+	int right = graph.AddTask("right", [&]() { log.Add(2); SleepMs(20); });
+	int join = graph.AddTask("join", [&]() { log.Add(3); });
+
+	graph.AddDependency(left, top);
+	graph.AddDependency(right, top);
+	graph.AddDependency(join, left);
+	graph.AddDependency(join, right);
+
+	TEST_CHECK(graph.Run(jobSystem));
+	TEST_CHECK(log.started.size() == 4);
+	TEST_CHECK(log.PositionOf(0) == 0);
+	TEST_CHECK(log.PositionOf(3) == 3);
+
+	// both branches ran side by side
+	double overlapStart = max(graph.GetTaskStart(left), graph.GetTaskStart(right));
+	double overlapEnd = min(graph.GetTaskEnd(left), graph.GetTaskEnd(right));
+	TEST_CHECK(overlapEnd > overlapStart);
+	TEST_CHECK(graph.GetTaskStart(join) >= max(graph.GetTaskEnd(left), graph.GetTaskEnd(right)));
+
+	jobSystem.Release();
+}
+
+// a cycle fails the run before any task is executed, bad edges are refused when added
+static void TestRejectsInvalidGraph()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	atomic<int> runCount{ 0 };
+	TaskGraph graph;
+	int a = graph.AddTask("a", [&]() { runCount++; });
+	int b = graph.AddTask("b", [&]() { runCount++; });
+	int c = graph.AddTask("c", [&]() { runCount++; });
+	graph.AddTask("single", [&]() { runCount++; });
+
+	TEST_CHECK(!graph.AddDependency(a, a));
+	TEST_CHECK(!graph.AddDependency(a, -1));
+	TEST_CHECK(!graph.AddDependency(-1, a));
+	TEST_CHECK(!graph.AddDependency(a, graph.GetTaskCount()));
+	TEST_CHECK(!graph.AddDependency(graph.GetTaskCount(), a));
+
+	// refused edges leave the graph runnable
+	TEST_CHECK(graph.Run(jobSystem));
+	TEST_CHECK(runCount == 4);
+
+	runCount = 0;
+	TEST_CHECK(graph.AddDependency(b, a));
+	TEST_CHECK(graph.AddDependency(c, b));
+	TEST_CHECK(graph.AddDependency(a, c));
+	TEST_CHECK(!graph.Run(jobSystem));
+	TEST_CHECK(runCount == 0);
+
+	vector<int> path;
+	TEST_CHECK(graph.GetCriticalPath(path) == 0.0);
+	TEST_CHECK(path.empty());
+
+	// cleared graph can be built again
+	graph.Clear();
+	TEST_CHECK(graph.GetTaskCount() == 0);
+	TEST_CHECK(graph.Run(jobSystem));
+
+	jobSystem.Release();
+}
+
+// synthetic frame with known task lengths, critical path is the long chain even though it has fewer tasks
+static void TestCriticalPath()
+{
+	JobSystem jobSystem;
+	jobSystem.Init(WORKER_COUNT);
+
+	TaskGraph graph;
+	int begin = graph.AddTask("begin", [&]() { SleepMs(2); });
+	int cull = graph.AddTask("cull", [&]() { SleepMs(40); });
+	int sortA = graph.AddTask("sortA", [&]() { SleepMs(4); });
+	int sortB = graph.AddTask("sortB", [&]() { SleepMs(4); });
+	int sortC = graph.AddTask("sortC", [&]() { SleepMs(4); });
+	int record = graph.AddTask("record", [&]() { SleepMs(10); });
+	int upload = graph.AddTask("upload", [&]() { SleepMs(2); });
+
+	// begin > cull > record is 52 ms, begin > sortA > sortB > sortC > record is 24 ms, upload hangs off begin
+	graph.AddDependency(cull, begin);
+	graph.AddDependency(sortA, begin);
+	graph.AddDependency(sortB, sortA);
+	graph.AddDependency(sortC, sortB);
+	graph.AddDependency(record, cull);
+	graph.AddDependency(record, sortC);
+	graph.AddDependency(upload, begin);
+
+	TEST_CHECK(graph.Run(jobSystem));
+
+	vector<int> path;
+	double pathTime = graph.GetCriticalPath(path);
+
+	vector<int> expected = { begin, cull, record };
+	TEST_CHECK(path == expected);
+
+	// path time is the sum of its measured tasks
+	double sum = 0.0;
+	for (int i : path)
+	{
+		sum += graph.GetTaskTime(i);
+	}
+	TEST_CHECK_NEAR(pathTime, sum, 1e-6);
+	TEST_CHECK(pathTime >= 52.0);
+
+	// same report the frame profile shows
+	string report;
+	for (int i : path)
+	{
+		report += (report.empty()) ? graph.GetTaskName(i) : " > " + graph.GetTaskName(i);
+	}
+	printf("critical path %.2f ms: %s\n", pathTime, report.c_str());
+	TEST_CHECK(report == "begin > cull > record");
+
+	jobSystem.Release();
+}
+
+int main()
+{
+	TEST_RUN(TestDependencyOrder);
+	TEST_RUN(TestDiamond);
+	TEST_RUN(TestRejectsInvalidGraph);
+	TEST_RUN(TestCriticalPath);
+
+	return TestResult();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+using namespace std;
+
+// minimal check macros, a failed check is reported and the test returns non-zero at the end
+static int testFailCount = 0;
+
+#define TEST_CHECK(x) \
+	do \
+	{ \
+		if (!(x)) \
+		{ \
+			printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #x); \
+			testFailCount++; \
+		} \
+	} while (0)
+
+#define TEST_CHECK_NEAR(x, y, eps) \
+	do \
+	{ \
+		if (!((x) - (y) <= (eps) && (y) - (x) <= (eps))) \
+		{ \
+			printf("%s(%d): check failed: %s = %f, %s = %f\n", __FILE__, __LINE__, #x, (double)(x), #y, (double)(y)); \
+			testFailCount++; \
+		} \
+	} while (0)
+
+#define TEST_RUN(x) \
+	do \
+	{ \
+		printf("%s\n", #x); \
+		x(); \
+	} while (0)
+
+inline int TestResult()
+{
+	if (testFailCount > 0)
+	{
+		printf("%d check(s) failed\n", testFailCount);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
+
+// benchmarks take iteration count from SQ_BENCH_ITERATIONS, ctest sets a small one
+inline int BenchIterations(int _default)
+{
+	const char* env = getenv("SQ_BENCH_ITERATIONS");
+	return (env != nullptr) ? atoi(env) : _default;
+}
+
+// milliseconds since _start
+inline double ElapsedMs(const chrono::high_resolution_clock::time_point& _start)
+{
+	return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - _start).count();
+}
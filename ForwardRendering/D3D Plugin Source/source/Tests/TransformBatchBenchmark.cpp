@@ -0,0 +1,149 @@
+#include "TestUtility.h"
+#include "TransformBatch.h"
+#include "RendererPool.h"
+#include "AabbTree.h"
+#include "JobSystem.h"
+#include <cmath>
+
+static const int OBJECT_COUNT = 20000;
+
+static uint32_t randomState = 31;
+static float NextRandom(float _min, float _max)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return _min + (_max - _min) * (float)(randomState >> 8) / (float)(1 << 24);
+}
+
+// scene side of RendererManager, pool plus the scene tree that ApplyWorldBound moves
+struct TransformScene
+{
+	RendererPool pool;
+	AabbTree tree;
+	vector<int> proxies;
+	BoundingBox localBound = BoundingBox(XMFLOAT3(0.0f, 0.5f, 0.0f), XMFLOAT3(0.5f, 1.0f, 0.5f));
+
+	void Init()
+	{
+		tree.Init(0.5f);
+		for (int i = 0; i < OBJECT_COUNT; i++)
+		{
+			int handle = pool.Add(true);
+			proxies.push_back(tree.CreateProxy(pool.GetWorldBound(handle), handle));
+		}
+	}
+
+	// same as RendererManager::ApplyWorldBound without the culling lanes
+	void ApplyWorldBound(int _id)
+	{
+		tree.MoveProxy(proxies[_id], pool.GetWorldBound(_id));
+	}
+};
+
+static void RandomWorlds(vector<XMFLOAT4X4>& _worlds, float _time)
+{
+	for (int i = 0; i < (int)_worlds.size(); i++)
+	{
+		XMMATRIX m = XMMatrixRotationRollPitchYaw(0.0f, _time + i * 0.01f, 0.0f);
+		m = XMMatrixMultiply(m, XMMatrixTranslation(NextRandom(-500.0f, 500.0f), 0.0f, NextRandom(-500.0f, 500.0f)));
+		XMStoreFloat4x4(&_worlds[i], m);
+	}
+}
+
+// 20k moving objects each frame, one SetWorldMatrix per object against one batch applied by workers
+int main()
+{
+	int iterations = BenchIterations(100);
+	int numThreads = max((int)thread::hardware_concurrency() - 1, 1);
+
+	JobSystem jobSystem;
+	jobSystem.Init(numThreads);
+	int jobCount = numThreads * 4;
+
+	TransformScene perCall, batched;
+	perCall.Init();
+	batched.Init();
+
+	TransformBatch batch;
+	vector<XMFLOAT4X4> frameWorlds(OBJECT_COUNT);
+	double perCallMs = 0.0;
+	double submitMs = 0.0;
+	double applyMs = 0.0;
+
+	for (int n = 0; n < iterations; n++)
+	{
+		RandomWorlds(frameWorlds, n * 0.1f);
+
+		// per call: every object updates world, inverse, bound and tree on main thread when the script sets it
+		auto start = chrono::high_resolution_clock::now();
+		for (int i = 0; i < OBJECT_COUNT; i++)
+		{
+			perCall.pool.SetWorld(i, frameWorlds[i], perCall.localBound);
+			perCall.ApplyWorldBound(i);
+		}
+		perCallMs += ElapsedMs(start);
+
+		// batched: main thread only fills the reserved buffer, like SqGraphicManager does
+		start = chrono::high_resolution_clock::now();
+		int* ids;
+		XMFLOAT4X4* worlds;
+		batch.Reserve(OBJECT_COUNT, &ids, &worlds);
+		for (int i = 0; i < OBJECT_COUNT; i++)
+		{
+			ids[i] = i;
+			worlds[i] = frameWorlds[i];
+		}
+		batch.Commit(OBJECT_COUNT);
+		submitMs += ElapsedMs(start);
+
+		// same stages as TransformWork: prepare, worker slices, serial finish
+		start = chrono::high_resolution_clock::now();
+		if (batch.Prepare(batched.pool.GetCount()))
+		{
+			jobSystem.ParallelFor(jobCount, [&](int _job)
+			{
+				int sliceStart, sliceEnd;
+				batch.GetSlice(_job, jobCount, sliceStart, sliceEnd);
+				for (int i = sliceStart; i < sliceEnd; i++)
+				{
+					if (batch.IsApplied(i))
+					{
+						batched.pool.UpdateWorld(batch.GetID(i), batch.GetWorld(i), batched.localBound);
+					}
+				}
+			});
+
+			for (int i = 0; i < batch.GetCount(); i++)
+			{
+				if (batch.IsApplied(i))
+				{
+					batched.pool.MarkWorldDirty(batch.GetID(i));
+					batched.ApplyWorldBound(batch.GetID(i));
+				}
+			}
+			batch.Clear();
+		}
+		applyMs += ElapsedMs(start);
+	}
+
+	jobSystem.Release();
+
+	printf("objects %d, threads %d, iterations %d\n", OBJECT_COUNT, numThreads, iterations);
+	printf("SetWorldMatrix per object: %.3f ms per frame on main thread\n", perCallMs / iterations);
+	printf("Reserve/Commit batch: %.3f ms on main thread, %.3f ms applied on render thread and workers\n", submitMs / iterations, applyMs / iterations);
+
+	// both paths end in the same scene
+	int mismatchCount = 0;
+	for (int i = 0; i < OBJECT_COUNT; i++)
+	{
+		const BoundingBox& a = perCall.pool.GetWorldBound(i);
+		const BoundingBox& b = batched.pool.GetWorldBound(i);
+		bool same = a.Center.x == b.Center.x && a.Center.z == b.Center.z && a.Extents.x == b.Extents.x
+			&& perCall.pool.GetInvWorld(i)._41 == batched.pool.GetInvWorld(i)._41
+			&& perCall.pool.GetWorldVersion(i) == batched.pool.GetWorldVersion(i);
+		mismatchCount += same ? 0 : 1;
+	}
+	TEST_CHECK(mismatchCount == 0);
+	TEST_CHECK(batch.GetCount() == 0);
+
+	return TestResult();
+}
@@ -0,0 +1,120 @@
+#include "TestUtility.h"
+#include "DrawPartition.h"
+#include "SubmissionQueue.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <thread>
+
+// packet of the queue draw list, transparent ones are back-to-front after the opaque queues
+struct TestPacket
+{
+	int id;
+	unsigned int indexCount;
+	int instanceCount;
+	int material;
+	bool bindFails;
+};
+
+// mock command list that keeps the draws recorded into it
+struct MockList
+{
+	vector<int> draws;
+};
+
+static uint32_t randomState = 2718;
+static uint32_t NextRandom(uint32_t _range)
+{
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) % _range;
+}
+
+// same loop as DrawTransparentPass, a packet whose material can't bind is skipped
+static void RecordRange(const vector<TestPacket>& _packets, int _start, int _end, MockList& _list)
+{
+	for (int i = _start; i < _end; i++)
+	{
+		if (_packets[i].bindFails)
+		{
+			continue;
+		}
+		_list.draws.push_back(_packets[i].id);
+	}
+}
+
+// parts recorded on workers in any order and flushed in part order give the single-threaded draw stream
+static void TestParallelMatchesSingleThread()
+{
+	const int maxParts = 8;
+	const int transparentStage = 3;
+
+	JobSystem jobSystem;
+	jobSystem.Init(4);
+
+	SubmissionQueue<MockList> queue;
+	queue.Init(transparentStage + 1, maxParts);
+
+	for (int round = 0; round < 300; round++)
+	{
+		int opaqueCount = NextRandom(50);
+		int transparentCount = NextRandom(400);
+		int count = opaqueCount + transparentCount;
+
+		vector<TestPacket> packets(count);
+		for (int i = 0; i < count; i++)
+		{
+			packets[i].id = i;
+			packets[i].indexCount = 6 + NextRandom(30000);
+			packets[i].instanceCount = (NextRandom(20) == 0) ? 1 + NextRandom(200) : 1;
+			packets[i].material = NextRandom(5);
+			packets[i].bindFails = NextRandom(50) == 0;
+		}
+
+		// cost prefix as CompileDrawPackets builds it
+		vector<double> prefixCost(count + 1, 0.0);
+		for (int i = 0; i < count; i++)
+		{
+			bool stateChange = (i == 0) || (packets[i].material != packets[i - 1].material);
+			prefixCost[i + 1] = prefixCost[i] + EstimateDrawCost(packets[i].indexCount, packets[i].instanceCount, stateChange);
+		}
+
+		int numParts = 1 + NextRandom(maxParts);
+		vector<int> bounds(numParts + 1);
+		PartitionByCost(prefixCost, opaqueCount, count, numParts, bounds.data());
+
+		MockList single;
+		RecordRange(packets, opaqueCount, count, single);
+
+		vector<MockList> parts(numParts);
+		jobSystem.ParallelFor(numParts, [&](int _part)
+		{
+			// later parts often finish first
+			if (_part % 2 == 0)
+			{
+				this_thread::yield();
+			}
+
+			RecordRange(packets, bounds[_part], bounds[_part + 1], parts[_part]);
+			queue.Deposit(transparentStage, _part, &parts[_part]);
+		});
+
+		MockList merged;
+		queue.Flush(transparentStage, transparentStage, [&](MockList** _lists, int _count)
+		{
+			for (int i = 0; i < _count; i++)
+			{
+				merged.draws.insert(merged.draws.end(), _lists[i]->draws.begin(), _lists[i]->draws.end());
+			}
+		});
+
+		TEST_CHECK(merged.draws == single.draws);
+	}
+
+	jobSystem.Release();
+}
+
+int main()
+{
+	TEST_RUN(TestParallelMatchesSingleThread);
+
+	return TestResult();
+}
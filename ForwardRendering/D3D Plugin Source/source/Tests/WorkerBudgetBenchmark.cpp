@@ -0,0 +1,122 @@
+#include "TestUtility.h"
+#include "WorkerBudget.h"
+#include "JobSystem.h"
+#include <cmath>
+
+// same as ForwardRenderingPath
+static const int FINE_JOBS_PER_WORKER = 4;
+
+static void SpinMs(double _ms)
+{
+	auto start = chrono::steady_clock::now();
+	while (chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() < _ms)
+	{
+	}
+}
+
+// synthetic stage, every job pays a fixed setup like opening a command list, then runs its contiguous slice of items
+struct SyntheticStage
+{
+	const char* name;
+	int itemWork;
+	double jobSetupMs;
+	double initialItemCost;
+	double workerOverhead;
+};
+
+static double RunStage(JobSystem& _jobSystem, const SyntheticStage& _stage, int _itemCount, int _jobCount, vector<float>& _results, vector<int>& _runCount)
+{
+	auto start = chrono::steady_clock::now();
+	_jobSystem.ParallelFor(_jobCount, [&](int _job)
+	{
+		SpinMs(_stage.jobSetupMs);
+
+		int count = (_itemCount + _jobCount - 1) / _jobCount;
+		int begin = min(_job * count, _itemCount);
+		int end = min(begin + count, _itemCount);
+		for (int i = begin; i < end; i++)
+		{
+			float x = (float)i;
+			for (int k = 0; k < _stage.itemWork; k++)
+			{
+				x = sqrtf(x * 1.0001f + 1.0f);
+			}
+			_results[i] = x;
+			_runCount[i]++;
+		}
+	});
+
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// scene sizes swept through a cheap transform-like stage and a recording-like stage with per job setup,
+// every job count from the budget against always splitting into the most jobs
+int main()
+{
+	int iterations = BenchIterations(30);
+	int numThreads = max((int)thread::hardware_concurrency() - 1, 1);
+	int maxJobs = numThreads * FINE_JOBS_PER_WORKER;
+
+	JobSystem jobSystem;
+	jobSystem.Init(numThreads);
+
+	const SyntheticStage stages[2] =
+	{
+		{ "transform", 20, 0.0, 0.0005, 0.005 },
+		{ "record", 200, 0.05, 0.005, 0.05 },
+	};
+	const int sceneSizes[5] = { 50, 500, 5000, 20000, 50000 };
+
+	printf("threads %d, max jobs %d, iterations %d\n", numThreads, maxJobs, iterations);
+
+	int badJobCount = 0;
+	int badItems = 0;
+	for (const SyntheticStage& stage : stages)
+	{
+		for (int size : sceneSizes)
+		{
+			vector<float> results(size);
+			vector<int> runCount(size, 0);
+
+			double fixedMs = 0.0;
+			for (int n = 0; n < iterations; n++)
+			{
+				fixedMs += RunStage(jobSystem, stage, size, maxJobs, results, runCount);
+			}
+
+			// budget learns item cost for a few frames before it is timed, like after a scene load
+			StageCost cost(stage.initialItemCost, stage.workerOverhead);
+			for (int n = 0; n < 5; n++)
+			{
+				int jobCount = cost.ChooseWorkerCount(size, maxJobs);
+				cost.Record(size, jobCount, RunStage(jobSystem, stage, size, jobCount, results, runCount));
+			}
+
+			double budgetMs = 0.0;
+			int jobCount = 1;
+			for (int n = 0; n < iterations; n++)
+			{
+				jobCount = cost.ChooseWorkerCount(size, maxJobs);
+				double elapsed = RunStage(jobSystem, stage, size, jobCount, results, runCount);
+				cost.Record(size, jobCount, elapsed);
+				budgetMs += elapsed;
+				badJobCount += (jobCount < 1 || jobCount > maxJobs) ? 1 : 0;
+			}
+
+			printf("%s %6d items: max jobs %.3f ms, budget %2d jobs %.3f ms, item cost %.5f ms\n", stage.name, size
+				, fixedMs / iterations, jobCount, budgetMs / iterations, cost.GetItemCost());
+
+			// every item was processed by exactly one job in every run
+			for (int c : runCount)
+			{
+				badItems += (c == iterations * 2 + 5) ? 0 : 1;
+			}
+		}
+	}
+
+	jobSystem.Release();
+
+	TEST_CHECK(badJobCount == 0);
+	TEST_CHECK(badItems == 0);
+	return TestResult();
+}
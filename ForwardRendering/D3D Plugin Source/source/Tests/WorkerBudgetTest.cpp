@@ -0,0 +1,89 @@
+#include "TestUtility.h"
+#include "WorkerBudget.h"
+#include <cmath>
+
+// worker count follows sqrt(items * itemCost / overhead), clamped to items and max workers
+static void TestChooseWorkerCount()
+{
+	TEST_CHECK(ChooseWorkerCount(0, 1.0, 1.0, 8) == 1);
+	TEST_CHECK(ChooseWorkerCount(100, 1.0, 1.0, 1) == 1);
+	TEST_CHECK(ChooseWorkerCount(100, 0.01, 0.0, 8) == 8);
+	TEST_CHECK(ChooseWorkerCount(3, 0.01, 0.0, 8) == 3);
+
+	// sqrt(16 * 0.25 / 1) = 2
+	TEST_CHECK(ChooseWorkerCount(16, 0.25, 1.0, 8) == 2);
+	TEST_CHECK(ChooseWorkerCount(10000, 1.0, 0.001, 8) == 8);
+	TEST_CHECK(ChooseWorkerCount(4, 100.0, 0.001, 8) == 4);
+	TEST_CHECK(ChooseWorkerCount(100, 0.0, 1.0, 8) == 1);
+}
+
+// recording time that exactly follows the model converges to true item cost, whatever worker count was used
+static void TestStageCostConverges()
+{
+	const double trueCost = 0.02;
+	const double overhead = 0.05;
+	StageCost cost(0.001, overhead);
+
+	for (int frame = 0; frame < 200; frame++)
+	{
+		int items = 500 + (frame % 7) * 100;
+		int workers = cost.ChooseWorkerCount(items, 8);
+		double elapsed = items * trueCost / workers + workers * overhead;
+		cost.Record(items, workers, elapsed);
+	}
+
+	TEST_CHECK_NEAR(cost.GetItemCost(), trueCost, trueCost * 0.01);
+	TEST_CHECK(cost.GetWorkerOverhead() == overhead);
+
+	// empty frame doesn't move the estimate
+	double before = cost.GetItemCost();
+	cost.Record(0, 4, 10.0);
+	TEST_CHECK(cost.GetItemCost() == before);
+}
+
+// a single spike moves the estimate only by the smoothing weight
+static void TestStageCostSmoothing()
+{
+	StageCost cost(0.01, 0.0);
+	cost.Record(100, 1, 100.0 * 0.11);
+	TEST_CHECK_NEAR(cost.GetItemCost(), 0.01 + (0.11 - 0.01) * STAGE_COST_SMOOTH, 1e-9);
+}
+
+// stages that share one partition choose a count from summed costs, which minimizes summed model time
+static void TestSharedPartitionCount()
+{
+	const double costs[3] = { 0.002, 0.006, 0.004 };
+	const double overheads[3] = { 0.05, 0.05, 0.05 };
+	int items = 2000;
+
+	int chosen = ChooseWorkerCount(items, costs[0] + costs[1] + costs[2], overheads[0] + overheads[1] + overheads[2], 16);
+
+	double bestTime = 1e30;
+	int best = 1;
+	for (int n = 1; n <= 16; n++)
+	{
+		double time = 0.0;
+		for (int s = 0; s < 3; s++)
+		{
+			time += items * costs[s] / n + n * overheads[s];
+		}
+
+		if (time < bestTime)
+		{
+			bestTime = time;
+			best = n;
+		}
+	}
+
+	TEST_CHECK(abs(chosen - best) <= 1);
+}
+
+int main()
+{
+	TEST_RUN(TestChooseWorkerCount);
+	TEST_RUN(TestStageCostConverges);
+	TEST_RUN(TestStageCostSmoothing);
+	TEST_RUN(TestSharedPartitionCount);
+
+	return TestResult();
+}
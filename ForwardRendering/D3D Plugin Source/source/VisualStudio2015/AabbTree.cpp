@@ -0,0 +1,546 @@
+#include "AabbTree.h"
+#include <algorithm>
+#include <cmath>
+
+enum BoundClassify
+{
+	Outside = 0, Inside, Intersect
+};
+
+inline void UnionBound(const AabbNode& _a, const AabbNode& _b, XMFLOAT3& _min, XMFLOAT3& _max)
+{
+	_min = XMFLOAT3(min(_a.boundMin.x, _b.boundMin.x), min(_a.boundMin.y, _b.boundMin.y), min(_a.boundMin.z, _b.boundMin.z));
+	_max = XMFLOAT3(max(_a.boundMax.x, _b.boundMax.x), max(_a.boundMax.y, _b.boundMax.y), max(_a.boundMax.z, _b.boundMax.z));
+}
+
+inline float SurfaceArea(const XMFLOAT3& _min, const XMFLOAT3& _max)
+{
+	float dx = _max.x - _min.x;
+	float dy = _max.y - _min.y;
+	float dz = _max.z - _min.z;
+	return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+inline float UnionArea(const AabbNode& _a, const AabbNode& _b)
+{
+	XMFLOAT3 bMin, bMax;
+	UnionBound(_a, _b, bMin, bMax);
+	return SurfaceArea(bMin, bMax);
+}
+
+inline bool ContainsBound(const AabbNode& _node, const XMFLOAT3& _min, const XMFLOAT3& _max)
+{
+	return _node.boundMin.x <= _min.x && _node.boundMin.y <= _min.y && _node.boundMin.z <= _min.z
+		&& _node.boundMax.x >= _max.x && _node.boundMax.y >= _max.y && _node.boundMax.z >= _max.z;
+}
+
+inline BoundClassify ClassifyBound(const AabbNode& _node, const XMFLOAT4* _planes, int _numPlanes)
+{
+	float cx = (_node.boundMin.x + _node.boundMax.x) * 0.5f;
+	float cy = (_node.boundMin.y + _node.boundMax.y) * 0.5f;
+	float cz = (_node.boundMin.z + _node.boundMax.z) * 0.5f;
+	float ex = (_node.boundMax.x - _node.boundMin.x) * 0.5f;
+	float ey = (_node.boundMax.y - _node.boundMin.y) * 0.5f;
+	float ez = (_node.boundMax.z - _node.boundMin.z) * 0.5f;
+
+	bool allInside = true;
+	for (int i = 0; i < _numPlanes; i++)
+	{
+		const XMFLOAT4& p = _planes[i];
+		float dist = cx * p.x + cy * p.y + cz * p.z + p.w;
+		float radius = ex * fabsf(p.x) + ey * fabsf(p.y) + ez * fabsf(p.z);
+
+		// a node is only rejected/accepted when it is clear of the plane,
+		// so leaves below it get the same answer as an exact test
+		float margin = (radius + fabsf(dist)) * 1e-5f + 1e-5f;
+
+		if (dist > radius + margin)
+		{
+			return BoundClassify::Outside;
+		}
+
+		if (dist >= -radius - margin)
+		{
+			allInside = false;
+		}
+	}
+
+	return allInside ? BoundClassify::Inside : BoundClassify::Intersect;
+}
+
+void AabbTree::Init(float _fatMargin)
+{
+	Release();
+	fatMargin = _fatMargin;
+}
+
+void AabbTree::Release()
+{
+	nodes.clear();
+	root = NULL_NODE;
+	freeList = NULL_NODE;
+	proxyCount = 0;
+}
+
+int AabbTree::CreateProxy(const BoundingBox& _bound, int _userData)
+{
+	int proxy = AllocateNode();
+
+	AabbNode& n = nodes[proxy];
+	n.boundMin = XMFLOAT3(_bound.Center.x - _bound.Extents.x - fatMargin, _bound.Center.y - _bound.Extents.y - fatMargin, _bound.Center.z - _bound.Extents.z - fatMargin);
+	n.boundMax = XMFLOAT3(_bound.Center.x + _bound.Extents.x + fatMargin, _bound.Center.y + _bound.Extents.y + fatMargin, _bound.Center.z + _bound.Extents.z + fatMargin);
+	n.userData = _userData;
+	n.height = 0;
+
+	InsertLeaf(proxy);
+	proxyCount++;
+
+	return proxy;
+}
+
+void AabbTree::DestroyProxy(int _proxy)
+{
+	if (_proxy < 0 || _proxy >= (int)nodes.size() || !nodes[_proxy].IsLeaf())
+	{
+		return;
+	}
+
+	RemoveLeaf(_proxy);
+	FreeNode(_proxy);
+	proxyCount--;
+}
+
+bool AabbTree::MoveProxy(int _proxy, const BoundingBox& _bound)
+{
+	if (_proxy < 0 || _proxy >= (int)nodes.size() || !nodes[_proxy].IsLeaf())
+	{
+		return false;
+	}
+
+	XMFLOAT3 tightMin = XMFLOAT3(_bound.Center.x - _bound.Extents.x, _bound.Center.y - _bound.Extents.y, _bound.Center.z - _bound.Extents.z);
+	XMFLOAT3 tightMax = XMFLOAT3(_bound.Center.x + _bound.Extents.x, _bound.Center.y + _bound.Extents.y, _bound.Center.z + _bound.Extents.z);
+
+	// still inside fat bound, nothing to do
+	if (ContainsBound(nodes[_proxy], tightMin, tightMax))
+	{
+		return false;
+	}
+
+	RemoveLeaf(_proxy);
+
+	nodes[_proxy].boundMin = XMFLOAT3(tightMin.x - fatMargin, tightMin.y - fatMargin, tightMin.z - fatMargin);
+	nodes[_proxy].boundMax = XMFLOAT3(tightMax.x + fatMargin, tightMax.y + fatMargin, tightMax.z + fatMargin);
+
+	InsertLeaf(_proxy);
+
+	return true;
+}
+
+void AabbTree::GetSubtreeRoots(int _targetCount, vector<int>& _roots) const
+{
+	_roots.clear();
+	if (root == NULL_NODE)
+	{
+		return;
+	}
+
+	// breadth-first expand the top of tree until there are enough subtrees
+	_roots.push_back(root);
+	for (int i = 0; i < (int)_roots.size() && (int)_roots.size() < _targetCount; )
+	{
+		int n = _roots[i];
+		if (nodes[n].IsLeaf())
+		{
+			i++;
+			continue;
+		}
+
+		_roots[i] = nodes[n].child1;
+		_roots.push_back(nodes[n].child2);
+	}
+}
+
+void AabbTree::QueryFrustum(int _root, const XMFLOAT4* _planes, int _numPlanes, vector<int>& _inside, vector<int>& _intersect) const
+{
+	if (_root == NULL_NODE)
+	{
+		return;
+	}
+
+	int stack[MAX_STACK_SIZE];
+	int stackCount = 0;
+	stack[stackCount++] = _root;
+
+	while (stackCount > 0)
+	{
+		int n = stack[--stackCount];
+		const AabbNode& node = nodes[n];
+
+		BoundClassify result = ClassifyBound(node, _planes, _numPlanes);
+		if (result == BoundClassify::Outside)
+		{
+			continue;
+		}
+
+		// whole subtree accepted
+		if (result == BoundClassify::Inside)
+		{
+			CollectLeaves(n, _inside);
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			_intersect.push_back(node.userData);
+			continue;
+		}
+
+		// the tree is height balanced, stack can't overflow in practice
+		if (stackCount + 2 > MAX_STACK_SIZE)
+		{
+			CollectLeaves(n, _intersect);
+			continue;
+		}
+
+		stack[stackCount++] = node.child1;
+		stack[stackCount++] = node.child2;
+	}
+}
+
+int AabbTree::GetRoot() const
+{
+	return root;
+}
+
+int AabbTree::GetHeight() const
+{
+	return (root == NULL_NODE) ? 0 : nodes[root].height;
+}
+
+int AabbTree::GetProxyCount() const
+{
+	return proxyCount;
+}
+
+int AabbTree::AllocateNode()
+{
+	int id;
+	if (freeList == NULL_NODE)
+	{
+		nodes.push_back(AabbNode());
+		id = (int)nodes.size() - 1;
+	}
+	else
+	{
+		id = freeList;
+		freeList = nodes[id].parent;
+	}
+
+	AabbNode& n = nodes[id];
+	n.parent = NULL_NODE;
+	n.child1 = NULL_NODE;
+	n.child2 = NULL_NODE;
+	n.height = 0;
+	n.userData = -1;
+
+	return id;
+}
+
+void AabbTree::FreeNode(int _node)
+{
+	nodes[_node].parent = freeList;
+	nodes[_node].height = -1;
+	freeList = _node;
+}
+
+void AabbTree::InsertLeaf(int _leaf)
+{
+	if (root == NULL_NODE)
+	{
+		root = _leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	// find the best sibling by surface area heuristic
+	int index = root;
+	while (!nodes[index].IsLeaf())
+	{
+		const AabbNode& node = nodes[index];
+		int child1 = node.child1;
+		int child2 = node.child2;
+
+		float area = SurfaceArea(node.boundMin, node.boundMax);
+		float combinedArea = UnionArea(node, nodes[_leaf]);
+
+		// cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = UnionArea(nodes[_leaf], nodes[child1]) + inheritanceCost;
+		if (!nodes[child1].IsLeaf())
+		{
+			cost1 -= SurfaceArea(nodes[child1].boundMin, nodes[child1].boundMax);
+		}
+
+		float cost2 = UnionArea(nodes[_leaf], nodes[child2]) + inheritanceCost;
+		if (!nodes[child2].IsLeaf())
+		{
+			cost2 -= SurfaceArea(nodes[child2].boundMin, nodes[child2].boundMax);
+		}
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = (cost1 < cost2) ? child1 : child2;
+	}
+
+	int sibling = index;
+
+	// create a new parent, note AllocateNode may grow the node array
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	UnionBound(nodes[_leaf], nodes[sibling], nodes[newParent].boundMin, nodes[newParent].boundMax);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = _leaf;
+	nodes[sibling].parent = newParent;
+	nodes[_leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE)
+	{
+		if (nodes[oldParent].child1 == sibling)
+		{
+			nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		root = newParent;
+	}
+
+	// walk back up the tree fixing heights and bounds
+	index = nodes[_leaf].parent;
+	while (index != NULL_NODE)
+	{
+		index = Balance(index);
+
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+		nodes[index].height = 1 + max(nodes[child1].height, nodes[child2].height);
+		UnionBound(nodes[child1], nodes[child2], nodes[index].boundMin, nodes[index].boundMax);
+
+		index = nodes[index].parent;
+	}
+}
+
+void AabbTree::RemoveLeaf(int _leaf)
+{
+	if (_leaf == root)
+	{
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[_leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = (nodes[parent].child1 == _leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != NULL_NODE)
+	{
+		// destroy parent and connect sibling to grand parent
+		if (nodes[grandParent].child1 == parent)
+		{
+			nodes[grandParent].child1 = sibling;
+		}
+		else
+		{
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		// refit ancestors
+		int index = grandParent;
+		while (index != NULL_NODE)
+		{
+			index = Balance(index);
+
+			int child1 = nodes[index].child1;
+			int child2 = nodes[index].child2;
+			UnionBound(nodes[child1], nodes[child2], nodes[index].boundMin, nodes[index].boundMax);
+			nodes[index].height = 1 + max(nodes[child1].height, nodes[child2].height);
+
+			index = nodes[index].parent;
+		}
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+
+	nodes[_leaf].parent = NULL_NODE;
+}
+
+int AabbTree::Balance(int _iA)
+{
+	AabbNode& A = nodes[_iA];
+	if (A.IsLeaf() || A.height < 2)
+	{
+		return _iA;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	AabbNode& B = nodes[iB];
+	AabbNode& C = nodes[iC];
+
+	int balance = C.height - B.height;
+
+	// rotate C up
+	if (balance > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		AabbNode& F = nodes[iF];
+		AabbNode& G = nodes[iG];
+
+		// swap A and C
+		C.child1 = _iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		// A's old parent should point to C
+		if (C.parent != NULL_NODE)
+		{
+			if (nodes[C.parent].child1 == _iA)
+			{
+				nodes[C.parent].child1 = iC;
+			}
+			else
+			{
+				nodes[C.parent].child2 = iC;
+			}
+		}
+		else
+		{
+			root = iC;
+		}
+
+		// rotate
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = _iA;
+			UnionBound(B, G, A.boundMin, A.boundMax);
+			UnionBound(A, F, C.boundMin, C.boundMax);
+
+			A.height = 1 + max(B.height, G.height);
+			C.height = 1 + max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = _iA;
+			UnionBound(B, F, A.boundMin, A.boundMax);
+			UnionBound(A, G, C.boundMin, C.boundMax);
+
+			A.height = 1 + max(B.height, F.height);
+			C.height = 1 + max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	// rotate B up
+	if (balance < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		AabbNode& D = nodes[iD];
+		AabbNode& E = nodes[iE];
+
+		// swap A and B
+		B.child1 = _iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		// A's old parent should point to B
+		if (B.parent != NULL_NODE)
+		{
+			if (nodes[B.parent].child1 == _iA)
+			{
+				nodes[B.parent].child1 = iB;
+			}
+			else
+			{
+				nodes[B.parent].child2 = iB;
+			}
+		}
+		else
+		{
+			root = iB;
+		}
+
+		// rotate
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = _iA;
+			UnionBound(C, E, A.boundMin, A.boundMax);
+			UnionBound(A, D, B.boundMin, B.boundMax);
+
+			A.height = 1 + max(C.height, E.height);
+			B.height = 1 + max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = _iA;
+			UnionBound(C, D, A.boundMin, A.boundMax);
+			UnionBound(A, E, B.boundMin, B.boundMax);
+
+			A.height = 1 + max(C.height, D.height);
+			B.height = 1 + max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return _iA;
+}
+
+void AabbTree::CollectLeaves(int _node, vector<int>& _result) const
+{
+	int stack[MAX_STACK_SIZE];
+	int stackCount = 0;
+	stack[stackCount++] = _node;
+
+	while (stackCount > 0)
+	{
+		const AabbNode& node = nodes[stack[--stackCount]];
+		if (node.IsLeaf())
+		{
+			_result.push_back(node.userData);
+			continue;
+		}
+
+		stack[stackCount++] = node.child1;
+		stack[stackCount++] = node.child2;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+using namespace DirectX;
+using namespace std;
+
+struct AabbNode
+{
+	bool IsLeaf() const
+	{
+		return child1 == -1;
+	}
+
+	// fat bound for leaves, union of children for branches
+	XMFLOAT3 boundMin;
+	XMFLOAT3 boundMax;
+
+	int parent;		// next free node when the node is in free list
+	int child1;
+	int child2;
+	int height;		// 0 for leaf, -1 for free node
+	int userData;
+};
+
+// dynamic bounding volume hierarchy, leaves store fat bounds so small movement doesn't touch the tree
+class AabbTree
+{
+public:
+	static const int NULL_NODE = -1;
+
+	void Init(float _fatMargin);
+	void Release();
+
+	int CreateProxy(const BoundingBox& _bound, int _userData);
+	void DestroyProxy(int _proxy);
+	bool MoveProxy(int _proxy, const BoundingBox& _bound);
+
+	// split tree into at least _targetCount subtrees (if possible) for multithread traversal
+	void GetSubtreeRoots(int _targetCount, vector<int>& _roots) const;
+
+	// planes are normalized frustum planes with inside on negative side (BoundingFrustum::GetPlanes)
+	// leaves fully inside go to _inside, leaves crossing a plane go to _intersect
+	void QueryFrustum(int _root, const XMFLOAT4* _planes, int _numPlanes, vector<int>& _inside, vector<int>& _intersect) const;
+
+	int GetRoot() const;
+	int GetHeight() const;
+	int GetProxyCount() const;
+
+private:
+	static const int MAX_STACK_SIZE = 256;
+
+	int AllocateNode();
+	void FreeNode(int _node);
+	void InsertLeaf(int _leaf);
+	void RemoveLeaf(int _leaf);
+	int Balance(int _node);
+	void CollectLeaves(int _node, vector<int>& _result) const;
+
+	vector<AabbNode> nodes;
+	int root = NULL_NODE;
+	int freeList = NULL_NODE;
+	int proxyCount = 0;
+	float fatMargin = 0.0f;
+};
\ No newline at end of file
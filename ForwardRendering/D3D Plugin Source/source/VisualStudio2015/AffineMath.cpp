@@ -0,0 +1,59 @@
+#include "AffineMath.h"
+
+static XMMATRIX AffineInverseMatrix(const XMFLOAT4X4& _world)
+{
+	XMMATRIX m = XMLoadFloat4x4(&_world);
+
+	// columns of inverse(A) are cross products of rows, divided by determinant
+	XMVECTOR c0 = XMVector3Cross(m.r[1], m.r[2]);
+	XMVECTOR c1 = XMVector3Cross(m.r[2], m.r[0]);
+	XMVECTOR c2 = XMVector3Cross(m.r[0], m.r[1]);
+	XMVECTOR det = XMVector3Dot(m.r[0], c0);
+
+	XMVECTOR invDet = XMVectorSelect(XMVectorReciprocal(det), XMVectorZero(), XMVectorEqual(det, XMVectorZero()));
+	c0 = XMVectorMultiply(c0, invDet);
+	c1 = XMVectorMultiply(c1, invDet);
+	c2 = XMVectorMultiply(c2, invDet);
+
+	// cross products have w = 0, so the transposed rows keep column 3 at zero
+	XMMATRIX inv = XMMatrixTranspose(XMMATRIX(c0, c1, c2, XMVectorZero()));
+
+	XMVECTOR t = m.r[3];
+	XMVECTOR invT = XMVectorMultiply(XMVectorSplatX(t), inv.r[0]);
+	invT = XMVectorMultiplyAdd(XMVectorSplatY(t), inv.r[1], invT);
+	invT = XMVectorMultiplyAdd(XMVectorSplatZ(t), inv.r[2], invT);
+	inv.r[3] = XMVectorSetW(XMVectorNegate(invT), 1.0f);
+
+	return inv;
+}
+
+void AffineInverse(const XMFLOAT4X4& _world, XMFLOAT4X4& _invWorld)
+{
+	XMStoreFloat4x4(&_invWorld, AffineInverseMatrix(_world));
+}
+
+void AffineTransformBound(const BoundingBox& _local, const XMFLOAT4X4& _world, BoundingBox& _out)
+{
+	XMMATRIX m = XMLoadFloat4x4(&_world);
+	XMVECTOR c = XMLoadFloat3(&_local.Center);
+	XMVECTOR e = XMLoadFloat3(&_local.Extents);
+
+	XMVECTOR center = XMVectorMultiplyAdd(XMVectorSplatX(c), m.r[0], m.r[3]);
+	center = XMVectorMultiplyAdd(XMVectorSplatY(c), m.r[1], center);
+	center = XMVectorMultiplyAdd(XMVectorSplatZ(c), m.r[2], center);
+
+	XMVECTOR extents = XMVectorMultiply(XMVectorSplatX(e), XMVectorAbs(m.r[0]));
+	extents = XMVectorMultiplyAdd(XMVectorSplatY(e), XMVectorAbs(m.r[1]), extents);
+	extents = XMVectorMultiplyAdd(XMVectorSplatZ(e), XMVectorAbs(m.r[2]), extents);
+
+	XMStoreFloat3(&_out.Center, center);
+	XMStoreFloat3(&_out.Extents, extents);
+}
+
+void AffinePack3x4(const XMFLOAT4X4& _world, XMFLOAT4* _rows)
+{
+	XMMATRIX t = XMMatrixTranspose(XMLoadFloat4x4(&_world));
+	XMStoreFloat4(&_rows[0], t.r[0]);
+	XMStoreFloat4(&_rows[1], t.r[1]);
+	XMStoreFloat4(&_rows[2], t.r[2]);
+}
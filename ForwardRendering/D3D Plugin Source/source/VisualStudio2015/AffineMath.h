@@ -0,0 +1,18 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+using namespace DirectX;
+
+// kernels for affine world matrices (row vector convention, translation in row 3, column 3 is 0,0,0,1)
+// matrices from unity are always affine, so the general 4x4 inverse and 8-corner bound transform aren't needed
+
+// inverse of linear part by cross products, translation is -t * inverse(A)
+// singular matrix (zero scale) gives zero linear part instead of inf/nan
+void AffineInverse(const XMFLOAT4X4& _world, XMFLOAT4X4& _invWorld);
+
+// world center is local center transformed, world extents are local extents times |A|
+// same box as BoundingBox::Transform for affine matrix without visiting 8 corners
+void AffineTransformBound(const BoundingBox& _local, const XMFLOAT4X4& _world, BoundingBox& _out);
+
+// pack to 3 rows of column vector form (transpose without the 0,0,0,1 row), matches row_major float3x4 in shader
+void AffinePack3x4(const XMFLOAT4X4& _world, XMFLOAT4* _rows);
\ No newline at end of file
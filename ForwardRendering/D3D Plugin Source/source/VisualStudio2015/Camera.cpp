@@ -91,6 +91,7 @@ void Camera::ClearCamera(ID3D12GraphicsCommandList* _cmdList)
 	clearBarrier[1] = CD3DX12_RESOURCE_BARRIER::Transition(dsvSrc, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
 	_cmdList->ResourceBarrier(2, clearBarrier);
+	GRAPHIC_STAT_ADD(StatBarriers, 2)
 
 	// clear render target view and depth view (reversed-z)
 	_cmdList->ClearRenderTargetView(hRtv, cameraData.clearColor, 0, nullptr);
@@ -127,8 +128,12 @@ void Camera::ResolveDepthBuffer(ID3D12GraphicsCommandList* _cmdList, int _frameI
 
 	_cmdList->DrawInstanced(6, 1, 0, 0);
 	GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[0]);
+	GRAPHIC_STAT_DRAW(1, 2)
 
 	_cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(GetMsaaDsvSrc(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+	GRAPHIC_STAT_ADD(StatBarriers, 2)
+	GRAPHIC_STAT_ADD(StatRootParameters, 2)
+	GRAPHIC_STAT_ADD(StatDescriptorTables, 1)
 }
 
 CameraData *Camera::GetCameraData()
@@ -219,6 +224,7 @@ void Camera::SetViewProj(XMFLOAT4X4 _view, XMFLOAT4X4 _proj, XMFLOAT4X4 _projCul
 	invViewMatrix = _invView;
 	invProjMatrix = _invProj;
 	position = _position;
+	XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&_direction)));
 	farZ = _far;
 	nearZ = _near;
 
@@ -284,6 +290,11 @@ XMFLOAT3 Camera::GetPosition()
 	return position;
 }
 
+XMFLOAT3 Camera::GetDirection()
+{
+	return direction;
+}
+
 float Camera::GetFarZ()
 {
 	return farZ;
@@ -319,6 +330,11 @@ bool Camera::FrustumTest(BoundingBox _bound)
 	return (camFrustum.Contains(_bound) != DirectX::DISJOINT);
 }
 
+BoundingFrustum Camera::GetFrustum()
+{
+	return camFrustum;
+}
+
 Shader* Camera::GetFallbackShader()
 {
 	return wireFrameDebug;
@@ -91,12 +91,14 @@ public:
 	XMFLOAT4X4 GetInvView();
 	XMFLOAT4X4 GetInvProj();
 	XMFLOAT3 GetPosition();
+	XMFLOAT3 GetDirection();
 	float GetFarZ();
 	float GetNearZ();
 	Material *GetPipelineMaterial(MaterialType _type, CullMode _cullMode);
 	Material* GetResolveDepthMaterial();
 	RenderMode GetRenderMode();
 	bool FrustumTest(BoundingBox _bound);
+	BoundingFrustum GetFrustum();
 	Shader* GetFallbackShader();
 	RenderTargetData GetRenderTargetData();
 	void FillSystemConstant(SystemConstant& _sc);
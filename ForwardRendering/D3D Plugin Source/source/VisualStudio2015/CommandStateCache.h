@@ -0,0 +1,212 @@
+#pragma once
+#include <d3d12.h>
+
+// calls that reached the list since last TakeCount, grouped by kind
+struct StateCallCount
+{
+	int pipelineState;
+	int rootSignature;
+	int rootArgument;
+	int descriptorTable;
+	int inputAssembler;
+	int filtered;
+
+	int Issued() const
+	{
+		return pipelineState + rootSignature + rootArgument + descriptorTable + inputAssembler;
+	}
+};
+
+// thin recorder around a graphics command list, calls that set the same state again are dropped and counted
+// only state set through the cache is tracked, call Begin again after setting state on the list directly
+// list type is a template parameter, so the filtered stream can be checked with a mock list
+template<typename T> class CommandStateCache
+{
+public:
+	static const int MAX_ROOT_PARAMETERS = 16;
+
+	void Begin(T* _list)
+	{
+		list = _list;
+		Invalidate();
+	}
+
+	void Invalidate()
+	{
+		pso = nullptr;
+		rootSignature = nullptr;
+		topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		hasVertexBuffer = false;
+		hasIndexBuffer = false;
+		InvalidateRootArguments();
+	}
+
+	T* GetList() const
+	{
+		return list;
+	}
+
+	void SetPipelineState(ID3D12PipelineState* _pso)
+	{
+		if (_pso == pso)
+		{
+			count.filtered++;
+			return;
+		}
+
+		pso = _pso;
+		list->SetPipelineState(_pso);
+		count.pipelineState++;
+	}
+
+	void SetGraphicsRootSignature(ID3D12RootSignature* _rootSignature)
+	{
+		if (_rootSignature == rootSignature)
+		{
+			count.filtered++;
+			return;
+		}
+
+		// bindings of previous root signature are undefined after a change
+		rootSignature = _rootSignature;
+		InvalidateRootArguments();
+		list->SetGraphicsRootSignature(_rootSignature);
+		count.rootSignature++;
+	}
+
+	void SetGraphicsRootConstantBufferView(UINT _index, D3D12_GPU_VIRTUAL_ADDRESS _address)
+	{
+		if (!FilterRootArgument(_index, RootArgument::ConstantBufferView, _address))
+		{
+			list->SetGraphicsRootConstantBufferView(_index, _address);
+		}
+	}
+
+	void SetGraphicsRootShaderResourceView(UINT _index, D3D12_GPU_VIRTUAL_ADDRESS _address)
+	{
+		if (!FilterRootArgument(_index, RootArgument::ShaderResourceView, _address))
+		{
+			list->SetGraphicsRootShaderResourceView(_index, _address);
+		}
+	}
+
+	void SetGraphicsRootDescriptorTable(UINT _index, D3D12_GPU_DESCRIPTOR_HANDLE _table)
+	{
+		if (!FilterRootArgument(_index, RootArgument::DescriptorTable, _table.ptr))
+		{
+			list->SetGraphicsRootDescriptorTable(_index, _table);
+		}
+	}
+
+	// only slot 0 is cached, meshes of this plugin use one vertex stream
+	void IASetVertexBuffers(UINT _slot, const D3D12_VERTEX_BUFFER_VIEW* _view)
+	{
+		if (_slot == 0 && hasVertexBuffer && vertexBuffer.BufferLocation == _view->BufferLocation
+			&& vertexBuffer.SizeInBytes == _view->SizeInBytes && vertexBuffer.StrideInBytes == _view->StrideInBytes)
+		{
+			count.filtered++;
+			return;
+		}
+
+		if (_slot == 0)
+		{
+			vertexBuffer = *_view;
+			hasVertexBuffer = true;
+		}
+
+		list->IASetVertexBuffers(_slot, 1, _view);
+		count.inputAssembler++;
+	}
+
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* _view)
+	{
+		if (hasIndexBuffer && indexBuffer.BufferLocation == _view->BufferLocation
+			&& indexBuffer.SizeInBytes == _view->SizeInBytes && indexBuffer.Format == _view->Format)
+		{
+			count.filtered++;
+			return;
+		}
+
+		indexBuffer = *_view;
+		hasIndexBuffer = true;
+		list->IASetIndexBuffer(_view);
+		count.inputAssembler++;
+	}
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY _topology)
+	{
+		if (_topology == topology)
+		{
+			count.filtered++;
+			return;
+		}
+
+		topology = _topology;
+		list->IASetPrimitiveTopology(_topology);
+		count.inputAssembler++;
+	}
+
+	void DrawIndexedInstanced(UINT _indexCount, UINT _instanceCount, UINT _startIndex, INT _baseVertex, UINT _startInstance)
+	{
+		list->DrawIndexedInstanced(_indexCount, _instanceCount, _startIndex, _baseVertex, _startInstance);
+	}
+
+	// counts since last TakeCount, filtered + issued is what would be recorded without the cache
+	StateCallCount TakeCount()
+	{
+		StateCallCount result = count;
+		count = StateCallCount();
+		return result;
+	}
+
+private:
+	enum RootArgument
+	{
+		Unknown = 0, ConstantBufferView, ShaderResourceView, DescriptorTable
+	};
+
+	void InvalidateRootArguments()
+	{
+		for (int i = 0; i < MAX_ROOT_PARAMETERS; i++)
+		{
+			rootType[i] = RootArgument::Unknown;
+			rootValue[i] = 0;
+		}
+	}
+
+	// return true if the same argument is already bound, parameters above cache size are never filtered
+	bool FilterRootArgument(UINT _index, RootArgument _type, UINT64 _value)
+	{
+		if (_index < (UINT)MAX_ROOT_PARAMETERS)
+		{
+			if (rootType[_index] == _type && rootValue[_index] == _value)
+			{
+				count.filtered++;
+				return true;
+			}
+
+			rootType[_index] = _type;
+			rootValue[_index] = _value;
+		}
+
+		if (_type == RootArgument::DescriptorTable)
+			count.descriptorTable++;
+		else
+			count.rootArgument++;
+
+		return false;
+	}
+
+	T* list = nullptr;
+	ID3D12PipelineState* pso = nullptr;
+	ID3D12RootSignature* rootSignature = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer;
+	D3D12_INDEX_BUFFER_VIEW indexBuffer;
+	bool hasVertexBuffer = false;
+	bool hasIndexBuffer = false;
+	RootArgument rootType[MAX_ROOT_PARAMETERS];
+	UINT64 rootValue[MAX_ROOT_PARAMETERS];
+
+	StateCallCount count = StateCallCount();
+};
\ No newline at end of file
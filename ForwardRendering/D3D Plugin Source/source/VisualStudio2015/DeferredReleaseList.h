@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+using namespace std;
+
+// objects replaced while gpu may still use them, each one is kept until gpu completes the fence it was retired with
+// fence values are passed in, so the list doesn't depend on d3d and works with any counter
+class DeferredReleaseList
+{
+public:
+	void Add(const shared_ptr<void>& _object, uint64_t _fence)
+	{
+		Entry e;
+		e.fence = _fence;
+		e.object = _object;
+		entries.push_back(e);
+	}
+
+	// drop objects whose fence is completed, the rest keep their order
+	void Release(uint64_t _completedFence)
+	{
+		int keepCount = 0;
+		for (int i = 0; i < (int)entries.size(); i++)
+		{
+			if (entries[i].fence > _completedFence)
+			{
+				entries[keepCount++] = entries[i];
+			}
+		}
+
+		entries.resize(keepCount);
+	}
+
+	void Clear()
+	{
+		entries.clear();
+	}
+
+	int GetCount() const
+	{
+		return (int)entries.size();
+	}
+
+private:
+	struct Entry
+	{
+		uint64_t fence;
+		shared_ptr<void> object;
+	};
+	vector<Entry> entries;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <d3d12.h>
+#include <vector>
+using namespace std;
+
+class Material;
+
+// flattened draw compiled after sorting, recording threads only read these
+struct DrawPacket
+{
+	D3D12_VERTEX_BUFFER_VIEW vbv;
+	D3D12_INDEX_BUFFER_VIEW ibv;
+	UINT indexCount;
+	UINT startIndex;
+	INT baseVertex;
+	Material* material;
+	D3D12_GPU_VIRTUAL_ADDRESS instanceData;
+	D3D12_GPU_VIRTUAL_ADDRESS objectConstant;
+	int instanceCount;
+	int queue;
+};
+
+// packets of one render queue are stored in [start, start + count)
+struct DrawPacketRange
+{
+	int queue;
+	int start;
+	int count;
+	int partStart;	// offset of part bounds in draw bounds, -1 if range isn't split
+};
+
+// packets of one frame in sorted order, queue is the highest part of sort key so each queue is one contiguous range
+// vectors keep their capacity between frames, so compiling a frame no bigger than the last one doesn't allocate
+class DrawPacketStream
+{
+public:
+	void Clear()
+	{
+		packets.clear();
+		ranges.clear();
+	}
+
+	void Add(const DrawPacket& _dp)
+	{
+		if (ranges.size() == 0 || ranges.back().queue != _dp.queue)
+		{
+			DrawPacketRange range;
+			range.queue = _dp.queue;
+			range.start = (int)packets.size();
+			range.count = 0;
+			range.partStart = -1;
+			ranges.push_back(range);
+		}
+
+		packets.push_back(_dp);
+		ranges.back().count++;
+	}
+
+	const vector<DrawPacket>& GetPackets() const
+	{
+		return packets;
+	}
+
+	const vector<DrawPacketRange>& GetRanges() const
+	{
+		return ranges;
+	}
+
+	vector<DrawPacketRange>& GetRanges()
+	{
+		return ranges;
+	}
+
+private:
+	vector<DrawPacket> packets;
+	vector<DrawPacketRange> ranges;
+};
@@ -0,0 +1,37 @@
+#include "DrawPartition.h"
+#include <algorithm>
+
+double EstimateDrawCost(unsigned int _indexCount, int _instanceCount, bool _stateChange)
+{
+	double cost = DRAW_BASE_COST + (double)_indexCount * (double)max(_instanceCount, 1) * DRAW_INDEX_COST;
+	if (_stateChange)
+	{
+		cost += DRAW_STATE_CHANGE_COST;
+	}
+
+	return cost;
+}
+
+void PartitionByCost(const vector<double>& _prefixCost, int _start, int _end, int _numParts, int* _bounds)
+{
+	_bounds[0] = _start;
+	_bounds[_numParts] = _end;
+
+	double baseCost = _prefixCost[_start];
+	double totalCost = _prefixCost[_end] - baseCost;
+
+	for (int k = 1; k < _numParts; k++)
+	{
+		// first boundary whose prefix reaches the ideal split, then step back if previous one is closer
+		double target = baseCost + totalCost * k / _numParts;
+		int b = (int)(lower_bound(_prefixCost.begin() + _start, _prefixCost.begin() + _end, target) - _prefixCost.begin());
+
+		if (b > _start && target - _prefixCost[b - 1] < _prefixCost[b] - target)
+		{
+			b--;
+		}
+
+		// boundaries must not go backward, empty parts are fine
+		_bounds[k] = min(max(b, _bounds[k - 1]), _end);
+	}
+}
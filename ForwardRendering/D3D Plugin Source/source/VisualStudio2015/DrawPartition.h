@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+using namespace std;
+
+// relative cost of one draw packet, only ratios between packets matter
+// a draw call is the base unit, index work is weighted in so one heavy instanced batch counts as many draws
+const static double DRAW_BASE_COST = 1.0;
+const static double DRAW_INDEX_COST = 1.0 / 4096.0;
+const static double DRAW_STATE_CHANGE_COST = 2.0;
+
+double EstimateDrawCost(unsigned int _indexCount, int _instanceCount, bool _stateChange);
+
+// _prefixCost[i] is total cost of packets before i, packets [_start, _end) are split into _numParts contiguous parts
+// part k is [_bounds[k], _bounds[k + 1]), parts keep sort order, never overlap and cover every packet once
+void PartitionByCost(const vector<double>& _prefixCost, int _start, int _end, int _numParts, int* _bounds);
\ No newline at end of file
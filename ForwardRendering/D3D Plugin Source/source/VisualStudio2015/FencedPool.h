@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
+
+// objects handed out on demand, a recycled object is tagged with the fence value of its submission
+// and handed out again only after gpu completes that fence.
+// at the end of every trim window, free objects above the window's high water mark are destroyed
+// fence values are passed in, so the pool doesn't depend on d3d and works with any counter
+template<typename T> class FencedPool
+{
+public:
+	typedef function<T*()> CreateFunc;
+
+	void Init(const CreateFunc& _create, int _trimFrames)
+	{
+		create = _create;
+		trimFrames = _trimFrames;
+	}
+
+	void Clear()
+	{
+		lock_guard<mutex> lock(poolLock);
+		entries.clear();
+		highWater = 0;
+		windowFrames = 0;
+	}
+
+	// thread safe, return nullptr if a new object is needed and creation fails
+	T* Acquire(uint64_t _completedFence)
+	{
+		lock_guard<mutex> lock(poolLock);
+
+		// newest free entry first, it is most likely still in cache
+		int found = -1;
+		int freeCount = 0;
+		for (int i = (int)entries.size() - 1; i >= 0; i--)
+		{
+			if (!entries[i].inUse && entries[i].fence <= _completedFence)
+			{
+				found = (found == -1) ? i : found;
+				freeCount++;
+			}
+		}
+
+		if (found == -1)
+		{
+			T* object = create();
+			if (object == nullptr)
+			{
+				return nullptr;
+			}
+
+			Entry e;
+			e.object.reset(object);
+			e.fence = 0;
+			e.inUse = true;
+			entries.push_back(move(e));
+			highWater = max(highWater, (int)entries.size());
+
+			return object;
+		}
+
+		entries[found].inUse = true;
+		highWater = max(highWater, (int)entries.size() - freeCount + 1);
+
+		return entries[found].object.get();
+	}
+
+	// object must not be touched by caller after this, _fence is the value signaled after its submission
+	void Recycle(T* _object, uint64_t _fence)
+	{
+		lock_guard<mutex> lock(poolLock);
+
+		for (auto& e : entries)
+		{
+			if (e.object.get() == _object)
+			{
+				e.inUse = false;
+				e.fence = _fence;
+				return;
+			}
+		}
+	}
+
+	// once per frame, destroys free objects above the high water mark when trim window ends
+	void EndFrame(uint64_t _completedFence)
+	{
+		lock_guard<mutex> lock(poolLock);
+
+		if (++windowFrames < trimFrames)
+		{
+			return;
+		}
+
+		int excess = (int)entries.size() - highWater;
+		for (int i = (int)entries.size() - 1; i >= 0 && excess > 0; i--)
+		{
+			if (!entries[i].inUse && entries[i].fence <= _completedFence)
+			{
+				swap(entries[i], entries.back());
+				entries.pop_back();
+				excess--;
+			}
+		}
+
+		windowFrames = 0;
+		highWater = 0;
+	}
+
+	int GetCount()
+	{
+		lock_guard<mutex> lock(poolLock);
+		return (int)entries.size();
+	}
+
+	int GetHighWater()
+	{
+		lock_guard<mutex> lock(poolLock);
+		return highWater;
+	}
+
+private:
+	struct Entry
+	{
+		unique_ptr<T> object;
+		uint64_t fence;
+		bool inUse;
+	};
+
+	CreateFunc create;
+	vector<Entry> entries;
+	mutex poolLock;
+
+	// most objects needed at once in current trim window
+	int highWater = 0;
+	int windowFrames = 0;
+	int trimFrames = 1;
+};
\ No newline at end of file
@@ -9,93 +9,254 @@
 #include "d3dx12.h"
 #include <algorithm>
 
-void ForwardRenderingPath::CullingWork(Camera* _camera)
+void ForwardRenderingPath::RenderLoop(Camera* _camera, int _frameIdx)
 {
 	GRAPHIC_TIMER_START
 
 	currFrameResource = GraphicManager::Instance().GetFrameResource();
 	numWorkerThreads = GraphicManager::Instance().GetThreadCount() - 1;
 	targetCam = _camera;
+	frameIndex = _frameIdx;
+
+	// graph only holds task order, per frame state is read from members when tasks run
+	if (frameGraph.GetTaskCount() == 0)
+	{
+		BuildFrameGraph();
+		submitQueue.Init(SubmitStage::SubmitStageCount, MAX_WORKER_THREAD_COUNT);
+	}
 
-	workerType = WorkerType::Culling;
-	GraphicManager::Instance().WakeAndWaitWorker();
+	if (!GraphicManager::Instance().RunTaskGraph(frameGraph))
+	{
+		LogMessage(L"[SqGraphic Error] Frame task graph has a dependency cycle.");
+	}
 
-	GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.cullingTime)
+	// every task of this frame is done, per-thread counters can be summed without locks
+	FrameStatistics::Instance().Merge();
+
+	GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.renderTime)
+
+#if defined(GRAPHICTIME)
+	// stages overlap, so each entry is the cpu time of its tasks
+	GameTime& gameTime = GameTimerManager::Instance().gameTime;
+	gameTime.cullingTime = frameGraph.GetTaskTime(frameTasks[TransformTask]) + frameGraph.GetTaskTime(frameTasks[CullingTask]);
+	gameTime.sortingTime = frameGraph.GetTaskTime(frameTasks[SortCollectTask]) + frameGraph.GetTaskTime(frameTasks[InstanceSortTask])
+		+ frameGraph.GetTaskTime(frameTasks[QueueSortTask]) + frameGraph.GetTaskTime(frameTasks[FinishSortTask]);
+	gameTime.uploadTime = frameGraph.GetTaskTime(frameTasks[UploadInstanceTask]) + frameGraph.GetTaskTime(frameTasks[TopLevelASTask])
+		+ frameGraph.GetTaskTime(frameTasks[UploadConstantTask]);
+	gameTime.criticalPathTime = frameGraph.GetCriticalPath(criticalPath);
+	gameTime.recordThreadCount = recordThreadCount;
+	gameTime.transparentThreadCount = transparentThreadCount;
+
+	string& pathNames = GameTimerManager::Instance().criticalPath;
+	pathNames.clear();
+	for (int i : criticalPath)
+	{
+		pathNames += (pathNames.empty()) ? frameGraph.GetTaskName(i) : " > " + frameGraph.GetTaskName(i);
+	}
+#endif
 }
 
-void ForwardRenderingPath::SortingWork(Camera* _camera)
+void ForwardRenderingPath::BuildFrameGraph()
 {
-	GRAPHIC_TIMER_START
+	// tasks are added in FrameTask order, so task id equals enum value
+	frameTasks[TransformTask] = frameGraph.AddTask("Transform", [this]() { TransformWork(); });
+	frameTasks[CullingTask] = frameGraph.AddTask("Culling", [this]() { CullingWork(targetCam); });
+	frameTasks[SortCollectTask] = frameGraph.AddTask("SortCollect", [this]() { SortCollectWork(targetCam); });
+	frameTasks[InstanceSortTask] = frameGraph.AddTask("InstanceSort", [this]() { RadixSortWork(RendererManager::Instance().GetInstanceSorter(), incrementalSort); });
+	frameTasks[QueueSortTask] = frameGraph.AddTask("QueueSort", [this]() { RadixSortWork(RendererManager::Instance().GetQueueSorter(), incrementalSort); });
+	frameTasks[FinishSortTask] = frameGraph.AddTask("FinishSort", []() { RendererManager::Instance().FinishSortWork(); });
+	frameTasks[BeginFrameTask] = frameGraph.AddTask("BeginFrame", [this]() { BeginFrame(targetCam); });
+	frameTasks[CompileTask] = frameGraph.AddTask("CompileDrawPackets", [this]() { CompileWork(); });
+	frameTasks[UploadInstanceTask] = frameGraph.AddTask("UploadInstance", [this]() { UploadInstanceWork(); });
+	frameTasks[TopLevelASTask] = frameGraph.AddTask("UpdateTopLevelAS", [this]() { TopLevelASWork(); });
+	frameTasks[UploadConstantTask] = frameGraph.AddTask("UploadConstant", [this]() { UploadConstantWork(targetCam); });
+	frameTasks[PrePassTask] = frameGraph.AddTask("PrePass", [this]() { PrePassWork(targetCam); });
+	frameTasks[LightTask] = frameGraph.AddTask("LightWork", [this]() { GRAPHIC_STAT_PASS(StatLight) LightManager::Instance().LightWork(targetCam); });
+	frameTasks[OpaqueTask] = frameGraph.AddTask("Opaque", [this]() { opaqueCost.Record(recordItemCount, recordThreadCount, RecordStage(WorkerType::OpaqueRendering, SubmitStage::OpaqueSubmit, recordThreadCount)); });
+	frameTasks[CutoffTask] = frameGraph.AddTask("Cutoff", [this]() { cutoffCost.Record(recordItemCount, recordThreadCount, RecordStage(WorkerType::CutoffRendering, SubmitStage::CutoffSubmit, recordThreadCount)); });
+	frameTasks[TransparentTask] = frameGraph.AddTask("Transparent", [this]() { TransparentWork(targetCam); });
+	frameTasks[EndFrameTask] = frameGraph.AddTask("EndFrame", [this]() { EndFrame(targetCam); });
+
+	// world bounds -> visibility -> collected batch/queue lists
+	AddFrameDependency(CullingTask, TransformTask);
+	AddFrameDependency(SortCollectTask, CullingTask);
+
+	// two sorters don't share data
+	AddFrameDependency(InstanceSortTask, SortCollectTask);
+	AddFrameDependency(QueueSortTask, SortCollectTask);
+	AddFrameDependency(FinishSortTask, InstanceSortTask);
+	AddFrameDependency(FinishSortTask, QueueSortTask);
+
+	// packets follow sorted order, instance data only needs collected members
+	// upload writes only batch slots, which compile and top level AS don't read
+	AddFrameDependency(CompileTask, InstanceSortTask);
+	AddFrameDependency(CompileTask, QueueSortTask);
+	AddFrameDependency(UploadInstanceTask, SortCollectTask);
+
+	// top level AS reads visibility and records with main allocator after BeginFrame resets it
+	AddFrameDependency(TopLevelASTask, CullingTask);
+	AddFrameDependency(TopLevelASTask, BeginFrameTask);
+
+	// skybox constant is allocated from constant ring after CompileDrawPackets begins it
+	AddFrameDependency(UploadConstantTask, CompileTask);
+
+	// recording needs every input of draw packets, the rest is one chain on main command list
+	AddFrameDependency(PrePassTask, CompileTask);
+	AddFrameDependency(PrePassTask, UploadInstanceTask);
+	AddFrameDependency(PrePassTask, TopLevelASTask);
+	AddFrameDependency(PrePassTask, UploadConstantTask);
+	AddFrameDependency(LightTask, PrePassTask);
+	AddFrameDependency(OpaqueTask, LightTask);
+	AddFrameDependency(CutoffTask, OpaqueTask);
+	AddFrameDependency(TransparentTask, CutoffTask);
+	AddFrameDependency(EndFrameTask, TransparentTask);
+}
 
-	// sort work
-	RendererManager::Instance().SortWork(_camera);
+void ForwardRenderingPath::AddFrameDependency(FrameTask _task, FrameTask _dependsOn)
+{
+	frameGraph.AddDependency(frameTasks[_task], frameTasks[_dependsOn]);
+}
 
-	GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.sortingTime)
+void ForwardRenderingPath::TransformWork()
+{
+	// apply batched transforms before anything reads world bounds
+	if (RendererManager::Instance().PrepareTransformUpdate())
+	{
+		int count = RendererManager::Instance().GetPendingTransformCount();
+		int jobCount = transformCost.ChooseWorkerCount(count, numWorkerThreads * FINE_JOBS_PER_WORKER);
+		transformCost.Record(count, jobCount, RunStage(WorkerType::TransformUpdate, jobCount));
+		RendererManager::Instance().FinishTransformUpdate();
+	}
 }
 
-void ForwardRenderingPath::RenderLoop(Camera* _camera, int _frameIdx)
+void ForwardRenderingPath::CullingWork(Camera* _camera)
 {
-	GRAPHIC_TIMER_START
+	RendererManager::Instance().PrepareCulling(_camera);
 
-	targetCam = _camera;
-	frameIndex = _frameIdx;
+	RunStage(WorkerType::Culling, numWorkerThreads);
 
-	// begin frame
-	BeginFrame(_camera);
+	// occluders are picked from frustum results, then workers test their own visible lists
+	if (RendererManager::Instance().PrepareOcclusion(_camera))
+	{
+		RunStage(WorkerType::OcclusionCulling, numWorkerThreads);
+	}
+}
 
-	// upload work
-	UploadWork(_camera);
+void ForwardRenderingPath::SortCollectWork(Camera* _camera)
+{
+	// collect and build sort keys, sorters are run by their own tasks
+	RendererManager::Instance().SortWork(_camera, frameIndex);
+	incrementalSort = RendererManager::Instance().UseIncrementalSort();
+}
 
-	// pre pass work
-	PrePassWork(_camera);
+void ForwardRenderingPath::RadixSortWork(RadixSorter& _sorter, bool _incremental)
+{
+	// input is in last frame's order, usually only a few items move
+	if (_incremental && _sorter.SortIncremental())
+	{
+		return;
+	}
 
-	// light work
-	LightManager::Instance().LightWork(targetCam);
+	// small list isn't worth waking workers
+	if (_sorter.GetItemCount() < RadixSorter::PARALLEL_THRESHOLD)
+	{
+		_sorter.Sort();
+		return;
+	}
 
-	// opaque pass
-	workerType = WorkerType::OpaqueRendering;
-	GraphicManager::Instance().WakeAndWaitWorker();
+	// jobs capture the sorter, so both sorters can be split at the same time
+	_sorter.Begin(numWorkerThreads);
 
-	// cutoff pass
-	workerType = WorkerType::CutoffRendering;
-	GraphicManager::Instance().WakeAndWaitWorker();
+	while (_sorter.NextPass())
+	{
+		GraphicManager::Instance().RunWorkerJobs(numWorkerThreads, [&_sorter](int _jobIndex) { _sorter.Histogram(_jobIndex); });
 
-	// transparent pass, this can only be rendered with 1 thread for correct order
+		// scatter is skipped if all keys have the same digit
+		if (_sorter.PrefixSum())
+		{
+			GraphicManager::Instance().RunWorkerJobs(numWorkerThreads, [&_sorter](int _jobIndex) { _sorter.Scatter(_jobIndex); });
+		}
+	}
+
+	_sorter.End();
+}
+
+void ForwardRenderingPath::CompileWork()
+{
+	GRAPHIC_STAT_PASS(StatUpload)
+
+	// compile draw packets once, all recording threads read the same stream
+	GraphicManager::Instance().BeginConstantRing();
+	// recording parallelism follows batch count, a small scene records on one or two lists
+	// prepass, opaque and cutoff share one partition, so their summed costs choose one count for all three
+	recordItemCount = RendererManager::Instance().GetInstanceSorter().GetItemCount();
+	transparentItemCount = RendererManager::Instance().GetQueueSorter().GetItemCount();
+	recordThreadCount = ::ChooseWorkerCount(recordItemCount
+		, prePassCost.GetItemCost() + opaqueCost.GetItemCost() + cutoffCost.GetItemCost()
+		, prePassCost.GetWorkerOverhead() + opaqueCost.GetWorkerOverhead() + cutoffCost.GetWorkerOverhead(), numWorkerThreads);
+	transparentThreadCount = transparentCost.ChooseWorkerCount(transparentItemCount, numWorkerThreads);
+	RendererManager::Instance().CompileDrawPackets(frameIndex, recordThreadCount, transparentThreadCount);
+}
+
+void ForwardRenderingPath::TransparentWork(Camera* _camera)
+{
+	// skybox is executed first, then contiguous parts of back-to-front list are recorded in parallel
+	// and flushed in part order, so gpu blends them in exactly the single-threaded order
 	if (_camera->GetRenderMode() == RenderMode::ForwardPass)
 	{
 		DrawSkyboxPass(_camera);
-		DrawTransparentPass(_camera);
-	}
 
-	EndFrame(_camera);
-
-	GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.renderTime)
+		transparentCost.Record(transparentItemCount, transparentThreadCount, RecordStage(WorkerType::TransparentRendering, SubmitStage::TransparentSubmit, transparentThreadCount));
+	}
 }
 
-void ForwardRenderingPath::WorkerThread(int _threadIndex)
+StatPass ForwardRenderingPath::GetStatPass(WorkerType _type)
 {
-	while (true)
+	switch (_type)
 	{
-		// wait anything notify to work
-		GraphicManager::Instance().WaitBeginWorkerThread(_threadIndex);
+	case WorkerType::Upload:
+		return StatUpload;
+	case WorkerType::PrePassRendering:
+		return StatPrePass;
+	case WorkerType::OpaqueRendering:
+		return StatOpaque;
+	case WorkerType::CutoffRendering:
+		return StatCutoff;
+	case WorkerType::TransparentRendering:
+		return StatTransparent;
+	default:
+		return StatOther;
+	}
+}
 
-		GRAPHIC_TIMER_START
+void ForwardRenderingPath::WorkerJob(WorkerType _type, int _threadIndex, int _jobCount)
+{
+	// job index is used as thread index, it owns one command list and one slot of per-thread results
+	GRAPHIC_TIMER_START
+	GRAPHIC_STAT_PASS(GetStatPass(_type))
 
-		// culling work
-		if (workerType == WorkerType::Culling)
-		{
-			RendererManager::Instance().FrustumCulling(targetCam, _threadIndex);
-		}
-		else if (workerType == WorkerType::Upload)
-		{
-			RendererManager::Instance().UploadObjectConstant(frameIndex, _threadIndex, numWorkerThreads);
-			RendererManager::Instance().UploadInstanceData(frameIndex, _threadIndex, numWorkerThreads);
-		}
-		else if(workerType == WorkerType::PrePassRendering)
+	// culling work
+	if (_type == WorkerType::Culling)
+	{
+		RendererManager::Instance().FrustumCulling(targetCam, _threadIndex);
+	}
+	else if (_type == WorkerType::OcclusionCulling)
+	{
+		RendererManager::Instance().OcclusionCulling(_threadIndex);
+	}
+	else if (_type == WorkerType::TransformUpdate)
+	{
+		RendererManager::Instance().UpdateTransforms(_threadIndex, _jobCount);
+	}
+	else if (_type == WorkerType::Upload)
+	{
+		RendererManager::Instance().UploadInstanceData(frameIndex, _threadIndex, _jobCount);
+	}
+	else if(_type == WorkerType::PrePassRendering)
+	{
+		// process render thread, every mode except None closes the list it binds
+		if (targetCam->GetRenderMode() != RenderMode::None && BindForwardState(targetCam, _type, _threadIndex))
 		{
-			// process render thread
-			BindForwardState(targetCam, _threadIndex);
-
 			if (targetCam->GetRenderMode() == RenderMode::WireFrame)
 			{
 				DrawWireFrame(targetCam, _threadIndex);
@@ -110,47 +271,88 @@ void ForwardRenderingPath::WorkerThread(int _threadIndex)
 			{
 				DrawOpaqueNormalDepth(targetCam, _threadIndex);
 			}
-
-			GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.renderThreadTime[_threadIndex])
 		}
-		else if (workerType == WorkerType::OpaqueRendering)
-		{
-			if (targetCam->GetRenderMode() == RenderMode::ForwardPass)
-			{
-				BindForwardState(targetCam, _threadIndex);
-				DrawOpaquePass(targetCam, _threadIndex);
-			}
 
-			GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.renderThreadTime[_threadIndex])
+		GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.recordPassTime[GetStatPass(_type)][_threadIndex])
+	}
+	else if (_type == WorkerType::OpaqueRendering)
+	{
+		if (targetCam->GetRenderMode() == RenderMode::ForwardPass && BindForwardState(targetCam, _type, _threadIndex))
+		{
+			DrawOpaquePass(targetCam, _threadIndex);
 		}
-		else if (workerType == WorkerType::CutoffRendering)
+
+		GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.recordPassTime[GetStatPass(_type)][_threadIndex])
+	}
+	else if (_type == WorkerType::CutoffRendering)
+	{
+		if (targetCam->GetRenderMode() == RenderMode::ForwardPass && BindForwardState(targetCam, _type, _threadIndex))
 		{
-			if (targetCam->GetRenderMode() == RenderMode::ForwardPass)
-			{
-				BindForwardState(targetCam, _threadIndex);
-				DrawCutoutPass(targetCam, _threadIndex);
-			}
+			DrawCutoutPass(targetCam, _threadIndex);
+		}
 
-			GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.renderThreadTime[_threadIndex])
+		GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.recordPassTime[GetStatPass(_type)][_threadIndex])
+	}
+	else if (_type == WorkerType::TransparentRendering)
+	{
+		if (targetCam->GetRenderMode() == RenderMode::ForwardPass && BindForwardState(targetCam, _type, _threadIndex))
+		{
+			DrawTransparentPass(targetCam, _threadIndex);
 		}
 
-		// set worker finish
-		GraphicManager::Instance().SetWorkerThreadFinishEvent(_threadIndex);
+		GRAPHIC_TIMER_STOP_ADD(GameTimerManager::Instance().gameTime.recordPassTime[GetStatPass(_type)][_threadIndex])
 	}
 }
 
+double ForwardRenderingPath::RunStage(WorkerType _type, int _jobCount)
+{
+	auto stageStart = chrono::steady_clock::now();
+
+	// stage type is captured by its jobs instead of a shared member, stages of different tasks can overlap
+	GraphicManager::Instance().RunWorkerJobs(_jobCount, [this, _type, _jobCount](int _jobIndex)
+	{
+		WorkerJob(_type, _jobIndex, _jobCount);
+	});
+
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - stageStart).count();
+}
+
+double ForwardRenderingPath::RecordStage(WorkerType _type, SubmitStage _stage, int _jobCount)
+{
+	double elapsed = RunStage(_type, _jobCount);
+
+	// worker lists go to queue in thread order with one call, before main list of this stage is submitted
+	submitQueue.Flush(_stage, _stage, [](ID3D12CommandList** _lists, int _count)
+	{
+		GraphicManager::Instance().ExecuteCommandLists(_lists, _count);
+	});
+
+	// submitted lists go back to pool, they are reused after gpu finishes this frame
+	for (int i = 0; i < _jobCount; i++)
+	{
+		if (recordLists[i] != nullptr)
+		{
+			GraphicManager::Instance().RecycleCommandList(recordLists[i]);
+			recordLists[i] = nullptr;
+		}
+	}
+
+	return elapsed;
+}
+
+void ForwardRenderingPath::SubmitWorkerList(ID3D12GraphicsCommandList* _cmdList, SubmitStage _stage, int _threadIndex)
+{
+	// close now, the list is executed when its stage is flushed
+	LogIfFailedWithoutHR(_cmdList->Close());
+	submitQueue.Deposit(_stage, _threadIndex, _cmdList);
+}
+
 void ForwardRenderingPath::BeginFrame(Camera* _camera)
 {
 	// get frame resource
 	LogIfFailedWithoutHR(currFrameResource->mainGfxAllocator->Reset());
 	LogIfFailedWithoutHR(currFrameResource->mainGfxList->Reset(currFrameResource->mainGfxAllocator, nullptr));
 
-	// reset thread's allocator
-	for (int i = 0; i < numWorkerThreads; i++)
-	{
-		LogIfFailedWithoutHR(currFrameResource->workerGfxAlloc[i]->Reset());
-	}
-
 	auto _cmdList = currFrameResource->mainGfxList;
 
 	GPU_TIMER_START(_cmdList, GraphicManager::Instance().GetGpuTimeQuery())
@@ -162,18 +364,18 @@ void ForwardRenderingPath::BeginFrame(Camera* _camera)
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);
 }
 
-void ForwardRenderingPath::UploadWork(Camera *_camera)
+void ForwardRenderingPath::UploadInstanceWork()
 {
-	GRAPHIC_TIMER_START
-	workerType = WorkerType::Upload;
-	GraphicManager::Instance().WakeAndWaitWorker();
-
-	SystemConstant sc;
-	_camera->FillSystemConstant(sc);
-	LightManager::Instance().FillSystemConstant(sc);
+	GRAPHIC_STAT_PASS(StatUpload)
+	int count = RendererManager::Instance().GetInstanceBatchCount();
+	int jobCount = uploadCost.ChooseWorkerCount(count, numWorkerThreads * FINE_JOBS_PER_WORKER);
+	uploadCost.Record(count, jobCount, RunStage(WorkerType::Upload, jobCount));
+	RendererManager::Instance().FinishUploadInstanceData(frameIndex);
+}
 
-	GraphicManager::Instance().UploadSystemConstant(sc);
-	LightManager::Instance().UploadPerLightBuffer(frameIndex);
+void ForwardRenderingPath::TopLevelASWork()
+{
+	GRAPHIC_STAT_PASS(StatUpload)
 
 	// update ray tracing top level AS
 	auto _dxrList = GraphicManager::Instance().GetDxrList();
@@ -183,18 +385,29 @@ void ForwardRenderingPath::UploadWork(Camera *_camera)
 	RayTracingManager::Instance().UpdateTopAccelerationStructure(_dxrList);
 	GPU_TIMER_STOP(_dxrList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::UpdateTopLevelAS]);
 	GraphicManager::Instance().ExecuteCommandList(_dxrList);
+}
+
+void ForwardRenderingPath::UploadConstantWork(Camera* _camera)
+{
+	GRAPHIC_STAT_PASS(StatUpload)
 
-	GRAPHIC_TIMER_STOP(GameTimerManager::Instance().gameTime.uploadTime)
+	SystemConstant sc;
+	_camera->FillSystemConstant(sc);
+	LightManager::Instance().FillSystemConstant(sc);
+
+	GraphicManager::Instance().UploadSystemConstant(sc);
+	LightManager::Instance().UploadPerLightBuffer(frameIndex);
 }
 
 void ForwardRenderingPath::PrePassWork(Camera* _camera)
 {
+	GRAPHIC_STAT_PASS(StatPrePass)
+
 	auto _cmdList = currFrameResource->mainGfxList;
 	LogIfFailedWithoutHR(_cmdList->Reset(currFrameResource->mainGfxAllocator, nullptr));
 	GPU_TIMER_START(_cmdList, GraphicManager::Instance().GetGpuTimeQuery())
 
-	workerType = WorkerType::PrePassRendering;
-	GraphicManager::Instance().WakeAndWaitWorker();
+	prePassCost.Record(recordItemCount, recordThreadCount, RecordStage(WorkerType::PrePassRendering, SubmitStage::PrePassSubmit, recordThreadCount));
 
 	// resolve color/depth for other application
 	// for now color buffer is normal buffer
@@ -211,16 +424,26 @@ void ForwardRenderingPath::PrePassWork(Camera* _camera)
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
 }
 
-void ForwardRenderingPath::BindForwardState(Camera* _camera, int _threadIndex)
+bool ForwardRenderingPath::BindForwardState(Camera* _camera, WorkerType _type, int _threadIndex)
 {
-	// get frame resource
-	LogIfFailedWithoutHR(currFrameResource->workerGfxList[_threadIndex]->Reset(currFrameResource->workerGfxAlloc[_threadIndex], nullptr));
+	// every job records its own list from pool, it is recycled after its stage is submitted
+	recordLists[_threadIndex] = GraphicManager::Instance().AcquireCommandList();
+	if (recordLists[_threadIndex] == nullptr)
+	{
+		return false;
+	}
 
 	// update camera constant
 	CameraData* camData = _camera->GetCameraData();
-	auto _cmdList = currFrameResource->workerGfxList[_threadIndex];
+	auto _cmdList = recordLists[_threadIndex]->list.Get();
 
-	if (workerType == WorkerType::OpaqueRendering || workerType == WorkerType::CutoffRendering || workerType == WorkerType::PrePassRendering)
+	if (_type == WorkerType::OpaqueRendering || _type == WorkerType::CutoffRendering || _type == WorkerType::PrePassRendering)
+	{
+		GPU_TIMER_START(_cmdList, GraphicManager::Instance().GetGpuTimeQuery())
+	}
+
+	// transparent parts execute back to back, so one timer spans from first part to last part
+	if (_type == WorkerType::TransparentRendering && _threadIndex == 0)
 	{
 		GPU_TIMER_START(_cmdList, GraphicManager::Instance().GetGpuTimeQuery())
 	}
@@ -232,177 +455,199 @@ void ForwardRenderingPath::BindForwardState(Camera* _camera, int _threadIndex)
 	_cmdList->OMSetRenderTargets(1, rtv, true, dsv);
 	_cmdList->RSSetViewports(1, &_camera->GetViewPort());
 	_cmdList->RSSetScissorRects(1, &_camera->GetScissorRect());
-	_cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// draws of this list go through state cache from here on
+	stateCache[_threadIndex].Begin(_cmdList);
+	stateCache[_threadIndex].IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	return true;
 }
 
-void ForwardRenderingPath::BindDepthObject(ID3D12GraphicsCommandList* _cmdList, Camera* _camera, int _queue, Renderer* _renderer, Material* _mat, Mesh* _mesh
-	, D3D12_GPU_VIRTUAL_ADDRESS _instanceData)
+bool ForwardRenderingPath::BindPipelineMaterial(GraphicStateCache& _cache, Material* _mat)
+{
+	// same checks as MaterialManager::SetGraphicPass, but pso/root signature go through cache
+	if (!_mat->IsValid() || _mat->GetPSO() == nullptr || _mat->GetRootSignature() == nullptr)
+	{
+		return false;
+	}
+
+	_cache.SetPipelineState(_mat->GetPSO());
+	_cache.SetGraphicsRootSignature(_mat->GetRootSignature());
+
+	return true;
+}
+
+void ForwardRenderingPath::BindDepthObject(GraphicStateCache& _cache, const DrawPacket& _dp)
 {
 	// bind mesh
-	_cmdList->IASetVertexBuffers(0, 1, &_mesh->GetVertexBufferView());
-	_cmdList->IASetIndexBuffer(&_mesh->GetIndexBufferView());
+	_cache.IASetVertexBuffers(0, &_dp.vbv);
+	_cache.IASetIndexBuffer(&_dp.ibv);
 
 	// set system/object constant of renderer
-	_cmdList->SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
-	_cmdList->SetGraphicsRootShaderResourceView(1, _instanceData);
-	_cmdList->SetGraphicsRootConstantBufferView(2, _mat->GetMaterialConstantGPU(frameIndex));
+	_cache.SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
+	_cache.SetGraphicsRootShaderResourceView(1, _dp.instanceData);
+	_cache.SetGraphicsRootConstantBufferView(2, _dp.material->GetMaterialConstantGPU(frameIndex));
 
 	// setup descriptor table gpu
-	_cmdList->SetGraphicsRootDescriptorTable(3, ResourceManager::Instance().GetTexHeap()->GetGPUDescriptorHandleForHeapStart());
-	_cmdList->SetGraphicsRootDescriptorTable(4, ResourceManager::Instance().GetSamplerHeap()->GetGPUDescriptorHandleForHeapStart());
+	_cache.SetGraphicsRootDescriptorTable(3, ResourceManager::Instance().GetTexHeap()->GetGPUDescriptorHandleForHeapStart());
+	_cache.SetGraphicsRootDescriptorTable(4, ResourceManager::Instance().GetSamplerHeap()->GetGPUDescriptorHandleForHeapStart());
 }
 
-void ForwardRenderingPath::BindForwardObject(ID3D12GraphicsCommandList *_cmdList, Renderer* _renderer, Material* _mat, Mesh* _mesh
-	, D3D12_GPU_VIRTUAL_ADDRESS _instanceData)
+void ForwardRenderingPath::BindForwardObject(GraphicStateCache& _cache, const DrawPacket& _dp)
 {
 	// bind mesh
-	_cmdList->IASetVertexBuffers(0, 1, &_mesh->GetVertexBufferView());
-	_cmdList->IASetIndexBuffer(&_mesh->GetIndexBufferView());
+	_cache.IASetVertexBuffers(0, &_dp.vbv);
+	_cache.IASetIndexBuffer(&_dp.ibv);
 
 	// set system/object constant of renderer
-	_cmdList->SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
+	_cache.SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
 
 	// choose tile result for opaque/transparent obj
-	if (_mat->GetRenderQueue() <= RenderQueue::OpaqueLast)
-		_cmdList->SetGraphicsRootDescriptorTable(1, LightManager::Instance().GetForwardPlus()->GetLightCullingSrv());
+	if (_dp.queue <= RenderQueue::OpaqueLast)
+		_cache.SetGraphicsRootDescriptorTable(1, LightManager::Instance().GetForwardPlus()->GetLightCullingSrv());
 	else
-		_cmdList->SetGraphicsRootDescriptorTable(1, LightManager::Instance().GetForwardPlus()->GetLightCullingTransSrv());
+		_cache.SetGraphicsRootDescriptorTable(1, LightManager::Instance().GetForwardPlus()->GetLightCullingTransSrv());
+
+	_cache.SetGraphicsRootConstantBufferView(2, _dp.objectConstant);
+	_cache.SetGraphicsRootShaderResourceView(3, _dp.instanceData);
+	_cache.SetGraphicsRootConstantBufferView(4, _dp.material->GetMaterialConstantGPU(frameIndex));
+	_cache.SetGraphicsRootDescriptorTable(5, ResourceManager::Instance().GetTexHeap()->GetGPUDescriptorHandleForHeapStart());
+	_cache.SetGraphicsRootDescriptorTable(6, ResourceManager::Instance().GetSamplerHeap()->GetGPUDescriptorHandleForHeapStart());
+	_cache.SetGraphicsRootShaderResourceView(7, LightManager::Instance().GetLightDataGPU(LightType::Directional, frameIndex, 0));
+	_cache.SetGraphicsRootShaderResourceView(8, LightManager::Instance().GetLightDataGPU(LightType::Point, frameIndex, 0));
+}
+
+void ForwardRenderingPath::DrawPacketMesh(GraphicStateCache& _cache, const DrawPacket& _dp)
+{
+	_cache.DrawIndexedInstanced(_dp.indexCount, _dp.instanceCount, _dp.startIndex, _dp.baseVertex, 0);
+	GRAPHIC_STAT_DRAW(_dp.instanceCount, (uint64_t)(_dp.indexCount / 3) * _dp.instanceCount)
+}
+
+void ForwardRenderingPath::AddStateCount(GraphicStateCache& _cache, int _threadIndex)
+{
+	StateCallCount count = _cache.TakeCount();
+
+#if defined(GRAPHICTIME)
+	GameTimerManager::Instance().gameTime.stateIssuedCount[_threadIndex] += count.Issued();
+	GameTimerManager::Instance().gameTime.stateFilteredCount[_threadIndex] += count.filtered;
+#endif
 
-	_cmdList->SetGraphicsRootConstantBufferView(2, _renderer->GetObjectConstantGPU(frameIndex));
-	_cmdList->SetGraphicsRootShaderResourceView(3, _instanceData);
-	_cmdList->SetGraphicsRootConstantBufferView(4, _mat->GetMaterialConstantGPU(frameIndex));
-	_cmdList->SetGraphicsRootDescriptorTable(5, ResourceManager::Instance().GetTexHeap()->GetGPUDescriptorHandleForHeapStart());
-	_cmdList->SetGraphicsRootDescriptorTable(6, ResourceManager::Instance().GetSamplerHeap()->GetGPUDescriptorHandleForHeapStart());
-	_cmdList->SetGraphicsRootShaderResourceView(7, LightManager::Instance().GetLightDataGPU(LightType::Directional, frameIndex, 0));
-	_cmdList->SetGraphicsRootShaderResourceView(8, LightManager::Instance().GetLightDataGPU(LightType::Point, frameIndex, 0));
+	GRAPHIC_STAT_ADD(StatPsoSwitches, count.pipelineState)
+	GRAPHIC_STAT_ADD(StatRootParameters, count.rootArgument)
+	GRAPHIC_STAT_ADD(StatDescriptorTables, count.descriptorTable)
+}
+
+void ForwardRenderingPath::GetPacketChunk(const DrawPacketRange& _range, int _threadIndex, int& _start, int& _end)
+{
+	// parts are balanced by estimated cost when packets are compiled, each thread draws one of them
+	const vector<int>& bounds = RendererManager::Instance().GetInstanceDrawBounds();
+	_start = bounds[_range.partStart + _threadIndex];
+	_end = bounds[_range.partStart + _threadIndex + 1];
 }
 
 void ForwardRenderingPath::DrawWireFrame(Camera* _camera, int _threadIndex)
 {
-	auto _cmdList = currFrameResource->workerGfxList[_threadIndex];
+	auto _cmdList = recordLists[_threadIndex]->list.Get();
+	GraphicStateCache& cache = stateCache[_threadIndex];
 	
 	// set debug wire frame material
 	Material *mat = _camera->GetPipelineMaterial(MaterialType::DebugWireFrame, CullMode::Off);
-	if (!MaterialManager::Instance().SetGraphicPass(_cmdList, mat))
+	if (!BindPipelineMaterial(cache, mat))
 	{
+		// pooled list must be closed before it is recycled
+		SubmitWorkerList(_cmdList, SubmitStage::PrePassSubmit, _threadIndex);
 		return;
 	}
 
 	// loop render-queue
-	auto instanceRenderers = RendererManager::Instance().GetInstanceRenderers();
-	for (auto const& qr : instanceRenderers)
+	const vector<DrawPacket>& packets = RendererManager::Instance().GetInstanceDrawPackets();
+	for (auto const& range : RendererManager::Instance().GetInstanceDrawRanges())
 	{
-		auto renderers = qr.second;
-		int count = (int)renderers.size() / numWorkerThreads + 1;
-		int start = _threadIndex * count;
+		int start, end;
+		GetPacketChunk(range, _threadIndex, start, end);
 
-		for (int i = start; i <= start + count; i++)
+		for (int i = start; i < end; i++)
 		{
-			// valid renderer
-			if (!RendererManager::Instance().ValidRenderer(i, renderers))
-			{
-				continue;
-			}
-
 			// bind mesh
-			auto r = renderers[i];
-			if (r.GetInstanceCount() == 0)
-			{
-				continue;
-			}
-
-			Mesh *m = r.cache->GetMesh();
-			_cmdList->IASetVertexBuffers(0, 1, &m->GetVertexBufferView());
-			_cmdList->IASetIndexBuffer(&m->GetIndexBufferView());
+			const DrawPacket& dp = packets[i];
+			cache.IASetVertexBuffers(0, &dp.vbv);
+			cache.IASetIndexBuffer(&dp.ibv);
 
 			// set system constant of renderer
-			_cmdList->SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
-			_cmdList->SetGraphicsRootShaderResourceView(1, r.GetInstanceDataGPU(frameIndex));
+			cache.SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
+			cache.SetGraphicsRootShaderResourceView(1, dp.instanceData);
 
 			// draw mesh
-			m->DrawSubMesh(_cmdList, r.submeshIndex, r.GetInstanceCount());
+			DrawPacketMesh(cache, dp);
 			GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[_threadIndex])
 		}
 	}
 
 	// close command list and execute
-	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
+	AddStateCount(cache, _threadIndex);
+	SubmitWorkerList(_cmdList, SubmitStage::PrePassSubmit, _threadIndex);
 }
 
 void ForwardRenderingPath::DrawOpaqueNormalDepth(Camera* _camera, int _threadIndex)
 {
-	auto _cmdList = currFrameResource->workerGfxList[_threadIndex];
+	auto _cmdList = recordLists[_threadIndex]->list.Get();
+	GraphicStateCache& cache = stateCache[_threadIndex];
 
 	// bind descriptor heap, only need to set once, changing descriptor heap isn't good
 	ID3D12DescriptorHeap* descriptorHeaps[] = { ResourceManager::Instance().GetTexHeap(),ResourceManager::Instance().GetSamplerHeap() };
 	_cmdList->SetDescriptorHeaps(2, descriptorHeaps);
 
 	// loop render-queue
-	auto instanceRenderers = RendererManager::Instance().GetInstanceRenderers();
-	for (auto const& qr : instanceRenderers)
+	const vector<DrawPacket>& packets = RendererManager::Instance().GetInstanceDrawPackets();
+	for (auto const& range : RendererManager::Instance().GetInstanceDrawRanges())
 	{
-		auto renderers = qr.second;
-		int count = (int)renderers.size() / numWorkerThreads + 1;
-		int start = _threadIndex * count;
-
 		// don't draw transparent
-		if (qr.first > RenderQueue::OpaqueLast)
+		if (range.queue > RenderQueue::OpaqueLast)
 		{
 			continue;
 		}
 
+		int start, end;
+		GetPacketChunk(range, _threadIndex, start, end);
+
 		Material* lastMat = nullptr;
-		for (int i = start; i <= start + count; i++)
+		for (int i = start; i < end; i++)
 		{
-			// valid renderer
-			if (!RendererManager::Instance().ValidRenderer(i, renderers))
-			{
-				continue;
-			}
-
-			// instance check
-			auto r = renderers[i];
-			if (r.GetInstanceCount() == 0)
-			{
-				continue;
-			}
-
-			Mesh* m = r.cache->GetMesh();
+			const DrawPacket& dp = packets[i];
 
 			// choose pipeline material according to renderqueue
-			Material* const objMat = r.cache->GetMaterial(r.submeshIndex);
-
 			Material* pipeMat = nullptr;
-			if (qr.first < RenderQueue::CutoffStart)
+			if (range.queue < RenderQueue::CutoffStart)
 			{
-				pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassOpaque, objMat->GetCullMode());
+				pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassOpaque, dp.material->GetCullMode());
 			}
-			else if (qr.first >= RenderQueue::CutoffStart)
+			else if (range.queue >= RenderQueue::CutoffStart)
 			{
-				pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassCutoff, objMat->GetCullMode());
+				pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassCutoff, dp.material->GetCullMode());
 			}
 
 			// bind pipeline material
 			if (pipeMat != lastMat)
 			{
-				if (!MaterialManager::Instance().SetGraphicPass(_cmdList, pipeMat))
+				if (!BindPipelineMaterial(cache, pipeMat))
 				{
 					continue;
 				}
 				lastMat = pipeMat;
 			}
 
-			BindDepthObject(_cmdList, _camera, qr.first, r.cache, objMat, m, r.GetInstanceDataGPU(frameIndex));
+			BindDepthObject(cache, dp);
 
 			// draw mesh
-			m->DrawSubMesh(_cmdList, r.submeshIndex, r.GetInstanceCount());
+			DrawPacketMesh(cache, dp);
 			GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[_threadIndex])
 		}
 	}
 
+	AddStateCount(cache, _threadIndex);
 	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeDepth[_threadIndex])
 	// close command list and execute
-	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
+	SubmitWorkerList(_cmdList, SubmitStage::PrePassSubmit, _threadIndex);
 }
 
 void ForwardRenderingPath::DrawTransparentNormalDepth(ID3D12GraphicsCommandList* _cmdList, Camera* _camera)
@@ -428,79 +673,66 @@ void ForwardRenderingPath::DrawTransparentNormalDepth(ID3D12GraphicsCommandList*
 	ID3D12DescriptorHeap* descriptorHeaps[] = { ResourceManager::Instance().GetTexHeap(),ResourceManager::Instance().GetSamplerHeap() };
 	_cmdList->SetDescriptorHeaps(2, descriptorHeaps);
 
+	// depth resolve above set its own pipeline on this list, so cache starts here
+	mainStateCache.Begin(_cmdList);
+
 	// loop render-queue
-	auto instanceRenderers = RendererManager::Instance().GetInstanceRenderers();
-	for (auto const& qr : instanceRenderers)
+	const vector<DrawPacket>& packets = RendererManager::Instance().GetInstanceDrawPackets();
+	for (auto const& range : RendererManager::Instance().GetInstanceDrawRanges())
 	{
-		auto renderers = qr.second;
-
 		// don't draw opaue
-		if (qr.first <= RenderQueue::OpaqueLast)
+		if (range.queue <= RenderQueue::OpaqueLast)
 		{
 			continue;
 		}
 
 		Material* lastMat = nullptr;
-		for (int i = 0; i < renderers.size(); i++)
+		for (int i = range.start; i < range.start + range.count; i++)
 		{
-			// valid renderer
-			if (!RendererManager::Instance().ValidRenderer(i, renderers))
-			{
-				continue;
-			}
-
-			// instance check
-			auto r = renderers[i];
-			if (r.GetInstanceCount() == 0)
-			{
-				continue;
-			}
-
-			Mesh* m = r.cache->GetMesh();
+			const DrawPacket& dp = packets[i];
 
 			// choose pipeline material according to renderqueue
-			Material* const objMat = r.cache->GetMaterial(r.submeshIndex);
-			Material* pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassCutoff, objMat->GetCullMode());
+			Material* pipeMat = _camera->GetPipelineMaterial(MaterialType::DepthPrePassCutoff, dp.material->GetCullMode());
 			
 			// bind pipeline material
 			if (lastMat != pipeMat)
 			{
-				if (!MaterialManager::Instance().SetGraphicPass(_cmdList, pipeMat))
+				if (!BindPipelineMaterial(mainStateCache, pipeMat))
 				{
 					continue;
 				}
 				lastMat = pipeMat;
 			}
 
-			BindDepthObject(_cmdList, _camera, qr.first, r.cache, objMat, m, r.GetInstanceDataGPU(frameIndex));
+			BindDepthObject(mainStateCache, dp);
 
 			// draw mesh
-			m->DrawSubMesh(_cmdList, r.submeshIndex, r.GetInstanceCount());
+			DrawPacketMesh(mainStateCache, dp);
 			GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[0])
 		}
 	}
 
+	AddStateCount(mainStateCache, 0);
+
 	_cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(_camera->GetNormalSrc(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COMMON));
+	GRAPHIC_STAT_ADD(StatBarriers, 1)
 }
 
 void ForwardRenderingPath::DrawOpaquePass(Camera* _camera, int _threadIndex, bool _cutout)
 {
-	auto _cmdList = currFrameResource->workerGfxList[_threadIndex];
+	auto _cmdList = recordLists[_threadIndex]->list.Get();
+	GraphicStateCache& cache = stateCache[_threadIndex];
 
 	 // bind descriptor heap, only need to set once, changing descriptor heap isn't good
 	ID3D12DescriptorHeap* descriptorHeaps[] = { ResourceManager::Instance().GetTexHeap(),ResourceManager::Instance().GetSamplerHeap() };
 	_cmdList->SetDescriptorHeaps(2, descriptorHeaps);
 
 	// loop render-queue
-	auto instanceRenderers = RendererManager::Instance().GetInstanceRenderers();
-	for (auto const& qr : instanceRenderers)
+	const vector<DrawPacket>& packets = RendererManager::Instance().GetInstanceDrawPackets();
+	for (auto const& range : RendererManager::Instance().GetInstanceDrawRanges())
 	{
-		auto renderers = qr.second;
-		int count = (int)renderers.size() / numWorkerThreads + 1;
-		int start = _threadIndex * count;
-
 		// onlt draw opaque
-		if (qr.first > RenderQueue::OpaqueLast)
+		if (range.queue > RenderQueue::OpaqueLast)
 		{
 			continue;
 		}
@@ -508,52 +740,41 @@ void ForwardRenderingPath::DrawOpaquePass(Camera* _camera, int _threadIndex, boo
 		if (_cutout)
 		{
 			// cutout pass check
-			if (qr.first < RenderQueue::CutoffStart)
+			if (range.queue < RenderQueue::CutoffStart)
 			{
 				continue;
 			}
 		}
 
+		int start, end;
+		GetPacketChunk(range, _threadIndex, start, end);
+
 		Material *lastMat = nullptr;
-		for (int i = start; i <= start + count; i++)
+		for (int i = start; i < end; i++)
 		{
-			// valid renderer
-			if (!RendererManager::Instance().ValidRenderer(i, renderers))
-			{
-				continue;
-			}
-
-			// instance check
-			auto r = renderers[i];
-			if (r.GetInstanceCount() == 0)
-			{
-				continue;
-			}
-
-			Mesh* m = r.cache->GetMesh();
-
-			// choose pipeline material according to renderqueue
-			Material* const objMat = r.cache->GetMaterial(r.submeshIndex);
+			const DrawPacket& dp = packets[i];
 
 			// bind pipeline material
-			if (lastMat != objMat)
+			if (lastMat != dp.material)
 			{
-				if (!MaterialManager::Instance().SetGraphicPass(_cmdList, objMat))
+				if (!BindPipelineMaterial(cache, dp.material))
 				{
 					continue;
 				}
-				lastMat = objMat;
+				lastMat = dp.material;
 			}
 
 			// bind forward object
-			BindForwardObject(_cmdList, r.cache, objMat, m, r.GetInstanceDataGPU(frameIndex));
+			BindForwardObject(cache, dp);
 
 			// draw mesh
-			m->DrawSubMesh(_cmdList, r.submeshIndex, r.GetInstanceCount());
+			DrawPacketMesh(cache, dp);
 			GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[_threadIndex])
 		}
 	}
 
+	AddStateCount(cache, _threadIndex);
+
 	// close command list and execute
 	if (!_cutout)
 	{
@@ -564,7 +785,7 @@ void ForwardRenderingPath::DrawOpaquePass(Camera* _camera, int _threadIndex, boo
 		GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeCutout[_threadIndex])
 	}
 
-	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
+	SubmitWorkerList(_cmdList, (_cutout) ? SubmitStage::CutoffSubmit : SubmitStage::OpaqueSubmit, _threadIndex);
 }
 
 void ForwardRenderingPath::DrawCutoutPass(Camera* _camera, int _threadIndex)
@@ -574,9 +795,11 @@ void ForwardRenderingPath::DrawCutoutPass(Camera* _camera, int _threadIndex)
 
 void ForwardRenderingPath::DrawSkyboxPass(Camera* _camera)
 {
+	GRAPHIC_STAT_PASS(StatSkybox)
 	auto skybox = LightManager::Instance().GetSkybox();
 
-	if (!skybox->GetRenderer()->GetActive())
+	// skybox renderer is only initialized after SetSkybox
+	if (skybox->GetRenderer()->GetMesh() == nullptr || !skybox->GetRenderer()->GetActive() || skybox->GetObjectConstantGPU() == 0)
 	{
 		return;
 	}
@@ -608,9 +831,11 @@ void ForwardRenderingPath::DrawSkyboxPass(Camera* _camera)
 
 	// bind root object
 	_cmdList->SetGraphicsRootConstantBufferView(0, GraphicManager::Instance().GetSystemConstantGPU());
-	_cmdList->SetGraphicsRootConstantBufferView(1, skybox->GetRenderer()->GetObjectConstantGPU(frameIndex));
+	_cmdList->SetGraphicsRootConstantBufferView(1, skybox->GetObjectConstantGPU());
 	_cmdList->SetGraphicsRootDescriptorTable(2, skybox->GetSkyboxTex());
 	_cmdList->SetGraphicsRootDescriptorTable(3, skybox->GetSkyboxSampler());
+	GRAPHIC_STAT_ADD(StatRootParameters, 2)
+	GRAPHIC_STAT_ADD(StatDescriptorTables, 2)
 
 	// bind mesh and draw
 	Mesh* m = MeshManager::Instance().GetMesh(skybox->GetSkyMeshID());
@@ -619,76 +844,53 @@ void ForwardRenderingPath::DrawSkyboxPass(Camera* _camera)
 
 	m->DrawSubMesh(_cmdList, 0, 1);
 	GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[0])
+	GRAPHIC_STAT_DRAW(1, m->GetSubMesh(0).IndexCountPerInstance / 3)
 
 	// execute
 	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::SkyboxPass])
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
 }
 
-void ForwardRenderingPath::DrawTransparentPass(Camera* _camera)
+void ForwardRenderingPath::DrawTransparentPass(Camera* _camera, int _threadIndex)
 {
-	// get frame resource, reuse BeginFrame's list
-	auto _cmdList = currFrameResource->mainGfxList;
-	LogIfFailedWithoutHR(_cmdList->Reset(currFrameResource->mainGfxAllocator, nullptr));
-	GPU_TIMER_START(_cmdList, GraphicManager::Instance().GetGpuTimeQuery())
+	auto _cmdList = recordLists[_threadIndex]->list.Get();
+	GraphicStateCache& cache = stateCache[_threadIndex];
 
 	// bind descriptor heap, only need to set once, changing descriptor heap isn't good
 	ID3D12DescriptorHeap* descriptorHeaps[] = { ResourceManager::Instance().GetTexHeap(),ResourceManager::Instance().GetSamplerHeap() };
 	_cmdList->SetDescriptorHeaps(2, descriptorHeaps);
 
-	// bind
-	CameraData* camData = _camera->GetCameraData();
-	auto rtv = (camData->allowMSAA > 1) ? &_camera->GetMsaaRtv() : &_camera->GetRtv();
-	auto dsv = (camData->allowMSAA > 1) ? &_camera->GetMsaaDsv() : &_camera->GetDsv();
+	// each thread draws one contiguous part of back-to-front list, parts span queues
+	const vector<DrawPacket>& packets = RendererManager::Instance().GetQueueDrawPackets();
+	const vector<int>& bounds = RendererManager::Instance().GetTransparentDrawBounds();
 
-	_cmdList->OMSetRenderTargets(1, rtv, true,dsv);
-	_cmdList->RSSetViewports(1, &_camera->GetViewPort());
-	_cmdList->RSSetScissorRects(1, &_camera->GetScissorRect());
-	_cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	// loop render-queue
-	auto queueRenderers = RendererManager::Instance().GetQueueRenderers();
-	for (auto const& qr : queueRenderers)
+	for (int i = bounds[_threadIndex]; i < bounds[_threadIndex + 1]; i++)
 	{
-		auto renderers = qr.second;
+		const DrawPacket& dp = packets[i];
 
-		// onlt draw transparent
-		if (qr.first <= RenderQueue::OpaqueLast)
+		// bind pipeline material
+		if (!BindPipelineMaterial(cache, dp.material))
 		{
 			continue;
 		}
 
-		for (int i = 0; i < (int)renderers.size(); i++)
-		{
-			// valid renderer
-			if (!RendererManager::Instance().ValidRenderer(i, renderers))
-			{
-				continue;
-			}
-			auto const r = renderers[i];
-			Mesh* m = r.cache->GetMesh();
+		// bind forward object
+		BindForwardObject(cache, dp);
 
-			// choose pipeline material according to renderqueue
-			Material* const objMat = r.cache->GetMaterial(r.submeshIndex);
-
-			// bind pipeline material
-			if (!MaterialManager::Instance().SetGraphicPass(_cmdList, objMat))
-			{
-				continue;
-			}
+		// draw mesh
+		DrawPacketMesh(cache, dp);
+		GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[_threadIndex])
+	}
 
-			// bind forward object
-			BindForwardObject(_cmdList, r.cache, objMat, m, 0);
+	AddStateCount(cache, _threadIndex);
 
-			// draw mesh
-			m->DrawSubMesh(_cmdList, r.submeshIndex, 1);
-			GRAPHIC_BATCH_ADD(GameTimerManager::Instance().gameTime.batchCount[0])
-		}
+	// close command list, it is executed after lists of previous parts
+	if (_threadIndex == transparentThreadCount - 1)
+	{
+		GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::TransparentPass])
 	}
 
-	// close command list and execute
-	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::TransparentPass])
-	GraphicManager::Instance().ExecuteCommandList(_cmdList);;
+	SubmitWorkerList(_cmdList, SubmitStage::TransparentSubmit, _threadIndex);
 }
 
 void ForwardRenderingPath::EndFrame(Camera* _camera)
@@ -5,6 +5,10 @@
 #include "FrameResource.h"
 #include "RendererManager.h"
 #include "Light.h"
+#include "TaskGraph.h"
+#include "WorkerBudget.h"
+#include "SubmissionQueue.h"
+#include "CommandStateCache.h"
 using namespace Microsoft;
 
 enum WorkerType
@@ -15,8 +19,22 @@ enum WorkerType
 	OpaqueRendering,
 	CutoffRendering,
 	TransparentRendering,
+	OcclusionCulling,
+	TransformUpdate,
 };
 
+// slots of submission queue, worker lists of one stage are submitted together in thread order
+enum SubmitStage
+{
+	PrePassSubmit = 0,
+	OpaqueSubmit,
+	CutoffSubmit,
+	TransparentSubmit,
+	SubmitStageCount
+};
+
+typedef CommandStateCache<ID3D12GraphicsCommandList> GraphicStateCache;
+
 class ForwardRenderingPath
 {
 public:
@@ -31,34 +49,86 @@ public:
 		return instance;
 	}
 
-	ForwardRenderingPath() {}
+	// initial item cost and per worker overhead in ms, item costs are measured after first frame
+	ForwardRenderingPath() : transformCost(0.0005, 0.005), uploadCost(0.002, 0.005), prePassCost(0.002, 0.05), opaqueCost(0.005, 0.05), cutoffCost(0.005, 0.05), transparentCost(0.005, 0.05), recordLists() {}
 	~ForwardRenderingPath() {}
 
-	void CullingWork(Camera* _camera);
-	void SortingWork(Camera* _camera);
 	void RenderLoop(Camera* _camera, int _frameIdx);
-	void WorkerThread(int _threadIndex);
 private:
+	// stages without per-thread resources are split finer, idle threads steal the rest
+	static const int FINE_JOBS_PER_WORKER = 4;
+
+	// cpu tasks of a frame, each one starts as soon as its inputs are ready
+	enum FrameTask
+	{
+		TransformTask = 0, CullingTask, SortCollectTask, InstanceSortTask, QueueSortTask, FinishSortTask, BeginFrameTask, CompileTask
+		, UploadInstanceTask, TopLevelASTask, UploadConstantTask, PrePassTask, LightTask, OpaqueTask, CutoffTask, TransparentTask, EndFrameTask, FrameTaskCount
+	};
+
+	void BuildFrameGraph();
+	void AddFrameDependency(FrameTask _task, FrameTask _dependsOn);
+	StatPass GetStatPass(WorkerType _type);
+	void WorkerJob(WorkerType _type, int _threadIndex, int _jobCount);
+	double RunStage(WorkerType _type, int _jobCount);
+	double RecordStage(WorkerType _type, SubmitStage _stage, int _jobCount);
+	void SubmitWorkerList(ID3D12GraphicsCommandList* _cmdList, SubmitStage _stage, int _threadIndex);
+	void TransformWork();
+	void CullingWork(Camera* _camera);
+	void SortCollectWork(Camera* _camera);
+	void RadixSortWork(RadixSorter& _sorter, bool _incremental);
+	void CompileWork();
 	void BeginFrame(Camera* _camera);
-	void UploadWork(Camera* _camera);
+	void UploadInstanceWork();
+	void TopLevelASWork();
+	void UploadConstantWork(Camera* _camera);
 	void PrePassWork(Camera* _camera);
-	void BindForwardState(Camera* _camera, int _threadIndex);
-	void BindDepthObject(ID3D12GraphicsCommandList* _cmdList, Camera* _camera, int _queue, Renderer* _renderer, Material* _mat, Mesh* _mesh, D3D12_GPU_VIRTUAL_ADDRESS _instanceData);
-	void BindForwardObject(ID3D12GraphicsCommandList *_cmdList, Renderer *_renderer, Material *_mat, Mesh *_mesh, D3D12_GPU_VIRTUAL_ADDRESS _instanceData);
+	void TransparentWork(Camera* _camera);
+	bool BindForwardState(Camera* _camera, WorkerType _type, int _threadIndex);
+	bool BindPipelineMaterial(GraphicStateCache& _cache, Material* _mat);
+	void BindDepthObject(GraphicStateCache& _cache, const DrawPacket& _dp);
+	void BindForwardObject(GraphicStateCache& _cache, const DrawPacket& _dp);
+	void DrawPacketMesh(GraphicStateCache& _cache, const DrawPacket& _dp);
+	void AddStateCount(GraphicStateCache& _cache, int _threadIndex);
+	void GetPacketChunk(const DrawPacketRange& _range, int _threadIndex, int& _start, int& _end);
 	void DrawWireFrame(Camera* _camera, int _threadIndex);
 	void DrawOpaqueNormalDepth(Camera* _camera, int _threadIndex);
 	void DrawTransparentNormalDepth(ID3D12GraphicsCommandList* _cmdList, Camera* _camera);
 	void DrawOpaquePass(Camera* _camera, int _threadIndex, bool _cutout = false);
 	void DrawCutoutPass(Camera* _camera, int _threadIndex);
 	void DrawSkyboxPass(Camera* _camera);
-	void DrawTransparentPass(Camera* _camera);
+	void DrawTransparentPass(Camera* _camera, int _threadIndex);
 	void EndFrame(Camera* _camera);
 
 	Camera* targetCam;
 	Light* currLight;
-	WorkerType workerType;
 	int frameIndex;
 	int cascadeIndex;
 	FrameResource *currFrameResource;
 	int numWorkerThreads;
+	int recordThreadCount;
+	int transparentThreadCount;
+	int recordItemCount;
+	int transparentItemCount;
+	bool incrementalSort;
+
+	// stages whose parallelism follows workload, fine stages count jobs and recording counts command lists
+	// each recording stage learns its own cost, items are sorter items that worker count is chosen from
+	StageCost transformCost;
+	StageCost uploadCost;
+	StageCost prePassCost;
+	StageCost opaqueCost;
+	StageCost cutoffCost;
+	StageCost transparentCost;
+
+	SubmissionQueue<ID3D12CommandList> submitQueue;
+
+	// list recorded by each job of current stage
+	PooledCommandList* recordLists[MAX_WORKER_THREAD_COUNT];
+
+	// redundant state filter of each worker list, main list draws use their own
+	GraphicStateCache stateCache[MAX_WORKER_THREAD_COUNT];
+	GraphicStateCache mainStateCache;
+	TaskGraph frameGraph;
+	int frameTasks[FrameTaskCount];
+	vector<int> criticalPath;
 };
\ No newline at end of file
@@ -2,21 +2,25 @@
 #include <d3d12.h>
 #include <wrl.h>
 #include <DirectXMath.h>
+#include "JobSystem.h"
+#include "FrameSettings.h"
 using namespace Microsoft::WRL;
 using namespace DirectX;
 
-const static int MAX_FRAME_COUNT = 2;
-const static int MAX_WORKER_THREAD_COUNT = 16;
-
 struct FrameResource
 {
 	ID3D12CommandAllocator* mainGfxAllocator;
 	ID3D12GraphicsCommandList* mainGfxList;
-	ID3D12CommandAllocator *workerGfxAlloc[MAX_WORKER_THREAD_COUNT];
-	ID3D12GraphicsCommandList *workerGfxList[MAX_WORKER_THREAD_COUNT];
 	int currFrameIndex;
 };
 
+// allocator and the list recorded with it, handed out by command list pool
+struct PooledCommandList
+{
+	ComPtr<ID3D12CommandAllocator> allocator;
+	ComPtr<ID3D12GraphicsCommandList> list;
+};
+
 struct ObjectConstant
 {
 	XMFLOAT4X4 sqMatrixWorld;
@@ -0,0 +1,4 @@
+#pragma once
+
+// frames recorded ahead of the gpu, per-frame resources and dirty state are kept this many times
+const static int MAX_FRAME_COUNT = 2;
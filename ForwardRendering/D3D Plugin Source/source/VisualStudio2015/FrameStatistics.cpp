@@ -0,0 +1,159 @@
+#include "FrameStatistics.h"
+#include <cstring>
+
+static const char* passNames[StatPassCount] =
+{
+	"PrePass", "Light", "Opaque", "Cutoff", "Transparent", "Skybox", "Upload", "Other"
+};
+
+static void AddPassStatistics(PassStatistics& _dst, const PassStatistics& _src)
+{
+	for (int i = 0; i < StatCounterCount; i++)
+	{
+		_dst.counter[i] += _src.counter[i];
+	}
+}
+
+static bool IsEmpty(const PassStatistics& _stat)
+{
+	for (int i = 0; i < StatCounterCount; i++)
+	{
+		if (_stat.counter[i] > 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static string FormatPassStatistics(const PassStatistics& _stat)
+{
+	return "Draw " + to_string(_stat.counter[StatDraws])
+		+ ", Inst " + to_string(_stat.counter[StatInstances])
+		+ ", Tri " + to_string(_stat.counter[StatTriangles])
+		+ ", PSO " + to_string(_stat.counter[StatPsoSwitches])
+		+ ", Root " + to_string(_stat.counter[StatRootParameters])
+		+ ", Table " + to_string(_stat.counter[StatDescriptorTables])
+		+ ", Barrier " + to_string(_stat.counter[StatBarriers])
+		+ ", Upload(KB) " + to_string(_stat.counter[StatUploadBytes] / 1024) + "\n";
+}
+
+void FrameStatistics::Add(StatCounter _counter, uint64_t _value)
+{
+	Add(GetCurrentSlot(), GetCurrentPass(), _counter, _value);
+}
+
+void FrameStatistics::Add(int _slot, StatPass _pass, StatCounter _counter, uint64_t _value)
+{
+	if (_slot < 0 || _slot >= MAX_STAT_THREAD_COUNT)
+	{
+		return;
+	}
+
+	threads[_slot].pass[_pass].counter[_counter] += _value;
+}
+
+void FrameStatistics::AddDraw(uint64_t _instanceCount, uint64_t _triangleCount)
+{
+	// draw counters are added together, so a draw looks up its slot once
+	int slot = GetCurrentSlot();
+	if (slot < 0 || slot >= MAX_STAT_THREAD_COUNT)
+	{
+		return;
+	}
+
+	PassStatistics& stat = threads[slot].pass[GetCurrentPass()];
+	stat.counter[StatDraws]++;
+	stat.counter[StatInstances] += _instanceCount;
+	stat.counter[StatTriangles] += _triangleCount;
+}
+
+void FrameStatistics::Reset()
+{
+	memset(threads, 0, sizeof(threads));
+	frameThread = this_thread::get_id();
+}
+
+void FrameStatistics::Merge()
+{
+	// totals are rebuilt from scratch, so merge can be called again if a frame adds more later
+	memset(passTotal, 0, sizeof(passTotal));
+	memset(threadTotal, 0, sizeof(threadTotal));
+	memset(&frameTotal, 0, sizeof(frameTotal));
+
+	for (int i = 0; i < MAX_STAT_THREAD_COUNT; i++)
+	{
+		for (int j = 0; j < StatPassCount; j++)
+		{
+			AddPassStatistics(passTotal[j], threads[i].pass[j]);
+			AddPassStatistics(threadTotal[i], threads[i].pass[j]);
+		}
+		AddPassStatistics(frameTotal, threadTotal[i]);
+	}
+}
+
+const PassStatistics& FrameStatistics::GetPassTotal(StatPass _pass) const
+{
+	return passTotal[_pass];
+}
+
+const PassStatistics& FrameStatistics::GetThreadTotal(int _slot) const
+{
+	return threadTotal[_slot];
+}
+
+const PassStatistics& FrameStatistics::GetFrameTotal() const
+{
+	return frameTotal;
+}
+
+string FrameStatistics::Export() const
+{
+	string result = "-------------- Frame Statistics --------------\n";
+	result += "Frame: " + FormatPassStatistics(frameTotal);
+
+	// empty passes and idle threads are skipped
+	for (int i = 0; i < StatPassCount; i++)
+	{
+		if (!IsEmpty(passTotal[i]))
+		{
+			result += string(passNames[i]) + ": " + FormatPassStatistics(passTotal[i]);
+		}
+	}
+
+	for (int i = 0; i < MAX_STAT_THREAD_COUNT; i++)
+	{
+		if (!IsEmpty(threadTotal[i]))
+		{
+			string name = (i == 0) ? "Main" : "Worker " + to_string(i - 1);
+			result += "\t" + name + ": " + FormatPassStatistics(threadTotal[i]);
+		}
+	}
+
+	return result;
+}
+
+int FrameStatistics::GetCurrentSlot() const
+{
+	int worker = JobSystem::GetCurrentWorker();
+	if (worker != -1)
+	{
+		return worker + 1;
+	}
+
+	// outside threads would race on one slot, only the frame thread owns it
+	return (this_thread::get_id() == frameThread) ? 0 : -1;
+}
+
+StatPass FrameStatistics::GetCurrentPass()
+{
+	// job tag is the pass, untagged threads and jobs count to StatOther
+	int tag = JobSystem::GetCurrentTag();
+	return (tag >= 0 && tag < StatPassCount) ? (StatPass)tag : StatOther;
+}
+
+void FrameStatistics::SetCurrentPass(StatPass _pass)
+{
+	JobSystem::SetCurrentTag(_pass);
+}
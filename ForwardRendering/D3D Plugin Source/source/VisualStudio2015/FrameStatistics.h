@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "GameTime.h"
+#include "JobSystem.h"
+using namespace std;
+
+// passes that counters are grouped by, work outside a pass scope goes to StatOther
+enum StatPass
+{
+	StatPrePass = 0,
+	StatLight,
+	StatOpaque,
+	StatCutoff,
+	StatTransparent,
+	StatSkybox,
+	StatUpload,
+	StatOther,
+	StatPassCount
+};
+
+enum StatCounter
+{
+	StatDraws = 0,
+	StatInstances,
+	StatTriangles,
+	StatPsoSwitches,
+	StatRootParameters,
+	StatDescriptorTables,
+	StatBarriers,
+	StatUploadBytes,
+	StatCounterCount
+};
+
+// counters of one pass fill exactly one cache line
+struct PassStatistics
+{
+	uint64_t counter[StatCounterCount];
+};
+
+// every thread writes only its own slot, so counting needs no lock or atomic
+struct alignas(64) ThreadStatistics
+{
+	PassStatistics pass[StatPassCount];
+};
+
+// per-thread, per-pass frame counters, merged into totals once all recording of a frame is done
+// pass is carried by jobs, a job counts to the pass that was current where it was dispatched
+class FrameStatistics
+{
+public:
+	// slot 0 is for the thread that called Reset, worker n uses slot n + 1
+	// other threads outside job system have no slot and their counters are dropped
+	static const int MAX_STAT_THREAD_COUNT = MAX_WORKER_THREAD_COUNT + 1;
+
+	FrameStatistics(const FrameStatistics&) = delete;
+	FrameStatistics(FrameStatistics&&) = delete;
+	FrameStatistics& operator=(const FrameStatistics&) = delete;
+	FrameStatistics& operator=(FrameStatistics&&) = delete;
+
+	FrameStatistics() { Reset(); Merge(); }
+	~FrameStatistics() {}
+
+	static FrameStatistics& Instance()
+	{
+		static FrameStatistics instance;
+		return instance;
+	}
+
+	// counters of calling thread and its current pass
+	void Add(StatCounter _counter, uint64_t _value);
+	void Add(int _slot, StatPass _pass, StatCounter _counter, uint64_t _value);
+	void AddDraw(uint64_t _instanceCount, uint64_t _triangleCount);
+
+	// Reset before first task of a frame on the thread that runs it, Merge after the last one
+	void Reset();
+	void Merge();
+
+	// totals of last merge
+	const PassStatistics& GetPassTotal(StatPass _pass) const;
+	const PassStatistics& GetThreadTotal(int _slot) const;
+	const PassStatistics& GetFrameTotal() const;
+	string Export() const;
+
+	// -1 if calling thread has no slot
+	int GetCurrentSlot() const;
+	static StatPass GetCurrentPass();
+	static void SetCurrentPass(StatPass _pass);
+
+private:
+	ThreadStatistics threads[MAX_STAT_THREAD_COUNT];
+
+	PassStatistics passTotal[StatPassCount];
+	PassStatistics threadTotal[MAX_STAT_THREAD_COUNT];
+	PassStatistics frameTotal;
+	thread::id frameThread;
+};
+
+// counters of calling thread go to _pass until scope ends, previous pass is restored for nested jobs
+class StatPassScope
+{
+public:
+	StatPassScope(StatPass _pass)
+	{
+		previous = FrameStatistics::GetCurrentPass();
+		FrameStatistics::SetCurrentPass(_pass);
+	}
+
+	~StatPassScope()
+	{
+		FrameStatistics::SetCurrentPass(previous);
+	}
+
+private:
+	StatPass previous;
+};
+
+#if defined(GRAPHICTIME)
+#define GRAPHIC_STAT_ADD(x,y) FrameStatistics::Instance().Add(x, y);
+#define GRAPHIC_STAT_DRAW(x,y) FrameStatistics::Instance().AddDraw(x, y);
+#define GRAPHIC_STAT_PASS(x) StatPassScope statPassScope(x);
+#else
+#define GRAPHIC_STAT_ADD(x,y)
+#define GRAPHIC_STAT_DRAW(x,y)
+#define GRAPHIC_STAT_PASS(x)
+#endif
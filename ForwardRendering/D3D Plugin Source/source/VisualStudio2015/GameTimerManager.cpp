@@ -1,11 +1,17 @@
 #include "GameTimerManager.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 using namespace std;
 #include "GraphicManager.h"
 #include "RayTracingManager.h"
 #include "stdafx.h"
 
+// recording passes reported with their own imbalance
+static const StatPass recordPasses[] = { StatPrePass, StatOpaque, StatCutoff, StatTransparent };
+static const char* recordPassNames[] = { "PrePass", "Opaque", "Cutoff", "Transparent" };
+static const int RECORD_PASS_COUNT = 4;
+
 void GameTimerManager::Init()
 {
 	auto mainDevice = GraphicManager::Instance().GetDevice();
@@ -79,7 +85,9 @@ void GameTimerManager::CalcGpuTime()
 	gpuTimeOpaqueMs = 0;
 	gpuTimeCutoutMs = 0;
 	gpuTimeDepthMs = 0;
-	for (int i = 0; i < GraphicManager::Instance().GetThreadCount(); i++)
+
+	// lists beyond record thread count weren't recorded, their readback is stale
+	for (int i = 0; i < gameTime.recordThreadCount; i++)
 	{
 		// opaque time
 		uint64_t* pRes;
@@ -125,15 +133,49 @@ void GameTimerManager::PrintGameTime()
 		cpuProfile += "Sorting Time: " + to_string_precision(gameTime.sortingTime) + "\n";
 		cpuProfile += "Upload Time: " + to_string_precision(gameTime.uploadTime) + "\n";
 		cpuProfile += "Render Time: " + to_string_precision(gameTime.renderTime) + "\n";
+		cpuProfile += "Recording Threads: " + to_string_precision(gameTime.recordThreadCount) + "\n";
+		cpuProfile += "Transparent Threads: " + to_string_precision(gameTime.transparentThreadCount) + "\n";
+		cpuProfile += "Critical Path: " + to_string_precision(gameTime.criticalPathTime) + " (" + criticalPath + ")\n";
 
 		int totalDrawCall = 0;
-		for (int i = 0; i < GraphicManager::Instance().GetThreadCount() - 1; i++)
+		int totalStateIssued = 0;
+		int totalStateFiltered = 0;
+		int numThreads = max(gameTime.recordThreadCount, gameTime.transparentThreadCount);
+		for (int i = 0; i < numThreads; i++)
 		{
-			cpuProfile += "\tThread " + to_string_precision(i) + " Time:" + to_string_precision(gameTime.renderThreadTime[i]) + "\n";
+			double threadTime = 0.0;
+			for (int j = 0; j < RECORD_PASS_COUNT; j++)
+			{
+				threadTime += gameTime.recordPassTime[recordPasses[j]][i];
+			}
+
+			cpuProfile += "\tThread " + to_string_precision(i) + " Time:" + to_string_precision(threadTime) + "\n";
 			totalDrawCall += gameTime.batchCount[i];
+			totalStateIssued += gameTime.stateIssuedCount[i];
+			totalStateFiltered += gameTime.stateFilteredCount[i];
 		}
 
+		// slowest list of a pass against the average of that pass, 1.0 means perfectly balanced
+		// passes run one after another, so imbalance of one pass can't be hidden by another
+		cpuProfile += "Recording Imbalance (max/avg):";
+		for (int j = 0; j < RECORD_PASS_COUNT; j++)
+		{
+			int passThreads = (recordPasses[j] == StatTransparent) ? gameTime.transparentThreadCount : gameTime.recordThreadCount;
+			double maxPassTime = 0.0;
+			double totalPassTime = 0.0;
+			for (int i = 0; i < passThreads; i++)
+			{
+				maxPassTime = max(maxPassTime, gameTime.recordPassTime[recordPasses[j]][i]);
+				totalPassTime += gameTime.recordPassTime[recordPasses[j]][i];
+			}
+
+			double imbalance = (totalPassTime > 0.0) ? maxPassTime * passThreads / totalPassTime : 1.0;
+			cpuProfile += string(" ") + recordPassNames[j] + " " + to_string_precision(imbalance);
+		}
+		cpuProfile += "\n";
+
 		cpuProfile += "Total DrawCall: " + to_string_precision(totalDrawCall) + "\n";
+		cpuProfile += "State Calls Issued/Filtered: " + to_string_precision(totalStateIssued) + " / " + to_string_precision(totalStateFiltered) + "\n";
 		cpuProfile += "Total ray tracing instance (Top Level): " + to_string_precision(RayTracingManager::Instance().GetTopLevelAsCount()) + "\n";
 
 		gpuProfile = "";
@@ -153,6 +195,8 @@ void GameTimerManager::PrintGameTime()
 		gpuProfile += "Forward Opaque: " + to_string_precision(gpuTimeOpaqueMs) + "\n";
 		gpuProfile += "Forward Cutout: " + to_string_precision(gpuTimeCutoutMs) + "\n";
 
+		statProfile = FrameStatistics::Instance().Export();
+
 		profileTime = 0.0;
 	}
 
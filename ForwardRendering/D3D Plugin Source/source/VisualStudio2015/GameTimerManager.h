@@ -1,6 +1,7 @@
 #pragma once
 #include "GameTime.h"
 #include "FrameResource.h"
+#include "FrameStatistics.h"
 #include <chrono>
 #include <string>
 using namespace std;
@@ -12,8 +13,14 @@ struct GameTime
 	double cullingTime;
 	double sortingTime;
 	double uploadTime;
+	double criticalPathTime;
+	int recordThreadCount;
+	int transparentThreadCount;
 	int batchCount[MAX_WORKER_THREAD_COUNT];
-	double renderThreadTime[MAX_WORKER_THREAD_COUNT];
+	int stateIssuedCount[MAX_WORKER_THREAD_COUNT];
+	int stateFilteredCount[MAX_WORKER_THREAD_COUNT];
+	// recording time of each list slot in each pass, imbalance is only meaningful within one pass
+	double recordPassTime[StatPassCount][MAX_WORKER_THREAD_COUNT];
 };
 
 enum GpuTimeType
@@ -57,7 +64,9 @@ public:
 	double gpuTimeDepthMs;
 	double totalGpuMs;
 
+	string criticalPath;
 	string cpuProfile;
 	string gpuProfile;
+	string statProfile;
 #endif
 };
\ No newline at end of file
@@ -34,6 +34,7 @@ void GenerateMipmap::Generate(ID3D12GraphicsCommandList* _cmdList, ID3D12Resourc
 
 	// transition
 	_cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(_src, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	GRAPHIC_STAT_ADD(StatBarriers, 1)
 
 	_cmdList->SetComputeRootDescriptorTable(0, _outMip);
 	_cmdList->SetComputeRootConstantBufferView(1, GraphicManager::Instance().GetSystemConstantGPU());
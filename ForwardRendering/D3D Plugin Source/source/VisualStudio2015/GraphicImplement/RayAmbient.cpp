@@ -68,6 +68,7 @@ void RayAmbient::Trace(Camera* _targetCam, D3D12_GPU_VIRTUAL_ADDRESS _dirLightGP
 	barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(_targetCam->GetCameraDepth(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	barriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(ambientSrc, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	_cmdList->ResourceBarrier(3, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 3)
 
 	// set roots
 	_cmdList->SetComputeRootDescriptorTable(0, GetAmbientUav());
@@ -106,6 +107,7 @@ void RayAmbient::Trace(Camera* _targetCam, D3D12_GPU_VIRTUAL_ADDRESS _dirLightGP
 	barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(_targetCam->GetCameraDepth(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	barriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(ambientSrc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	_cmdList->ResourceBarrier(3, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 3)
 
 	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::RayTracingAmbient]);
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);
@@ -175,6 +177,7 @@ void RayAmbient::AmbientRegionFade(ID3D12GraphicsCommandList *_cmdList)
 	D3D12_RESOURCE_BARRIER barriers[1];
 	barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(ambientHitDistance->Resource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	_cmdList->ResourceBarrier(1, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 1)
 
 	// bind roots
 	auto frameIdx = GraphicManager::Instance().GetFrameResource()->currFrameIndex;
@@ -193,6 +196,7 @@ void RayAmbient::AmbientRegionFade(ID3D12GraphicsCommandList *_cmdList)
 	// transition
 	barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(ambientHitDistance->Resource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	_cmdList->ResourceBarrier(1, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 1)
 }
 
 D3D12_GPU_DESCRIPTOR_HANDLE RayAmbient::GetAmbientUav()
@@ -116,6 +116,7 @@ void RayShadow::RayTracingShadow(Camera* _targetCam, ForwardPlus* _forwardPlus,
 	barriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(_targetCam->GetCameraDepth(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	barriers[3] = CD3DX12_RESOURCE_BARRIER::Transition(_targetCam->GetTransparentDepth(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	_cmdList->ResourceBarrier(4, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 4)
 
 	// set state
 	_cmdList->SetComputeRootDescriptorTable(0, GetRTShadowUav());
@@ -152,6 +153,7 @@ void RayShadow::RayTracingShadow(Camera* _targetCam, ForwardPlus* _forwardPlus,
 	barriers[4] = CD3DX12_RESOURCE_BARRIER::Transition(_forwardPlus->GetPointLightTileTransSrc(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	barriers[5] = CD3DX12_RESOURCE_BARRIER::Transition(_targetCam->GetTransparentDepth(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	_cmdList->ResourceBarrier(5, barriers);
+	GRAPHIC_STAT_ADD(StatBarriers, 5)
 
 	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::RayTracingShadow]);
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);
@@ -179,6 +181,7 @@ void RayShadow::CollectRayShadow(Camera* _targetCam)
 	collect[4] = CD3DX12_RESOURCE_BARRIER::Transition(GetRayShadowSrc(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	collect[5] = CD3DX12_RESOURCE_BARRIER::Transition(GetTransRayShadowSrc(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	_cmdList->ResourceBarrier(6, collect);
+	GRAPHIC_STAT_ADD(StatBarriers, 6)
 
 	// set heap
 	ID3D12DescriptorHeap* descriptorHeaps[] = { ResourceManager::Instance().GetTexHeap() , ResourceManager::Instance().GetSamplerHeap() };
@@ -226,6 +229,7 @@ void RayShadow::CollectRayShadow(Camera* _targetCam)
 	collect[4] = CD3DX12_RESOURCE_BARRIER::Transition(GetRayShadowSrc(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	collect[5] = CD3DX12_RESOURCE_BARRIER::Transition(GetTransRayShadowSrc(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	_cmdList->ResourceBarrier(6, collect);
+	GRAPHIC_STAT_ADD(StatBarriers, 6)
 
 	GPU_TIMER_STOP(_cmdList, GraphicManager::Instance().GetGpuTimeQuery(), GameTimerManager::Instance().gpuTimeResult[GpuTimeType::CollectShadowMap]);
 	GraphicManager::Instance().ExecuteCommandList(_cmdList);
@@ -14,7 +14,7 @@ void Skybox::Init(ID3D12Resource* _skyboxSrc, TextureWrapMode wrapU, TextureWrap
 	{
 		auto rtd = CameraManager::Instance().GetCamera()->GetRenderTargetData();
 		skyboxMat = MaterialManager::Instance().CreateGraphicMat(skyShader, rtd, D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_FRONT, 1, 0, D3D12_COMPARISON_FUNC_GREATER_EQUAL, false);
-		skyboxRenderer.Init(_skyMesh, false);
+		skyboxRenderer.Init(&skyboxPool, _skyMesh, false);
 	}
 }
 
@@ -22,6 +22,7 @@ void Skybox::Release()
 {
 	skyboxMat.Release();
 	skyboxRenderer.Release();
+	skyboxPool.Release();
 }
 
 void Skybox::SetSkyboxData(XMFLOAT4 _ag, XMFLOAT4 _as, float _skyIntensity)
@@ -36,6 +37,16 @@ Renderer* Skybox::GetRenderer()
 	return &skyboxRenderer;
 }
 
+void Skybox::SetObjectConstantGPU(D3D12_GPU_VIRTUAL_ADDRESS _address)
+{
+	objectConstantGPU = _address;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Skybox::GetObjectConstantGPU()
+{
+	return objectConstantGPU;
+}
+
 Material* Skybox::GetMaterial()
 {
 	return &skyboxMat;
@@ -22,6 +22,8 @@ public:
 	void SetSkyboxData(XMFLOAT4 _ag, XMFLOAT4 _as, float _skyIntensity);
 
 	Renderer* GetRenderer();
+	void SetObjectConstantGPU(D3D12_GPU_VIRTUAL_ADDRESS _address);
+	D3D12_GPU_VIRTUAL_ADDRESS GetObjectConstantGPU();
 	Material* GetMaterial();
 	SkyboxData GetSkyboxData();
 	D3D12_GPU_DESCRIPTOR_HANDLE GetSkyboxTex();
@@ -32,6 +34,8 @@ private:
 	int skyMeshId;
 	Material skyboxMat;
 	Renderer skyboxRenderer;
+	RendererPool skyboxPool;
 	SkyboxData skyboxData;
+	D3D12_GPU_VIRTUAL_ADDRESS objectConstantGPU = 0;
 	DescriptorHeapData skyboxSrv;
 };
\ No newline at end of file
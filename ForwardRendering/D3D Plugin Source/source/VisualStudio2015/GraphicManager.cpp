@@ -1,6 +1,7 @@
 #include "GraphicManager.h"
 #include "stdafx.h"
 #include "ForwardRenderingPath.h"
+#include "MeshManager.h"
 #include "d3dx12.h"
 
 bool GraphicManager::Initialize(ID3D12Device* _device, int _numOfThreads)
@@ -55,6 +56,7 @@ void GraphicManager::InitSystemConstant()
 	{
 		systemConstantGPU[i] = make_unique<UploadBuffer<SystemConstant>>(mainDevice, 1, true);
 	}
+	constantRing.Init(mainDevice, CONSTANT_RING_SIZE);
 
 	// init sampler
 	linearWrapSampler.AddSampler(TextureWrapMode::Repeat, TextureWrapMode::Repeat, TextureWrapMode::Repeat, 0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
@@ -71,27 +73,17 @@ void GraphicManager::Release()
 	CloseHandle(beginRenderThread);
 	CloseHandle(renderThreadHandle);
 	CloseHandle(renderThreadFinish);
-
-	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
-	{
-		CloseHandle(beginWorkerThread[i]);
-		CloseHandle(workerThreadHandle[i]);
-		CloseHandle(workerThreadFinish[i]);
-	}
+	jobSystem.Release();
 
 	for (int i = 0; i < MAX_FRAME_COUNT; i++)
 	{
 		mainGfxAllocator[i].Reset();
-
-		for (int j = 0; j < numOfLogicalCores - 1; j++)
-		{
-			workerGfxAllocator[j][i].Reset();
-			workerGfxList[j].Reset();
-		}
-
 		systemConstantGPU[i].reset();
 		graphicFences[i] = 0;
 	}
+	constantRing.Release();
+	deferredObjects.Clear();
+	commandListPool.Clear();
 	mainGfxList.Reset();
 	mainFence = 0;
 
@@ -120,6 +112,9 @@ void GraphicManager::Update()
 		LogIfFailedWithoutHR(mainGraphicFence->SetEventOnCompletion(graphicFences[currFrameIndex], mainFenceEvent));
 		WaitForSingleObjectEx(mainFenceEvent, INFINITE, FALSE);
 	}
+	ReleaseDeferredObjects();
+	commandListPool.EndFrame(mainGraphicFence->GetCompletedValue());
+	MeshManager::Instance().ReadbackCompletedGeometry(mainGraphicFence->GetCompletedValue());
 
 	GRAPHIC_TIMER_STOP(GameTimerManager::Instance().gameTime.updateTime)
 }
@@ -165,20 +160,22 @@ HRESULT GraphicManager::CreateGraphicCommand()
 	for (int i = 0; i < MAX_FRAME_COUNT; i++)
 	{
 		CreateGfxAlloc(mainGfxAllocator[i]);
+	}
 
-		// create worker GFX list
-		for (int j = 0; j < numOfLogicalCores - 1; j++)
-		{
-			CreateGfxAlloc(workerGfxAllocator[j][i]);
+	CreateGfxList(mainGfxAllocator[0], mainGfxList);
 
-			if (i == 0)
-			{
-				CreateGfxList(workerGfxAllocator[j][i], workerGfxList[j]);
-			}
+	// worker lists are created when a pass first needs them
+	commandListPool.Init([this]() -> PooledCommandList*
+	{
+		PooledCommandList* cmd = new PooledCommandList();
+		if (FAILED(CreateGfxAlloc(cmd->allocator)) || FAILED(CreateGfxList(cmd->allocator, cmd->list)))
+		{
+			delete cmd;
+			return nullptr;
 		}
-	}
 
-	CreateGfxList(mainGfxAllocator[0], mainGfxList);
+		return cmd;
+	}, COMMAND_LIST_TRIM_FRAMES);
 
 	return hr;
 }
@@ -237,17 +234,9 @@ bool GraphicManager::CreateGraphicThreads()
 	{
 		static unsigned int WINAPI render(LPVOID lpParameter)
 		{
-			ThreadParameter* parameter = reinterpret_cast<ThreadParameter*>(lpParameter);
 			GraphicManager::Instance().RenderThread();
 			return 0;
 		}
-
-		static unsigned int WINAPI worker(LPVOID lpParameter)
-		{
-			ThreadParameter* parameter = reinterpret_cast<ThreadParameter*>(lpParameter);
-			ForwardRenderingPath::Instance().WorkerThread(parameter->threadIndex);
-			return 0;
-		}
 	};
 
 	// render thread 
@@ -265,21 +254,7 @@ bool GraphicManager::CreateGraphicThreads()
 	result = (beginRenderThread != nullptr) && (renderThreadFinish != nullptr) && (renderThreadHandle != nullptr);
 
 	// worker thread (number of cores - 1)
-	for (int i = 0; i < numOfLogicalCores - 1; i++)
-	{
-		threadParams[i].threadIndex = i;
-		beginWorkerThread[i] = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		workerThreadFinish[i] = CreateEvent(nullptr, TRUE, FALSE, nullptr);
-		workerThreadHandle[i] = reinterpret_cast<HANDLE>(_beginthreadex(
-			nullptr,
-			0,
-			threadwrapper::worker,
-			reinterpret_cast<LPVOID>(&threadParams[i]),
-			0,
-			nullptr));
-
-		result &= (workerThreadHandle[i] != nullptr) && (workerThreadFinish[i] != nullptr) && (beginWorkerThread[i] != nullptr);
-	}
+	jobSystem.Init(numOfLogicalCores - 1);
 
 	if (!result)
 	{
@@ -298,15 +273,16 @@ void GraphicManager::DrawCamera()
 	GameTimerManager::Instance().gameTime.renderTime = 0.0;
 	for (int i = 0; i < numOfLogicalCores - 1; i++)
 	{
-		GameTimerManager::Instance().gameTime.renderThreadTime[i] = 0.0;
 		GameTimerManager::Instance().gameTime.batchCount[i] = 0;
+		GameTimerManager::Instance().gameTime.stateIssuedCount[i] = 0;
+		GameTimerManager::Instance().gameTime.stateFilteredCount[i] = 0;
 	}
+	memset(GameTimerManager::Instance().gameTime.recordPassTime, 0, sizeof(GameTimerManager::Instance().gameTime.recordPassTime));
+	FrameStatistics::Instance().Reset();
 #endif
 
 	// render path
 	Camera* cam = CameraManager::Instance().GetCamera();
-	ForwardRenderingPath::Instance().CullingWork(cam);
-	ForwardRenderingPath::Instance().SortingWork(cam);
 	ForwardRenderingPath::Instance().RenderLoop(cam, currFrameIndex);
 }
 
@@ -349,6 +325,12 @@ void GraphicManager::ExecuteCommandList(ID3D12GraphicsCommandList* _cmdList)
 	mainGraphicQueue->ExecuteCommandLists(1, &list);
 }
 
+void GraphicManager::ExecuteCommandLists(ID3D12CommandList** _lists, int _count)
+{
+	// lists are closed by their recording threads
+	mainGraphicQueue->ExecuteCommandLists(_count, _lists);
+}
+
 void GraphicManager::CopyResourceWithBarrier(ID3D12GraphicsCommandList* _cmdList, ID3D12Resource* _src, ID3D12Resource* _dst, D3D12_RESOURCE_STATES _beforeCopy[2], D3D12_RESOURCE_STATES _afterCopy[2])
 {
 	D3D12_RESOURCE_BARRIER copyBefore[2];
@@ -362,6 +344,7 @@ void GraphicManager::CopyResourceWithBarrier(ID3D12GraphicsCommandList* _cmdList
 	_cmdList->ResourceBarrier(2, copyBefore);
 	_cmdList->CopyResource(_dst, _src);
 	_cmdList->ResourceBarrier(2, copyAfter);
+	GRAPHIC_STAT_ADD(StatBarriers, 4)
 }
 
 void GraphicManager::ResolveColorBuffer(ID3D12GraphicsCommandList* _cmdList, ID3D12Resource* _src, ID3D12Resource* _dst, DXGI_FORMAT _format)
@@ -380,6 +363,7 @@ void GraphicManager::ResolveColorBuffer(ID3D12GraphicsCommandList* _cmdList, ID3
 	_cmdList->ResourceBarrier(2, resolveColor);
 	_cmdList->ResolveSubresource(_dst, 0, _src, 0, _format);
 	_cmdList->ResourceBarrier(2, finishResolve);
+	GRAPHIC_STAT_ADD(StatBarriers, 4)
 }
 
 void GraphicManager::RenderThread()
@@ -443,12 +427,6 @@ FrameResource* GraphicManager::GetFrameResource()
 {
 	frameResource.mainGfxAllocator = mainGfxAllocator[currFrameIndex].Get();
 	frameResource.mainGfxList = mainGfxList.Get();
-
-	for (int i = 0; i < numOfLogicalCores - 1; i++)
-	{
-		frameResource.workerGfxAlloc[i] = workerGfxAllocator[i][currFrameIndex].Get();
-		frameResource.workerGfxList[i] = workerGfxList[i].Get();
-	}
 	frameResource.currFrameIndex = currFrameIndex;
 
 	return &frameResource;
@@ -459,32 +437,17 @@ UINT64 GraphicManager::GetGpuFreq()
 	return gpuFreq;
 }
 
-void GraphicManager::WaitBeginWorkerThread(int _index)
-{
-	WaitForSingleObject(beginWorkerThread[_index], INFINITE);
-}
 
-void GraphicManager::WakeAndWaitWorker()
+void GraphicManager::RunWorkerJobs(int _jobCount, const JobSystem::JobFunc& _func)
 {
-	// reset thread
-	for (int i = 0; i < numOfLogicalCores - 1; i++)
-	{
-		ResetEvent(workerThreadFinish[i]);
-	}
-
-	// begin thread
-	for (int i = 0; i < numOfLogicalCores - 1; i++)
-	{
-		SetEvent(beginWorkerThread[i]);
-	}
-
-	// wait for thread finish
-	WaitForMultipleObjects(numOfLogicalCores - 1, workerThreadFinish, TRUE, INFINITE);
+	// job index selects command list and result slots, any thread can run any index
+	jobSystem.ParallelFor(_jobCount, _func);
 }
 
-void GraphicManager::SetWorkerThreadFinishEvent(int _index)
+bool GraphicManager::RunTaskGraph(TaskGraph& _graph)
 {
-	SetEvent(workerThreadFinish[_index]);
+	// tasks and their worker jobs share the same threads, a waiting task helps with other jobs
+	return _graph.Run(jobSystem);
 }
 
 void GraphicManager::UploadSystemConstant(SystemConstant _sc)
@@ -495,6 +458,7 @@ void GraphicManager::UploadSystemConstant(SystemConstant _sc)
 
 	systemConstantCPU = _sc;
 	systemConstantGPU[currFrameIndex]->CopyData(0, systemConstantCPU);
+	GRAPHIC_STAT_ADD(StatUploadBytes, sizeof(SystemConstant))
 }
 
 SystemConstant GraphicManager::GetSystemConstantCPU()
@@ -507,6 +471,61 @@ D3D12_GPU_VIRTUAL_ADDRESS GraphicManager::GetSystemConstantGPU()
 	return systemConstantGPU[currFrameIndex]->Resource()->GetGPUVirtualAddress();
 }
 
+void GraphicManager::BeginConstantRing()
+{
+	// render thread signals mainFence + 1 after this frame is drawn
+	constantRing.BeginFrame(mainGraphicFence->GetCompletedValue(), mainFence + 1);
+}
+
+UploadRingBuffer* GraphicManager::GetConstantRing()
+{
+	return &constantRing;
+}
+
+void GraphicManager::DeferRelease(shared_ptr<void> _object)
+{
+	// submitted frames and the frame being recorded might still use it
+	deferredObjects.Add(_object, mainFence + 1);
+}
+
+UINT64 GraphicManager::GetPendingFence()
+{
+	// work submitted from now on is done once the fence reaches this
+	return mainFence + 1;
+}
+
+PooledCommandList* GraphicManager::AcquireCommandList()
+{
+	PooledCommandList* cmd = commandListPool.Acquire(mainGraphicFence->GetCompletedValue());
+	if (cmd == nullptr)
+	{
+		LogMessage(L"[SqGraphic Error] Failed to create pooled command list.");
+		return nullptr;
+	}
+
+	// gpu is done with last submission of this pair, allocator memory can be reused
+	LogIfFailedWithoutHR(cmd->allocator->Reset());
+	LogIfFailedWithoutHR(cmd->list->Reset(cmd->allocator.Get(), nullptr));
+
+	return cmd;
+}
+
+void GraphicManager::RecycleCommandList(PooledCommandList* _cmd)
+{
+	// submitted during this frame, so it is free after the frame's fence
+	commandListPool.Recycle(_cmd, mainFence + 1);
+}
+
+void GraphicManager::ReleaseDeferredObjects()
+{
+	if (deferredObjects.GetCount() == 0)
+	{
+		return;
+	}
+
+	deferredObjects.Release(mainGraphicFence->GetCompletedValue());
+}
+
 void GraphicManager::GetScreenSize(int& _w, int& _h)
 {
 	_w = screenWidth;
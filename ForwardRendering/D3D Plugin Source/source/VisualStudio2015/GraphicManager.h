@@ -13,17 +13,16 @@ using namespace Microsoft::WRL;
 // frame resource
 #include "FrameResource.h"
 #include "UploadBuffer.h"
+#include "UploadRingBuffer.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
+#include "FencedPool.h"
+#include "DeferredReleaseList.h"
 
 // game time
 #include "GameTimerManager.h"
 #include "CameraManager.h"
 
-// setup thread parameter
-struct ThreadParameter
-{
-	int threadIndex;
-};
-
 class GraphicManager
 {
 public:
@@ -55,6 +54,7 @@ public:
 	void ResetCreationList();
 	void ExecuteCreationList();
 	void ExecuteCommandList(ID3D12GraphicsCommandList* _cmdList);
+	void ExecuteCommandLists(ID3D12CommandList** _lists, int _count);
 	void CopyResourceWithBarrier(ID3D12GraphicsCommandList* _cmdList, ID3D12Resource* _src, ID3D12Resource* _dst, D3D12_RESOURCE_STATES _beforeCopy[2], D3D12_RESOURCE_STATES _afterCopy[2]);
 	void ResolveColorBuffer(ID3D12GraphicsCommandList* _cmdList, ID3D12Resource* _src, ID3D12Resource* _dst, DXGI_FORMAT _format);
 
@@ -67,12 +67,17 @@ public:
 	UINT GetCbvSrvUavDesciptorSize();
 	FrameResource *GetFrameResource();
 	UINT64 GetGpuFreq();
-	void WaitBeginWorkerThread(int _index);
-	void WakeAndWaitWorker();
-	void SetWorkerThreadFinishEvent(int _index);
+	void RunWorkerJobs(int _jobCount, const JobSystem::JobFunc& _func);
+	bool RunTaskGraph(TaskGraph& _graph);
 	void UploadSystemConstant(SystemConstant _sc);
 	SystemConstant GetSystemConstantCPU();
 	D3D12_GPU_VIRTUAL_ADDRESS GetSystemConstantGPU();
+	void BeginConstantRing();
+	UploadRingBuffer* GetConstantRing();
+	void DeferRelease(shared_ptr<void> _object);
+	UINT64 GetPendingFence();
+	PooledCommandList* AcquireCommandList();
+	void RecycleCommandList(PooledCommandList* _cmd);
 	void GetScreenSize(int& _w, int& _h);
 
 private:
@@ -83,15 +88,16 @@ private:
 	HRESULT CreateGraphicFences();
 	bool CreateGraphicThreads();
 	void DrawCamera();
+	void ReleaseDeferredObjects();
 
 	ID3D12Device *mainDevice;
 	ComPtr<ID3D12CommandQueue> mainGraphicQueue;
 	ComPtr<ID3D12CommandAllocator> mainGfxAllocator[MAX_FRAME_COUNT];
 	ComPtr<ID3D12GraphicsCommandList> mainGfxList;
 
-	// allow multiple-thread gfx
-	ComPtr<ID3D12CommandAllocator> workerGfxAllocator[MAX_WORKER_THREAD_COUNT][MAX_FRAME_COUNT];	
-	ComPtr<ID3D12GraphicsCommandList> workerGfxList[MAX_WORKER_THREAD_COUNT];
+	// lists for multiple-thread gfx, created on demand and shrunk to the peak of last trim window
+	static const int COMMAND_LIST_TRIM_FRAMES = 120;
+	FencedPool<PooledCommandList> commandListPool;
 	ComPtr<ID3D12Device5> rayTracingDevice;
 	ComPtr<ID3D12GraphicsCommandList5> rayTracingCmd;
 
@@ -104,10 +110,9 @@ private:
 	HANDLE beginRenderThread;
 	HANDLE renderThreadHandle;
 	HANDLE renderThreadFinish;
-	HANDLE beginWorkerThread[MAX_WORKER_THREAD_COUNT];
-	HANDLE workerThreadHandle[MAX_WORKER_THREAD_COUNT];
-	HANDLE workerThreadFinish[MAX_WORKER_THREAD_COUNT];
-	ThreadParameter threadParams[MAX_WORKER_THREAD_COUNT];
+
+	// worker threads (number of cores - 1), render thread runs jobs too while it waits
+	JobSystem jobSystem;
 
 	// frame index and fences
 	int currFrameIndex;
@@ -135,4 +140,11 @@ private:
 
 	// system constant
 	unique_ptr<UploadBuffer<SystemConstant>> systemConstantGPU[MAX_FRAME_COUNT];
+
+	// transient object constants of in-flight frames
+	static const UINT64 CONSTANT_RING_SIZE = 4 * 1024 * 1024;
+	UploadRingBuffer constantRing;
+
+	// objects replaced while gpu may still use them, released once fence passes
+	DeferredReleaseList deferredObjects;
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// instance batches are found by mesh, submesh, material and queue through a hash table
+struct InstanceBatchKey
+{
+	bool operator==(const InstanceBatchKey& _in) const
+	{
+		return _in.meshID == meshID
+			&& _in.submeshIndex == submeshIndex
+			&& _in.materialID == materialID
+			&& _in.queue == queue;
+	}
+
+	int meshID;
+	int submeshIndex;
+	int materialID;
+	int queue;
+};
+
+struct InstanceBatchKeyHash
+{
+	size_t operator()(const InstanceBatchKey& _key) const
+	{
+		// fnv-1a over the four ids
+		uint64_t h = 14695981039346656037ULL;
+		const int ids[4] = { _key.meshID, _key.submeshIndex, _key.materialID, _key.queue };
+		for (int i = 0; i < 4; i++)
+		{
+			h ^= (uint32_t)ids[i];
+			h *= 1099511628211ULL;
+		}
+
+		return (size_t)h;
+	}
+};
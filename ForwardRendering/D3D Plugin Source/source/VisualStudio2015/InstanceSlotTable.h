@@ -0,0 +1,169 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+using namespace std;
+
+const static int INSTANCE_MIN_CAPACITY = 16;
+
+inline int FitInstanceCapacity(int _capacity, int _memberCount)
+{
+	// grow geometrically, shrink only when mostly empty so adding/removing around a size doesn't thrash
+	if (_memberCount > _capacity)
+	{
+		return max(max(_capacity * 2, _memberCount), INSTANCE_MIN_CAPACITY);
+	}
+
+	if (_capacity > INSTANCE_MIN_CAPACITY && _memberCount * 4 < _capacity)
+	{
+		return max(_memberCount * 2, INSTANCE_MIN_CAPACITY);
+	}
+
+	return _capacity;
+}
+
+// renderer id and world version last written to each slot of one instance buffer
+// a renderer owns at most one slot, so a slot it left can't be taken as current when it comes back later
+class InstanceSlotTable
+{
+public:
+	// every slot starts unknown, used when the buffer is recreated
+	void Reset(int _capacity)
+	{
+		owners.assign(_capacity, -1);
+		versions.assign(_capacity, 0);
+		ownedSlot.clear();
+		ownedSlot.reserve(_capacity);
+	}
+
+	void Release()
+	{
+		owners.clear();
+		versions.clear();
+		ownedSlot.clear();
+	}
+
+	int GetCapacity() const
+	{
+		return (int)owners.size();
+	}
+
+	// checked while collecting, slot needs upload if it held another renderer or its renderer is dirty for this buffer
+	bool NeedsWrite(int _slot, int _id, bool _dirty) const
+	{
+		return _dirty || owners[_slot] != _id;
+	}
+
+	// true if slot doesn't hold this version of renderer yet, slot is recorded as written then
+	// guards slots picked by NeedsWrite, a renderer dirty because of another batch doesn't rewrite a current slot
+	bool Claim(int _slot, int _id, uint32_t _version)
+	{
+		if (owners[_slot] == _id && versions[_slot] == _version)
+		{
+			return false;
+		}
+
+		// renderer moves out of its old slot, and the renderer that held this slot loses it
+		auto it = ownedSlot.find(_id);
+		if (it != ownedSlot.end() && it->second != _slot)
+		{
+			owners[it->second] = -1;
+		}
+
+		if (owners[_slot] != -1 && owners[_slot] != _id)
+		{
+			ownedSlot.erase(owners[_slot]);
+		}
+
+		owners[_slot] = _id;
+		versions[_slot] = _version;
+		ownedSlot[_id] = _slot;
+		return true;
+	}
+
+private:
+	vector<int> owners;
+	vector<uint32_t> versions;
+
+	// renderer id to the slot it owns, only touched when a slot is written
+	unordered_map<int, int> ownedSlot;
+};
+
+// renderers whose world changed since each frame buffer last uploaded them
+// a dirty bit per frame buffer dedupes the lists, so marking is O(1) and clearing walks only the list
+template<int FRAME_COUNT>
+class WorldDirtyList
+{
+public:
+	// new handle is dirty in every frame buffer
+	int Add()
+	{
+		bits.push_back(0);
+		int handle = (int)bits.size() - 1;
+		Mark(handle);
+
+		return handle;
+	}
+
+	void Release()
+	{
+		bits.clear();
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			lists[i].clear();
+		}
+	}
+
+	void Mark(int _handle)
+	{
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			uint8_t bit = (uint8_t)(1 << i);
+			if ((bits[_handle] & bit) == 0)
+			{
+				bits[_handle] |= bit;
+				lists[i].push_back(_handle);
+			}
+		}
+	}
+
+	bool IsDirty(int _handle, int _frameIdx) const
+	{
+		return (bits[_handle] & (1 << _frameIdx)) != 0;
+	}
+
+	const vector<int>& GetList(int _frameIdx) const
+	{
+		return lists[_frameIdx];
+	}
+
+	// after upload of a frame buffer, handles it didn't upload (not visible) stay dirty for it
+	template<typename UploadedFunc>
+	void Clear(int _frameIdx, UploadedFunc _isUploaded)
+	{
+		uint8_t bit = (uint8_t)(1 << _frameIdx);
+		vector<int>& list = lists[_frameIdx];
+		int keepCount = 0;
+
+		for (int i = 0; i < (int)list.size(); i++)
+		{
+			if (_isUploaded(list[i]))
+			{
+				bits[list[i]] &= ~bit;
+			}
+			else
+			{
+				list[keepCount++] = list[i];
+			}
+		}
+
+		list.resize(keepCount);
+	}
+
+private:
+	static_assert(FRAME_COUNT <= 8, "one byte of dirty bits per handle");
+
+	vector<uint8_t> bits;
+	vector<int> lists[FRAME_COUNT];
+};
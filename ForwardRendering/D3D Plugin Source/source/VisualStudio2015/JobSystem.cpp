@@ -0,0 +1,226 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// index of worker that runs on this thread, -1 for threads outside job system
+static thread_local int currentWorker = -1;
+
+// tag of the job running on this thread, or whatever the thread set outside jobs
+static thread_local int currentTag = -1;
+
+void JobSystem::Init(int _numThreads)
+{
+	running = true;
+	_numThreads = max(_numThreads, 1);
+
+	for (int i = 0; i < _numThreads; i++)
+	{
+		queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+
+	for (int i = 0; i < _numThreads; i++)
+	{
+		workers.push_back(thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+void JobSystem::Release()
+{
+	{
+		lock_guard<mutex> lock(sleepLock);
+		running = false;
+	}
+	sleepCondition.notify_all();
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	workers.clear();
+	queues.clear();
+	queuedJobs = 0;
+}
+
+void JobSystem::Dispatch(int _jobCount, const JobFunc& _func, JobCounter& _counter)
+{
+	if (_jobCount <= 0)
+	{
+		return;
+	}
+
+	_counter.count += _jobCount;
+
+	// nested dispatch stays on own deque (others steal it), outside threads spread jobs over all deques
+	int numQueues = (int)queues.size();
+	int start = (currentWorker != -1) ? currentWorker : nextQueue.fetch_add(1) % numQueues;
+
+	for (int i = 0; i < _jobCount; i++)
+	{
+		int q = (currentWorker != -1) ? start : (start + i) % numQueues;
+
+		Job job;
+		job.func = &_func;
+		job.index = i;
+		job.tag = currentTag;
+		job.counter = &_counter;
+
+		lock_guard<mutex> lock(queues[q]->lock);
+		queues[q]->jobs.push_back(job);
+	}
+
+	queuedJobs += _jobCount;
+	{
+		lock_guard<mutex> lock(sleepLock);
+	}
+
+	// only wake as many workers as there are jobs, the rest keep sleeping
+	if (_jobCount >= numQueues)
+	{
+		sleepCondition.notify_all();
+	}
+	else
+	{
+		for (int i = 0; i < _jobCount; i++)
+		{
+			sleepCondition.notify_one();
+		}
+	}
+
+	// blocked waiters can help with new jobs too
+	waitCondition.notify_all();
+}
+
+void JobSystem::Wait(JobCounter& _counter)
+{
+	// help while there are jobs to steal, block once the last jobs are running on other threads
+	while (_counter.count.load(memory_order_acquire) > 0)
+	{
+		if (RunOneJob(currentWorker))
+		{
+			continue;
+		}
+
+		unique_lock<mutex> lock(sleepLock);
+		waitCondition.wait(lock, [this, &_counter]() { return _counter.count.load(memory_order_acquire) == 0 || queuedJobs.load() > 0; });
+	}
+}
+
+void JobSystem::ParallelFor(int _jobCount, const JobFunc& _func)
+{
+	JobCounter counter;
+	Dispatch(_jobCount, _func, counter);
+	Wait(counter);
+}
+
+int JobSystem::GetThreadCount() const
+{
+	return (int)workers.size();
+}
+
+int JobSystem::GetCurrentWorker()
+{
+	return currentWorker;
+}
+
+int JobSystem::GetCurrentTag()
+{
+	return currentTag;
+}
+
+void JobSystem::SetCurrentTag(int _tag)
+{
+	currentTag = _tag;
+}
+
+void JobSystem::WorkerLoop(int _workerIndex)
+{
+	currentWorker = _workerIndex;
+
+	while (true)
+	{
+		if (RunOneJob(_workerIndex))
+		{
+			continue;
+		}
+
+		// queued jobs are drained before shutdown, so no counter is left waiting forever
+		unique_lock<mutex> lock(sleepLock);
+		sleepCondition.wait(lock, [this]() { return !running || queuedJobs.load() > 0; });
+
+		if (!running && queuedJobs.load() == 0)
+		{
+			break;
+		}
+	}
+
+	currentWorker = -1;
+}
+
+bool JobSystem::PopJob(int _workerIndex, Job& _job)
+{
+	// owner takes newest job, it is most likely still in cache
+	WorkerQueue& q = *queues[_workerIndex];
+	lock_guard<mutex> lock(q.lock);
+	if (q.jobs.empty())
+	{
+		return false;
+	}
+
+	_job = q.jobs.back();
+	q.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::StealJob(int _thiefIndex, Job& _job)
+{
+	// thieves take oldest job from the other end
+	int numQueues = (int)queues.size();
+	int start = (_thiefIndex != -1) ? _thiefIndex + 1 : 0;
+
+	for (int i = 0; i < numQueues; i++)
+	{
+		int victim = (start + i) % numQueues;
+		if (victim == _thiefIndex)
+		{
+			continue;
+		}
+
+		WorkerQueue& q = *queues[victim];
+		lock_guard<mutex> lock(q.lock);
+		if (!q.jobs.empty())
+		{
+			_job = q.jobs.front();
+			q.jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::RunOneJob(int _workerIndex)
+{
+	Job job;
+	bool found = (_workerIndex != -1 && PopJob(_workerIndex, job)) || StealJob(_workerIndex, job);
+	if (!found)
+	{
+		return false;
+	}
+
+	queuedJobs--;
+
+	// stolen job must not see the tag of the job this thread is waiting in
+	int previousTag = currentTag;
+	currentTag = job.tag;
+	(*job.func)(job.index);
+	currentTag = previousTag;
+
+	// counter can go out of scope as soon as it reaches 0, only the lock is touched after that
+	if (job.counter->count.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		lock_guard<mutex> lock(sleepLock);
+		waitCondition.notify_all();
+	}
+
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+using namespace std;
+
+const static int MAX_WORKER_THREAD_COUNT = 16;
+
+// counts unfinished jobs of one dispatch, Wait returns when it reaches 0
+struct JobCounter
+{
+	atomic<int> count{ 0 };
+};
+
+// portable job system, every worker owns a deque and steals from others when it runs dry
+// the thread that waits on a counter also runs jobs, so there is no lockstep barrier between stages
+class JobSystem
+{
+public:
+	typedef function<void(int)> JobFunc;
+
+	void Init(int _numThreads);
+	void Release();
+
+	// _func(i) for i in [0, _jobCount), _func must live until counter is waited
+	void Dispatch(int _jobCount, const JobFunc& _func, JobCounter& _counter);
+	void Wait(JobCounter& _counter);
+	void ParallelFor(int _jobCount, const JobFunc& _func);
+
+	int GetThreadCount() const;
+
+	// index of worker running on calling thread, -1 outside job system
+	static int GetCurrentWorker();
+
+	// tag of calling thread, -1 if never set, a job runs with the tag its dispatching thread had at Dispatch
+	// so a thread that waits inside a tagged scope doesn't hand its tag to the jobs it steals
+	static int GetCurrentTag();
+	static void SetCurrentTag(int _tag);
+
+private:
+	struct Job
+	{
+		const JobFunc* func;
+		int index;
+		int tag;
+		JobCounter* counter;
+	};
+
+	struct WorkerQueue
+	{
+		mutex lock;
+		deque<Job> jobs;
+	};
+
+	void WorkerLoop(int _workerIndex);
+	bool PopJob(int _workerIndex, Job& _job);
+	bool StealJob(int _thiefIndex, Job& _job);
+	bool RunOneJob(int _workerIndex);
+
+	vector<thread> workers;
+	vector<unique_ptr<WorkerQueue>> queues;
+
+	// sleeping workers are woken when jobs are pushed
+	// waiting threads are woken when jobs are pushed or a counter reaches 0
+	mutex sleepLock;
+	condition_variable sleepCondition;
+	condition_variable waitCondition;
+	atomic<int> queuedJobs{ 0 };
+	atomic<bool> running{ false };
+	atomic<int> nextQueue{ 0 };
+};
\ No newline at end of file
@@ -108,18 +108,21 @@ void LightManager::UploadPerLightBuffer(int _frameIdx)
 				SqLightData* sld = lightList[j].GetLightData();
 				lightData[_frameIdx]->CopyData(j, *sld);
 				lightList[j].SetDirty(false, _frameIdx);
+				GRAPHIC_STAT_ADD(StatUploadBytes, sizeof(SqLightData))
 			}
 		}
 	}
 
-	// upload skybox constant
-	ObjectConstant oc;
-	oc.sqMatrixWorld = skybox.GetRenderer()->GetWorld();
-
-	if (skybox.GetRenderer()->IsDirty(_frameIdx))
+	// upload skybox constant, ring slices only live for one frame
+	if (skybox.GetRenderer()->GetMesh() == nullptr)
 	{
-		skybox.GetRenderer()->UpdateObjectConstant(oc, _frameIdx);
+		return;
 	}
+
+	ObjectConstant oc;
+	oc.sqMatrixWorld = skybox.GetRenderer()->GetWorld();
+	oc.sqMatrixInvWorld = skybox.GetRenderer()->GetInvWorld();
+	skybox.SetObjectConstantGPU(GraphicManager::Instance().GetConstantRing()->AllocateConstant(&oc, sizeof(ObjectConstant)));
 }
 
 void LightManager::FillSystemConstant(SystemConstant& _sc)
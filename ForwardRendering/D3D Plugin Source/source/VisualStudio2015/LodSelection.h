@@ -0,0 +1,45 @@
+#pragma once
+
+// lod switches only after screen size passes the threshold by this fraction
+const static float LOD_HYSTERESIS = 0.1f;
+
+// _thresholds[i] is the min screen size that keeps lod i, descending with lod
+// returns the lod to use this frame given the lod used last frame
+inline int SelectLod(const float* _thresholds, int _lodCount, float _screenSize, int _currLod, float _hysteresis)
+{
+	if (_lodCount <= 0)
+	{
+		return 0;
+	}
+
+	// no history, pick directly
+	if (_currLod < 0 || _currLod >= _lodCount)
+	{
+		int lod = 0;
+		while (lod < _lodCount - 1 && _screenSize < _thresholds[lod])
+		{
+			lod++;
+		}
+		return lod;
+	}
+
+	// finer lod needs to exceed its threshold by the band
+	int lod = _currLod;
+	while (lod > 0 && _screenSize >= _thresholds[lod - 1] * (1.0f + _hysteresis))
+	{
+		lod--;
+	}
+
+	if (lod != _currLod)
+	{
+		return lod;
+	}
+
+	// coarser lod needs to drop below current threshold by the band
+	while (lod < _lodCount - 1 && _screenSize < _thresholds[lod] * (1.0f - _hysteresis))
+	{
+		lod++;
+	}
+
+	return lod;
+}
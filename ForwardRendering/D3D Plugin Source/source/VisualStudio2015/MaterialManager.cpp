@@ -332,6 +332,7 @@ bool MaterialManager::SetGraphicPass(ID3D12GraphicsCommandList* _cmdList, Materi
 
 	_cmdList->SetPipelineState(_mat->GetPSO());
 	_cmdList->SetGraphicsRootSignature(_mat->GetRootSignature());
+	GRAPHIC_STAT_ADD(StatPsoSwitches, 1)
 
 	return true;
 }
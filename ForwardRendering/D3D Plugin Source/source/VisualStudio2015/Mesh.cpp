@@ -36,6 +36,24 @@ bool Mesh::Initialize(int _instanceID, MeshData _mesh)
 	indexBuffer = make_unique<DefaultBuffer>(device, ibDesc);
 	cmdList->CopyResource(indexBuffer->Resource(), ibSrc);
 
+	// readback copy for cpu side geometry
+	auto readbackHeap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	auto vbReadbackDesc = CD3DX12_RESOURCE_DESC::Buffer(vbDesc.Width);
+	auto ibReadbackDesc = CD3DX12_RESOURCE_DESC::Buffer(ibDesc.Width);
+	if (SUCCEEDED(device->CreateCommittedResource(&readbackHeap, D3D12_HEAP_FLAG_NONE, &vbReadbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(readbackVertex.GetAddressOf())))
+		&& SUCCEEDED(device->CreateCommittedResource(&readbackHeap, D3D12_HEAP_FLAG_NONE, &ibReadbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(readbackIndex.GetAddressOf()))))
+	{
+		cmdList->CopyBufferRegion(readbackVertex.Get(), 0, vbSrc, 0, vbDesc.Width);
+		cmdList->CopyBufferRegion(readbackIndex.Get(), 0, ibSrc, 0, ibDesc.Width);
+		readbackFence = GraphicManager::Instance().GetPendingFence();
+	}
+	else
+	{
+		LogMessage(L"[SqGraphic Error] SqMesh: Create readback buffer failed, mesh can't be an occluder.");
+		readbackVertex.Reset();
+		readbackIndex.Reset();
+	}
+
 	GraphicManager::Instance().ExecuteCreationList();
 
 	for (int i = 0; i < meshData.subMeshCount; i++)
@@ -102,6 +120,10 @@ void Mesh::Release()
 
 	vertexBuffer.reset();
 	indexBuffer.reset();
+	readbackVertex.Reset();
+	readbackIndex.Reset();
+	cpuPositions.clear();
+	cpuIndices.clear();
 }
 
 void Mesh::ReleaseScratch()
@@ -113,6 +135,61 @@ void Mesh::ReleaseScratch()
 	scratchBottom.clear();
 }
 
+void Mesh::ReadbackGeometry()
+{
+	// must be called after gpu finishes the copy in Initialize
+	if (readbackVertex == nullptr || readbackIndex == nullptr)
+	{
+		return;
+	}
+
+	D3D12_RANGE readRange = { 0, meshData.vertexSizeInBytes };
+	void* data = nullptr;
+	if (SUCCEEDED(readbackVertex->Map(0, &readRange, &data)))
+	{
+		// position is the first float3 of a vertex
+		int vertCount = meshData.vertexSizeInBytes / meshData.vertexStrideInBytes;
+		cpuPositions.resize(vertCount);
+
+		for (int i = 0; i < vertCount; i++)
+		{
+			memcpy(&cpuPositions[i], (BYTE*)data + i * meshData.vertexStrideInBytes, sizeof(XMFLOAT3));
+		}
+
+		D3D12_RANGE writeRange = { 0, 0 };
+		readbackVertex->Unmap(0, &writeRange);
+	}
+
+	readRange = { 0, meshData.indexSizeInBytes };
+	if (SUCCEEDED(readbackIndex->Map(0, &readRange, &data)))
+	{
+		int idxStride = (meshData.indexFormat == 0) ? 2 : 4;
+		int idxCount = meshData.indexSizeInBytes / idxStride;
+		cpuIndices.resize(idxCount);
+
+		for (int i = 0; i < idxCount; i++)
+		{
+			cpuIndices[i] = (idxStride == 2) ? ((unsigned short*)data)[i] : ((unsigned int*)data)[i];
+		}
+
+		D3D12_RANGE writeRange = { 0, 0 };
+		readbackIndex->Unmap(0, &writeRange);
+	}
+
+	readbackVertex.Reset();
+	readbackIndex.Reset();
+}
+
+bool Mesh::IsReadbackPending()
+{
+	return readbackVertex != nullptr && readbackIndex != nullptr;
+}
+
+UINT64 Mesh::GetReadbackFence()
+{
+	return readbackFence;
+}
+
 void Mesh::DrawSubMesh(ID3D12GraphicsCommandList* _cmdList, int _subIndex, int _instanceCount)
 {
 	SubMesh sm = GetSubMesh(_subIndex);
@@ -194,6 +271,16 @@ void Mesh::CreateBottomAccelerationStructure(ID3D12GraphicsCommandList5* _dxrLis
 	}
 }
 
+const vector<XMFLOAT3>& Mesh::GetCpuPositions() const
+{
+	return cpuPositions;
+}
+
+const vector<unsigned int>& Mesh::GetCpuIndices() const
+{
+	return cpuIndices;
+}
+
 ID3D12Resource* Mesh::GetBottomAS(int _submesh)
 {
 	return bottomLevelAS[_submesh]->Resource();
@@ -35,6 +35,9 @@ public:
 	bool Initialize(int _instanceID, MeshData _mesh);
 	void Release();
 	void ReleaseScratch();
+	void ReadbackGeometry();
+	bool IsReadbackPending();
+	UINT64 GetReadbackFence();
 	void DrawSubMesh(ID3D12GraphicsCommandList* _cmdList, int _subIndex, int _instanceCount);
 
 	D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView();
@@ -44,6 +47,8 @@ public:
 	ID3D12Resource* GetBottomAS(int _submesh);
 	int GetVertexSrv();
 	int GetInstanceID();
+	const vector<XMFLOAT3>& GetCpuPositions() const;
+	const vector<unsigned int>& GetCpuIndices() const;
 
 private:
 	MeshData meshData;
@@ -59,6 +64,13 @@ private:
 	D3D12_VERTEX_BUFFER_VIEW vbv;
 	D3D12_INDEX_BUFFER_VIEW ibv;
 
+	// cpu copy of positions and indices for software occlusion, filled after gpu copy is done
+	ComPtr<ID3D12Resource> readbackVertex;
+	ComPtr<ID3D12Resource> readbackIndex;
+	UINT64 readbackFence = 0;
+	vector<XMFLOAT3> cpuPositions;
+	vector<unsigned int> cpuIndices;
+
 	vector<unique_ptr<DefaultBuffer>> scratchBottom;
 	vector<unique_ptr<DefaultBuffer>> bottomLevelAS;
 };
\ No newline at end of file
@@ -29,6 +29,11 @@ bool MeshManager::AddMesh(int _instanceID, MeshData _mesh)
 	{
 		meshes.push_back(std::move(m));
 		meshIndexTable[_instanceID] = (int)meshes.size() - 1;
+
+		if (meshes.back().IsReadbackPending())
+		{
+			pendingReadback.push_back((int)meshes.size() - 1);
+		}
 	}
 
 	return init;
@@ -42,6 +47,7 @@ void MeshManager::Release()
 	}
 
 	meshes.clear();
+	pendingReadback.clear();
 	defaultInputLayout.clear();
 	meshIndexTable.clear();
 	indexInHeap.clear();
@@ -63,6 +69,35 @@ void MeshManager::ReleaseScratch()
 	}
 }
 
+void MeshManager::ReadbackGeometry()
+{
+	// caller has waited for gpu
+	for (int i : pendingReadback)
+	{
+		meshes[i].ReadbackGeometry();
+	}
+	pendingReadback.clear();
+}
+
+void MeshManager::ReadbackCompletedGeometry(UINT64 _completedFence)
+{
+	// meshes added after instance rendering init become occluders once their copy is done,
+	// this also releases their readback buffers
+	for (size_t i = 0; i < pendingReadback.size();)
+	{
+		Mesh& m = meshes[pendingReadback[i]];
+		if (m.GetReadbackFence() > _completedFence)
+		{
+			i++;
+			continue;
+		}
+
+		m.ReadbackGeometry();
+		pendingReadback[i] = pendingReadback.back();
+		pendingReadback.pop_back();
+	}
+}
+
 Mesh * MeshManager::GetMesh(int _instanceID)
 {
 	if (meshIndexTable.find(_instanceID) != meshIndexTable.end())
@@ -73,6 +108,16 @@ Mesh * MeshManager::GetMesh(int _instanceID)
 	return nullptr;
 }
 
+int MeshManager::GetMeshIndex(int _instanceID)
+{
+	if (meshIndexTable.find(_instanceID) != meshIndexTable.end())
+	{
+		return meshIndexTable[_instanceID];
+	}
+
+	return -1;
+}
+
 D3D12_INPUT_ELEMENT_DESC* MeshManager::GetDefaultInputLayout()
 {
 	return defaultInputLayout.data();
@@ -28,13 +28,17 @@ public:
 	void Release();
 	void CreateBottomAccelerationStructure(ID3D12GraphicsCommandList5* _dxrList);
 	void ReleaseScratch();
+	void ReadbackGeometry();
+	void ReadbackCompletedGeometry(UINT64 _completedFence);
 
 	Mesh *GetMesh(int _instanceID);
+	int GetMeshIndex(int _instanceID);
 	D3D12_INPUT_ELEMENT_DESC* GetDefaultInputLayout();
 	UINT GetDefaultInputLayoutSize();
 
 private:
 	vector<Mesh> meshes;
+	vector<int> pendingReadback;
 	vector<int> indexInHeap;
 	vector<D3D12_INPUT_ELEMENT_DESC> defaultInputLayout;
 	unordered_map<int, int> meshIndexTable;
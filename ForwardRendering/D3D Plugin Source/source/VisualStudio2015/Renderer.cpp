@@ -1,37 +1,23 @@
 #include "Renderer.h"
 #include "GraphicManager.h"
 
-void Renderer::Init(int _meshID, bool _isDynamic)
+void Renderer::Init(RendererPool* _pool, int _meshID, bool _isDynamic)
 {
-	for (int i = 0; i < MAX_FRAME_COUNT; i++)
-	{
-		rendererConstant[i] = make_unique<UploadBuffer<ObjectConstant>>(GraphicManager::Instance().GetDevice(), 1, true);
-		isDirty[i] = true;
-	}
+	// hot state lives in pool, starts visible and active
+	pool = _pool;
+	handle = pool->Add(_isDynamic);
 
-	mesh = MeshManager::Instance().GetMesh(_meshID);
-	isVisible = true;
+	lodMeshes.push_back(MeshManager::Instance().GetMesh(_meshID));
+	lodScreenSizes.push_back(0.0f);
+	currLod = 0;
 	isShadowVisible = true;
-	isActive = true;
-	isDynamic = _isDynamic;
 }
 
 void Renderer::Release()
 {
-	for (int i = 0; i < MAX_FRAME_COUNT; i++)
-	{
-		rendererConstant[i].reset();
-	}
 	materials.clear();
-
-	mesh = nullptr;
-}
-
-void Renderer::UpdateObjectConstant(ObjectConstant _sc, int _frameIdx)
-{
-	currentObjConst = _sc;
-	rendererConstant[_frameIdx]->CopyData(0, currentObjConst);
-	isDirty[_frameIdx] = false;
+	lodMeshes.clear();
+	lodScreenSizes.clear();
 }
 
 void Renderer::UpdateLocalBound(float _cx, float _cy, float _cz, float _ex, float _ey, float _ez)
@@ -43,7 +29,7 @@ void Renderer::UpdateLocalBound(float _cx, float _cy, float _cz, float _ex, floa
 
 void Renderer::SetVisible(bool _visible)
 {
-	isVisible = _visible && isActive;
+	pool->SetVisible(handle, _visible);
 }
 
 void Renderer::SetShadowVisible(bool _visible)
@@ -53,29 +39,19 @@ void Renderer::SetShadowVisible(bool _visible)
 
 void Renderer::SetActive(bool _active)
 {
-	isActive = _active;
-}
-
-void Renderer::SetDirty(int _frameIdx)
-{
-	isDirty[_frameIdx] = true;
+	pool->SetActive(handle, _active);
 }
 
 void Renderer::SetWorld(XMFLOAT4X4 _world)
 {
-	world = _world;
-
-	// inverse world for normal transform
-	XMMATRIX w = XMLoadFloat4x4(&world);
-	XMStoreFloat4x4(&invWorld, XMMatrixInverse(&XMMatrixDeterminant(w), w));
-
 	// update bound also note we only cache local bound when init!
-	localBound.Transform(worldBound, XMLoadFloat4x4(&world));
+	pool->SetWorld(handle, _world, localBound);
+}
 
-	for (int i = 0; i < MAX_FRAME_COUNT; i++)
-	{
-		SetDirty(i);
-	}
+void Renderer::UpdateWorld(const XMFLOAT4X4& _world)
+{
+	// world and bound only, caller bumps world version afterward
+	pool->UpdateWorld(handle, _world, localBound);
 }
 
 void Renderer::SetInstanceID(int _id)
@@ -88,29 +64,73 @@ void Renderer::AddMaterial(Material* _material)
 	materials.push_back(_material);
 }
 
+void Renderer::AddLod(int _meshID, float _screenSize)
+{
+	Mesh* m = MeshManager::Instance().GetMesh(_meshID);
+	if (m == nullptr)
+	{
+		return;
+	}
+
+	// previous lod is kept while screen size >= _screenSize
+	lodScreenSizes.back() = _screenSize;
+	lodMeshes.push_back(m);
+	lodScreenSizes.push_back(0.0f);
+}
+
+bool Renderer::UpdateLod(float _screenSize)
+{
+	// returns true if lod changed
+	int lod = SelectLod(lodScreenSizes.data(), (int)lodScreenSizes.size(), _screenSize, currLod, LOD_HYSTERESIS);
+	bool changed = (lod != currLod);
+	currLod = lod;
+
+	return changed;
+}
+
 XMFLOAT4X4 Renderer::GetWorld()
 {
-	return world;
+	return pool->GetWorld(handle);
 }
 
 XMFLOAT4X4 Renderer::GetInvWorld()
 {
-	return invWorld;
+	return pool->GetInvWorld(handle);
 }
 
 Mesh * Renderer::GetMesh()
 {
-	return mesh;
+	return GetMesh(currLod);
+}
+
+Mesh* Renderer::GetMesh(int _lod)
+{
+	if (_lod < 0 || _lod >= (int)lodMeshes.size())
+	{
+		return nullptr;
+	}
+
+	return lodMeshes[_lod];
+}
+
+int Renderer::GetLodCount()
+{
+	return (int)lodMeshes.size();
+}
+
+int Renderer::GetLod()
+{
+	return currLod;
 }
 
 BoundingBox Renderer::GetWorldBound()
 {
-	return worldBound;
+	return pool->GetWorldBound(handle);
 }
 
 bool Renderer::GetVisible()
 {
-	return isVisible;
+	return pool->IsVisible(handle);
 }
 
 bool Renderer::GetShadowVisible()
@@ -120,17 +140,17 @@ bool Renderer::GetShadowVisible()
 
 bool Renderer::GetActive()
 {
-	return isActive;
+	return pool->IsActive(handle);
 }
 
-bool Renderer::IsDirty(int _frameIdx)
+bool Renderer::IsDynamic()
 {
-	return isDirty[_frameIdx];
+	return pool->IsDynamic(handle);
 }
 
-bool Renderer::IsDynamic()
+int Renderer::GetHandle()
 {
-	return isDynamic;
+	return handle;
 }
 
 int Renderer::GetInstanceID()
@@ -158,14 +178,9 @@ Material* const Renderer::GetMaterial(int _index)
 	return materials[_index];
 }
 
-D3D12_GPU_VIRTUAL_ADDRESS Renderer::GetObjectConstantGPU(int _frameIdx)
-{
-	return rendererConstant[_frameIdx]->Resource()->GetGPUVirtualAddress();
-}
-
 float Renderer::GetSqrDistanceToCamera(Camera* _camera)
 {
-	XMVECTOR cRenderer = XMLoadFloat3(&worldBound.Center);
+	XMVECTOR cRenderer = XMLoadFloat3(&pool->GetWorldBound(handle).Center);
 	XMVECTOR cCamera = XMLoadFloat3(&_camera->GetPosition());
 
 	// return square distance
@@ -6,53 +6,55 @@
 using namespace DirectX;
 #include "Material.h"
 #include "Camera.h"
+#include "RendererPool.h"
+#include "LodSelection.h"
 
 class Renderer
 {
 public:
-	void Init(int _meshID, bool _isDynamic);
+	void Init(RendererPool* _pool, int _meshID, bool _isDynamic);
 	void Release();
-	void UpdateObjectConstant(ObjectConstant _sc, int _frameIdx);
 	void UpdateLocalBound(float _cx,float _cy, float _cz, float _ex, float _ey, float _ez);
 	void SetVisible(bool _visible);
 	void SetShadowVisible(bool _visible);
 	void SetActive(bool _active);
-	void SetDirty(int _frameIdx);
 	void SetWorld(XMFLOAT4X4 _world);
+	void UpdateWorld(const XMFLOAT4X4& _world);
 	void SetInstanceID(int _id);
 	void AddMaterial(Material *_material);
+	void AddLod(int _meshID, float _screenSize);
+	bool UpdateLod(float _screenSize);
 
 	XMFLOAT4X4 GetWorld();
 	XMFLOAT4X4 GetInvWorld();
 	Mesh *GetMesh();
+	Mesh *GetMesh(int _lod);
+	int GetLodCount();
+	int GetLod();
 	BoundingBox GetWorldBound();
 	bool GetVisible();
 	bool GetShadowVisible();
 	bool GetActive();
-	bool IsDirty(int _frameIdx);
 	bool IsDynamic();
+	int GetHandle();
 	int GetInstanceID();
 	int GetNumMaterials();
 	const vector<Material*> GetMaterials();
 	Material* const GetMaterial(int _index);
-	D3D12_GPU_VIRTUAL_ADDRESS GetObjectConstantGPU(int _frameIdx);
 	float GetSqrDistanceToCamera(Camera* _camera);
 
 private:
-	ObjectConstant currentObjConst;
-	unique_ptr<UploadBuffer<ObjectConstant>> rendererConstant[MAX_FRAME_COUNT];
-
-	Mesh *mesh;
+	// lod 0 is the mesh from Init, lodScreenSizes[i] is the min screen size of lod i
+	vector<Mesh*> lodMeshes;
+	vector<float> lodScreenSizes;
+	int currLod = 0;
 	BoundingBox localBound;
-	BoundingBox worldBound;
-	bool isVisible;
 	bool isShadowVisible;
-	bool isActive;
-	bool isDirty[MAX_FRAME_COUNT];
-	bool isDynamic;
 	int instanceID = -1;
 
+	// world, bound and flags are in pool, only cold data is kept here
+	RendererPool* pool = nullptr;
+	int handle = -1;
+
 	vector<Material*> materials;
-	XMFLOAT4X4 world;
-	XMFLOAT4X4 invWorld;
 };
\ No newline at end of file
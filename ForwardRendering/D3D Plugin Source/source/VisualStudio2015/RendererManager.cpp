@@ -3,13 +3,20 @@
 #include "MaterialManager.h"
 #include "GraphicManager.h"
 #include <algorithm>
+#include <functional>
+#include <cmath>
 
 void RendererManager::Init()
 {
-	// request memory for common render queue
-	queuedRenderers[RenderQueue::Opaque].reserve(OPAQUE_CAPACITY);
-	queuedRenderers[RenderQueue::Cutoff].reserve(CUTOFF_CAPACITY);
-	queuedRenderers[RenderQueue::Transparent].reserve(TRANSPARENT_CAPACITY);
+	// request memory for queue renderer, only transparent objects are queued
+	queuedRenderers.reserve(TRANSPARENT_CAPACITY);
+	queueSorter.GetItems().reserve(TRANSPARENT_CAPACITY);
+
+	// static renderers never move, dynamic ones get a fat margin to absorb small movement
+	sceneTree[0].Init(0.0f);
+	sceneTree[1].Init(0.5f);
+
+	occlusionBuffer.Init();
 }
 
 int RendererManager::AddRenderer(int _instanceID, int _meshInstanceID, bool _isDynamic)
@@ -26,12 +33,33 @@ int RendererManager::AddRenderer(int _instanceID, int _meshInstanceID, bool _isD
 
 	renderers.push_back(std::move(make_shared<Renderer>()));
 	id = (int)renderers.size() - 1;
-	renderers[id]->Init(_meshInstanceID, _isDynamic);
+	renderers[id]->Init(&rendererPool, _meshInstanceID, _isDynamic);
 	renderers[id]->SetInstanceID(_instanceID);
+	cullingBounds.Resize((int)renderers.size());
+	treeProxy.resize(renderers.size(), -1);
+	queueSortFrame.resize(renderers.size(), -1);
+	occluderFrame.resize(renderers.size(), -1);
+	batchMembership.resize(renderers.size());
+	rebatchFlag.resize(renderers.size(), 0);
+
+	// invisible until culling finds it in the scene tree
+	renderers[id]->SetVisible(false);
+	RequestRebatch(id);
 
 	return id;
 }
 
+void RendererManager::AddRendererLod(int _id, int _meshInstanceID, float _screenSize)
+{
+	if (_id < 0 || _id >= (int)renderers.size())
+	{
+		return;
+	}
+
+	renderers[_id]->AddLod(_meshInstanceID, _screenSize);
+	RequestRebatch(_id);
+}
+
 void RendererManager::AddCreatedMaterial(int _instanceID, Material *_mat)
 {
 	if (_instanceID < 0 || _instanceID >= (int)renderers.size())
@@ -40,126 +68,229 @@ void RendererManager::AddCreatedMaterial(int _instanceID, Material *_mat)
 	}
 
 	renderers[_instanceID]->AddMaterial(_mat);
+	RequestRebatch(_instanceID);
 }
 
 void RendererManager::InitInstanceRendering()
 {
-	// crate instance renderer & count capacity
-	for (auto &r : renderers)
+	// all meshes are uploaded at this point, fetch cpu geometry for occluders
+	GraphicManager::Instance().WaitForGPU();
+	MeshManager::Instance().ReadbackGeometry();
+
+	// batch every renderer added so far, later changes are rebatched before each sort
+	instanceBatchReady = true;
+	UpdateInstanceBatches();
+	instanceSorter.GetItems().reserve(instanceBatchList.size());
+}
+
+void RendererManager::RequestRebatch(int _id)
+{
+	if (rebatchFlag[_id] == 0)
+	{
+		rebatchFlag[_id] = 1;
+		rebatchList.push_back(_id);
+	}
+}
+
+void RendererManager::UpdateInstanceBatches()
+{
+	if (!instanceBatchReady || rebatchList.empty())
+	{
+		return;
+	}
+
+	for (int id : rebatchList)
 	{
+		rebatchFlag[id] = 0;
+
+		// a batch it joins again may still hold an older world of it in the old slot
+		rendererPool.MarkWorldDirty(id);
+
+		// leave old batches, then join batches of current materials, every lod mesh gets its own batch
+		for (int b : batchMembership[id])
+		{
+			instanceBatchList[b]->RemoveMember();
+		}
+		batchMembership[id].clear();
+
+		Renderer* r = renderers[id].get();
 		auto mats = r->GetMaterials();
-		for (int i = 0; i < r->GetNumMaterials(); i++)
+		for (int lod = 0; lod < r->GetLodCount(); lod++)
 		{
-			InstanceRenderer ir;
-			ir.cache = r.get();
-			ir.materialID = mats[i]->GetInstanceID();
-			ir.submeshIndex = i;
+			for (int i = 0; i < r->GetNumMaterials(); i++)
+			{
+				InstanceRenderer ir;
+				ir.cache = r;
+				ir.mesh = r->GetMesh(lod);
+				ir.materialID = mats[i]->GetInstanceID();
+				ir.submeshIndex = i;
 
-			int queue = mats[i]->GetRenderQueue();
-			int idx = FindInstanceRenderer(queue, ir);
+				int queue = mats[i]->GetRenderQueue();
+				int batch = FindInstanceRenderer(queue, ir);
 
-			if (idx == -1)
-			{
-				// init and add to list
-				instanceRenderers[queue].push_back(ir);
-				idx = (int)instanceRenderers[queue].size() - 1;
+				if (batch == -1)
+				{
+					batch = CreateInstanceBatch(queue, ir, mats[i]);
+				}
+
+				instanceBatchList[batch]->AddMember();
+				batchMembership[id].push_back(batch);
 			}
-			instanceRenderers[queue][idx].CountCapacity();
 		}
 	}
+	rebatchList.clear();
 
-	// actually create instance upload buffer
-	for (auto& r : instanceRenderers)
+	// resize buffers of all batches, unchanged ones return immediately
+	for (auto& ir : instanceBatchList)
 	{
-		for (auto& ir : r.second)
-		{
-			ir.CreateInstanceData();
-		}
+		ir->FitCapacity();
 	}
 }
 
-void RendererManager::AddToQueueRenderer(Renderer* _renderer, Camera *_camera)
+int RendererManager::CreateInstanceBatch(int _queue, InstanceRenderer& _ir, Material* _mat)
 {
-	XMFLOAT3 camPos = _camera->GetPosition();
-	auto mat = _renderer->GetMaterials();
+	int psoIndex = _mat->GetPsoData().psoIndexInPool;
+	int matIndex = MaterialManager::Instance().GetMatIndexFromID(_ir.materialID);
+	int meshIndex = MeshManager::Instance().GetMeshIndex(_ir.mesh->GetInstanceID());
+	CheckSortKeyField(_queue, SORT_QUEUE_BITS, L"queue");
+	CheckSortKeyField(psoIndex, SORT_PSO_BITS, L"pso");
+	CheckSortKeyField(matIndex, SORT_MATERIAL_BITS, L"material");
+	CheckSortKeyField(meshIndex, SORT_MESH_BITS, L"mesh");
 
-	// calc z distance to camera
-	auto bound = _renderer->GetWorldBound();
-	float minZ = bound.Center.z - bound.Extents.z;
-	float maxZ = bound.Center.z + bound.Extents.z;
-	float zDist = min(abs(minZ - camPos.z), abs(maxZ - camPos.z));
+	_ir.queue = _queue;
+	_ir.sortKeyBase = MakeOpaqueSortKeyBase(_queue, psoIndex, matIndex, meshIndex);
 
-	for (int i = 0; i < _renderer->GetNumMaterials(); i++)
+	// batch index only grows, so last sorted order and sort frames stay valid
+	instanceRenderers[_queue].push_back(_ir);
+	instanceBatchList.push_back(&instanceRenderers[_queue].back());
+	instanceSortFrame.push_back(-1);
+
+	int batch = (int)instanceBatchList.size() - 1;
+	instanceBatchIndex[GetInstanceBatchKey(_queue, _ir)] = batch;
+
+	return batch;
+}
+
+void RendererManager::CheckSortKeyField(int _value, int _bits, const wchar_t* _name)
+{
+	// clamped fields share one key value, draws stay in stable batch order but their state changes interleave
+	if (SortKeyFits(_value, _bits) || sortKeyOverflowLogged)
+	{
+		return;
+	}
+
+	LogMessage(L"[SqGraphic Error] SqRendererManager: sort key " + wstring(_name) + L" index " + to_wstring(_value)
+		+ L" doesn't fit " + to_wstring(_bits) + L" bits, draws above it won't be grouped.");
+	sortKeyOverflowLogged = true;
+}
+
+void RendererManager::AddToQueueRenderer(int _id)
+{
+	Renderer* renderer = renderers[_id].get();
+	auto mat = renderer->GetMaterials();
+
+	// transparent objects are sorted by view depth of bound center
+	float viewDepth = CalcViewDepth(rendererPool.GetWorldBound(_id), false);
+
+	for (int i = 0; i < renderer->GetNumMaterials(); i++)
 	{
 		// add transparent object to queue renderer only
-		if (_renderer->GetMaterial(i)->GetRenderQueue() <= RenderQueue::OpaqueLast)
+		if (mat[i]->GetRenderQueue() <= RenderQueue::OpaqueLast)
 		{
 			continue;
 		}
 
 		QueueRenderer qr;
-		qr.cache = _renderer;
+		qr.cache = renderer;
+		qr.rendererID = _id;
 		qr.submeshIndex = i;
-		qr.materialID = _renderer->GetMaterial(i)->GetInstanceID();
-
-		// get min z distance to camera
-		qr.zDistanceToCam = zDist;
+		qr.materialID = mat[i]->GetInstanceID();
+		qr.queue = mat[i]->GetRenderQueue();
+		qr.zDistanceToCam = viewDepth;
 		
-		queuedRenderers[mat[i]->GetRenderQueue()].push_back(qr);
+		queuedRenderers.push_back(qr);
 	}
+
+	queueSortFrame[_id] = sortFrame;
 }
 
-void RendererManager::AddToInstanceRenderer(Renderer* _renderer, Camera *_camera)
+void RendererManager::AddToInstanceRenderer(int _id, int _frameIdx)
 {
-	XMFLOAT3 camPos = _camera->GetPosition();
+	Renderer* _renderer = renderers[_id].get();
 	auto mats = _renderer->GetMaterials();
+	bool dirty = rendererPool.IsWorldDirty(_id, _frameIdx);
 
-	// calc z distance to camera
-	auto bound = _renderer->GetWorldBound();
-	float minZ = bound.Center.z - bound.Extents.z;
-	float maxZ = bound.Center.z + bound.Extents.z;
-	float zDist = min(abs(minZ - camPos.z), abs(maxZ - camPos.z));
+	// opaque objects are sorted by nearest view depth of bound
+	float viewDepth = CalcViewDepth(rendererPool.GetWorldBound(_id), true);
 
 	for (int i = 0; i < _renderer->GetNumMaterials(); i++)
 	{
 		InstanceRenderer ir;
 		ir.cache = _renderer;
+		ir.mesh = _renderer->GetMesh();
 		ir.materialID = mats[i]->GetInstanceID();
 		ir.submeshIndex = i;
 
 		int queue = mats[i]->GetRenderQueue();
-		int idx = FindInstanceRenderer(queue, ir);
+		int batch = FindInstanceRenderer(queue, ir);
 
-		if (idx != -1)
+		if (batch != -1)
 		{
-			// add instance data
-			SqInstanceData sid;
-			sid.world = _renderer->GetWorld();
-			sid.invWorld = _renderer->GetInvWorld();
-			instanceRenderers[queue][idx].AddInstanceData(sid, zDist);
+			// only id is collected, data is pulled from pool when the slot needs upload
+			instanceBatchList[batch]->AddInstance(_id, viewDepth, _frameIdx, dirty);
 		}
 	}
 }
 
-int RendererManager::FindInstanceRenderer(int _queue, InstanceRenderer _ir)
+float RendererManager::CalcViewDepth(const BoundingBox& _bound, bool _nearest)
 {
-	for (int i = 0; i < (int)instanceRenderers[_queue].size(); i++)
+	// depth along camera forward axis
+	float depth = (_bound.Center.x - sortCamPos.x) * sortCamDir.x
+		+ (_bound.Center.y - sortCamPos.y) * sortCamDir.y
+		+ (_bound.Center.z - sortCamPos.z) * sortCamDir.z;
+
+	if (_nearest)
 	{
-		if (_ir == instanceRenderers[_queue][i])
-		{
-			return i;
-		}
+		depth -= _bound.Extents.x * abs(sortCamDir.x) + _bound.Extents.y * abs(sortCamDir.y) + _bound.Extents.z * abs(sortCamDir.z);
 	}
 
-	return -1;
+	return depth;
 }
 
-void RendererManager::ClearQueueRenderer()
+bool RendererManager::IsCameraTeleport(XMFLOAT3 _pos, XMFLOAT3 _dir)
 {
-	for (auto& r : queuedRenderers)
+	XMVECTOR deltaPos = XMVectorSubtract(XMLoadFloat3(&_pos), XMLoadFloat3(&sortCamPos));
+	float sqrDist = XMVectorGetX(XMVector3LengthSq(deltaPos));
+	float cosAngle = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&_dir), XMLoadFloat3(&sortCamDir)));
+
+	return sqrDist > SORT_TELEPORT_DISTANCE * SORT_TELEPORT_DISTANCE || cosAngle < SORT_TELEPORT_COS;
+}
+
+int RendererManager::FindInstanceRenderer(int _queue, InstanceRenderer& _ir)
+{
+	auto it = instanceBatchIndex.find(GetInstanceBatchKey(_queue, _ir));
+	if (it == instanceBatchIndex.end())
 	{
-		r.second.clear();
+		return -1;
 	}
+
+	return it->second;
+}
+
+InstanceBatchKey RendererManager::GetInstanceBatchKey(int _queue, InstanceRenderer& _ir)
+{
+	InstanceBatchKey key;
+	key.meshID = _ir.mesh->GetInstanceID();
+	key.submeshIndex = _ir.submeshIndex;
+	key.materialID = _ir.materialID;
+	key.queue = _queue;
+
+	return key;
+}
+
+void RendererManager::ClearQueueRenderer()
+{
+	queuedRenderers.clear();
 }
 
 void RendererManager::ClearInstanceRendererData()
@@ -181,46 +312,7 @@ void RendererManager::UpdateLocalBound(int _id, float _x, float _y, float _z, fl
 	}
 
 	renderers[_id]->UpdateLocalBound(_x, _y, _z, _ex, _ey, _ez);
-}
-
-void RendererManager::UploadObjectConstant(int _frameIdx, int _threadIndex, int _numThreads)
-{
-	auto renderers = RendererManager::Instance().GetRenderers();
-
-	// split thread group
-	int count = (int)renderers.size() / _numThreads + 1;
-	int start = _threadIndex * count;
-
-	// update renderer constant
-	for (int i = start; i <= start + count; i++)
-	{
-		if (i >= (int)renderers.size())
-		{
-			continue;
-		}
-
-		auto r = renderers[i];
-		if (!r->GetVisible())
-		{
-			continue;
-		}
-
-		if (!r->IsDirty(_frameIdx))
-		{
-			continue;
-		}
-
-		Mesh* m = r->GetMesh();
-		if (m == nullptr)
-		{
-			continue;
-		}
-
-		ObjectConstant sc;
-		sc.sqMatrixWorld = r->GetWorld();
-		sc.sqMatrixInvWorld = r->GetInvWorld();
-		r->UpdateObjectConstant(sc, _frameIdx);
-	}
+	InvalidateStaticCulling(_id);
 }
 
 void RendererManager::UploadInstanceData(int _frameIdx, int _threadIndex, int _numThreads)
@@ -231,19 +323,26 @@ void RendererManager::UploadInstanceData(int _frameIdx, int _threadIndex, int _n
 		int count = (int)r.second.size() / _numThreads + 1;
 		int start = _threadIndex * count;
 
-		for (int i = start; i <= start + count; i++)
+		for (int i = start; i < start + count; i++)
 		{
 			if (i >= (int)r.second.size())
 			{
 				continue;
 			}
 
-			auto ir = r.second[i];
-			ir.UploadInstanceData(_frameIdx);
+			auto& ir = r.second[i];
+			int writeCount = ir.UploadInstanceData(_frameIdx, rendererPool);
+			GRAPHIC_STAT_ADD(StatUploadBytes, writeCount * sizeof(SqInstanceData))
 		}
 	}
 }
 
+void RendererManager::FinishUploadInstanceData(int _frameIdx)
+{
+	// uploaded renderers are clean for this frame's buffer, cost is O(dirty)
+	rendererPool.ClearWorldDirty(_frameIdx);
+}
+
 void RendererManager::SetWorldMatrix(int _id, XMFLOAT4X4 _world)
 {
 	if (_id < 0 || _id >= (int)renderers.size())
@@ -252,6 +351,77 @@ void RendererManager::SetWorldMatrix(int _id, XMFLOAT4X4 _world)
 	}
 
 	renderers[_id]->SetWorld(_world);
+	ApplyWorldBound(_id);
+}
+
+void RendererManager::SetWorldMatrices(const int* _ids, const XMFLOAT4X4* _worlds, int _count)
+{
+	transformBatch.Add(_ids, _worlds, _count);
+}
+
+void RendererManager::ReserveWorldMatrices(int _capacity, int** _ids, XMFLOAT4X4** _worlds)
+{
+	transformBatch.Reserve(_capacity, _ids, _worlds);
+}
+
+void RendererManager::CommitWorldMatrices(int _count)
+{
+	transformBatch.Commit(_count);
+}
+
+bool RendererManager::PrepareTransformUpdate()
+{
+	return transformBatch.Prepare((int)renderers.size());
+}
+
+void RendererManager::UpdateTransforms(int _threadIdx, int _numThreads)
+{
+	int start, end;
+	transformBatch.GetSlice(_threadIdx, _numThreads, start, end);
+
+	for (int i = start; i < end; i++)
+	{
+		if (transformBatch.IsApplied(i))
+		{
+			renderers[transformBatch.GetID(i)]->UpdateWorld(transformBatch.GetWorld(i));
+		}
+	}
+}
+
+void RendererManager::FinishTransformUpdate()
+{
+	// culling lanes and scene tree aren't thread safe, finish them here
+	for (int i = 0; i < transformBatch.GetCount(); i++)
+	{
+		if (!transformBatch.IsApplied(i))
+		{
+			continue;
+		}
+
+		int id = transformBatch.GetID(i);
+		rendererPool.MarkWorldDirty(id);
+		ApplyWorldBound(id);
+	}
+
+	transformBatch.Clear();
+}
+
+void RendererManager::ApplyWorldBound(int _id)
+{
+	const BoundingBox& bound = rendererPool.GetWorldBound(_id);
+	cullingBounds.SetBound(_id, bound);
+
+	// renderer joins the scene tree when it gets the first world matrix
+	AabbTree& tree = sceneTree[rendererPool.IsDynamic(_id) ? 1 : 0];
+	if (treeProxy[_id] == AabbTree::NULL_NODE)
+	{
+		treeProxy[_id] = tree.CreateProxy(bound, _id);
+	}
+	else
+	{
+		tree.MoveProxy(treeProxy[_id], bound);
+	}
+	InvalidateStaticCulling(_id);
 }
 
 void RendererManager::Release()
@@ -262,11 +432,6 @@ void RendererManager::Release()
 		r.reset();
 	}
 
-	for (auto& r : queuedRenderers)
-	{
-		r.second.clear();
-	}
-
 	for (auto& r : instanceRenderers)
 	{
 		for (auto& ir : r.second)
@@ -278,6 +443,46 @@ void RendererManager::Release()
 	renderers.clear();
 	queuedRenderers.clear();
 	instanceRenderers.clear();
+	instanceBatchList.clear();
+	instanceSorter.GetItems().clear();
+	queueSorter.GetItems().clear();
+	instanceSortFrame.clear();
+	queueSortFrame.clear();
+	lastInstanceOrder.clear();
+	lastSortedQueue.clear();
+	instanceBatchIndex.clear();
+	batchMembership.clear();
+	rebatchList.clear();
+	rebatchFlag.clear();
+	instanceBatchReady = false;
+	instanceDrawStream.Clear();
+	queueDrawStream.Clear();
+	instanceDrawCost.clear();
+	instanceDrawBounds.clear();
+	cullingBounds.Release();
+	rendererPool.Release();
+	transformBatch.Release();
+
+	for (int i = 0; i < 2; i++)
+	{
+		sceneTree[i].Release();
+	}
+
+	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
+	{
+		visibleList[i].clear();
+		intersectList[i].clear();
+		lodChangedList[i].clear();
+	}
+
+	treeProxy.clear();
+	subtreeRoots.clear();
+	cullingRoots.clear();
+	staticCullingCache.clear();
+	currStaticCache = nullptr;
+	occlusionBuffer.Release();
+	occluderCandidates.clear();
+	occluderFrame.clear();
 }
 
 void RendererManager::SetNativeRendererActive(int _id, bool _active)
@@ -287,103 +492,536 @@ void RendererManager::SetNativeRendererActive(int _id, bool _active)
 		return;
 	}
 	renderers[_id]->SetActive(_active);
+	InvalidateStaticCulling(_id);
 }
 
-void RendererManager::SortWork(Camera* _camera)
+void RendererManager::SortWork(Camera* _camera, int _frameIdx)
 {
+	// lod changes found by culling workers move renderers between batches, mark them here on one thread
+	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
+	{
+		for (int id : lodChangedList[i])
+		{
+			rendererPool.MarkWorldDirty(id);
+		}
+		lodChangedList[i].clear();
+	}
+
+	UpdateInstanceBatches();
 	ClearQueueRenderer();
 	ClearInstanceRendererData();
+	sortFrame++;
 
-	for (int i = 0; i < (int)renderers.size(); i++)
+	// last frame's order is only a good guess if camera didn't jump
+	XMFLOAT3 camPos = _camera->GetPosition();
+	XMFLOAT3 camDir = _camera->GetDirection();
+	useIncrementalSort = !IsCameraTeleport(camPos, camDir);
+	sortCamPos = camPos;
+	sortCamDir = camDir;
+
+	// queue renderers still visible are added in last sorted order, so the list is nearly sorted
+	for (auto& qr : lastSortedQueue)
+	{
+		if (qr.rendererID < rendererPool.GetCount() && queueSortFrame[qr.rendererID] != sortFrame && rendererPool.IsVisible(qr.rendererID))
+		{
+			AddToQueueRenderer(qr.rendererID);
+		}
+	}
+
+	for (int i = 0; i < rendererPool.GetCount(); i++)
 	{
-		if (renderers[i]->GetVisible())
+		if (rendererPool.IsVisible(i))
 		{
-			AddToQueueRenderer(renderers[i].get(), _camera);
-			AddToInstanceRenderer(renderers[i].get(), _camera);
+			if (queueSortFrame[i] != sortFrame)
+			{
+				AddToQueueRenderer(i);
+			}
+			AddToInstanceRenderer(i, _frameIdx);
 		}
 	}
 
-	// sort queue renderers
-	for (auto& qr : queuedRenderers)
+	// build sort keys, the actual sort is split to worker threads by render path
+	auto& instanceItems = instanceSorter.GetItems();
+	instanceItems.clear();
+
+	// batches in last sorted order first, then batches that were empty last frame
+	for (auto& i : lastInstanceOrder)
+	{
+		AddInstanceSortItem(i);
+	}
+
+	for (int i = 0; i < (int)instanceBatchList.size(); i++)
+	{
+		AddInstanceSortItem(i);
+	}
+
+	auto& queueItems = queueSorter.GetItems();
+	queueItems.clear();
+	for (int i = 0; i < (int)queuedRenderers.size(); i++)
+	{
+		const QueueRenderer& qr = queuedRenderers[i];
+
+		// material only breaks depth ties here, overflow is reported once and never affects back to front order
+		int matIndex = MaterialManager::Instance().GetMatIndexFromID(qr.materialID);
+		CheckSortKeyField(matIndex, SORT_MATERIAL_BITS, L"material");
+
+		SortItem item;
+		item.key = MakeTransparentSortKey(qr.queue, matIndex, qr.zDistanceToCam);
+		item.index = i;
+		queueItems.push_back(item);
+	}
+}
+
+void RendererManager::AddInstanceSortItem(int _batchIndex)
+{
+	InstanceRenderer* ir = instanceBatchList[_batchIndex];
+	if (ir->GetInstanceCount() == 0 || instanceSortFrame[_batchIndex] == sortFrame)
+	{
+		return;
+	}
+
+	ir->FinishCollectInstance();
+	instanceSortFrame[_batchIndex] = sortFrame;
+
+	SortItem item;
+	item.key = MakeOpaqueSortKey(ir->sortKeyBase, ir->zDistToCamTotal);
+	item.index = _batchIndex;
+	instanceSorter.GetItems().push_back(item);
+}
+
+void RendererManager::FinishSortWork()
+{
+	// keep sorted order as the starting guess of next frame
+	lastInstanceOrder.clear();
+	for (auto& item : instanceSorter.GetItems())
+	{
+		lastInstanceOrder.push_back(item.index);
+	}
+
+	lastSortedQueue.clear();
+	for (auto& item : queueSorter.GetItems())
+	{
+		lastSortedQueue.push_back(queuedRenderers[item.index]);
+	}
+}
+
+bool RendererManager::UseIncrementalSort()
+{
+	return useIncrementalSort;
+}
+
+void RendererManager::PrepareCulling(Camera* _camera)
+{
+	cullingBounds.SetFrustum(_camera->GetFrustum());
+
+	// only renderers visible last frame need to be reset
+	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
 	{
-		if (qr.first > RenderQueue::OpaqueLast)
+		for (auto& id : visibleList[i])
 		{
-			// sort back-to-front for transparent obj
-			sort(qr.second.begin(), qr.second.end(), BackToFrontRender);
+			rendererPool.SetVisible(id, false);
 		}
+		visibleList[i].clear();
 	}
 
-	// sort instance renderers
-	for (auto& ir : instanceRenderers)
+	// projection scale of y axis is cot(fov / 2), sign depends on platform
+	XMFLOAT4X4 proj = _camera->GetProj();
+	cullingCamPos = _camera->GetPosition();
+	screenSizeScale = fabsf(proj._22);
+	screenHeight = _camera->GetViewPort().Height;
+
+	int numWorkerThreads = GraphicManager::Instance().GetThreadCount() - 1;
+	currStaticCache = &staticCullingCache[_camera->GetCameraData()->instanceID];
+	staticCullingState = GetStaticCullingState(_camera, *currStaticCache, numWorkerThreads);
+
+	// split scene trees into subtrees for worker threads, static tree is only traversed when cache is rebuilt
+	cullingRoots.clear();
+
+	for (int i = 0; i < 2; i++)
 	{
-		for (auto& iir : ir.second)
+		if (i == 0 && staticCullingState != StaticCullingState::Rebuild)
 		{
-			iir.FinishCollectInstance();
+			continue;
 		}
 
-		if (ir.first <= RenderQueue::OpaqueLast)
+		sceneTree[i].GetSubtreeRoots(numWorkerThreads * SUBTREE_PER_THREAD, subtreeRoots);
+		for (auto& n : subtreeRoots)
 		{
-			// sort from front to back for instance group
-			sort(ir.second.begin(), ir.second.end(), FrontToBackInstance);
+			CullingRoot cr;
+			cr.tree = i;
+			cr.node = n;
+			cullingRoots.push_back(cr);
 		}
 	}
 }
 
+StaticCullingState RendererManager::GetStaticCullingState(Camera* _camera, StaticCullingCache& _cache, int _numThreads)
+{
+	XMFLOAT3 corners[BoundingFrustum::CORNER_COUNT];
+	_camera->GetFrustum().GetCorners(corners);
+
+	float margin = _camera->GetFarZ() * STATIC_CULLING_MARGIN_RATIO;
+	return UpdateStaticCulling(_cache, cullingBounds.GetPlanes(), corners, margin, staticCullingVersion, _numThreads);
+}
+
+void RendererManager::InvalidateStaticCulling(int _id)
+{
+	if (!rendererPool.IsDynamic(_id))
+	{
+		staticCullingVersion++;
+	}
+}
+
 void RendererManager::FrustumCulling(Camera* _camera, int _threadIdx)
 {
 	auto numWorkerThreads = GraphicManager::Instance().GetThreadCount() - 1;
-	int count = (int)renderers.size() / numWorkerThreads + 1;
-	int start = _threadIdx * count;
+	vector<int>& visible = visibleList[_threadIdx];
+	vector<int>& intersect = intersectList[_threadIdx];
+	vector<int>& staticCandidates = currStaticCache->candidates[_threadIdx];
+	vector<int>& staticVisible = currStaticCache->visible[_threadIdx];
+	intersect.clear();
+
+	// subtrees are interleaved between threads, each renderer is a leaf of exactly one subtree
+	for (int i = _threadIdx; i < (int)cullingRoots.size(); i += numWorkerThreads)
+	{
+		const CullingRoot& cr = cullingRoots[i];
+		if (cr.tree == 0)
+		{
+			// every static leaf touching the expanded frustum becomes a candidate
+			sceneTree[0].QueryFrustum(cr.node, currStaticCache->planes, cullingBounds.GetPlaneCount(), staticCandidates, staticCandidates);
+		}
+		else
+		{
+			sceneTree[cr.tree].QueryFrustum(cr.node, cullingBounds.GetPlanes(), cullingBounds.GetPlaneCount(), visible, intersect);
+		}
+	}
+
+	// leaves inside frustum are visible without further test
+	for (auto& id : visible)
+	{
+		rendererPool.SetVisible(id, true);
+	}
+
+	TestIntersectBounds(_camera, intersect, visible);
+
+	// static candidates are tested again only if the frustum moved
+	if (staticCullingState != StaticCullingState::Reuse)
+	{
+		staticVisible.clear();
+		TestIntersectBounds(_camera, staticCandidates, staticVisible);
+	}
+	else
+	{
+		for (auto& id : staticVisible)
+		{
+			rendererPool.SetVisible(id, true);
+		}
+	}
+
+	visible.insert(visible.end(), staticVisible.begin(), staticVisible.end());
+
+	// ids culled here stay in visible list, they are reset next frame anyway
+	EvaluateScreenSize(visible, _threadIdx);
+}
 
-	for (int i = start; i <= start + count; i++)
+void RendererManager::EvaluateScreenSize(const vector<int>& _list, int _threadIdx)
+{
+	for (auto& id : _list)
 	{
-		if (i >= (int)renderers.size())
+		if (!rendererPool.IsVisible(id))
+		{
+			continue;
+		}
+
+		const BoundingBox& bound = rendererPool.GetWorldBound(id);
+		float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bound.Extents)));
+		float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&bound.Center), XMLoadFloat3(&cullingCamPos))));
+
+		// camera inside bound sphere counts as full screen
+		float screenSize = radius * screenSizeScale / max(dist, radius);
+		if (screenSize * screenHeight < screenSizeCullingPixels)
 		{
+			rendererPool.SetVisible(id, false);
 			continue;
 		}
 
-		bool isVisible = _camera->FrustumTest(renderers[i]->GetWorldBound());
-		renderers[i]->SetVisible(isVisible);
+		// lod change moves renderer to another batch, so membership of its slots changed,
+		// SortWork marks it world dirty, so every batch rewrites the slot it gets for this renderer
+		Renderer* r = renderers[id].get();
+		if (r->GetLodCount() > 1 && r->UpdateLod(screenSize))
+		{
+			lodChangedList[_threadIdx].push_back(id);
+		}
+	}
+}
+
+void RendererManager::TestIntersectBounds(Camera* _camera, const vector<int>& _list, vector<int>& _visible)
+{
+	// test tight bounds 4 at a time
+	for (int i = 0; i < (int)_list.size(); i += SimdCulling::LANE_COUNT)
+	{
+		int laneCount = (int)_list.size() - i;
+		if (laneCount > SimdCulling::LANE_COUNT)
+		{
+			laneCount = SimdCulling::LANE_COUNT;
+		}
+
+		int visibleMask, ambiguousMask;
+		cullingBounds.TestIndices(&_list[i], laneCount, visibleMask, ambiguousMask);
+
+		for (int lane = 0; lane < laneCount; lane++)
+		{
+			int id = _list[i + lane];
+
+			// within rounding distance of a plane, fall back to the exact scalar test
+			bool isVisible = (visibleMask & (1 << lane)) != 0;
+			if (!isVisible && (ambiguousMask & (1 << lane)))
+			{
+				isVisible = _camera->FrustumTest(rendererPool.GetWorldBound(id));
+			}
+
+			if (isVisible)
+			{
+				rendererPool.SetVisible(id, true);
+				_visible.push_back(id);
+			}
+		}
 	}
 }
 
-bool RendererManager::ValidRenderer(int _index, vector<QueueRenderer>& _renderers)
+bool RendererManager::PrepareOcclusion(Camera* _camera)
 {
-	if (_index >= (int)_renderers.size())
+	if (!enableOcclusion)
 	{
 		return false;
 	}
 
-	auto const r = _renderers[_index];
-	if (!r.cache->GetVisible())
+	occlusionFrame++;
+
+	// rank frustum visible renderers by screen size
+	XMFLOAT3 camPos = _camera->GetPosition();
+	occluderCandidates.clear();
+
+	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
+	{
+		for (auto& id : visibleList[i])
+		{
+			const BoundingBox& bound = rendererPool.GetWorldBound(id);
+			float sqrRadius = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&bound.Extents)));
+			float sqrDist = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&bound.Center), XMLoadFloat3(&camPos))));
+			float screenSize = sqrRadius / max(sqrDist, 1e-4f);
+
+			if (screenSize >= OCCLUDER_MIN_SCREEN_SIZE)
+			{
+				occluderCandidates.push_back(make_pair(screenSize, id));
+			}
+		}
+	}
+
+	if (occluderCandidates.size() == 0)
 	{
 		return false;
 	}
 
-	Mesh* m = r.cache->GetMesh();
-	if (m == nullptr)
+	sort(occluderCandidates.begin(), occluderCandidates.end(), greater<pair<float, int>>());
+
+	XMFLOAT4X4 view = _camera->GetView();
+	XMFLOAT4X4 proj = _camera->GetProj();
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&proj)));
+	occlusionBuffer.BeginFrame(viewProj, _camera->GetNearZ());
+
+	int occluderCount = 0;
+	int triangleCount = 0;
+	for (auto& c : occluderCandidates)
+	{
+		if (occluderCount >= MAX_OCCLUDER_COUNT || triangleCount >= OCCLUDER_TRIANGLE_BUDGET)
+		{
+			break;
+		}
+
+		Renderer* r = renderers[c.second].get();
+		Mesh* m = r->GetMesh();
+		if (m == nullptr)
+		{
+			continue;
+		}
+
+		const vector<XMFLOAT3>& positions = m->GetCpuPositions();
+		const vector<unsigned int>& indices = m->GetCpuIndices();
+		auto mats = r->GetMaterials();
+		int rasterized = 0;
+
+		for (int i = 0; i < r->GetNumMaterials(); i++)
+		{
+			// cutoff and transparent surfaces have holes
+			if (mats[i]->GetRenderQueue() >= RenderQueue::CutoffStart)
+			{
+				continue;
+			}
+
+			SubMesh sm = m->GetSubMesh(i);
+			if (sm.IndexCountPerInstance == 0 || sm.StartIndexLocation + sm.IndexCountPerInstance > indices.size())
+			{
+				continue;
+			}
+
+			rasterized += occlusionBuffer.RasterizeTriangles(positions.data(), (int)positions.size(), &indices[sm.StartIndexLocation]
+				, sm.IndexCountPerInstance, sm.BaseVertexLocation, r->GetWorld());
+		}
+
+		if (rasterized > 0)
+		{
+			// occluders are never tested against themselves
+			occluderFrame[c.second] = occlusionFrame;
+			occluderCount++;
+			triangleCount += rasterized;
+		}
+	}
+
+	if (occluderCount == 0)
 	{
 		return false;
 	}
 
+	occlusionBuffer.BuildHiZ();
 	return true;
 }
 
-bool RendererManager::ValidRenderer(int _index, vector<InstanceRenderer>& _renderers)
+void RendererManager::OcclusionCulling(int _threadIdx)
 {
-	if (_index >= (int)_renderers.size())
+	// ids stay in visible list, so visibility is still reset next frame
+	for (auto& id : visibleList[_threadIdx])
 	{
-		return false;
+		if (occluderFrame[id] == occlusionFrame)
+		{
+			continue;
+		}
+
+		if (occlusionBuffer.IsOccluded(rendererPool.GetWorldBound(id)))
+		{
+			rendererPool.SetVisible(id, false);
+		}
+	}
+}
+
+void RendererManager::SetSoftwareOcclusion(bool _enable)
+{
+	enableOcclusion = _enable;
+}
+
+void RendererManager::SetScreenSizeCulling(float _pixels)
+{
+	screenSizeCullingPixels = _pixels;
+}
+
+void RendererManager::CompileDrawPackets(int _frameIdx, int _numParts, int _numTransparentParts)
+{
+	UploadRingBuffer* constantRing = GraphicManager::Instance().GetConstantRing();
+	instanceDrawStream.Clear();
+	queueDrawStream.Clear();
+
+	// instanced shaders read world from instance data, they share one dummy object constant
+	ObjectConstant identity;
+	XMStoreFloat4x4(&identity.sqMatrixWorld, XMMatrixIdentity());
+	identity.sqMatrixInvWorld = identity.sqMatrixWorld;
+	D3D12_GPU_VIRTUAL_ADDRESS instanceObjectConstant = constantRing->AllocateConstant(&identity, sizeof(ObjectConstant));
+
+	// packets follow sorted order, the stream opens a range whenever the queue changes
+	for (auto& item : instanceSorter.GetItems())
+	{
+		InstanceRenderer* ir = instanceBatchList[item.index];
+		AddDrawPacket(instanceDrawStream, ir->cache, ir->mesh, ir->submeshIndex, ir->queue, ir->GetInstanceCount(), ir->GetInstanceDataGPU(_frameIdx), instanceObjectConstant);
+	}
+
+	// split instance ranges by estimated cost, each recording thread takes one part
+	const vector<DrawPacket>& instancePackets = instanceDrawStream.GetPackets();
+	instanceDrawCost.resize(instancePackets.size() + 1);
+	instanceDrawCost[0] = 0.0;
+	for (int i = 0; i < (int)instancePackets.size(); i++)
+	{
+		const DrawPacket& dp = instancePackets[i];
+		bool stateChange = (i == 0) || (dp.material != instancePackets[i - 1].material);
+		instanceDrawCost[i + 1] = instanceDrawCost[i] + EstimateDrawCost(dp.indexCount, dp.instanceCount, stateChange);
 	}
 
-	auto const r = _renderers[_index];
-	Mesh* m = r.cache->GetMesh();
+	_numParts = max(_numParts, 1);
+	vector<DrawPacketRange>& instanceRanges = instanceDrawStream.GetRanges();
+	instanceDrawBounds.resize(instanceRanges.size() * (_numParts + 1));
+	for (int i = 0; i < (int)instanceRanges.size(); i++)
+	{
+		DrawPacketRange& r = instanceRanges[i];
+		r.partStart = i * (_numParts + 1);
+		PartitionByCost(instanceDrawCost, r.start, r.start + r.count, _numParts, &instanceDrawBounds[r.partStart]);
+	}
+
+	// queue renderers are drawn one by one
+	for (auto& item : queueSorter.GetItems())
+	{
+		const QueueRenderer& qr = queuedRenderers[item.index];
+
+		// queue renderers read world from object constant, written to ring every frame they are drawn
+		ObjectConstant oc;
+		oc.sqMatrixWorld = rendererPool.GetWorld(qr.rendererID);
+		oc.sqMatrixInvWorld = rendererPool.GetInvWorld(qr.rendererID);
+		D3D12_GPU_VIRTUAL_ADDRESS objectConstant = constantRing->AllocateConstant(&oc, sizeof(ObjectConstant));
+		if (objectConstant == 0)
+		{
+			continue;
+		}
+
+		AddDrawPacket(queueDrawStream, qr.cache, qr.cache->GetMesh(), qr.submeshIndex, qr.queue, 1, 0, objectConstant);
+	}
+
+	// queues are sorted ascending, so transparent packets are one contiguous back-to-front run at the end
+	const vector<DrawPacket>& queuePackets = queueDrawStream.GetPackets();
+	int transparentStart = (int)queuePackets.size();
+	for (auto const& r : queueDrawStream.GetRanges())
+	{
+		if (r.queue > RenderQueue::OpaqueLast)
+		{
+			transparentStart = r.start;
+			break;
+		}
+	}
+
+	queueDrawCost.resize(queuePackets.size() + 1);
+	queueDrawCost[0] = 0.0;
+	for (int i = 0; i < (int)queuePackets.size(); i++)
+	{
+		const DrawPacket& dp = queuePackets[i];
+		bool stateChange = (i == 0) || (dp.material != queuePackets[i - 1].material);
+		queueDrawCost[i + 1] = queueDrawCost[i] + EstimateDrawCost(dp.indexCount, dp.instanceCount, stateChange);
+	}
+
+	// parts are recorded in parallel and submitted in part order, which keeps exact blending order
+	_numTransparentParts = max(_numTransparentParts, 1);
+	transparentDrawBounds.resize(_numTransparentParts + 1);
+	PartitionByCost(queueDrawCost, transparentStart, (int)queuePackets.size(), _numTransparentParts, &transparentDrawBounds[0]);
+}
+
+void RendererManager::AddDrawPacket(DrawPacketStream& _stream, Renderer* _renderer, Mesh* _mesh, int _submeshIndex, int _queue, int _instanceCount, D3D12_GPU_VIRTUAL_ADDRESS _instanceData, D3D12_GPU_VIRTUAL_ADDRESS _objectConstant)
+{
+	Mesh* m = _mesh;
 	if (m == nullptr)
 	{
-		return false;
+		return;
 	}
 
-	return true;
+	DrawPacket dp;
+	dp.vbv = m->GetVertexBufferView();
+	dp.ibv = m->GetIndexBufferView();
+	SubMesh sm = m->GetSubMesh(_submeshIndex);
+	dp.indexCount = sm.IndexCountPerInstance;
+	dp.startIndex = sm.StartIndexLocation;
+	dp.baseVertex = sm.BaseVertexLocation;
+	dp.material = _renderer->GetMaterial(_submeshIndex);
+	dp.instanceData = _instanceData;
+	dp.objectConstant = _objectConstant;
+	dp.instanceCount = _instanceCount;
+	dp.queue = _queue;
+
+	_stream.Add(dp);
 }
 
 vector<shared_ptr<Renderer>>& RendererManager::GetRenderers()
@@ -391,12 +1029,67 @@ vector<shared_ptr<Renderer>>& RendererManager::GetRenderers()
 	return renderers;
 }
 
-map<int, vector<QueueRenderer>>& RendererManager::GetQueueRenderers()
+const RendererPool& RendererManager::GetRendererPool() const
+{
+	return rendererPool;
+}
+
+vector<QueueRenderer>& RendererManager::GetQueueRenderers()
 {
 	return queuedRenderers;
 }
 
-map<int, vector<InstanceRenderer>>& RendererManager::GetInstanceRenderers()
+map<int, deque<InstanceRenderer>>& RendererManager::GetInstanceRenderers()
 {
 	return instanceRenderers;
 }
+
+const vector<DrawPacket>& RendererManager::GetInstanceDrawPackets() const
+{
+	return instanceDrawStream.GetPackets();
+}
+
+const vector<DrawPacketRange>& RendererManager::GetInstanceDrawRanges() const
+{
+	return instanceDrawStream.GetRanges();
+}
+
+const vector<int>& RendererManager::GetInstanceDrawBounds() const
+{
+	return instanceDrawBounds;
+}
+
+const vector<DrawPacket>& RendererManager::GetQueueDrawPackets() const
+{
+	return queueDrawStream.GetPackets();
+}
+
+const vector<DrawPacketRange>& RendererManager::GetQueueDrawRanges() const
+{
+	return queueDrawStream.GetRanges();
+}
+
+const vector<int>& RendererManager::GetTransparentDrawBounds() const
+{
+	return transparentDrawBounds;
+}
+
+RadixSorter& RendererManager::GetInstanceSorter()
+{
+	return instanceSorter;
+}
+
+int RendererManager::GetPendingTransformCount() const
+{
+	return transformBatch.GetCount();
+}
+
+int RendererManager::GetInstanceBatchCount() const
+{
+	return (int)instanceBatchList.size();
+}
+
+RadixSorter& RendererManager::GetQueueSorter()
+{
+	return queueSorter;
+}
@@ -4,20 +4,37 @@
 #include "Light.h"
 using namespace std;
 #include <map>
+#include <deque>
+#include <unordered_map>
+#include <cstring>
 #include "UploadBuffer.h"
 #include "GraphicManager.h"
+#include "SimdCulling.h"
+#include "AabbTree.h"
+#include "SortUtility.h"
+#include "SoftwareOcclusion.h"
+#include "AffineMath.h"
+#include "DrawPartition.h"
+#include "InstanceSlotTable.h"
+#include "DrawPacket.h"
+#include "StaticCulling.h"
+#include "TransformBatch.h"
+#include "InstanceBatchKey.h"
+#include "SortKey.h"
 
 struct SqInstanceData
 {
-	XMFLOAT4X4 world;
-	XMFLOAT4X4 invWorld;
+	// packed by AffinePack3x4, normal matrix is derived in shader
+	XMFLOAT4 world[3];
 };
 
 struct QueueRenderer
 {
 	Renderer* cache;
+	int rendererID;
 	int submeshIndex;
 	int materialID;
+	int queue;
 	float zDistanceToCam;
 };
 
@@ -27,7 +44,7 @@ public:
 	bool operator==(InstanceRenderer& _in)
 	{
 		// instance rendering needs the same mesh and material
-		return _in.cache->GetMesh()->GetInstanceID() == cache->GetMesh()->GetInstanceID()
+		return _in.mesh->GetInstanceID() == mesh->GetInstanceID()
 			&& _in.submeshIndex == submeshIndex
 			&& _in.materialID == materialID;
 	}
@@ -35,60 +52,105 @@ public:
 	InstanceRenderer()
 	{
 		cache = nullptr;
+		mesh = nullptr;
 		submeshIndex = -1;
 		materialID = -1;
-		maxCapacity = 0;
+		queue = -1;
+		sortKeyBase = 0;
+		memberCount = 0;
+		bufferCapacity = 0;
 	}
 
-	void CreateInstanceData()
+	void FitCapacity()
 	{
+		int capacity = FitInstanceCapacity(bufferCapacity, memberCount);
+		if (capacity == bufferCapacity)
+		{
+			return;
+		}
+
+		// gpu may still read old buffers of in-flight frames, new buffers start with unknown slots
 		for (int i = 0; i < MAX_FRAME_COUNT; i++)
 		{
-			instanceDataGPU[i] = make_shared<UploadBuffer<SqInstanceData>>(GraphicManager::Instance().GetDevice(), maxCapacity, false);
+			if (instanceDataGPU[i])
+			{
+				GraphicManager::Instance().DeferRelease(instanceDataGPU[i]);
+			}
+			instanceDataGPU[i] = make_shared<UploadBuffer<SqInstanceData>>(GraphicManager::Instance().GetDevice(), capacity, false);
+			slotTable[i].Reset(capacity);
 		}
+		bufferCapacity = capacity;
 	}
 
 	void Release()
 	{
-		instanceDataCPU.clear();
+		instanceIDs.clear();
+		writeSlots.clear();
 		for (int i = 0; i < MAX_FRAME_COUNT; i++)
 		{
 			instanceDataGPU[i].reset();
+			slotTable[i].Release();
 		}
+		memberCount = 0;
+		bufferCapacity = 0;
 	}
 
-	void AddInstanceData(SqInstanceData _data, float _zDist)
+	void AddInstance(int _id, float _zDist, int _frameIdx, bool _dirty)
 	{
-		instanceDataCPU.push_back(_data);
+		// slots are picked while collecting, upload only visits the ones that changed
+		int slot = (int)instanceIDs.size();
+		instanceIDs.push_back(_id);
 		zDistToCamTotal += _zDist;
+
+		if (slot < bufferCapacity && slotTable[_frameIdx].NeedsWrite(slot, _id, _dirty))
+		{
+			writeSlots.push_back(slot);
+		}
 	}
 
 	void FinishCollectInstance()
 	{
-		if ((int)instanceDataCPU.size() == 0)
+		if ((int)instanceIDs.size() == 0)
 		{
 			return;
 		}
-		zDistToCamTotal = zDistToCamTotal / (int)instanceDataCPU.size();
+		zDistToCamTotal = zDistToCamTotal / (int)instanceIDs.size();
 	}
 
 	void ClearInstanceData()
 	{
-		instanceDataCPU.clear();
+		instanceIDs.clear();
+		writeSlots.clear();
 		zDistToCamTotal = 0;
 	}
 
 	int GetInstanceCount()
 	{
-		return (int)instanceDataCPU.size();
+		return (int)instanceIDs.size();
 	}
 
-	void UploadInstanceData(int _frameIdx)
+	int UploadInstanceData(int _frameIdx, const RendererPool& _pool)
 	{
-		for (int i = 0; i < (int)instanceDataCPU.size() && i < maxCapacity; i++)
+		// cost is O(changed slots), version check skips slots that already hold current world
+		// returns number of slots written
+		InstanceSlotTable& table = slotTable[_frameIdx];
+		int writeCount = 0;
+
+		for (int slot : writeSlots)
 		{
-			instanceDataGPU[_frameIdx]->CopyData(i, instanceDataCPU[i]);
+			int id = instanceIDs[slot];
+			if (!table.Claim(slot, id, _pool.GetWorldVersion(id)))
+			{
+				continue;
+			}
+
+			SqInstanceData sid;
+			AffinePack3x4(_pool.GetWorld(id), sid.world);
+			instanceDataGPU[_frameIdx]->CopyData(slot, sid);
+			writeCount++;
 		}
+
+		return writeCount;
 	}
 
 	D3D12_GPU_VIRTUAL_ADDRESS GetInstanceDataGPU(int _frameIdx)
@@ -96,44 +158,48 @@ public:
 		return instanceDataGPU[_frameIdx]->Resource()->GetGPUVirtualAddress();
 	}
 
-	void CountCapacity()
+	void AddMember()
 	{
-		maxCapacity++;
+		memberCount++;
+	}
+
+	void RemoveMember()
+	{
+		memberCount--;
 	}
 
 	Renderer* cache;
+	Mesh* mesh;
 	int submeshIndex;
 	int materialID;
+	int queue;
 	float zDistToCamTotal;
 
+	// queue/pso/material/mesh part of sort key, these don't change after init
+	uint64_t sortKeyBase;
+
 private:
-	int maxCapacity;
-	vector<SqInstanceData> instanceDataCPU;
+	// renderers that can be drawn by this batch, buffer capacity follows it with FitCapacity
+	int memberCount;
+	int bufferCapacity;
+	vector<int> instanceIDs;
 	shared_ptr<UploadBuffer<SqInstanceData>> instanceDataGPU[MAX_FRAME_COUNT];
-};
 
-inline bool FrontToBackRender(QueueRenderer const& i, QueueRenderer const& j)
-{
-	// sort from low distance to high distance (front to back)
-	return i.zDistanceToCam < j.zDistanceToCam;
-}
+	// slots of this frame that changed owner or whose renderer is world dirty
+	vector<int> writeSlots;
 
-inline bool BackToFrontRender(QueueRenderer const& i, QueueRenderer const& j)
-{
-	// sort from high distance to low distance (back to front)
-	return i.zDistanceToCam > j.zDistanceToCam;
-}
+	// renderer id and world version last written to each slot of instanceDataGPU
+	InstanceSlotTable slotTable[MAX_FRAME_COUNT];
+};
 
-inline bool MaterialIdSort(InstanceRenderer const& i, InstanceRenderer const& j)
+struct CullingRoot
 {
-	return i.materialID < j.materialID;
-}
+	int tree;
+	int node;
+};
 
-inline bool FrontToBackInstance(InstanceRenderer const& i, InstanceRenderer const& j)
-{
-	// sort from low distance to high distance (front to back)
-	return i.zDistToCamTotal < j.zDistToCamTotal;
-}
+// squared (bound radius / distance), smaller renderers aren't worth rasterizing as occluders
+const static float OCCLUDER_MIN_SCREEN_SIZE = 0.01f;
 
 class RendererManager
 {
@@ -154,36 +220,153 @@ public:
 
 	void Init();
 	int AddRenderer(int _instanceID, int _meshInstanceID, bool _isDynamic);
+	void AddRendererLod(int _id, int _meshInstanceID, float _screenSize);
 	void AddCreatedMaterial(int _instanceID, Material *_mat);
 	void InitInstanceRendering();
 	void UpdateLocalBound(int _id, float _x, float _y, float _z, float _ex, float _ey, float _ez);
-	void UploadObjectConstant(int _frameIdx, int _threadIndex, int _numThreads);
 	void UploadInstanceData(int _frameIdx, int _threadIndex, int _numThreads);
+	void FinishUploadInstanceData(int _frameIdx);
 	void SetWorldMatrix(int _id, XMFLOAT4X4 _world);
+	void SetWorldMatrices(const int* _ids, const XMFLOAT4X4* _worlds, int _count);
+	void ReserveWorldMatrices(int _capacity, int** _ids, XMFLOAT4X4** _worlds);
+	void CommitWorldMatrices(int _count);
+	bool PrepareTransformUpdate();
+	void UpdateTransforms(int _threadIdx, int _numThreads);
+	void FinishTransformUpdate();
 	void Release();
 	void SetNativeRendererActive(int _id, bool _active);
-	void SortWork(Camera* _camera);
+	void SortWork(Camera* _camera, int _frameIdx);
+	void FinishSortWork();
+	bool UseIncrementalSort();
+	void PrepareCulling(Camera* _camera);
 	void FrustumCulling(Camera* _camera, int _threadIdx);
-
-	bool ValidRenderer(int _index, vector<QueueRenderer> &_renderers);
-	bool ValidRenderer(int _index, vector<InstanceRenderer>& _renderers);
+	bool PrepareOcclusion(Camera* _camera);
+	void OcclusionCulling(int _threadIdx);
+	void SetSoftwareOcclusion(bool _enable);
+	void SetScreenSizeCulling(float _pixels);
+	void CompileDrawPackets(int _frameIdx, int _numParts, int _numTransparentParts);
 
 	vector<shared_ptr<Renderer>> &GetRenderers();
-	map<int, vector<QueueRenderer>>& GetQueueRenderers();
-	map<int, vector<InstanceRenderer>>& GetInstanceRenderers();
+	const RendererPool& GetRendererPool() const;
+	vector<QueueRenderer>& GetQueueRenderers();
+	map<int, deque<InstanceRenderer>>& GetInstanceRenderers();
+	const vector<DrawPacket>& GetInstanceDrawPackets() const;
+	const vector<DrawPacketRange>& GetInstanceDrawRanges() const;
+	const vector<int>& GetInstanceDrawBounds() const;
+	const vector<DrawPacket>& GetQueueDrawPackets() const;
+	const vector<DrawPacketRange>& GetQueueDrawRanges() const;
+	const vector<int>& GetTransparentDrawBounds() const;
+	RadixSorter& GetInstanceSorter();
+	int GetPendingTransformCount() const;
+	int GetInstanceBatchCount() const;
+	RadixSorter& GetQueueSorter();
 
 private:
-	static const int OPAQUE_CAPACITY = 5000;
-	static const int CUTOFF_CAPACITY = 2500;
 	static const int TRANSPARENT_CAPACITY = 500;
+	static const int SUBTREE_PER_THREAD = 4;
+	static const int MAX_OCCLUDER_COUNT = 32;
+	static const int OCCLUDER_TRIANGLE_BUDGET = 20000;
 
 	void ClearQueueRenderer();
 	void ClearInstanceRendererData();
-	void AddToQueueRenderer(Renderer* _renderer, Camera* _camera);
-	void AddToInstanceRenderer(Renderer* _renderer, Camera* _camera);
-	int FindInstanceRenderer(int _queue, InstanceRenderer _ir);
+	void AddToQueueRenderer(int _id);
+	void AddToInstanceRenderer(int _id, int _frameIdx);
+	void AddInstanceSortItem(int _batchIndex);
+	void RequestRebatch(int _id);
+	void UpdateInstanceBatches();
+	int CreateInstanceBatch(int _queue, InstanceRenderer& _ir, Material* _mat);
+	void CheckSortKeyField(int _value, int _bits, const wchar_t* _name);
+	float CalcViewDepth(const BoundingBox& _bound, bool _nearest);
+	bool IsCameraTeleport(XMFLOAT3 _pos, XMFLOAT3 _dir);
+	int FindInstanceRenderer(int _queue, InstanceRenderer& _ir);
+	InstanceBatchKey GetInstanceBatchKey(int _queue, InstanceRenderer& _ir);
+	void EvaluateScreenSize(const vector<int>& _list, int _threadIdx);
+	void TestIntersectBounds(Camera* _camera, const vector<int>& _list, vector<int>& _visible);
+	StaticCullingState GetStaticCullingState(Camera* _camera, StaticCullingCache& _cache, int _numThreads);
+	void InvalidateStaticCulling(int _id);
+	void ApplyWorldBound(int _id);
+	void AddDrawPacket(DrawPacketStream& _stream, Renderer* _renderer, Mesh* _mesh, int _submeshIndex, int _queue, int _instanceCount, D3D12_GPU_VIRTUAL_ADDRESS _instanceData, D3D12_GPU_VIRTUAL_ADDRESS _objectConstant);
 
 	vector<shared_ptr<Renderer>> renderers;
-	map<int, vector<QueueRenderer>> queuedRenderers;
-	map<int, vector<InstanceRenderer>> instanceRenderers;
+
+	// hot state of renderers, handle is the same as index in renderers
+	RendererPool rendererPool;
+	vector<QueueRenderer> queuedRenderers;
+	// deque keeps batch pointers valid when batches are added at runtime
+	map<int, deque<InstanceRenderer>> instanceRenderers;
+	vector<InstanceRenderer*> instanceBatchList;
+
+	// batches each renderer is counted in, renderers in rebatch list are moved before next sort
+	vector<vector<int>> batchMembership;
+	vector<int> rebatchList;
+	vector<uint8_t> rebatchFlag;
+	bool instanceBatchReady = false;
+
+	// sorted by 64-bit keys, item index points to instanceBatchList/queuedRenderers
+	RadixSorter instanceSorter;
+	RadixSorter queueSorter;
+
+	// sorted order of last frame, used as input order so incremental sort has little to do
+	vector<int> lastInstanceOrder;
+	vector<QueueRenderer> lastSortedQueue;
+	vector<int> instanceSortFrame;
+	vector<int> queueSortFrame;
+	int sortFrame = 0;
+	bool useIncrementalSort = false;
+	bool sortKeyOverflowLogged = false;
+	XMFLOAT3 sortCamPos = XMFLOAT3(0, 0, 0);
+	XMFLOAT3 sortCamDir = XMFLOAT3(0, 0, 1);
+
+	// (mesh, submesh, material, queue) to index in instanceBatchList
+	unordered_map<InstanceBatchKey, int, InstanceBatchKeyHash> instanceBatchIndex;
+
+	// draw stream of current frame, capacity is kept between frames
+	DrawPacketStream instanceDrawStream;
+	DrawPacketStream queueDrawStream;
+
+	// prefix sum of estimated packet cost, each instance range is split into parts of similar cost
+	vector<double> instanceDrawCost;
+	vector<int> instanceDrawBounds;
+
+	// transparent queue packets are split the same way, but across queues since blending order is global
+	vector<double> queueDrawCost;
+	vector<int> transparentDrawBounds;
+
+	// world bounds in SoA form for simd culling, indexed the same as renderers
+	SimdCulling cullingBounds;
+
+	// scene bvh, [0] for static renderers, [1] for dynamic renderers with fat bounds
+	AabbTree sceneTree[2];
+	vector<int> treeProxy;
+	vector<int> subtreeRoots;
+	vector<CullingRoot> cullingRoots;
+
+	// per worker results, visible list is also used for resetting visibility next frame
+	vector<int> visibleList[MAX_WORKER_THREAD_COUNT];
+	vector<int> intersectList[MAX_WORKER_THREAD_COUNT];
+
+	// renderers that changed lod in culling, marked world dirty on one thread before collecting
+	vector<int> lodChangedList[MAX_WORKER_THREAD_COUNT];
+
+	// static culling result per camera instance id, version is bumped when any static renderer changes
+	unordered_map<int, StaticCullingCache> staticCullingCache;
+	StaticCullingCache* currStaticCache = nullptr;
+	StaticCullingState staticCullingState = StaticCullingState::Rebuild;
+	int staticCullingVersion = 0;
+
+	// transforms batched from main thread, applied by workers before culling
+	TransformBatch transformBatch;
+
+	// screen size is bound radius * projection scale / distance, i.e. fraction of screen height
+	XMFLOAT3 cullingCamPos = XMFLOAT3(0, 0, 0);
+	float screenSizeScale = 1.0f;
+	float screenHeight = 1.0f;
+	float screenSizeCullingPixels = 0.0f;
+
+	// large visible renderers are rasterized to a small cpu depth buffer, then the rest test against it
+	SoftwareOcclusion occlusionBuffer;
+	vector<pair<float, int>> occluderCandidates;
+	vector<int> occluderFrame;
+	int occlusionFrame = 0;
+	bool enableOcclusion = true;
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "RendererPool.h"
+#include "AffineMath.h"
+
+int RendererPool::Add(bool _isDynamic)
+{
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+	// new renderer starts visible, active and dirty in every frame buffer
+	worldBounds.push_back(BoundingBox());
+	worlds.push_back(identity);
+	invWorlds.push_back(identity);
+	flags.push_back(VISIBLE_BIT | ACTIVE_BIT | (_isDynamic ? DYNAMIC_BIT : 0));
+	worldVersions.push_back(1);
+
+	return worldDirty.Add();
+}
+
+void RendererPool::Release()
+{
+	worldBounds.clear();
+	worlds.clear();
+	invWorlds.clear();
+	flags.clear();
+	worldVersions.clear();
+	worldDirty.Release();
+}
+
+int RendererPool::GetCount() const
+{
+	return (int)flags.size();
+}
+
+void RendererPool::SetWorld(int _handle, const XMFLOAT4X4& _world, const BoundingBox& _localBound)
+{
+	UpdateWorld(_handle, _world, _localBound);
+	MarkWorldDirty(_handle);
+}
+
+void RendererPool::UpdateWorld(int _handle, const XMFLOAT4X4& _world, const BoundingBox& _localBound)
+{
+	worlds[_handle] = _world;
+
+	// inverse world for normal transform, world is always affine
+	AffineInverse(_world, invWorlds[_handle]);
+	AffineTransformBound(_localBound, _world, worldBounds[_handle]);
+}
+
+void RendererPool::MarkWorldDirty(int _handle)
+{
+	// every slot that holds this renderer is out of date now, in any batch and frame buffer
+	worldVersions[_handle]++;
+	worldDirty.Mark(_handle);
+}
+
+void RendererPool::SetVisible(int _handle, bool _visible)
+{
+	// inactive renderer is never visible
+	if (_visible && (flags[_handle] & ACTIVE_BIT))
+	{
+		flags[_handle] |= VISIBLE_BIT;
+	}
+	else
+	{
+		flags[_handle] &= ~VISIBLE_BIT;
+	}
+}
+
+void RendererPool::SetActive(int _handle, bool _active)
+{
+	if (_active)
+	{
+		flags[_handle] |= ACTIVE_BIT;
+	}
+	else
+	{
+		flags[_handle] &= ~ACTIVE_BIT;
+	}
+}
+
+const XMFLOAT4X4& RendererPool::GetWorld(int _handle) const
+{
+	return worlds[_handle];
+}
+
+const XMFLOAT4X4& RendererPool::GetInvWorld(int _handle) const
+{
+	return invWorlds[_handle];
+}
+
+const BoundingBox& RendererPool::GetWorldBound(int _handle) const
+{
+	return worldBounds[_handle];
+}
+
+bool RendererPool::IsVisible(int _handle) const
+{
+	return (flags[_handle] & VISIBLE_BIT) != 0;
+}
+
+bool RendererPool::IsActive(int _handle) const
+{
+	return (flags[_handle] & ACTIVE_BIT) != 0;
+}
+
+bool RendererPool::IsDynamic(int _handle) const
+{
+	return (flags[_handle] & DYNAMIC_BIT) != 0;
+}
+
+uint32_t RendererPool::GetWorldVersion(int _handle) const
+{
+	return worldVersions[_handle];
+}
+
+bool RendererPool::IsWorldDirty(int _handle, int _frameIdx) const
+{
+	return worldDirty.IsDirty(_handle, _frameIdx);
+}
+
+int RendererPool::GetWorldDirtyCount(int _frameIdx) const
+{
+	return (int)worldDirty.GetList(_frameIdx).size();
+}
+
+void RendererPool::ClearWorldDirty(int _frameIdx)
+{
+	// only visible renderers were collected and uploaded, the rest stay dirty until they show up
+	worldDirty.Clear(_frameIdx, [this](int _handle) { return IsVisible(_handle); });
+}
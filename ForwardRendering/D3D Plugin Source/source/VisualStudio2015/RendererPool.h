@@ -0,0 +1,57 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include <cstdint>
+#include "FrameSettings.h"
+#include "InstanceSlotTable.h"
+using namespace DirectX;
+using namespace std;
+
+// hot per-renderer state in flat arrays, a renderer handle indexes all of them
+// cold data (meshes, materials, gpu buffers) stays in Renderer
+class RendererPool
+{
+public:
+	int Add(bool _isDynamic);
+	void Release();
+	int GetCount() const;
+
+	void SetWorld(int _handle, const XMFLOAT4X4& _world, const BoundingBox& _localBound);
+
+	// world data only without touching flags, workers can call this for different handles
+	void UpdateWorld(int _handle, const XMFLOAT4X4& _world, const BoundingBox& _localBound);
+	void MarkWorldDirty(int _handle);
+	void SetVisible(int _handle, bool _visible);
+	void SetActive(int _handle, bool _active);
+
+	const XMFLOAT4X4& GetWorld(int _handle) const;
+	const XMFLOAT4X4& GetInvWorld(int _handle) const;
+	const BoundingBox& GetWorldBound(int _handle) const;
+	bool IsVisible(int _handle) const;
+	bool IsActive(int _handle) const;
+	bool IsDynamic(int _handle) const;
+
+	// bumped whenever world changes, instance slots compare it with the version they hold
+	uint32_t GetWorldVersion(int _handle) const;
+
+	// handles marked since a frame buffer was last uploaded, ClearWorldDirty after its upload is done
+	bool IsWorldDirty(int _handle, int _frameIdx) const;
+	int GetWorldDirtyCount(int _frameIdx) const;
+	void ClearWorldDirty(int _frameIdx);
+
+private:
+	// one byte of state flags per renderer
+	static const uint8_t VISIBLE_BIT = 1 << 0;
+	static const uint8_t ACTIVE_BIT = 1 << 1;
+	static const uint8_t DYNAMIC_BIT = 1 << 2;
+
+	vector<BoundingBox> worldBounds;
+	vector<XMFLOAT4X4> worlds;
+	vector<XMFLOAT4X4> invWorlds;
+	vector<uint8_t> flags;
+	vector<uint32_t> worldVersions;
+
+	// dirty bits are kept apart from flags, culling workers write flags while upload clears dirty bits
+	WorldDirtyList<MAX_FRAME_COUNT> worldDirty;
+};
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "RingAllocator.h"
+
+void RingAllocator::Init(uint64_t _capacity, uint64_t _alignment)
+{
+	// aligned sizes and capacity keep every head, tail and wrap point aligned
+	alignment = (_alignment > 0) ? _alignment : 1;
+	capacity = _capacity / alignment * alignment;
+	head = 0;
+	tail = 0;
+	usedSize = 0;
+	inFlightFrames.clear();
+	frameOpened = false;
+}
+
+void RingAllocator::Release()
+{
+	Init(0, 1);
+}
+
+void RingAllocator::BeginFrame(uint64_t _completedFence, uint64_t _frameFence)
+{
+	// close last frame
+	if (frameOpened)
+	{
+		currFrame.end = head;
+		inFlightFrames.push_back(currFrame);
+	}
+
+	// frames finished by gpu give back their space, they are retired in order
+	while (inFlightFrames.size() > 0 && inFlightFrames.front().fence <= _completedFence)
+	{
+		tail = inFlightFrames.front().end;
+		usedSize -= inFlightFrames.front().size;
+		inFlightFrames.pop_front();
+	}
+
+	// nothing in flight, start from 0 so a slice as large as the ring still fits
+	if (inFlightFrames.size() == 0)
+	{
+		head = 0;
+		tail = 0;
+	}
+
+	currFrame.fence = _frameFence;
+	currFrame.end = head;
+	currFrame.size = 0;
+	frameOpened = true;
+}
+
+bool RingAllocator::Allocate(uint64_t _size, uint64_t& _offset)
+{
+	_size = (_size + alignment - 1) / alignment * alignment;
+	if (_size > capacity || usedSize + _size > capacity)
+	{
+		return false;
+	}
+
+	uint64_t waste = 0;
+	if (head >= tail)
+	{
+		// free space is [head, capacity) + [0, tail), a slice never crosses the end
+		if (head + _size <= capacity)
+		{
+			_offset = head;
+		}
+		else if (_size <= tail)
+		{
+			waste = capacity - head;
+			_offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// free space is [head, tail)
+		if (head + _size > tail)
+		{
+			return false;
+		}
+		_offset = head;
+	}
+
+	// head == tail after this means the ring is full, usedSize tells full from empty
+	head = (_offset + _size) % capacity;
+	usedSize += waste + _size;
+	currFrame.size += waste + _size;
+
+	return true;
+}
+
+uint64_t RingAllocator::GetCapacity() const
+{
+	return capacity;
+}
+
+uint64_t RingAllocator::GetUsedSize() const
+{
+	return usedSize;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+using namespace std;
+
+struct RingFrame
+{
+	uint64_t fence;
+	uint64_t end;
+	uint64_t size;
+};
+
+// offset bookkeeping of a ring buffer whose allocations are freed per frame by fence
+// allocations of a frame are freed together after gpu passes the fence of that frame
+class RingAllocator
+{
+public:
+	// every slice starts at a multiple of _alignment, capacity is rounded down to it
+	void Init(uint64_t _capacity, uint64_t _alignment);
+	void Release();
+
+	// retire frames with completed fence, following allocations belong to _frameFence
+	void BeginFrame(uint64_t _completedFence, uint64_t _frameFence);
+
+	// contiguous range of at least _size bytes, false when ring is full
+	bool Allocate(uint64_t _size, uint64_t& _offset);
+
+	uint64_t GetCapacity() const;
+	uint64_t GetUsedSize() const;
+
+private:
+	// free space is [head, tail) with wrap around, waste at the end counts as used
+	uint64_t capacity = 0;
+	uint64_t alignment = 1;
+	uint64_t head = 0;
+	uint64_t tail = 0;
+	uint64_t usedSize = 0;
+
+	deque<RingFrame> inFlightFrames;
+	RingFrame currFrame;
+	bool frameOpened = false;
+};
@@ -0,0 +1,144 @@
+#include "SimdCulling.h"
+#include <xmmintrin.h>
+
+void SimdCulling::Resize(int _count)
+{
+	int groupCount = (_count + LANE_COUNT - 1) / LANE_COUNT;
+
+	// unused lanes are zero-size boxes at origin, callers never read them
+	centerX.resize(groupCount, XMVectorZero());
+	centerY.resize(groupCount, XMVectorZero());
+	centerZ.resize(groupCount, XMVectorZero());
+	extentX.resize(groupCount, XMVectorZero());
+	extentY.resize(groupCount, XMVectorZero());
+	extentZ.resize(groupCount, XMVectorZero());
+
+	boundCount = _count;
+}
+
+void SimdCulling::Release()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+	boundCount = 0;
+}
+
+void SimdCulling::SetBound(int _index, const BoundingBox& _bound)
+{
+	if (_index < 0 || _index >= boundCount)
+	{
+		return;
+	}
+
+	int group = _index / LANE_COUNT;
+	int lane = _index % LANE_COUNT;
+
+	centerX[group].m128_f32[lane] = _bound.Center.x;
+	centerY[group].m128_f32[lane] = _bound.Center.y;
+	centerZ[group].m128_f32[lane] = _bound.Center.z;
+	extentX[group].m128_f32[lane] = _bound.Extents.x;
+	extentY[group].m128_f32[lane] = _bound.Extents.y;
+	extentZ[group].m128_f32[lane] = _bound.Extents.z;
+}
+
+void SimdCulling::SetFrustum(const BoundingFrustum& _frustum)
+{
+	// same normalized planes BoundingFrustum::Contains builds internally
+	XMVECTOR planes[NUM_PLANES];
+	_frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+	for (int i = 0; i < NUM_PLANES; i++)
+	{
+		XMStoreFloat4(&frustumPlanes[i], planes[i]);
+		planeX[i] = XMVectorSplatX(planes[i]);
+		planeY[i] = XMVectorSplatY(planes[i]);
+		planeZ[i] = XMVectorSplatZ(planes[i]);
+		planeW[i] = XMVectorSplatW(planes[i]);
+		absPlaneX[i] = XMVectorAbs(planeX[i]);
+		absPlaneY[i] = XMVectorAbs(planeY[i]);
+		absPlaneZ[i] = XMVectorAbs(planeZ[i]);
+	}
+}
+
+void SimdCulling::TestGroup(int _group, int& _visibleMask, int& _ambiguousMask) const
+{
+	TestLanes(centerX[_group], centerY[_group], centerZ[_group], extentX[_group], extentY[_group], extentZ[_group], _visibleMask, _ambiguousMask);
+}
+
+void SimdCulling::TestIndices(const int* _indices, int _count, int& _visibleMask, int& _ambiguousMask) const
+{
+	// unused lanes stay zero-size boxes at origin, callers never read them
+	XMVECTOR cx = XMVectorZero();
+	XMVECTOR cy = XMVectorZero();
+	XMVECTOR cz = XMVectorZero();
+	XMVECTOR ex = XMVectorZero();
+	XMVECTOR ey = XMVectorZero();
+	XMVECTOR ez = XMVectorZero();
+
+	for (int i = 0; i < _count && i < LANE_COUNT; i++)
+	{
+		int group = _indices[i] / LANE_COUNT;
+		int lane = _indices[i] % LANE_COUNT;
+
+		cx.m128_f32[i] = centerX[group].m128_f32[lane];
+		cy.m128_f32[i] = centerY[group].m128_f32[lane];
+		cz.m128_f32[i] = centerZ[group].m128_f32[lane];
+		ex.m128_f32[i] = extentX[group].m128_f32[lane];
+		ey.m128_f32[i] = extentY[group].m128_f32[lane];
+		ez.m128_f32[i] = extentZ[group].m128_f32[lane];
+	}
+
+	TestLanes(cx, cy, cz, ex, ey, ez, _visibleMask, _ambiguousMask);
+}
+
+const XMFLOAT4* SimdCulling::GetPlanes() const
+{
+	return frustumPlanes;
+}
+
+int SimdCulling::GetPlaneCount() const
+{
+	return NUM_PLANES;
+}
+
+int SimdCulling::GetCount() const
+{
+	return boundCount;
+}
+
+int SimdCulling::GetGroupCount() const
+{
+	return (int)centerX.size();
+}
+
+void SimdCulling::TestLanes(XMVECTOR _cx, XMVECTOR _cy, XMVECTOR _cz, XMVECTOR _ex, XMVECTOR _ey, XMVECTOR _ez, int& _visibleMask, int& _ambiguousMask) const
+{
+	// dot products are evaluated in a different order than XMVector4Dot,
+	// so only trust results that are clear of the outside threshold by a small margin
+	const XMVECTOR relativeEps = XMVectorReplicate(1e-5f);
+	const XMVECTOR absoluteEps = XMVectorReplicate(1e-5f);
+
+	XMVECTOR outside = XMVectorFalseInt();
+	XMVECTOR nearOutside = XMVectorFalseInt();
+
+	for (int i = 0; i < NUM_PLANES; i++)
+	{
+		XMVECTOR dist = XMVectorMultiplyAdd(_cx, planeX[i], XMVectorMultiplyAdd(_cy, planeY[i], XMVectorMultiplyAdd(_cz, planeZ[i], planeW[i])));
+		XMVECTOR radius = XMVectorMultiplyAdd(_ex, absPlaneX[i], XMVectorMultiplyAdd(_ey, absPlaneY[i], XMVectorMultiply(_ez, absPlaneZ[i])));
+		XMVECTOR margin = XMVectorMultiplyAdd(XMVectorAdd(radius, XMVectorAbs(dist)), relativeEps, absoluteEps);
+
+		// only dist > radius culls, a box intersecting a plane is as visible as one inside all of them
+		outside = XMVectorOrInt(outside, XMVectorGreater(dist, XMVectorAdd(radius, margin)));
+		nearOutside = XMVectorOrInt(nearOutside, XMVectorGreater(dist, XMVectorSubtract(radius, margin)));
+	}
+
+	int outsideMask = _mm_movemask_ps(outside);
+	int nearOutsideMask = _mm_movemask_ps(nearOutside);
+
+	_visibleMask = ~nearOutsideMask & 0xF;
+	_ambiguousMask = nearOutsideMask & ~outsideMask;
+}
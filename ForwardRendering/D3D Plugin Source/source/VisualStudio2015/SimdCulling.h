@@ -0,0 +1,60 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+using namespace DirectX;
+using namespace std;
+
+// bounds stored as structure-of-arrays, each XMVECTOR lane holds one box
+// so a frustum plane can be tested against 4 boxes at a time
+class SimdCulling
+{
+public:
+	static const int LANE_COUNT = 4;
+
+	void Resize(int _count);
+	void Release();
+	void SetBound(int _index, const BoundingBox& _bound);
+	void SetFrustum(const BoundingFrustum& _frustum);
+
+	// return 4-bit masks of boxes not outside any plane (visible, inside or intersecting)
+	// and of boxes within a rounding margin of a plane's outside threshold, which need the scalar test,
+	// boxes in neither mask are culled
+	void TestGroup(int _group, int& _visibleMask, int& _ambiguousMask) const;
+
+	// same as TestGroup but gathers up to 4 arbitrary bounds, lane k tests _indices[k]
+	void TestIndices(const int* _indices, int _count, int& _visibleMask, int& _ambiguousMask) const;
+
+	// normalized planes of last SetFrustum, inside on negative side
+	const XMFLOAT4* GetPlanes() const;
+	int GetPlaneCount() const;
+
+	int GetCount() const;
+	int GetGroupCount() const;
+
+private:
+	static const int NUM_PLANES = 6;
+
+	void TestLanes(XMVECTOR _cx, XMVECTOR _cy, XMVECTOR _cz, XMVECTOR _ex, XMVECTOR _ey, XMVECTOR _ez, int& _visibleMask, int& _ambiguousMask) const;
+
+	XMFLOAT4 frustumPlanes[NUM_PLANES];
+
+	// splatted frustum planes
+	XMVECTOR planeX[NUM_PLANES];
+	XMVECTOR planeY[NUM_PLANES];
+	XMVECTOR planeZ[NUM_PLANES];
+	XMVECTOR planeW[NUM_PLANES];
+	XMVECTOR absPlaneX[NUM_PLANES];
+	XMVECTOR absPlaneY[NUM_PLANES];
+	XMVECTOR absPlaneZ[NUM_PLANES];
+
+	// world bound lanes
+	vector<XMVECTOR> centerX;
+	vector<XMVECTOR> centerY;
+	vector<XMVECTOR> centerZ;
+	vector<XMVECTOR> extentX;
+	vector<XMVECTOR> extentY;
+	vector<XMVECTOR> extentZ;
+
+	int boundCount = 0;
+};
\ No newline at end of file
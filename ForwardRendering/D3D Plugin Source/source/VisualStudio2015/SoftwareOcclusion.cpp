@@ -0,0 +1,236 @@
+#include "SoftwareOcclusion.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void SoftwareOcclusion::Init()
+{
+	depthBuffer.assign(BUFFER_WIDTH * BUFFER_HEIGHT, 0.0f);
+	tileDepth.assign(TILE_COUNT_X * TILE_COUNT_Y, 0.0f);
+}
+
+void SoftwareOcclusion::Release()
+{
+	depthBuffer.clear();
+	tileDepth.clear();
+}
+
+void SoftwareOcclusion::BeginFrame(XMFLOAT4X4 _viewProj, float _nearZ)
+{
+	viewProj = _viewProj;
+	nearZ = _nearZ;
+
+	fill(depthBuffer.begin(), depthBuffer.end(), 0.0f);
+	fill(tileDepth.begin(), tileDepth.end(), 0.0f);
+}
+
+int SoftwareOcclusion::RasterizeTriangles(const XMFLOAT3* _positions, int _vertexCount, const unsigned int* _indices, int _indexCount, int _baseVertex, XMFLOAT4X4 _world)
+{
+	XMMATRIX wvp = XMMatrixMultiply(XMLoadFloat4x4(&_world), XMLoadFloat4x4(&viewProj));
+	int triCount = 0;
+
+	for (int i = 0; i + 2 < _indexCount; i += 3)
+	{
+		XMFLOAT3 screen[3];
+		bool valid = true;
+
+		for (int k = 0; k < 3; k++)
+		{
+			int idx = (int)_indices[i + k] + _baseVertex;
+			if (idx < 0 || idx >= _vertexCount)
+			{
+				valid = false;
+				break;
+			}
+
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&_positions[idx]), wvp));
+			if (clip.w < nearZ)
+			{
+				valid = false;
+				break;
+			}
+
+			// screen position and 1/w, which is linear in screen space
+			float invW = 1.0f / clip.w;
+			screen[k].x = (clip.x * invW * 0.5f + 0.5f) * BUFFER_WIDTH;
+			screen[k].y = (clip.y * invW * 0.5f + 0.5f) * BUFFER_HEIGHT;
+			screen[k].z = invW;
+		}
+
+		if (valid)
+		{
+			RasterizeTriangle(screen[0], screen[1], screen[2]);
+			triCount++;
+		}
+	}
+
+	return triCount;
+}
+
+void SoftwareOcclusion::BuildHiZ()
+{
+	// keep the farthest occluder of each tile
+	for (int ty = 0; ty < TILE_COUNT_Y; ty++)
+	{
+		for (int tx = 0; tx < TILE_COUNT_X; tx++)
+		{
+			float farthest = FLT_MAX;
+			for (int y = ty * TILE_SIZE; y < (ty + 1) * TILE_SIZE; y++)
+			{
+				for (int x = tx * TILE_SIZE; x < (tx + 1) * TILE_SIZE; x++)
+				{
+					farthest = min(farthest, depthBuffer[y * BUFFER_WIDTH + x]);
+				}
+			}
+			tileDepth[ty * TILE_COUNT_X + tx] = farthest;
+		}
+	}
+}
+
+bool SoftwareOcclusion::IsOccluded(const BoundingBox& _bound) const
+{
+	XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+	_bound.GetCorners(corners);
+
+	XMMATRIX vp = XMLoadFloat4x4(&viewProj);
+	float minX = FLT_MAX, minY = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearestInvW = 0.0f;
+
+	for (size_t i = 0; i < BoundingBox::CORNER_COUNT; i++)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corners[i]), vp));
+
+		// crossing near plane, projected rect isn't reliable
+		if (clip.w < nearZ)
+		{
+			return false;
+		}
+
+		float invW = 1.0f / clip.w;
+		float sx = (clip.x * invW * 0.5f + 0.5f) * BUFFER_WIDTH;
+		float sy = (clip.y * invW * 0.5f + 0.5f) * BUFFER_HEIGHT;
+
+		minX = min(minX, sx);
+		maxX = max(maxX, sx);
+		minY = min(minY, sy);
+		maxY = max(maxY, sy);
+		nearestInvW = max(nearestInvW, invW);
+	}
+
+	// pull the bound slightly closer so surfaces touching the bound don't occlude it
+	nearestInvW *= 1.001f;
+
+	int x0 = max((int)floorf(minX), 0);
+	int y0 = max((int)floorf(minY), 0);
+	int x1 = min((int)ceilf(maxX), (int)BUFFER_WIDTH);
+	int y1 = min((int)ceilf(maxY), (int)BUFFER_HEIGHT);
+	if (x0 >= x1 || y0 >= y1)
+	{
+		return false;
+	}
+
+	for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ty++)
+	{
+		for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; tx++)
+		{
+			// whole tile is covered by closer occluders
+			if (tileDepth[ty * TILE_COUNT_X + tx] > nearestInvW)
+			{
+				continue;
+			}
+
+			int px0 = max(x0, tx * TILE_SIZE);
+			int px1 = min(x1, (tx + 1) * TILE_SIZE);
+			int py0 = max(y0, ty * TILE_SIZE);
+			int py1 = min(y1, (ty + 1) * TILE_SIZE);
+
+			for (int y = py0; y < py1; y++)
+			{
+				for (int x = px0; x < px1; x++)
+				{
+					if (depthBuffer[y * BUFFER_WIDTH + x] <= nearestInvW)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+const vector<float>& SoftwareOcclusion::GetDepthBuffer() const
+{
+	return depthBuffer;
+}
+
+void SoftwareOcclusion::RasterizeTriangle(XMFLOAT3 _v0, XMFLOAT3 _v1, XMFLOAT3 _v2)
+{
+	float area = (_v1.x - _v0.x) * (_v2.y - _v0.y) - (_v1.y - _v0.y) * (_v2.x - _v0.x);
+	if (fabsf(area) < 1e-6f)
+	{
+		return;
+	}
+
+	// both windings are rasterized, flip to positive area
+	if (area < 0)
+	{
+		swap(_v1, _v2);
+		area = -area;
+	}
+
+	int x0 = max((int)floorf(min(_v0.x, min(_v1.x, _v2.x))), 0);
+	int y0 = max((int)floorf(min(_v0.y, min(_v1.y, _v2.y))), 0);
+	int x1 = min((int)ceilf(max(_v0.x, max(_v1.x, _v2.x))), (int)BUFFER_WIDTH);
+	int y1 = min((int)ceilf(max(_v0.y, max(_v1.y, _v2.y))), (int)BUFFER_HEIGHT);
+
+	float invArea = 1.0f / area;
+
+	// edge function steps per pixel, w(px + 1) = w(px) + dx and w(py + 1) = w(py) + dy
+	float e0dx = -(_v2.y - _v1.y), e0dy = _v2.x - _v1.x;
+	float e1dx = -(_v0.y - _v2.y), e1dy = _v0.x - _v2.x;
+	float e2dx = -(_v1.y - _v0.y), e2dy = _v1.x - _v0.x;
+
+	// an edge value at pixel center minus this is its lowest value over the pixel's 4 corners
+	float e0Margin = 0.5f * (fabsf(e0dx) + fabsf(e0dy));
+	float e1Margin = 0.5f * (fabsf(e1dx) + fabsf(e1dy));
+	float e2Margin = 0.5f * (fabsf(e2dx) + fabsf(e2dy));
+
+	// same for 1/w, which is linear in screen space too
+	float zdx = (e0dx * _v0.z + e1dx * _v1.z + e2dx * _v2.z) * invArea;
+	float zdy = (e0dy * _v0.z + e1dy * _v1.z + e2dy * _v2.z) * invArea;
+	float zMargin = 0.5f * (fabsf(zdx) + fabsf(zdy));
+
+	for (int y = y0; y < y1; y++)
+	{
+		float py = y + 0.5f;
+		for (int x = x0; x < x1; x++)
+		{
+			// edge functions at pixel center
+			float px = x + 0.5f;
+			float w0 = (_v2.x - _v1.x) * (py - _v1.y) - (_v2.y - _v1.y) * (px - _v1.x);
+			float w1 = (_v0.x - _v2.x) * (py - _v2.y) - (_v0.y - _v2.y) * (px - _v2.x);
+			float w2 = (_v1.x - _v0.x) * (py - _v0.y) - (_v1.y - _v0.y) * (px - _v0.x);
+
+			// the query tests every pixel a bound touches, so an occluder may only write pixels it covers entirely
+			if (w0 < e0Margin || w1 < e1Margin || w2 < e2Margin)
+			{
+				continue;
+			}
+
+			// and only the farthest depth it has inside the pixel
+			float invW = (w0 * _v0.z + w1 * _v1.z + w2 * _v2.z) * invArea - zMargin;
+			if (invW <= 0.0f)
+			{
+				continue;
+			}
+
+			float& depth = depthBuffer[y * BUFFER_WIDTH + x];
+			depth = max(depth, invW);
+		}
+	}
+}
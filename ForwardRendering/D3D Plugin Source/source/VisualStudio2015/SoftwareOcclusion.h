@@ -0,0 +1,41 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+using namespace DirectX;
+using namespace std;
+
+// low resolution cpu depth buffer of a few large occluders
+// stores 1/w of the nearest occluder per pixel (0 means empty) plus the farthest value per tile
+// a pixel is written only if one occluder triangle covers all of it, with the farthest 1/w the triangle has inside it,
+// so pixels along triangle edges stay empty and lose occlusion rather than gain it
+class SoftwareOcclusion
+{
+public:
+	static const int BUFFER_WIDTH = 256;
+	static const int BUFFER_HEIGHT = 144;
+	static const int TILE_SIZE = 8;
+	static const int TILE_COUNT_X = BUFFER_WIDTH / TILE_SIZE;
+	static const int TILE_COUNT_Y = BUFFER_HEIGHT / TILE_SIZE;
+
+	void Init();
+	void Release();
+	void BeginFrame(XMFLOAT4X4 _viewProj, float _nearZ);
+
+	// rasterize indexed triangles, triangles crossing near plane are skipped since it only loses occlusion
+	int RasterizeTriangles(const XMFLOAT3* _positions, int _vertexCount, const unsigned int* _indices, int _indexCount, int _baseVertex, XMFLOAT4X4 _world);
+	void BuildHiZ();
+
+	// true only if the bound is behind occluders at every pixel it covers
+	bool IsOccluded(const BoundingBox& _bound) const;
+
+	const vector<float>& GetDepthBuffer() const;
+
+private:
+	void RasterizeTriangle(XMFLOAT3 _v0, XMFLOAT3 _v1, XMFLOAT3 _v2);
+
+	XMFLOAT4X4 viewProj;
+	float nearZ = 0.0f;
+	vector<float> depthBuffer;
+	vector<float> tileDepth;
+};
\ No newline at end of file
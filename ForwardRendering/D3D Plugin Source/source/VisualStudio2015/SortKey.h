@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+// sort key layout, high bits first
+// opaque:      queue(13) | pso(10) | material(12) | mesh(13) | depth(16), front to back
+// transparent: queue(13) | ~depth(32) | material(12) | unused(7), back to front
+const static int SORT_QUEUE_BITS = 13;
+const static int SORT_PSO_BITS = 10;
+const static int SORT_MATERIAL_BITS = 12;
+const static int SORT_MESH_BITS = 13;
+const static int SORT_DEPTH_BITS = 16;
+
+// camera movement treated as a cut, last frame's order isn't reused
+const static float SORT_TELEPORT_DISTANCE = 10.0f;
+const static float SORT_TELEPORT_COS = 0.9f;
+
+inline bool SortKeyFits(int _value, int _bits)
+{
+	return _value >= 0 && (uint64_t)_value < (1ULL << _bits);
+}
+
+inline uint64_t SortKeyField(int _value, int _bits)
+{
+	// out of range values are clamped, callers check SortKeyFits first and report it
+	uint64_t maxValue = (1ULL << _bits) - 1;
+	if (_value < 0)
+	{
+		return 0;
+	}
+
+	return min((uint64_t)_value, maxValue);
+}
+
+inline uint64_t SortKeyDepth(float _depth)
+{
+	// bit pattern of a non-negative float increases with its value
+	_depth = max(_depth, 0.0f);
+	uint32_t bits;
+	memcpy(&bits, &_depth, sizeof(float));
+
+	return bits;
+}
+
+inline uint64_t MakeOpaqueSortKeyBase(int _queue, int _pso, int _material, int _mesh)
+{
+	uint64_t key = SortKeyField(_queue, SORT_QUEUE_BITS);
+	key = (key << SORT_PSO_BITS) | SortKeyField(_pso, SORT_PSO_BITS);
+	key = (key << SORT_MATERIAL_BITS) | SortKeyField(_material, SORT_MATERIAL_BITS);
+	key = (key << SORT_MESH_BITS) | SortKeyField(_mesh, SORT_MESH_BITS);
+
+	return key << SORT_DEPTH_BITS;
+}
+
+inline uint64_t MakeOpaqueSortKey(uint64_t _keyBase, float _depth)
+{
+	// keep top 16 bits of depth, enough precision for front to back
+	return _keyBase | (SortKeyDepth(_depth) >> (32 - SORT_DEPTH_BITS));
+}
+
+inline uint64_t MakeTransparentSortKey(int _queue, int _material, float _depth)
+{
+	uint64_t key = SortKeyField(_queue, SORT_QUEUE_BITS);
+	key = (key << 32) | (~SortKeyDepth(_depth) & 0xffffffffULL);
+	key = (key << SORT_MATERIAL_BITS) | SortKeyField(_material, SORT_MATERIAL_BITS);
+
+	return key << (64 - SORT_QUEUE_BITS - 32 - SORT_MATERIAL_BITS);
+}
@@ -0,0 +1,183 @@
+#include "SortUtility.h"
+#include <algorithm>
+#include <cstring>
+
+vector<SortItem>& RadixSorter::GetItems()
+{
+	return items;
+}
+
+int RadixSorter::GetItemCount() const
+{
+	return (int)items.size();
+}
+
+void RadixSorter::Sort()
+{
+	Begin(1);
+	while (NextPass())
+	{
+		Histogram(0);
+		if (PrefixSum())
+		{
+			Scatter(0);
+		}
+	}
+	End();
+}
+
+bool RadixSorter::SortIncremental()
+{
+	int itemCount = (int)items.size();
+	int64_t shiftBudget = (int64_t)itemCount * INCREMENTAL_SHIFT_PER_ITEM;
+	int64_t shiftCount = 0;
+
+	for (int i = 1; i < itemCount; i++)
+	{
+		SortItem item = items[i];
+		int j = i - 1;
+
+		while (j >= 0 && items[j].key > item.key)
+		{
+			items[j + 1] = items[j];
+			j--;
+
+			if (++shiftCount > shiftBudget)
+			{
+				items[j + 1] = item;
+				return false;
+			}
+		}
+
+		items[j + 1] = item;
+	}
+
+	return true;
+}
+
+void RadixSorter::Begin(int _numThreads)
+{
+	numThreads = max(_numThreads, 1);
+	temp.resize(items.size());
+	histogram.resize(numThreads * RADIX_SIZE);
+
+	src = items.data();
+	dst = temp.data();
+	pass = -1;
+	needSwap = false;
+}
+
+bool RadixSorter::NextPass()
+{
+	// output of last scatter is the input of next pass
+	if (needSwap)
+	{
+		swap(src, dst);
+		needSwap = false;
+	}
+
+	pass++;
+	return pass < PASS_COUNT;
+}
+
+void RadixSorter::Histogram(int _threadIndex)
+{
+	if (_threadIndex >= numThreads)
+	{
+		return;
+	}
+
+	int* count = &histogram[_threadIndex * RADIX_SIZE];
+	memset(count, 0, sizeof(int) * RADIX_SIZE);
+
+	int start, end;
+	GetChunk(_threadIndex, start, end);
+
+	int shift = pass * RADIX_BITS;
+	for (int i = start; i < end; i++)
+	{
+		count[(src[i].key >> shift) & (RADIX_SIZE - 1)]++;
+	}
+}
+
+bool RadixSorter::PrefixSum()
+{
+	int itemCount = (int)items.size();
+
+	// the digit is the same for all items, nothing to reorder
+	for (int d = 0; d < RADIX_SIZE; d++)
+	{
+		int digitCount = 0;
+		for (int t = 0; t < numThreads; t++)
+		{
+			digitCount += histogram[t * RADIX_SIZE + d];
+		}
+
+		if (digitCount == itemCount)
+		{
+			return false;
+		}
+
+		if (digitCount > 0)
+		{
+			break;
+		}
+	}
+
+	// offsets ordered by digit then thread, keeps the sort stable
+	int total = 0;
+	for (int d = 0; d < RADIX_SIZE; d++)
+	{
+		for (int t = 0; t < numThreads; t++)
+		{
+			int c = histogram[t * RADIX_SIZE + d];
+			histogram[t * RADIX_SIZE + d] = total;
+			total += c;
+		}
+	}
+
+	needSwap = true;
+	return true;
+}
+
+void RadixSorter::Scatter(int _threadIndex)
+{
+	if (_threadIndex >= numThreads)
+	{
+		return;
+	}
+
+	int* offset = &histogram[_threadIndex * RADIX_SIZE];
+
+	int start, end;
+	GetChunk(_threadIndex, start, end);
+
+	int shift = pass * RADIX_BITS;
+	for (int i = start; i < end; i++)
+	{
+		dst[offset[(src[i].key >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+	}
+}
+
+void RadixSorter::End()
+{
+	if (needSwap)
+	{
+		swap(src, dst);
+		needSwap = false;
+	}
+
+	// odd number of scatters, result is in temp
+	if (src != items.data())
+	{
+		memcpy(items.data(), src, sizeof(SortItem) * items.size());
+	}
+}
+
+void RadixSorter::GetChunk(int _threadIndex, int& _start, int& _end) const
+{
+	int itemCount = (int)items.size();
+	int count = (itemCount + numThreads - 1) / numThreads;
+	_start = min(_threadIndex * count, itemCount);
+	_end = min(_start + count, itemCount);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+struct SortItem
+{
+	uint64_t key;
+	int index;
+};
+
+// stable LSD radix sort on 64-bit keys
+// each pass is histogram -> prefix sum -> scatter, histogram/scatter can be split to worker threads.
+// a thread always handles the same contiguous part of input, so result doesn't depend on thread count
+class RadixSorter
+{
+public:
+	static const int RADIX_BITS = 8;
+	static const int RADIX_SIZE = 1 << RADIX_BITS;
+	static const int PASS_COUNT = 64 / RADIX_BITS;
+
+	// below this count waking worker threads costs more than sorting
+	static const int PARALLEL_THRESHOLD = 4096;
+
+	// average element moves allowed for incremental sort before giving up
+	static const int INCREMENTAL_SHIFT_PER_ITEM = 8;
+
+	vector<SortItem>& GetItems();
+	int GetItemCount() const;
+	void Sort();
+
+	// insertion sort for input that is nearly sorted already (e.g. last frame's order)
+	// return false if it runs out of budget, items are still a valid permutation then
+	bool SortIncremental();
+
+	// parallel sort steps, Histogram/Scatter are called once per thread index
+	void Begin(int _numThreads);
+	bool NextPass();
+	void Histogram(int _threadIndex);
+	bool PrefixSum();
+	void Scatter(int _threadIndex);
+	void End();
+
+private:
+	void GetChunk(int _threadIndex, int& _start, int& _end) const;
+
+	vector<SortItem> items;
+	vector<SortItem> temp;
+	vector<int> histogram;
+	SortItem* src = nullptr;
+	SortItem* dst = nullptr;
+	int numThreads = 1;
+	int pass = -1;
+	bool needSwap = false;
+};
\ No newline at end of file
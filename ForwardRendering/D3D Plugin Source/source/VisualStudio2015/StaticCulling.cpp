@@ -0,0 +1,58 @@
+#include "StaticCulling.h"
+#include <cstring>
+
+StaticCullingState UpdateStaticCulling(StaticCullingCache& _cache, const XMFLOAT4* _planes, const XMFLOAT3* _corners, float _margin, int _version, int _numThreads)
+{
+	const int numPlanes = StaticCullingCache::NUM_PLANES;
+	const int numCorners = 8;
+
+	// cache is valid only if the whole current frustum is inside the expanded one
+	bool valid = (_cache.version == _version && _cache.threadCount == _numThreads);
+	if (valid)
+	{
+		for (int i = 0; i < numCorners && valid; i++)
+		{
+			for (int j = 0; j < numPlanes; j++)
+			{
+				const XMFLOAT4& p = _cache.planes[j];
+				if (p.x * _corners[i].x + p.y * _corners[i].y + p.z * _corners[i].z + p.w > 0.0f)
+				{
+					valid = false;
+					break;
+				}
+			}
+		}
+	}
+
+	if (valid)
+	{
+		// frustum didn't change at all, last visible result still holds
+		if (_cache.tested && memcmp(_cache.testedPlanes, _planes, sizeof(XMFLOAT4) * numPlanes) == 0)
+		{
+			return StaticCullingState::Reuse;
+		}
+
+		memcpy(_cache.testedPlanes, _planes, sizeof(XMFLOAT4) * numPlanes);
+		return StaticCullingState::Retest;
+	}
+
+	// push planes outward, planes are normalized so w offset is the distance
+	for (int i = 0; i < numPlanes; i++)
+	{
+		_cache.planes[i] = _planes[i];
+		_cache.planes[i].w -= _margin;
+	}
+
+	for (int i = 0; i < MAX_WORKER_THREAD_COUNT; i++)
+	{
+		_cache.candidates[i].clear();
+		_cache.visible[i].clear();
+	}
+
+	memcpy(_cache.testedPlanes, _planes, sizeof(XMFLOAT4) * numPlanes);
+	_cache.version = _version;
+	_cache.threadCount = _numThreads;
+	_cache.tested = true;
+
+	return StaticCullingState::Rebuild;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "JobSystem.h"
+using namespace DirectX;
+using namespace std;
+
+// static culling cache margin, as a fraction of camera far distance
+const static float STATIC_CULLING_MARGIN_RATIO = 0.02f;
+
+enum StaticCullingState
+{
+	Rebuild = 0,
+	Retest,
+	Reuse,
+};
+
+// static renderers found with expanded frustum planes, valid until camera leaves the expanded frustum
+struct StaticCullingCache
+{
+	static const int NUM_PLANES = 6;
+
+	XMFLOAT4 planes[NUM_PLANES];
+	XMFLOAT4 testedPlanes[NUM_PLANES];
+	vector<int> candidates[MAX_WORKER_THREAD_COUNT];
+	vector<int> visible[MAX_WORKER_THREAD_COUNT];
+	int version = -1;
+	int threadCount = 0;
+	bool tested = false;
+};
+
+// decide how static renderers are culled this frame and prepare the cache for it
+// _planes are the normalized frustum planes of this frame, _corners its 8 corners
+// Rebuild: cache planes are pushed out by _margin and lists are cleared, static tree has to be queried with cache planes
+// Retest: candidates still cover the frustum, only their exact test runs again
+// Reuse: frustum didn't change, last visible lists still hold
+StaticCullingState UpdateStaticCulling(StaticCullingCache& _cache, const XMFLOAT4* _planes, const XMFLOAT3* _corners, float _margin, int _version, int _numThreads);
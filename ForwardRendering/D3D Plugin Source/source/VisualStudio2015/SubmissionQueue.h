@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+using namespace std;
+
+// closed command lists are deposited to fixed slots (stage, worker) and flushed in slot order,
+// so gpu order doesn't depend on which worker finishes first and a flush is one batched execute call
+// list type is a template parameter, so ordering can be checked with any mock list
+template<typename T> class SubmissionQueue
+{
+public:
+	void Init(int _numStages, int _slotsPerStage)
+	{
+		numStages = _numStages;
+		slotsPerStage = _slotsPerStage;
+		slots.assign(_numStages * _slotsPerStage, nullptr);
+		batch.reserve(slots.size());
+	}
+
+	// every worker owns its slot, so deposit needs no lock
+	void Deposit(int _stage, int _slot, T* _list)
+	{
+		if (_stage < 0 || _stage >= numStages || _slot < 0 || _slot >= slotsPerStage)
+		{
+			return;
+		}
+
+		slots[_stage * slotsPerStage + _slot] = _list;
+	}
+
+	// lists of stages [_firstStage, _lastStage] in (stage, slot) order, _execute(T** _lists, int _count) is called once if there is any
+	// must be called after all workers of these stages are finished
+	template<typename ExecuteFunc> int Flush(int _firstStage, int _lastStage, ExecuteFunc _execute)
+	{
+		batch.clear();
+
+		for (int i = _firstStage * slotsPerStage; i < (_lastStage + 1) * slotsPerStage && i < (int)slots.size(); i++)
+		{
+			if (slots[i] != nullptr)
+			{
+				batch.push_back(slots[i]);
+				slots[i] = nullptr;
+			}
+		}
+
+		if (!batch.empty())
+		{
+			_execute(batch.data(), (int)batch.size());
+		}
+
+		return (int)batch.size();
+	}
+
+private:
+	vector<T*> slots;
+	vector<T*> batch;
+	int numStages = 0;
+	int slotsPerStage = 0;
+};
\ No newline at end of file
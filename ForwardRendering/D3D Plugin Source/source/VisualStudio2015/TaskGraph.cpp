@@ -0,0 +1,192 @@
+#include "TaskGraph.h"
+
+int TaskGraph::AddTask(const string& _name, const TaskFunc& _func)
+{
+	Task t;
+	t.name = _name;
+	t.func = _func;
+	tasks.push_back(t);
+
+	return (int)tasks.size() - 1;
+}
+
+bool TaskGraph::AddDependency(int _task, int _dependsOn)
+{
+	if (_task < 0 || _task >= (int)tasks.size() || _dependsOn < 0 || _dependsOn >= (int)tasks.size() || _task == _dependsOn)
+	{
+		return false;
+	}
+
+	tasks[_dependsOn].dependents.push_back(_task);
+	tasks[_task].dependencyCount++;
+
+	return true;
+}
+
+void TaskGraph::Clear()
+{
+	tasks.clear();
+	taskJobs.clear();
+	pendingCounts.reset();
+	jobSystem = nullptr;
+}
+
+bool TaskGraph::Run(JobSystem& _jobSystem)
+{
+	vector<int> order;
+	if (!SortTopological(order))
+	{
+		return false;
+	}
+
+	int numTasks = (int)tasks.size();
+	pendingCounts.reset(new atomic<int>[numTasks]);
+
+	// build all job funcs before dispatching anything, dispatched jobs hold pointers to them
+	taskJobs.clear();
+	for (int i = 0; i < numTasks; i++)
+	{
+		pendingCounts[i] = tasks[i].dependencyCount;
+		taskJobs.push_back([this, i](int) { ExecuteTask(i); });
+	}
+
+	jobSystem = &_jobSystem;
+	runStart = chrono::steady_clock::now();
+
+	for (int i = 0; i < numTasks; i++)
+	{
+		if (tasks[i].dependencyCount == 0)
+		{
+			_jobSystem.Dispatch(1, taskJobs[i], graphCounter);
+		}
+	}
+
+	// dependents are dispatched before the finishing task decreases counter, so it only reaches 0 at the end
+	_jobSystem.Wait(graphCounter);
+
+	return true;
+}
+
+double TaskGraph::GetCriticalPath(vector<int>& _path) const
+{
+	_path.clear();
+
+	vector<int> order;
+	if (!SortTopological(order) || order.empty())
+	{
+		return 0.0;
+	}
+
+	// longest finish time of a chain ending at each task, previous points back along the chain
+	vector<double> chainTime(tasks.size(), 0.0);
+	vector<int> previous(tasks.size(), -1);
+
+	for (int i : order)
+	{
+		chainTime[i] += GetTaskTime(i);
+		for (int d : tasks[i].dependents)
+		{
+			if (chainTime[i] > chainTime[d] || previous[d] == -1)
+			{
+				chainTime[d] = chainTime[i];
+				previous[d] = i;
+			}
+		}
+	}
+
+	int last = order[0];
+	for (int i : order)
+	{
+		if (chainTime[i] > chainTime[last])
+		{
+			last = i;
+		}
+	}
+
+	for (int i = last; i != -1; i = previous[i])
+	{
+		_path.insert(_path.begin(), i);
+	}
+
+	return chainTime[last];
+}
+
+int TaskGraph::GetTaskCount() const
+{
+	return (int)tasks.size();
+}
+
+const string& TaskGraph::GetTaskName(int _task) const
+{
+	return tasks[_task].name;
+}
+
+double TaskGraph::GetTaskStart(int _task) const
+{
+	return tasks[_task].startTime;
+}
+
+double TaskGraph::GetTaskEnd(int _task) const
+{
+	return tasks[_task].endTime;
+}
+
+double TaskGraph::GetTaskTime(int _task) const
+{
+	return tasks[_task].endTime - tasks[_task].startTime;
+}
+
+void TaskGraph::ExecuteTask(int _task)
+{
+	Task& t = tasks[_task];
+
+	t.startTime = GetElapsedTime();
+	if (t.func)
+	{
+		t.func();
+	}
+	t.endTime = GetElapsedTime();
+
+	// last finished input dispatches the dependent, counter release makes this task's output visible to it
+	for (int d : t.dependents)
+	{
+		if (pendingCounts[d].fetch_sub(1, memory_order_acq_rel) == 1)
+		{
+			jobSystem->Dispatch(1, taskJobs[d], graphCounter);
+		}
+	}
+}
+
+bool TaskGraph::SortTopological(vector<int>& _order) const
+{
+	_order.clear();
+
+	vector<int> remaining(tasks.size());
+	for (int i = 0; i < (int)tasks.size(); i++)
+	{
+		remaining[i] = tasks[i].dependencyCount;
+		if (remaining[i] == 0)
+		{
+			_order.push_back(i);
+		}
+	}
+
+	// _order doubles as the queue of tasks whose inputs are all visited
+	for (int i = 0; i < (int)_order.size(); i++)
+	{
+		for (int d : tasks[_order[i]].dependents)
+		{
+			if (--remaining[d] == 0)
+			{
+				_order.push_back(d);
+			}
+		}
+	}
+
+	return _order.size() == tasks.size();
+}
+
+double TaskGraph::GetElapsedTime() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - runStart).count();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "JobSystem.h"
+#include <string>
+#include <chrono>
+using namespace std;
+
+// cpu tasks with explicit dependencies, a task is pushed to job system as soon as all of its inputs are finished
+// tasks are kept between runs, so a frame graph is built once and executed every frame
+class TaskGraph
+{
+public:
+	typedef function<void()> TaskFunc;
+
+	int AddTask(const string& _name, const TaskFunc& _func);
+
+	// return false and add nothing if either task doesn't exist or a task depends on itself
+	bool AddDependency(int _task, int _dependsOn);
+	void Clear();
+
+	// run all tasks and wait for them, return false without running anything if dependencies form a cycle
+	bool Run(JobSystem& _jobSystem);
+
+	// longest chain of measured task time in last run, path is in execution order, return its length in ms
+	double GetCriticalPath(vector<int>& _path) const;
+
+	int GetTaskCount() const;
+	const string& GetTaskName(int _task) const;
+
+	// ms relative to the beginning of last run
+	double GetTaskStart(int _task) const;
+	double GetTaskEnd(int _task) const;
+	double GetTaskTime(int _task) const;
+
+private:
+	struct Task
+	{
+		string name;
+		TaskFunc func;
+		vector<int> dependents;
+		int dependencyCount = 0;
+		double startTime = 0.0;
+		double endTime = 0.0;
+	};
+
+	void ExecuteTask(int _task);
+	bool SortTopological(vector<int>& _order) const;
+	double GetElapsedTime() const;
+
+	vector<Task> tasks;
+
+	// per run state, job funcs must stay alive until graph counter is waited
+	vector<JobSystem::JobFunc> taskJobs;
+	unique_ptr<atomic<int>[]> pendingCounts;
+	JobCounter graphCounter;
+	JobSystem* jobSystem = nullptr;
+	chrono::steady_clock::time_point runStart;
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "TransformBatch.h"
+#include <algorithm>
+#include <cstring>
+
+void TransformBatch::Add(const int* _ids, const XMFLOAT4X4* _worlds, int _count)
+{
+	if (_ids == nullptr || _worlds == nullptr || _count <= 0)
+	{
+		return;
+	}
+
+	int* idDst;
+	XMFLOAT4X4* worldDst;
+	Reserve(_count, &idDst, &worldDst);
+
+	memcpy(idDst, _ids, sizeof(int) * _count);
+	memcpy(worldDst, _worlds, sizeof(XMFLOAT4X4) * _count);
+	Commit(_count);
+}
+
+void TransformBatch::Reserve(int _capacity, int** _ids, XMFLOAT4X4** _worlds)
+{
+	_capacity = max(_capacity, 0);
+	if (count + _capacity > (int)ids.size())
+	{
+		ids.resize(count + _capacity);
+		worlds.resize(count + _capacity);
+	}
+
+	// caller writes at the end of pending batch
+	*_ids = ids.data() + count;
+	*_worlds = worlds.data() + count;
+	reserved = _capacity;
+}
+
+void TransformBatch::Commit(int _count)
+{
+	count += min(max(_count, 0), reserved);
+	reserved = 0;
+}
+
+bool TransformBatch::Prepare(int _rendererCount)
+{
+	if (count == 0)
+	{
+		return false;
+	}
+
+	stamps.resize(_rendererCount, -1);
+	for (int i = 0; i < count; i++)
+	{
+		if (ids[i] < 0 || ids[i] >= _rendererCount)
+		{
+			ids[i] = -1;
+			continue;
+		}
+
+		stamps[ids[i]] = i;
+	}
+
+	return true;
+}
+
+void TransformBatch::GetSlice(int _threadIdx, int _numThreads, int& _start, int& _end) const
+{
+	int sliceCount = (count + _numThreads - 1) / _numThreads;
+	_start = min(_threadIdx * sliceCount, count);
+	_end = min(_start + sliceCount, count);
+}
+
+bool TransformBatch::IsApplied(int _index) const
+{
+	int id = ids[_index];
+	return id != -1 && stamps[id] == _index;
+}
+
+int TransformBatch::GetID(int _index) const
+{
+	return ids[_index];
+}
+
+const XMFLOAT4X4& TransformBatch::GetWorld(int _index) const
+{
+	return worlds[_index];
+}
+
+int TransformBatch::GetCount() const
+{
+	return count;
+}
+
+void TransformBatch::Clear()
+{
+	count = 0;
+}
+
+void TransformBatch::Release()
+{
+	ids.clear();
+	worlds.clear();
+	count = 0;
+	reserved = 0;
+	stamps.clear();
+}
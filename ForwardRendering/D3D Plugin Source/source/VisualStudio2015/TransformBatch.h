@@ -0,0 +1,41 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+using namespace DirectX;
+using namespace std;
+
+// world matrices batched from main thread, applied by workers before culling
+// buffer is kept between frames so pointers from Reserve stay valid until commit
+class TransformBatch
+{
+public:
+	void Add(const int* _ids, const XMFLOAT4X4* _worlds, int _count);
+	void Reserve(int _capacity, int** _ids, XMFLOAT4X4** _worlds);
+	void Commit(int _count);
+
+	// drops out of range ids and finds the last entry of every id, false if nothing is pending
+	bool Prepare(int _rendererCount);
+
+	// contiguous slice of entries for a worker, each renderer is written by one thread only
+	void GetSlice(int _threadIdx, int _numThreads, int& _start, int& _end) const;
+
+	// duplicated ids in a batch only apply the last one
+	bool IsApplied(int _index) const;
+
+	int GetID(int _index) const;
+	const XMFLOAT4X4& GetWorld(int _index) const;
+	int GetCount() const;
+
+	// empties the batch after it is applied, buffers are kept
+	void Clear();
+	void Release();
+
+private:
+	vector<int> ids;
+	vector<XMFLOAT4X4> worlds;
+	int count = 0;
+	int reserved = 0;
+
+	// last pending index of each renderer
+	vector<int> stamps;
+};
@@ -0,0 +1,79 @@
+#include "UploadRingBuffer.h"
+#include "UploadBuffer.h"
+#include "stdafx.h"
+#include "FrameStatistics.h"
+#include "d3dx12.h"
+
+bool UploadRingBuffer::Init(ID3D12Device* _device, UINT64 _capacity)
+{
+	UINT64 capacity = CalcConstantBufferByteSize((UINT)_capacity);
+	allocator.Init(capacity, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	fullLogged = false;
+
+	HRESULT hr = S_OK;
+	LogIfFailed(_device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(capacity),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&ringBuffer)), hr);
+
+	if (FAILED(hr))
+	{
+		return false;
+	}
+
+	// keep mapped for the whole lifetime
+	LogIfFailed(ringBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)), hr);
+	gpuAddress = ringBuffer->GetGPUVirtualAddress();
+
+	return SUCCEEDED(hr);
+}
+
+void UploadRingBuffer::Release()
+{
+	if (ringBuffer != nullptr)
+	{
+		ringBuffer->Unmap(0, nullptr);
+	}
+
+	ringBuffer.Reset();
+	mappedData = nullptr;
+	gpuAddress = 0;
+	allocator.Release();
+}
+
+void UploadRingBuffer::BeginFrame(UINT64 _completedFence, UINT64 _frameFence)
+{
+	allocator.BeginFrame(_completedFence, _frameFence);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS UploadRingBuffer::AllocateConstant(const void* _data, UINT _byteSize)
+{
+	UINT64 offset = 0;
+	if (mappedData == nullptr || !allocator.Allocate(_byteSize, offset))
+	{
+		if (!fullLogged)
+		{
+			LogMessage(L"[SqGraphic Error] Upload ring buffer is full.");
+			fullLogged = true;
+		}
+		return 0;
+	}
+
+	memcpy(mappedData + offset, _data, _byteSize);
+	GRAPHIC_STAT_ADD(StatUploadBytes, _byteSize)
+
+	return gpuAddress + offset;
+}
+
+UINT64 UploadRingBuffer::GetCapacity() const
+{
+	return allocator.GetCapacity();
+}
+
+UINT64 UploadRingBuffer::GetUsedSize() const
+{
+	return allocator.GetUsedSize();
+}
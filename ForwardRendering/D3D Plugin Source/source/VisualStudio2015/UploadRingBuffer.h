@@ -0,0 +1,31 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include "RingAllocator.h"
+using namespace Microsoft::WRL;
+
+// one persistently mapped upload buffer for transient per-frame data (object constants etc.)
+// allocations of a frame are freed together after gpu passes the fence of that frame
+// not thread safe, only render thread allocates
+class UploadRingBuffer
+{
+public:
+	bool Init(ID3D12Device* _device, UINT64 _capacity);
+	void Release();
+
+	// retire frames with completed fence, following allocations belong to _frameFence
+	void BeginFrame(UINT64 _completedFence, UINT64 _frameFence);
+
+	// 256-byte aligned slice for a constant buffer, returns 0 when ring is full
+	D3D12_GPU_VIRTUAL_ADDRESS AllocateConstant(const void* _data, UINT _byteSize);
+
+	UINT64 GetCapacity() const;
+	UINT64 GetUsedSize() const;
+
+private:
+	ComPtr<ID3D12Resource> ringBuffer;
+	BYTE* mappedData = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	RingAllocator allocator;
+	bool fullLogged = false;
+};
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "WorkerBudget.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+int ChooseWorkerCount(int _itemCount, double _itemCost, double _workerOverhead, int _maxWorkers)
+{
+	if (_itemCount <= 0 || _maxWorkers <= 1)
+	{
+		return 1;
+	}
+
+	// no overhead means every worker helps
+	if (_workerOverhead <= 0.0)
+	{
+		return min(_itemCount, _maxWorkers);
+	}
+
+	double best = sqrt((double)_itemCount * max(_itemCost, 0.0) / _workerOverhead);
+	int count = (int)(best + 0.5);
+
+	// never more workers than items
+	return max(1, min(min(count, _itemCount), _maxWorkers));
+}
+
+StageCost::StageCost(double _initialItemCost, double _workerOverhead)
+{
+	itemCost = _initialItemCost;
+	workerOverhead = _workerOverhead;
+}
+
+int StageCost::ChooseWorkerCount(int _itemCount, int _maxWorkers) const
+{
+	return ::ChooseWorkerCount(_itemCount, itemCost, workerOverhead, _maxWorkers);
+}
+
+void StageCost::Record(int _itemCount, int _workerCount, double _elapsedTime)
+{
+	if (_itemCount <= 0 || _workerCount <= 0)
+	{
+		return;
+	}
+
+	// invert the model of ChooseWorkerCount, so more workers don't look like more expensive items
+	double work = max(_elapsedTime * _workerCount - (double)_workerCount * _workerCount * workerOverhead, 0.0);
+	itemCost += (work / _itemCount - itemCost) * STAGE_COST_SMOOTH;
+}
+
+double StageCost::GetItemCost() const
+{
+	return itemCost;
+}
+
+double StageCost::GetWorkerOverhead() const
+{
+	return workerOverhead;
+}
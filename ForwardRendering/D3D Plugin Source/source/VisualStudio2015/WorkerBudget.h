@@ -0,0 +1,26 @@
+#pragma once
+
+// weight of newest frame when smoothing measured stage cost
+const static double STAGE_COST_SMOOTH = 0.1;
+
+// stage time with n workers is about items * itemCost / n + n * workerOverhead, smallest at n = sqrt(items * itemCost / workerOverhead)
+// result is clamped to [1, _maxWorkers], costs are in ms
+int ChooseWorkerCount(int _itemCount, double _itemCost, double _workerOverhead, int _maxWorkers);
+
+// per item cost of one stage, smoothed over frames so a single spike doesn't change parallelism
+class StageCost
+{
+public:
+	StageCost(double _initialItemCost, double _workerOverhead);
+
+	int ChooseWorkerCount(int _itemCount, int _maxWorkers) const;
+
+	// _elapsedTime is wall time of the stage, total work is about _elapsedTime * _workerCount
+	void Record(int _itemCount, int _workerCount, double _elapsedTime);
+	double GetItemCost() const;
+	double GetWorkerOverhead() const;
+
+private:
+	double itemCost;
+	double workerOverhead;
+};
\ No newline at end of file
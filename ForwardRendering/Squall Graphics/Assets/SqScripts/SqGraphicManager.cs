@@ -29,6 +29,9 @@ public class SqGraphicManager : MonoBehaviour
     [DllImport("SquallGraphics")]
     static extern IntPtr GetGpuProfile();
 
+    [DllImport("SquallGraphics")]
+    static extern IntPtr GetFrameStatistics();
+
     /// <summary>
     /// number of render threads
     /// </summary>
@@ -99,6 +102,7 @@ public class SqGraphicManager : MonoBehaviour
         if (Input.GetKeyUp(KeyCode.R))
             displayFrameData = !displayFrameData;
 
+        SqMeshRenderer.FlushTransforms();
         UpdateSqGraphic();
         RenderSqGraphic();
     }
@@ -109,6 +113,7 @@ public class SqGraphicManager : MonoBehaviour
         {
             string cpuProfile = Marshal.PtrToStringAnsi(GetCpuProfile());
             string gpuProfile = Marshal.PtrToStringAnsi(GetGpuProfile()) + "\nFPS: " + GetComponent<FPSCounter>().m_CurrentFps;
+            string frameStatistics = Marshal.PtrToStringAnsi(GetFrameStatistics());
 
             GUIStyle fontStyle = new GUIStyle(GUI.skin.textArea);
             fontStyle.normal.textColor = Color.yellow;
@@ -116,6 +121,7 @@ public class SqGraphicManager : MonoBehaviour
 
             GUI.TextArea(new Rect(0, 0, 400 * Screen.width / 1920, 430 * Screen.height / 1080), cpuProfile, fontStyle);
             GUI.TextArea(new Rect(400 * Screen.width / 1920, 0, 400 * Screen.width / 1920, 430 * Screen.height / 1080), gpuProfile, fontStyle);
+            GUI.TextArea(new Rect(800 * Screen.width / 1920, 0, 1000 * Screen.width / 1920, 430 * Screen.height / 1080), frameStatistics, fontStyle);
         }
     }
 }
@@ -17,6 +17,9 @@ public class SqMeshRenderer : MonoBehaviour
     [DllImport("SquallGraphics")]
     static extern void SetWorldMatrix(int _instanceID, Matrix4x4 _world);
 
+    [DllImport("SquallGraphics")]
+    static extern void SetWorldMatrices(int[] _ids, Matrix4x4[] _worlds, int _count);
+
     [DllImport("SquallGraphics")]
     static extern void UpdateNativeMaterialProp(int _instanceID, uint _byteSize, MaterialConstant _mc);
 
@@ -26,6 +29,23 @@ public class SqMeshRenderer : MonoBehaviour
     MeshRenderer rendererCache;
     int rendererNativeID = -1;
 
+    // moved renderers of this frame, sent with one call before rendering
+    static int[] batchIDs = new int[1024];
+    static Matrix4x4[] batchWorlds = new Matrix4x4[1024];
+    static int batchCount = 0;
+
+    /// <summary>
+    /// send batched transforms to native side
+    /// </summary>
+    public static void FlushTransforms()
+    {
+        if (batchCount > 0)
+        {
+            SetWorldMatrices(batchIDs, batchWorlds, batchCount);
+            batchCount = 0;
+        }
+    }
+
     void Start ()
     {
         // return if sqgraphic not init
@@ -65,7 +85,7 @@ public class SqMeshRenderer : MonoBehaviour
 
         if (transform.hasChanged)
         {
-            UpdateNativeTransform();
+            AddToTransformBatch();
         }
     }
 
@@ -87,6 +107,20 @@ public class SqMeshRenderer : MonoBehaviour
         transform.hasChanged = false;
     }
 
+    void AddToTransformBatch()
+    {
+        if (batchCount == batchIDs.Length)
+        {
+            System.Array.Resize(ref batchIDs, batchCount * 2);
+            System.Array.Resize(ref batchWorlds, batchCount * 2);
+        }
+
+        batchIDs[batchCount] = rendererNativeID;
+        batchWorlds[batchCount] = rendererCache.localToWorldMatrix;
+        batchCount++;
+        transform.hasChanged = false;
+    }
+
     void ExtractMaterialData()
     {
         Material[] mats = rendererCache.sharedMaterials;
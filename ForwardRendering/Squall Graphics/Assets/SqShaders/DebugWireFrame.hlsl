@@ -17,7 +17,7 @@ struct v2f
 v2f WireFrameVS(VertexInput i, uint iid : SV_InstanceID)
 {
 	v2f o = (v2f)0;
-	o.wpos = mul(_SqInstanceData[iid].world, float4(i.vertex, 1.0f));
+	o.wpos = float4(mul(_SqInstanceData[iid].world, float4(i.vertex, 1.0f)), 1.0f);
 	o.vertex = mul(SQ_MATRIX_VP, o.wpos);
 
 	return o;
@@ -28,17 +28,16 @@ v2f DepthPrePassVS(VertexInput i, uint iid : SV_InstanceID)
 {
 	v2f o = (v2f)0;
 
-	float4x4 world = _SqInstanceData[iid].world;
-	float4x4 invWorld = _SqInstanceData[iid].invWorld;
-	float4 wpos = mul(world, float4(i.vertex, 1.0f));
+	float3x4 world = _SqInstanceData[iid].world;
+	float4 wpos = float4(mul(world, float4(i.vertex, 1.0f)), 1.0f);
 
 	o.vertex = mul(SQ_MATRIX_VP, wpos);
 	o.tex.xy = i.uv1 * _MainTex_ST.xy + _MainTex_ST.zw;
 	o.tex.zw = lerp(i.uv1, i.uv2, _DetailUV);
 	o.tex.zw = o.tex.zw * _DetailAlbedoMap_ST.xy + _DetailAlbedoMap_ST.zw;
 
-	// assume uniform scale, mul normal with world matrix directly
-	o.normal = LocalToWorldNormal(invWorld, i.normal);
+	// normal matrix from cofactor of world, works with non-uniform scale
+	o.normal = LocalToWorldNormal(world, i.normal);
 	o.worldToTangent = CreateTBN(world, o.normal, i.tangent);
 
 	return o;
@@ -49,7 +49,7 @@ v2f ForwardPassVS(VertexInput i, uint iid : SV_InstanceID)
 #ifdef _TRANSPARENT_ON
 	float4 wpos = mul(SQ_MATRIX_WORLD, float4(i.vertex, 1.0f));
 #else
-	float4 wpos = mul(_SqInstanceData[iid].world, float4(i.vertex, 1.0f));
+	float4 wpos = float4(mul(_SqInstanceData[iid].world, float4(i.vertex, 1.0f)), 1.0f);
 #endif
 
 	o.worldPos = wpos.xyz;
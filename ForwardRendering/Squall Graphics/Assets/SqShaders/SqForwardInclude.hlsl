@@ -108,7 +108,7 @@ float3 LocalToWorldDir(float3 dir)
 	return mul((float3x3)SQ_MATRIX_WORLD, dir);
 }
 
-float3 LocalToWorldDir(float4x4 world, float3 dir)
+float3 LocalToWorldDir(float3x4 world, float3 dir)
 {
 	return mul((float3x3)world, dir);
 }
@@ -119,10 +119,17 @@ float3 LocalToWorldNormal(float3 normal)
 	return normalize(mul(normal, SQ_MATRIX_INV_WORLD));
 }
 
-float3 LocalToWorldNormal(float4x4 invWorld, float3 normal)
+float3 LocalToWorldNormal(float3x4 world, float3 normal)
 {
-	// mul(IT_M, norm) => mul(norm, I_M) => {dot(norm, I_M.col0), dot(norm, I_M.col1), dot(norm, I_M.col2)}
-	return normalize(mul(normal, (float3x3)invWorld));
+	// IT_M = cofactor(M) / det(M), rows of cofactor are cross products of rows of M
+	// only direction is needed, so keep the sign of det for mirrored matrix
+	float3x3 m = (float3x3)world;
+	float3 c0 = cross(m[1], m[2]);
+	float3 c1 = cross(m[2], m[0]);
+	float3 c2 = cross(m[0], m[1]);
+	float detSign = (dot(m[0], c0) < 0) ? -1.0f : 1.0f;
+
+	return normalize(float3(dot(c0, normal), dot(c1, normal), dot(c2, normal)) * detSign);
 }
 
 float3x3 CreateTBN(float3 normal, float4 oTangent)
@@ -138,7 +145,7 @@ float3x3 CreateTBN(float3 normal, float4 oTangent)
 	return tbn;
 }
 
-float3x3 CreateTBN(float4x4 world, float3 normal, float4 oTangent)
+float3x3 CreateTBN(float3x4 world, float3 normal, float4 oTangent)
 {
 	float3 tangent = LocalToWorldDir(world, oTangent.xyz);
 	float3 binormal = cross(normal, tangent) * oTangent.w;
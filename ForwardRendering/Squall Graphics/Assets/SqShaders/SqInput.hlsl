@@ -40,8 +40,8 @@ struct SubMesh
 
 struct SqInstanceData
 {
-	float4x4 world;
-	float4x4 invWorld;
+	// affine world without the (0,0,0,1) row, normal matrix is derived from it
+	row_major float3x4 world;
 };
 
 cbuffer SystemConstant : register(b0)